@@ -0,0 +1,98 @@
+#ifndef MATH_PRACTICE_AND_OPERATING_SYSTEMS_ALLOCATOR_LOGGER_GUARDANT_H
+#define MATH_PRACTICE_AND_OPERATING_SYSTEMS_ALLOCATOR_LOGGER_GUARDANT_H
+
+#include <logger_guardant.h>
+#include <utility>
+
+/**
+ * logger_guardant for the allocators, whose logging can be compiled out: with MP_OS_ALLOCATOR_NO_LOGGING
+ * (the MP_OS_ALLOCATOR_LOGGING=OFF build option) every *_with_guard call is empty and is_enabled_with_guard
+ * is a constant false, so messages built under it are dead code and the logger is never even asked for.
+ * Messages built right in the call arguments are still built, so hot paths build them only under
+ * is_enabled_with_guard.
+ */
+class allocator_logger_guardant :
+    public logger_guardant
+{
+
+public:
+
+#ifdef MP_OS_ALLOCATOR_NO_LOGGING
+    static constexpr const bool logging_enabled = false;
+#else
+    static constexpr const bool logging_enabled = true;
+#endif
+
+public:
+
+    template<typename message_type>
+    allocator_logger_guardant &log_with_guard(
+        message_type &&message,
+        logger::severity severity) &
+    {
+        if constexpr (logging_enabled)
+        {
+            logger_guardant::log_with_guard(std::forward<message_type>(message), severity);
+        }
+
+        return *this;
+    }
+
+    template<typename message_type>
+    allocator_logger_guardant &trace_with_guard(
+        message_type &&message) &
+    {
+        return log_with_guard(std::forward<message_type>(message), logger::severity::trace);
+    }
+
+    template<typename message_type>
+    allocator_logger_guardant &debug_with_guard(
+        message_type &&message) &
+    {
+        return log_with_guard(std::forward<message_type>(message), logger::severity::debug);
+    }
+
+    template<typename message_type>
+    allocator_logger_guardant &information_with_guard(
+        message_type &&message) &
+    {
+        return log_with_guard(std::forward<message_type>(message), logger::severity::information);
+    }
+
+    template<typename message_type>
+    allocator_logger_guardant &warning_with_guard(
+        message_type &&message) &
+    {
+        return log_with_guard(std::forward<message_type>(message), logger::severity::warning);
+    }
+
+    template<typename message_type>
+    allocator_logger_guardant &error_with_guard(
+        message_type &&message) &
+    {
+        return log_with_guard(std::forward<message_type>(message), logger::severity::error);
+    }
+
+    template<typename message_type>
+    allocator_logger_guardant &critical_with_guard(
+        message_type &&message) &
+    {
+        return log_with_guard(std::forward<message_type>(message), logger::severity::critical);
+    }
+
+    bool is_enabled_with_guard(
+        logger::severity severity) const
+    {
+        if constexpr (logging_enabled)
+        {
+            return logger_guardant::is_enabled_with_guard(severity);
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+};
+
+#endif //MATH_PRACTICE_AND_OPERATING_SYSTEMS_ALLOCATOR_LOGGER_GUARDANT_H
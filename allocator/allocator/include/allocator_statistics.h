@@ -0,0 +1,165 @@
+#ifndef MATH_PRACTICE_AND_OPERATING_SYSTEMS_ALLOCATOR_STATISTICS_H
+#define MATH_PRACTICE_AND_OPERATING_SYSTEMS_ALLOCATOR_STATISTICS_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <mutex>
+
+class allocator_statistics
+{
+
+public:
+
+    // класс размеров блока - floor(log2(размер))
+    static constexpr const size_t size_classes_count = sizeof(size_t) * 8;
+
+    /**
+     * Every field is read separately, so a snapshot taken during allocations may be slightly inconsistent.
+     * Counts only grow; rates are the difference of two snapshots divided by the time between them.
+     */
+    struct statistics_snapshot final
+    {
+
+        size_t total_bytes;
+
+        size_t bytes_in_use;
+
+        // наибольшее значение bytes_in_use за время жизни аллокатора
+        size_t peak_bytes_in_use;
+
+        size_t free_bytes;
+
+        size_t largest_free_block;
+
+        size_t occupied_blocks;
+
+        std::array<size_t, size_classes_count> occupied_blocks_per_size_class;
+
+        size_t allocations;
+
+        size_t failed_allocations;
+
+        size_t deallocations;
+
+        size_t contended_locks;
+
+        std::chrono::nanoseconds lock_wait_time;
+
+        // освобождения, отложенные в очередь из-за занятой блокировки
+        size_t remote_frees;
+
+    };
+
+    /**
+     * Counters kept inside an allocator. They are changed only by the thread holding the allocator's lock,
+     * so updates are plain relaxed loads and stores; any thread may read them without locking.
+     */
+    class counters final
+    {
+
+    private:
+
+        std::atomic<size_t> _total_bytes;
+
+        std::atomic<size_t> _bytes_in_use;
+
+        std::atomic<size_t> _peak_bytes_in_use;
+
+        std::atomic<size_t> _largest_free_block;
+
+        std::atomic<size_t> _occupied_blocks;
+
+        std::atomic<size_t> _occupied_blocks_per_size_class[size_classes_count];
+
+        std::atomic<size_t> _allocations;
+
+        std::atomic<size_t> _failed_allocations;
+
+        std::atomic<size_t> _deallocations;
+
+        std::atomic<size_t> _contended_locks;
+
+        std::atomic<size_t> _lock_wait_nanoseconds;
+
+        std::atomic<size_t> _remote_frees;
+
+    public:
+
+        explicit counters(
+            size_t total_bytes) noexcept;
+
+    public:
+
+        // takes the mutex; the time spent waiting for it is counted only when it was already taken
+        std::unique_lock<std::mutex> lock(
+            std::mutex &mutex) noexcept;
+
+        // takes the mutex only if it is free, nothing is counted
+        std::unique_lock<std::mutex> try_lock(
+            std::mutex &mutex) noexcept;
+
+        void on_allocate(
+            size_t block_size) noexcept;
+
+        void on_deallocate(
+            size_t block_size) noexcept;
+
+        void on_failed_allocation() noexcept;
+
+        // a block taken from the remote free queue, its on_deallocate is counted separately
+        void on_remote_free() noexcept;
+
+        /**
+         * For allocators without a lock: several threads may count at once, so these use
+         * atomic read-modify-write operations instead of plain stores.
+         */
+        void on_allocate_unlocked(
+            size_t block_size) noexcept;
+
+        void on_deallocate_unlocked(
+            size_t block_size) noexcept;
+
+        void on_failed_allocation_unlocked() noexcept;
+
+        void set_largest_free_block(
+            size_t size) noexcept;
+
+        size_t get_largest_free_block() const noexcept;
+
+        void add_total_bytes(
+            size_t size) noexcept;
+
+        void remove_total_bytes(
+            size_t size) noexcept;
+
+        statistics_snapshot snapshot() const noexcept;
+
+    private:
+
+        static inline void add(
+            std::atomic<size_t> &counter,
+            size_t value) noexcept;
+
+        static inline void subtract(
+            std::atomic<size_t> &counter,
+            size_t value) noexcept;
+
+        static inline size_t get_size_class(
+            size_t block_size) noexcept;
+
+    };
+
+public:
+
+    virtual ~allocator_statistics() noexcept = default;
+
+public:
+
+    // does not take the allocator's lock
+    virtual statistics_snapshot get_statistics() const noexcept = 0;
+
+};
+
+#endif //MATH_PRACTICE_AND_OPERATING_SYSTEMS_ALLOCATOR_STATISTICS_H
@@ -13,7 +13,9 @@ public:
     {
         first_fit,
         the_best_fit,
-        the_worst_fit
+        the_worst_fit,
+        // поиск продолжается с места предыдущего выделения; без такого указателя работает как first_fit
+        next_fit
     };
 
 public:
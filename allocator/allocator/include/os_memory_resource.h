@@ -0,0 +1,75 @@
+#ifndef MATH_PRACTICE_AND_OPERATING_SYSTEMS_ALLOCATOR_OS_MEMORY_RESOURCE_H
+#define MATH_PRACTICE_AND_OPERATING_SYSTEMS_ALLOCATOR_OS_MEMORY_RESOURCE_H
+
+#include <memory_resource>
+#include <cstddef>
+
+/**
+ * Maps memory straight from the OS: mmap on POSIX, VirtualAlloc on Windows. Nothing is committed up front,
+ * a page costs physical memory only after the first write, so a large arena may be created cheaply.
+ * Passed as the parent allocator of allocator_boundary_tags or allocator_buddies_system it also lets them
+ * give the pages of large free ranges back to the OS.
+ */
+class os_memory_resource final:
+    public std::pmr::memory_resource
+{
+
+private:
+
+    bool _huge_pages;
+
+    size_t _release_threshold;
+
+public:
+
+    /**
+     * huge_pages asks the kernel to back the mappings with transparent huge pages (Linux only).
+     * Free ranges shorter than release_threshold bytes are never given back, so that a block freed and
+     * allocated again in a loop does not pay for a system call and a page fault each time.
+     */
+    explicit os_memory_resource(
+        bool huge_pages = false,
+        size_t release_threshold = 1 << 16) noexcept;
+
+public:
+
+    static size_t get_page_size() noexcept;
+
+    size_t get_release_threshold() const noexcept;
+
+    bool uses_huge_pages() const noexcept;
+
+    /**
+     * Gives back the pages lying entirely inside [from, to). The range stays mapped, its contents are lost:
+     * the pages read as zeros on POSIX and are undefined on Windows.
+     */
+    void release_pages(
+        void *from,
+        void *to) const noexcept;
+
+    /**
+     * Releases the pages of a free range if resource is an os_memory_resource and the range is long enough,
+     * does nothing otherwise. Allocators call it for every free range they form.
+     */
+    static void release_free_range(
+        std::pmr::memory_resource *resource,
+        void *from,
+        void *to) noexcept;
+
+private:
+
+    void *do_allocate(
+        size_t bytes,
+        size_t alignment) override;
+
+    void do_deallocate(
+        void *at,
+        size_t bytes,
+        size_t alignment) override;
+
+    bool do_is_equal(
+        std::pmr::memory_resource const &other) const noexcept override;
+
+};
+
+#endif //MATH_PRACTICE_AND_OPERATING_SYSTEMS_ALLOCATOR_OS_MEMORY_RESOURCE_H
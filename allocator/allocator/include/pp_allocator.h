@@ -13,11 +13,47 @@ struct smart_mem_resource : public std::pmr::memory_resource
 private:
     virtual void do_deallocate_sm(void*) =0;
 
-    void do_deallocate(void* p, size_t, size_t) final;
+    void do_deallocate(void* p, size_t bytes, size_t alignment) final;
 
+    /**
+     * Gets the size and alignment the caller passed to deallocate. The default one ignores them.
+     * Code in this repository often frees with a size of 1, so only an allocator created for callers
+     * that always free with the size and alignment of the allocation may rely on them.
+     */
+    virtual void do_deallocate_sized_sm(void* p, size_t bytes, size_t alignment);
+
+    // блок без требований к выравниванию, выравнивание данных зависит от аллокатора
     virtual void* do_allocate_sm(size_t) =0;
 
+    /**
+     * Called by allocate for every alignment, including the default alignof(std::max_align_t), so the
+     * returned pointer must be aligned as asked. It is freed by do_deallocate_sm as usual. The default one
+     * takes the block from do_allocate_sm and throws std::bad_alloc if it happens to be misaligned,
+     * so allocators whose blocks are not aligned to max_align_t by themselves override it.
+     */
+    virtual void* do_allocate_aligned_sm(size_t bytes, size_t alignment);
+
     void * do_allocate(size_t _Bytes, size_t _Align) final;
+
+    /**
+     * The default ones take and free the blocks one by one. Allocators override them to take their lock
+     * and search the free memory once for the whole batch.
+     */
+    virtual void do_allocate_batch_sm(size_t bytes, size_t count, void** out, size_t alignment);
+
+    virtual void do_deallocate_batch_sm(void* const* blocks, size_t count);
+
+public:
+
+    /**
+     * Puts count blocks of bytes bytes aligned as allocate(bytes, alignment) would align them into out.
+     * All or nothing: when one of them can not be allocated the ones already taken are given back
+     * and std::bad_alloc is thrown.
+     */
+    void allocate_batch(size_t bytes, size_t count, void** out, size_t alignment = alignof(std::max_align_t));
+
+    // the blocks are freed without their size and alignment, blocks that need them are freed with deallocate
+    void deallocate_batch(void* const* blocks, size_t count);
 };
 
 
@@ -67,6 +103,14 @@ public:
 
     void deallocate_bytes(void* p, size_t bytes = 1, size_t alignment = alignof(std::max_align_t));
 
+    /**
+     * count blocks of nbytes bytes in one call to the resource if it is a smart_mem_resource,
+     * one by one otherwise. All or nothing, like smart_mem_resource::allocate_batch.
+     */
+    void allocate_bytes_batch(size_t nbytes, size_t count, void** out, size_t alignment = alignof(std::max_align_t));
+
+    void deallocate_bytes_batch(void* const* p, size_t count, size_t bytes = 1, size_t alignment = alignof(std::max_align_t));
+
     template< class U >
     [[nodiscard]] U* allocate_object( std::size_t n = 1 );
 
@@ -154,6 +198,48 @@ U *pp_allocator<T>::allocate_object(std::size_t n)
     return reinterpret_cast<U*>(allocate_bytes(n * sizeof(U), alignof(U)));
 }
 
+template<typename T>
+void pp_allocator<T>::deallocate_bytes_batch(void *const *p, size_t count, size_t bytes, size_t alignment)
+{
+    if (auto *smart = dynamic_cast<smart_mem_resource*>(resource()); smart != nullptr && alignment <= alignof(std::max_align_t))
+    {
+        smart->deallocate_batch(p, count);
+        return;
+    }
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        resource()->deallocate(p[i], bytes, alignment);
+    }
+}
+
+template<typename T>
+void pp_allocator<T>::allocate_bytes_batch(size_t nbytes, size_t count, void **out, size_t alignment)
+{
+    if (auto *smart = dynamic_cast<smart_mem_resource*>(resource()); smart != nullptr)
+    {
+        smart->allocate_batch(nbytes, count, out, alignment);
+        return;
+    }
+
+    size_t allocated = 0;
+    try
+    {
+        for (; allocated < count; ++allocated)
+        {
+            out[allocated] = resource()->allocate(nbytes, alignment);
+        }
+    }
+    catch (...)
+    {
+        for (size_t i = 0; i < allocated; ++i)
+        {
+            resource()->deallocate(out[i], nbytes, alignment);
+        }
+        throw;
+    }
+}
+
 template<typename T>
 void pp_allocator<T>::deallocate_bytes(void *p, size_t bytes, size_t alignment)
 {
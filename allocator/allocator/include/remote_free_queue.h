@@ -0,0 +1,65 @@
+#ifndef MATH_PRACTICE_AND_OPERATING_SYSTEMS_ALLOCATOR_REMOTE_FREE_QUEUE_H
+#define MATH_PRACTICE_AND_OPERATING_SYSTEMS_ALLOCATOR_REMOTE_FREE_QUEUE_H
+
+#include <atomic>
+
+/**
+ * Blocks freed while the allocator's lock was taken by another thread. Any thread pushes a block
+ * without locking, the word at the pushed address links it to the block pushed before it.
+ * The thread holding the lock takes the whole list at once and frees the blocks itself,
+ * from the last pushed to the first. The queue lives in the allocator's trusted memory.
+ */
+class remote_free_queue final
+{
+
+private:
+
+    std::atomic<void*> _head;
+
+public:
+
+    remote_free_queue() noexcept:
+        _head(nullptr)
+    {
+    }
+
+    remote_free_queue(remote_free_queue const &other) = delete;
+
+    remote_free_queue &operator=(remote_free_queue const &other) = delete;
+
+public:
+
+    // node must have room for a pointer, aligned as a pointer
+    void push(
+        void *node) noexcept
+    {
+        void *head = _head.load(std::memory_order_relaxed);
+
+        do
+        {
+            *reinterpret_cast<void**>(node) = head;
+        }
+        while (!_head.compare_exchange_weak(head, node, std::memory_order_release, std::memory_order_relaxed));
+    }
+
+    // nullptr when the queue is empty
+    void *take_all() noexcept
+    {
+        // без лишней записи, пока никто ничего не положил
+        if (_head.load(std::memory_order_relaxed) == nullptr)
+        {
+            return nullptr;
+        }
+
+        return _head.exchange(nullptr, std::memory_order_acquire);
+    }
+
+    static void *next(
+        void *node) noexcept
+    {
+        return *reinterpret_cast<void**>(node);
+    }
+
+};
+
+#endif //MATH_PRACTICE_AND_OPERATING_SYSTEMS_ALLOCATOR_REMOTE_FREE_QUEUE_H
@@ -0,0 +1,175 @@
+#include "../include/allocator_statistics.h"
+#include <bit>
+
+allocator_statistics::counters::counters(
+    size_t total_bytes) noexcept:
+        _total_bytes(total_bytes),
+        _bytes_in_use(0),
+        _peak_bytes_in_use(0),
+        _largest_free_block(total_bytes),
+        _occupied_blocks(0),
+        _allocations(0),
+        _failed_allocations(0),
+        _deallocations(0),
+        _contended_locks(0),
+        _lock_wait_nanoseconds(0),
+        _remote_frees(0)
+{
+    for (auto &counter : _occupied_blocks_per_size_class)
+    {
+        counter.store(0, std::memory_order_relaxed);
+    }
+}
+
+std::unique_lock<std::mutex> allocator_statistics::counters::lock(
+    std::mutex &mutex) noexcept
+{
+    std::unique_lock<std::mutex> guard(mutex, std::try_to_lock);
+
+    if (!guard.owns_lock())
+    {
+        auto start = std::chrono::steady_clock::now();
+        guard.lock();
+        auto waited = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+
+        add(_contended_locks, 1);
+        add(_lock_wait_nanoseconds, static_cast<size_t>(waited.count()));
+    }
+
+    return guard;
+}
+
+std::unique_lock<std::mutex> allocator_statistics::counters::try_lock(
+    std::mutex &mutex) noexcept
+{
+    return std::unique_lock<std::mutex>(mutex, std::try_to_lock);
+}
+
+void allocator_statistics::counters::on_allocate(
+    size_t block_size) noexcept
+{
+    add(_allocations, 1);
+    add(_bytes_in_use, block_size);
+    if (auto in_use = _bytes_in_use.load(std::memory_order_relaxed); in_use > _peak_bytes_in_use.load(std::memory_order_relaxed))
+    {
+        _peak_bytes_in_use.store(in_use, std::memory_order_relaxed);
+    }
+    add(_occupied_blocks, 1);
+    add(_occupied_blocks_per_size_class[get_size_class(block_size)], 1);
+}
+
+void allocator_statistics::counters::on_deallocate(
+    size_t block_size) noexcept
+{
+    add(_deallocations, 1);
+    subtract(_bytes_in_use, block_size);
+    subtract(_occupied_blocks, 1);
+    subtract(_occupied_blocks_per_size_class[get_size_class(block_size)], 1);
+}
+
+void allocator_statistics::counters::on_failed_allocation() noexcept
+{
+    add(_failed_allocations, 1);
+}
+
+void allocator_statistics::counters::on_remote_free() noexcept
+{
+    add(_remote_frees, 1);
+}
+
+void allocator_statistics::counters::on_allocate_unlocked(
+    size_t block_size) noexcept
+{
+    _allocations.fetch_add(1, std::memory_order_relaxed);
+    auto in_use = _bytes_in_use.fetch_add(block_size, std::memory_order_relaxed) + block_size;
+    auto peak = _peak_bytes_in_use.load(std::memory_order_relaxed);
+    while (in_use > peak && !_peak_bytes_in_use.compare_exchange_weak(peak, in_use, std::memory_order_relaxed))
+    {
+    }
+    _occupied_blocks.fetch_add(1, std::memory_order_relaxed);
+    _occupied_blocks_per_size_class[get_size_class(block_size)].fetch_add(1, std::memory_order_relaxed);
+}
+
+void allocator_statistics::counters::on_deallocate_unlocked(
+    size_t block_size) noexcept
+{
+    _deallocations.fetch_add(1, std::memory_order_relaxed);
+    _bytes_in_use.fetch_sub(block_size, std::memory_order_relaxed);
+    _occupied_blocks.fetch_sub(1, std::memory_order_relaxed);
+    _occupied_blocks_per_size_class[get_size_class(block_size)].fetch_sub(1, std::memory_order_relaxed);
+}
+
+void allocator_statistics::counters::on_failed_allocation_unlocked() noexcept
+{
+    _failed_allocations.fetch_add(1, std::memory_order_relaxed);
+}
+
+void allocator_statistics::counters::set_largest_free_block(
+    size_t size) noexcept
+{
+    _largest_free_block.store(size, std::memory_order_relaxed);
+}
+
+size_t allocator_statistics::counters::get_largest_free_block() const noexcept
+{
+    return _largest_free_block.load(std::memory_order_relaxed);
+}
+
+void allocator_statistics::counters::add_total_bytes(
+    size_t size) noexcept
+{
+    add(_total_bytes, size);
+}
+
+void allocator_statistics::counters::remove_total_bytes(
+    size_t size) noexcept
+{
+    subtract(_total_bytes, size);
+}
+
+allocator_statistics::statistics_snapshot allocator_statistics::counters::snapshot() const noexcept
+{
+    statistics_snapshot result {};
+
+    result.total_bytes = _total_bytes.load(std::memory_order_relaxed);
+    result.bytes_in_use = _bytes_in_use.load(std::memory_order_relaxed);
+    result.peak_bytes_in_use = _peak_bytes_in_use.load(std::memory_order_relaxed);
+    result.free_bytes = result.total_bytes > result.bytes_in_use ? result.total_bytes - result.bytes_in_use : 0;
+    result.largest_free_block = _largest_free_block.load(std::memory_order_relaxed);
+    result.occupied_blocks = _occupied_blocks.load(std::memory_order_relaxed);
+
+    for (size_t size_class = 0; size_class < size_classes_count; ++size_class)
+    {
+        result.occupied_blocks_per_size_class[size_class] = _occupied_blocks_per_size_class[size_class].load(std::memory_order_relaxed);
+    }
+
+    result.allocations = _allocations.load(std::memory_order_relaxed);
+    result.failed_allocations = _failed_allocations.load(std::memory_order_relaxed);
+    result.deallocations = _deallocations.load(std::memory_order_relaxed);
+    result.contended_locks = _contended_locks.load(std::memory_order_relaxed);
+    result.lock_wait_time = std::chrono::nanoseconds(_lock_wait_nanoseconds.load(std::memory_order_relaxed));
+    result.remote_frees = _remote_frees.load(std::memory_order_relaxed);
+
+    return result;
+}
+
+// пишет только владелец блокировки, поэтому атомарное чтение-изменение-запись не нужно
+inline void allocator_statistics::counters::add(
+    std::atomic<size_t> &counter,
+    size_t value) noexcept
+{
+    counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+inline void allocator_statistics::counters::subtract(
+    std::atomic<size_t> &counter,
+    size_t value) noexcept
+{
+    counter.store(counter.load(std::memory_order_relaxed) - value, std::memory_order_relaxed);
+}
+
+inline size_t allocator_statistics::counters::get_size_class(
+    size_t block_size) noexcept
+{
+    return block_size == 0 ? 0 : std::bit_width(block_size) - 1;
+}
@@ -0,0 +1,186 @@
+#include "../include/os_memory_resource.h"
+#include <cstdint>
+#include <new>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    // размер прозрачной большой страницы x86-64 и aarch64 со страницами по 4 КБ
+    constexpr size_t huge_page_size = size_t(1) << 21;
+
+    size_t round_up(
+        size_t value,
+        size_t alignment) noexcept
+    {
+        return (value + alignment - 1) & ~(alignment - 1);
+    }
+}
+
+os_memory_resource::os_memory_resource(
+    bool huge_pages,
+    size_t release_threshold) noexcept:
+        _huge_pages(huge_pages),
+        _release_threshold(release_threshold)
+{
+
+}
+
+size_t os_memory_resource::get_page_size() noexcept
+{
+    static size_t const page_size = []()
+    {
+#ifdef _WIN32
+        SYSTEM_INFO info;
+        GetSystemInfo(&info);
+        return static_cast<size_t>(info.dwPageSize);
+#else
+        return static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#endif
+    }();
+
+    return page_size;
+}
+
+size_t os_memory_resource::get_release_threshold() const noexcept
+{
+    return _release_threshold;
+}
+
+bool os_memory_resource::uses_huge_pages() const noexcept
+{
+    return _huge_pages;
+}
+
+/** On POSIX the mapping is taken bigger by the alignment and the ends are unmapped. Big mappings with huge pages
+ * are aligned to the huge page, otherwise the kernel can not put huge pages at their start.
+ * VirtualAlloc aligns to the allocation granularity (64 KB) and stricter alignments are refused.
+ */
+void *os_memory_resource::do_allocate(
+    size_t bytes,
+    size_t alignment)
+{
+    size_t page_size = get_page_size();
+    size_t size = round_up(bytes == 0 ? 1 : bytes, page_size);
+
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    if (alignment > info.dwAllocationGranularity)
+    {
+        throw std::bad_alloc();
+    }
+
+    // память выделяется в счет лимита коммита, но физические страницы появляются при первом обращении
+    void *memory = VirtualAlloc(nullptr, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    if (memory == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+
+    return memory;
+#else
+    if (_huge_pages && size >= huge_page_size && alignment < huge_page_size)
+    {
+        alignment = huge_page_size;
+    }
+
+    size_t extra = alignment > page_size ? alignment - page_size : 0;
+    if (size > SIZE_MAX - extra)
+    {
+        throw std::bad_alloc();
+    }
+
+    void *mapping = mmap(nullptr, size + extra, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (mapping == MAP_FAILED)
+    {
+        throw std::bad_alloc();
+    }
+
+    auto start = reinterpret_cast<std::uintptr_t>(mapping);
+    auto aligned = round_up(start, alignment > page_size ? alignment : page_size);
+
+    if (aligned != start)
+    {
+        munmap(mapping, aligned - start);
+    }
+    if (size_t tail = start + size + extra - (aligned + size); tail != 0)
+    {
+        munmap(reinterpret_cast<void *>(aligned + size), tail);
+    }
+
+#ifdef MADV_HUGEPAGE
+    if (_huge_pages)
+    {
+        // только совет: без поддержки THP память остается на обычных страницах
+        madvise(reinterpret_cast<void *>(aligned), size, MADV_HUGEPAGE);
+    }
+#endif
+
+    return reinterpret_cast<void *>(aligned);
+#endif
+}
+
+void os_memory_resource::do_deallocate(
+    void *at,
+    size_t bytes,
+    size_t)
+{
+#ifdef _WIN32
+    VirtualFree(at, 0, MEM_RELEASE);
+#else
+    munmap(at, round_up(bytes == 0 ? 1 : bytes, get_page_size()));
+#endif
+}
+
+bool os_memory_resource::do_is_equal(
+    std::pmr::memory_resource const &other) const noexcept
+{
+    // любой экземпляр может освободить отображение другого
+    return dynamic_cast<os_memory_resource const *>(&other) != nullptr;
+}
+
+void os_memory_resource::release_pages(
+    void *from,
+    void *to) const noexcept
+{
+    size_t page_size = get_page_size();
+    auto begin = round_up(reinterpret_cast<std::uintptr_t>(from), page_size);
+    auto end = reinterpret_cast<std::uintptr_t>(to) & ~(page_size - 1);
+
+    if (begin >= end)
+    {
+        return;
+    }
+
+#ifdef _WIN32
+    VirtualAlloc(reinterpret_cast<void *>(begin), end - begin, MEM_RESET, PAGE_READWRITE);
+#else
+    madvise(reinterpret_cast<void *>(begin), end - begin, MADV_DONTNEED);
+#endif
+}
+
+void os_memory_resource::release_free_range(
+    std::pmr::memory_resource *resource,
+    void *from,
+    void *to) noexcept
+{
+    size_t length = reinterpret_cast<std::uintptr_t>(to) - reinterpret_cast<std::uintptr_t>(from);
+
+    // короткие диапазоны отсекаются до dynamic_cast
+    if (resource == nullptr || length < get_page_size())
+    {
+        return;
+    }
+
+    auto *os_resource = dynamic_cast<os_memory_resource *>(resource);
+    if (os_resource != nullptr && length >= os_resource->_release_threshold)
+    {
+        os_resource->release_pages(from, to);
+    }
+}
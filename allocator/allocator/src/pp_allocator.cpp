@@ -3,16 +3,80 @@
 //
 
 #include "pp_allocator.h"
+#include <cstddef>
+#include <cstdint>
 
 
-void smart_mem_resource::do_deallocate(void* p, size_t, size_t)
+void smart_mem_resource::do_deallocate(void* p, size_t bytes, size_t alignment)
+{
+    do_deallocate_sized_sm(p, bytes, alignment);
+}
+
+void smart_mem_resource::do_deallocate_sized_sm(void* p, size_t, size_t)
 {
     do_deallocate_sm(p);
 }
 
 void * smart_mem_resource::do_allocate(size_t _Bytes, size_t _Align)
 {
-    return do_allocate_sm(_Bytes);
+    return do_allocate_aligned_sm(_Bytes, _Align);
+}
+
+void* smart_mem_resource::do_allocate_aligned_sm(size_t bytes, size_t alignment)
+{
+    void* p = do_allocate_sm(bytes);
+
+    if (reinterpret_cast<std::uintptr_t>(p) % alignment != 0)
+    {
+        do_deallocate_sm(p);
+        throw std::bad_alloc();
+    }
+
+    return p;
+}
+
+void smart_mem_resource::do_allocate_batch_sm(size_t bytes, size_t count, void** out, size_t alignment)
+{
+    size_t allocated = 0;
+    try
+    {
+        for (; allocated < count; ++allocated)
+        {
+            out[allocated] = do_allocate_aligned_sm(bytes, alignment);
+        }
+    }
+    catch (...)
+    {
+        for (size_t i = 0; i < allocated; ++i)
+        {
+            do_deallocate_sm(out[i]);
+        }
+        throw;
+    }
+}
+
+void smart_mem_resource::do_deallocate_batch_sm(void* const* blocks, size_t count)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        do_deallocate_sm(blocks[i]);
+    }
+}
+
+void smart_mem_resource::allocate_batch(size_t bytes, size_t count, void** out, size_t alignment)
+{
+    if (count != 0)
+    {
+        do_allocate_batch_sm(bytes, count, out, alignment);
+    }
+}
+
+void smart_mem_resource::deallocate_batch(void* const* blocks, size_t count)
+{
+    if (count != 0)
+    {
+        do_deallocate_batch_sm(blocks, count);
+    }
 }
 
 void* test_mem_resource::do_allocate_sm(size_t n)
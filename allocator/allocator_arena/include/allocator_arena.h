@@ -0,0 +1,120 @@
+#ifndef MATH_PRACTICE_AND_OPERATING_SYSTEMS_ALLOCATOR_ALLOCATOR_ARENA_H
+#define MATH_PRACTICE_AND_OPERATING_SYSTEMS_ALLOCATOR_ALLOCATOR_ARENA_H
+
+#include <pp_allocator.h>
+#include <allocator_logger_guardant.h>
+#include <typename_holder.h>
+#include <cstddef>
+
+/**
+ * Monotonic arena: blocks are cut from the current chunk by moving a pointer, deallocate does nothing and
+ * memory comes back all at once by reset() or by rewinding to a checkpoint. Chunks are taken from
+ * the parent allocator (the global heap if there is none) and chained, so the arena grows on demand.
+ * There is no per-block metadata and no locking, an arena belongs to one thread at a time.
+ * A moved-from arena has no chunks; it may still be used, its first allocation takes a new chunk.
+ */
+class allocator_arena final:
+    public smart_mem_resource,
+    private allocator_logger_guardant,
+    private typename_holder
+{
+
+private:
+
+    // заголовок участка: предыдущий участок, размер участка вместе с заголовком
+    struct chunk_header
+    {
+        chunk_header *prev;
+        size_t size;
+    };
+
+    static constexpr const size_t chunk_header_size = sizeof(chunk_header);
+
+    static constexpr const size_t default_alignment = alignof(std::max_align_t);
+
+    std::pmr::memory_resource *_parent_allocator;
+
+    logger *_logger;
+
+    size_t _chunk_size;
+
+    chunk_header *_current_chunk;
+
+    // занято байт в текущем участке, считая заголовок
+    size_t _offset;
+
+public:
+
+    /**
+     * Position of the arena; rewinding to it frees everything allocated after it was taken
+     */
+    struct checkpoint
+    {
+        void *chunk;
+        size_t offset;
+    };
+
+public:
+
+    explicit allocator_arena(
+        size_t chunk_size = 4096,
+        std::pmr::memory_resource *parent_allocator = nullptr,
+        logger *logger = nullptr);
+
+    allocator_arena(
+        allocator_arena const &other) = delete;
+
+    allocator_arena &operator=(
+        allocator_arena const &other) = delete;
+
+    allocator_arena(
+        allocator_arena &&other) noexcept;
+
+    allocator_arena &operator=(
+        allocator_arena &&other) noexcept;
+
+    ~allocator_arena() override;
+
+public:
+
+    [[nodiscard]] void *do_allocate_sm(
+        size_t size) override;
+
+    [[nodiscard]] void *do_allocate_aligned_sm(
+        size_t size,
+        size_t alignment) override;
+
+    void do_deallocate_sm(
+        void *at) override;
+
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override;
+
+public:
+
+    checkpoint get_checkpoint() const noexcept;
+
+    // gives back everything allocated after the checkpoint, chunks taken after it go back to the parent allocator
+    void rewind(
+        checkpoint const &point);
+
+    // gives back everything, only the first chunk is kept
+    void reset();
+
+private:
+
+    chunk_header *create_chunk(
+        size_t size,
+        chunk_header *prev);
+
+    void release_chunks_after(
+        chunk_header *last_kept);
+
+    void release();
+
+    inline logger *get_logger() const override;
+
+    inline std::string get_typename() const override;
+
+};
+
+#endif //MATH_PRACTICE_AND_OPERATING_SYSTEMS_ALLOCATOR_ALLOCATOR_ARENA_H
@@ -0,0 +1,207 @@
+#include "../include/allocator_arena.h"
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <utility>
+
+using byte = unsigned char;
+
+allocator_arena::allocator_arena(
+    size_t chunk_size,
+    std::pmr::memory_resource *parent_allocator,
+    logger *logger):
+        _parent_allocator(parent_allocator),
+        _logger(logger),
+        _chunk_size(chunk_size < 2 * chunk_header_size ? 2 * chunk_header_size : chunk_size),
+        _current_chunk(nullptr),
+        _offset(chunk_header_size)
+{
+    _current_chunk = create_chunk(_chunk_size, nullptr);
+
+    debug_with_guard("allocator_arena created");
+}
+
+allocator_arena::allocator_arena(
+    allocator_arena &&other) noexcept:
+        _parent_allocator(other._parent_allocator),
+        _logger(other._logger),
+        _chunk_size(other._chunk_size),
+        _current_chunk(std::exchange(other._current_chunk, nullptr)),
+        _offset(other._offset)
+{
+}
+
+allocator_arena &allocator_arena::operator=(
+    allocator_arena &&other) noexcept
+{
+    if (this != &other)
+    {
+        release();
+
+        _parent_allocator = other._parent_allocator;
+        _logger = other._logger;
+        _chunk_size = other._chunk_size;
+        _current_chunk = std::exchange(other._current_chunk, nullptr);
+        _offset = other._offset;
+    }
+
+    return *this;
+}
+
+allocator_arena::~allocator_arena()
+{
+    release();
+}
+
+[[nodiscard]] void *allocator_arena::do_allocate_sm(
+    size_t size)
+{
+    return do_allocate_aligned_sm(size, default_alignment);
+}
+
+[[nodiscard]] void *allocator_arena::do_allocate_aligned_sm(
+    size_t size,
+    size_t alignment)
+{
+    auto chunk_start = reinterpret_cast<std::uintptr_t>(_current_chunk);
+    size_t padding = -(chunk_start + _offset) & (alignment - 1);
+
+    // у перемещенной арены участков нет, первое выделение берет новый
+    size_t available = _current_chunk == nullptr ? 0 : _current_chunk->size - _offset;
+
+    if (_current_chunk == nullptr || padding > available || size > available - padding)
+    {
+        if (size > std::numeric_limits<size_t>::max() - chunk_header_size - alignment)
+        {
+            error_with_guard("Requested size is too big");
+            throw std::bad_alloc();
+        }
+
+        // остаток текущего участка пропадает до rewind/reset
+        trace_with_guard("allocator_arena takes new chunk");
+
+        _current_chunk = create_chunk(std::max(_chunk_size, chunk_header_size + alignment - 1 + size), _current_chunk);
+        _offset = chunk_header_size;
+
+        chunk_start = reinterpret_cast<std::uintptr_t>(_current_chunk);
+        padding = -(chunk_start + _offset) & (alignment - 1);
+    }
+
+    void *block = reinterpret_cast<byte *>(_current_chunk) + _offset + padding;
+    _offset += padding + size;
+
+    return block;
+}
+
+void allocator_arena::do_deallocate_sm(
+    void *)
+{
+}
+
+bool allocator_arena::do_is_equal(const std::pmr::memory_resource &other) const noexcept
+{
+    return this == &other;
+}
+
+allocator_arena::checkpoint allocator_arena::get_checkpoint() const noexcept
+{
+    return { _current_chunk, _offset };
+}
+
+void allocator_arena::rewind(
+    checkpoint const &point)
+{
+    auto *chunk = _current_chunk;
+    while (chunk != nullptr && chunk != point.chunk)
+    {
+        chunk = chunk->prev;
+    }
+
+    if (chunk == nullptr || point.offset < chunk_header_size || point.offset > chunk->size)
+    {
+        error_with_guard("Tried to rewind to checkpoint of another arena");
+        throw std::logic_error("Checkpoint does not belong to allocator_arena");
+    }
+
+    release_chunks_after(chunk);
+
+    _current_chunk = chunk;
+    _offset = point.offset;
+}
+
+void allocator_arena::reset()
+{
+    if (_current_chunk == nullptr)
+    {
+        return;
+    }
+
+    auto *first_chunk = _current_chunk;
+    while (first_chunk->prev != nullptr)
+    {
+        first_chunk = first_chunk->prev;
+    }
+
+    release_chunks_after(first_chunk);
+
+    _current_chunk = first_chunk;
+    _offset = chunk_header_size;
+
+    debug_with_guard("allocator_arena reset");
+}
+
+allocator_arena::chunk_header *allocator_arena::create_chunk(
+    size_t size,
+    chunk_header *prev)
+{
+    void *memory;
+
+    try
+    {
+        memory = _parent_allocator == nullptr
+                ? ::operator new(size)
+                : _parent_allocator->allocate(size);
+    }
+    catch (std::bad_alloc const &)
+    {
+        error_with_guard("allocator_arena can not get new chunk");
+        throw;
+    }
+
+    return new (memory) chunk_header { prev, size };
+}
+
+void allocator_arena::release_chunks_after(
+    chunk_header *last_kept)
+{
+    while (_current_chunk != last_kept)
+    {
+        auto *prev = _current_chunk->prev;
+
+        if (_parent_allocator == nullptr)
+        {
+            ::operator delete(_current_chunk);
+        }
+        else
+        {
+            _parent_allocator->deallocate(_current_chunk, _current_chunk->size);
+        }
+
+        _current_chunk = prev;
+    }
+}
+
+void allocator_arena::release()
+{
+    release_chunks_after(nullptr);
+}
+
+inline logger *allocator_arena::get_logger() const
+{
+    return _logger;
+}
+
+inline std::string allocator_arena::get_typename() const
+{
+    return "allocator_arena";
+}
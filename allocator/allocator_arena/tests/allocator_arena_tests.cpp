@@ -0,0 +1,86 @@
+#include <gtest/gtest.h>
+#include <allocator_arena.h>
+#include <allocator_boundary_tags.h>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+TEST(allocatorArenaPositiveTests, test1)
+{
+    allocator_arena arena(1024);
+
+    auto *first_block = reinterpret_cast<char *>(arena.allocate(sizeof(char) * 10));
+    auto *second_block = reinterpret_cast<char *>(arena.allocate(sizeof(char) * 10, 1));
+    auto *aligned_block = arena.allocate(sizeof(char) * 10, 64);
+
+    ASSERT_EQ(reinterpret_cast<std::uintptr_t>(first_block) % alignof(std::max_align_t), 0);
+    ASSERT_EQ(reinterpret_cast<std::uintptr_t>(aligned_block) % 64, 0);
+    ASSERT_GE(second_block, first_block + 10);
+
+    // блоки больше участка получают свой участок
+    auto *big_block = reinterpret_cast<char *>(arena.allocate(sizeof(char) * 5000));
+    std::memset(big_block, 'a', 5000);
+
+    arena.deallocate(first_block, 10);
+
+    arena.reset();
+
+    ASSERT_EQ(arena.allocate(sizeof(char) * 10), static_cast<void *>(first_block));
+}
+
+TEST(allocatorArenaPositiveTests, test2)
+{
+    allocator_arena arena(256);
+
+    void *kept = arena.allocate(sizeof(char) * 100);
+    auto point = arena.get_checkpoint();
+
+    void *first_after = arena.allocate(sizeof(char) * 100);
+    for (int i = 0; i < 100; ++i)
+    {
+        static_cast<void>(arena.allocate(sizeof(char) * 200));
+    }
+
+    arena.rewind(point);
+
+    ASSERT_EQ(arena.allocate(sizeof(char) * 100), first_after);
+    ASSERT_NE(kept, first_after);
+
+    allocator_arena other(256);
+    ASSERT_THROW(other.rewind(point), std::logic_error);
+
+    // перемещенная арена без участков берет новый при первом выделении
+    allocator_arena moved_to(std::move(other));
+    other.reset();
+    auto *block = reinterpret_cast<char *>(other.allocate(sizeof(char) * 10));
+    std::memset(block, 'a', 10);
+    ASSERT_EQ(reinterpret_cast<std::uintptr_t>(block) % alignof(std::max_align_t), 0);
+}
+
+TEST(allocatorArenaPositiveTests, test3)
+{
+    allocator_boundary_tags parent(100'000, nullptr, nullptr, allocator_with_fit_mode::fit_mode::first_fit);
+
+    {
+        allocator_arena arena(2048, &parent);
+
+        std::vector<int, pp_allocator<int>> numbers{ pp_allocator<int>(&arena) };
+        for (int i = 0; i < 1000; ++i)
+        {
+            numbers.push_back(i);
+        }
+
+        for (int i = 0; i < 1000; ++i)
+        {
+            ASSERT_EQ(numbers[i], i);
+        }
+
+        ASSERT_GT(parent.get_blocks_info().size(), 2);
+    }
+
+    // все участки вернулись родителю
+    auto actual_blocks_state = parent.get_blocks_info();
+
+    ASSERT_EQ(actual_blocks_state.size(), 1);
+    ASSERT_EQ(actual_blocks_state[0].is_block_occupied, false);
+}
@@ -2,36 +2,108 @@
 #define MATH_PRACTICE_AND_OPERATING_SYSTEMS_ALLOCATOR_ALLOCATOR_BOUNDARY_TAGS_H
 
 #include <allocator_test_utils.h>
+#include <allocator_statistics.h>
 #include <allocator_with_fit_mode.h>
+#include <os_memory_resource.h>
 #include <pp_allocator.h>
-#include <logger_guardant.h>
+#include <allocator_logger_guardant.h>
+#include <remote_free_queue.h>
 #include <typename_holder.h>
 #include <iterator>
 #include <mutex>
+#include <algorithm>
+#include <limits>
 
 class allocator_boundary_tags final :
         public smart_mem_resource,
         public allocator_test_utils,
+        public allocator_statistics,
         public allocator_with_fit_mode,
-        private logger_guardant,
+        private allocator_logger_guardant,
         private typename_holder
 {
 
+public:
+
+    /**
+     * Integrity checks of the block chain, see verify(). Both modes run a verify() slice of sampled_verify_blocks
+     * blocks once in sampling_period allocations and deallocations. sampling checks the links of one freed block
+     * in sampling_period, full checks the links of every freed block and poisons freed memory: the bytes of
+     * a free gap past its header hold poison_byte and are checked to be intact when they are handed out again.
+     */
+    enum class integrity_checks
+    {
+        off,
+        sampling,
+        full
+    };
+
+    static constexpr const size_t sampling_period = 1024;
+
+    static constexpr const size_t sampled_verify_blocks = 16;
+
+    static constexpr const unsigned char poison_byte = 0xfd;
+
 private:
 
-    //структура меты: логгер, родительский аллокатор, фит мод, общий размер, указаеть на первый свободный
+    //структура меты: логгер, родительский аллокатор, фит мод, мьютекс, заголовок первого региона (размер,
+    // указатель на первый занятый, следующий регион), размер новых регионов (0 - не растет),
+    // индекс свободных блоков: битовая карта первого уровня, битовые карты второго уровня, головы списков,
+    // мета перемещаемых блоков: таблица хэндлов, ее емкость, первый свободный хэндл, регион и блок,
+    // на которых остановилось уплотнение, регион и блок, на которых остановилась проверка, счетчик операций
+    // до выборочной проверки, режим проверок, очередь освобождений из других потоков (выровнена),
+    // счетчики статистики (выровнены)
+
+    // структура заголовка добавленного региона: размер, указатель на первый занятый, следующий регион
+
+    // структура меты занятого блока: указатель на аллокатор, размер блока, указатель назад и вперед
+
+    // структура меты свободного блока (лежит в начале дыры): размер дыры, указатель назад и вперед по списку
+    // своего класса размеров, указатель на занятый блок слева
+
+    /**
+     * Free gaps are indexed by a two-level segregated list: the first level is floor(log2(size)),
+     * the second one splits each power of two into free_index_second_level_count equal ranges.
+     * The head of every list is its largest gap.
+     */
+    static constexpr const size_t free_index_first_level_count = sizeof(size_t) * 8;
+
+    static constexpr const size_t free_index_second_level_log2 = 3;
 
-    // структура меты занятого блока: размер блока, указатель на начало, указатель вперед и назад
+    static constexpr const size_t free_index_second_level_count = 1 << free_index_second_level_log2;
 
     /**
-     * TODO: You must improve it for alignment support
+     * Gaps of the bin straddling a requested size looked at past its head, see find_free_block()
      */
-    static constexpr const size_t allocator_metadata_size = sizeof(logger*) + sizeof(memory_resource*) + sizeof(allocator_with_fit_mode::fit_mode) +
-                                                            sizeof(size_t) + sizeof(std::mutex) + sizeof(void*);
+    static constexpr const size_t max_free_list_probes = 8;
+
+    static constexpr const size_t remote_frees_offset = (sizeof(logger*) + sizeof(memory_resource*) + sizeof(allocator_with_fit_mode::fit_mode) +
+                                                         sizeof(size_t) + sizeof(std::mutex) + sizeof(void*) + sizeof(void*) + sizeof(size_t) +
+                                                         sizeof(size_t) + free_index_first_level_count * sizeof(unsigned char) +
+                                                         free_index_first_level_count * free_index_second_level_count * sizeof(void*) +
+                                                         sizeof(void**) + sizeof(size_t) + sizeof(size_t) + sizeof(void*) + sizeof(void*) +
+                                                         sizeof(void*) + sizeof(void*) + sizeof(size_t) + sizeof(integrity_checks) +
+                                                         alignof(remote_free_queue) - 1) & ~(alignof(remote_free_queue) - 1);
+
+    static constexpr const size_t counters_offset = (remote_frees_offset + sizeof(remote_free_queue) +
+                                                     alignof(allocator_statistics::counters) - 1) & ~(alignof(allocator_statistics::counters) - 1);
+
+    static constexpr const size_t allocator_metadata_size = counters_offset + sizeof(allocator_statistics::counters);
+
+    static constexpr const size_t region_header_size = sizeof(size_t) + sizeof(void*) + sizeof(void*);
 
     static constexpr const size_t occupied_block_metadata_size = sizeof(size_t) + sizeof(void*) + sizeof(void*) + sizeof(void*);
 
-    static constexpr const size_t free_block_metadata_size = 0;
+    static constexpr const size_t free_block_metadata_size = sizeof(size_t) + sizeof(void*) + sizeof(void*) + sizeof(void*);
+
+    /**
+     * Gaps smaller than this can not hold even an empty block, so they are never indexed
+     */
+    static constexpr const size_t min_indexed_free_block_size = std::max(occupied_block_metadata_size, free_block_metadata_size);
+
+    static constexpr const size_t no_handle = std::numeric_limits<size_t>::max();
+
+    static constexpr const size_t min_handle_table_capacity = 16;
 
     void *_trusted_memory;
 
@@ -51,22 +123,102 @@ public:
 
 public:
 
+    /**
+     * A growable allocator takes one more region of at least space_size bytes from the parent allocator
+     * when no free gap fits a request, and gives a region back as soon as it becomes empty again.
+     * The first region is never given back. All regions share one free index.
+     * With an os_memory_resource as the parent allocator the regions are mapped from the OS and committed
+     * lazily, and the pages of large free gaps are given back to the OS when blocks are freed.
+     */
     explicit allocator_boundary_tags(
             size_t space_size,
             std::pmr::memory_resource *parent_allocator = nullptr,
             logger *log = nullptr,
-            allocator_with_fit_mode::fit_mode allocate_fit_mode = allocator_with_fit_mode::fit_mode::first_fit);
+            allocator_with_fit_mode::fit_mode allocate_fit_mode = allocator_with_fit_mode::fit_mode::first_fit,
+            bool growable = false);
 
 public:
 
     [[nodiscard]] void *do_allocate_sm(
             size_t bytes) override;
 
+    [[nodiscard]] void *do_allocate_aligned_sm(
+            size_t bytes,
+            size_t alignment) override;
+
+    /**
+     * When another thread holds the lock, the block is checked to be this allocator's one and put
+     * into the remote free queue instead of waiting; the next thread to take the lock frees it.
+     * Until then the block is still counted and listed as occupied.
+     */
     void do_deallocate_sm(
             void *at) override;
 
+    /**
+     * The whole batch is carved from one free gap, the blocks lie one after another in it.
+     * When no gap fits them all the blocks are searched one by one, still under one lock.
+     */
+    void do_allocate_batch_sm(
+            size_t bytes,
+            size_t count,
+            void **out,
+            size_t alignment) override;
+
+    void do_deallocate_batch_sm(
+            void *const *blocks,
+            size_t count) override;
+
     bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
 
+public:
+
+    /**
+     * A relocatable block is reached only through its handle, so compact() may move it.
+     * A pointer got from resolve() stays valid until the next compact() call.
+     * Relocatable blocks have no alignment beyond the one of blocks allocated with alignment 1.
+     */
+    enum class handle : size_t {};
+
+    handle allocate_relocatable(
+            size_t size);
+
+    void deallocate_relocatable(
+            handle block_handle);
+
+    void *resolve(
+            handle block_handle) const;
+
+    /**
+     * One slice of compaction: relocatable blocks slide left into the gaps before them, region by region,
+     * the other blocks stay where they are. A slice ends when about max_moved_bytes were moved
+     * (a block passed over costs its metadata), the next slice goes on from there.
+     * Returns true when the pass reached the end of the last region, the next slice starts a new pass.
+     */
+    bool compact(
+            size_t max_moved_bytes);
+
+public:
+
+    /**
+     * Checks are off by default. Switching to full poisons the gaps that are free already,
+     * with an os_memory_resource as the parent allocator this commits their released pages again.
+     */
+    void set_integrity_checks(
+            integrity_checks mode);
+
+    /**
+     * One slice of the integrity pass over the block chain, region by region: every block lies in its region
+     * and belongs to the allocator (a block another thread is still putting into the remote free queue only has
+     * to link inside the allocator), its size and links agree with its neighbours, a relocatable block
+     * is the one its handle points to, every indexed gap has the right size and is linked into the free index,
+     * and in full mode the gaps hold only poison (or zeros, where an os_memory_resource released their pages).
+     * A slice ends after max_checked_blocks blocks, the next slice goes on from there.
+     * Returns true when the pass reached the end of the last region, the next slice starts a new pass.
+     * Throws std::logic_error on the first damage found.
+     */
+    bool verify(
+            size_t max_checked_blocks = std::numeric_limits<size_t>::max());
+
 public:
 
     inline void set_fit_mode(
@@ -75,9 +227,10 @@ public:
 public:
 
     inline size_t get_size() const;
-    void* allocate_first_fit(void* left_elem, size_t size);
-    void* allocate_best_fit(void* left_elem, size_t size);
-    void* allocate_worst_fit(void* left_elem, size_t size);
+    void* allocate_with_fit_mode(allocator_with_fit_mode::fit_mode mode, size_t size, size_t alignment);
+    void* allocate_first_fit(size_t size, size_t alignment = 1);
+    void* allocate_best_fit(size_t size, size_t alignment = 1);
+    void* allocate_worst_fit(size_t size, size_t alignment = 1);
 
     inline void* get_prev_existing_block(void* right_elem) const;
     inline size_t get_block_data_size(void* block) const;
@@ -89,14 +242,105 @@ public:
     inline void* get_first_block() const noexcept;
     inline void **get_first_block_ptr() const noexcept;
 
+    inline std::pmr::memory_resource *get_parent_allocator() const noexcept;
+    inline void *get_main_region() const noexcept;
+    inline void **get_next_region_ptr() const noexcept;
+    inline size_t *get_growth_size_ptr() const noexcept;
+    inline size_t get_region_size(void* region) const noexcept;
+    inline void **get_region_first_block_ptr(void* region) const noexcept;
+    inline void **get_region_next_ptr(void* region) const noexcept;
+    inline void *get_region_start(void* region) const noexcept;
+    inline void *get_region_end(void* region) const noexcept;
+    void *find_region(void* address) const noexcept;
+    bool add_region(size_t size, size_t alignment);
+    void release_region(void* region);
+    void release_memory();
+
+    inline size_t *get_free_first_level_bitmap() const noexcept;
+    inline unsigned char *get_free_second_level_bitmaps() const noexcept;
+    inline void **get_free_list_head(size_t first_level, size_t second_level) const noexcept;
+    static inline void free_index_mapping(size_t size, size_t &first_level, size_t &second_level) noexcept;
+
+    inline size_t get_free_block_size(void* free_block) const noexcept;
+    inline void *&get_free_block_prev(void* free_block) const noexcept;
+    inline void *&get_free_block_next(void* free_block) const noexcept;
+    inline void *&get_free_block_left_occupied(void* free_block) const noexcept;
+
+    void insert_free_block(void* free_block, size_t size, void* left_occupied);
+    void remove_free_block(void* free_block);
+    void* find_free_block(size_t size, allocator_with_fit_mode::fit_mode mode) const;
+    void* probe_free_list(size_t first_level, size_t second_level, size_t needed, allocator_with_fit_mode::fit_mode mode) const;
+    void* get_largest_free_block() const noexcept;
+    size_t get_largest_free_block_size() const noexcept;
+    inline allocator_statistics::counters &get_counters() const noexcept;
+    void* allocate_from_free_block(void* free_block, size_t size, size_t alignment);
+
+    // allocates or throws std::bad_alloc under the lock taken by the caller
+    void* allocate_block(size_t size, size_t alignment);
+
+    // frees a block under the lock taken by the caller
+    void deallocate_block(void* at);
+
+    inline remote_free_queue &get_remote_frees() const noexcept;
+
+    // frees the blocks other threads queued, under the lock taken by the caller
+    void drain_remote_frees();
+
+    std::unique_lock<std::mutex> lock_and_drain();
+
+    // queues a block of this allocator without the lock, the link replaces the allocator pointer in its meta
+    bool defer_deallocation(void* at);
+
+    inline void **&get_handle_table() const noexcept;
+    inline size_t &get_handle_table_capacity() const noexcept;
+    inline size_t &get_free_handle() const noexcept;
+    inline void *&get_compaction_region() const noexcept;
+    inline void *&get_compaction_block() const noexcept;
+
+    // relocatable blocks keep the allocator pointer with the lowest bit set, their data starts with the handle
+    inline void *get_relocatable_tag() const noexcept;
+    void grow_handle_table();
+    void *get_relocatable_block(handle block_handle) const;
+    size_t move_block(void* block, void* to, void* left, void* region);
+
+    inline void *&get_verify_region() const noexcept;
+    inline void *&get_verify_block() const noexcept;
+    inline size_t &get_sampling_countdown() const noexcept;
+    inline integrity_checks &get_integrity_checks() const noexcept;
+
+    // counts an allocation or deallocation of a block, true when the checks are due on it
+    inline bool is_check_due() noexcept;
+
+    // the verify() slice due after an operation, under the lock taken by the caller
+    void verify_if_due();
+    [[noreturn]] void report_corruption(std::string const &what);
+    void check_block_links(void* block);
+    void check_free_gap(void* gap_start, void* gap_end, void* left);
+    void check_poison(void* from, void* to);
+    void poison_free_gaps();
+
+    // verify() slice under the lock taken by the caller
+    bool verify_blocks(size_t max_checked_blocks);
+
 
     std::vector<allocator_test_utils::block_info> get_blocks_info() const override;
-    inline std::mutex* get_mutex();
+    inline std::mutex* get_mutex() const;
+
+    statistics_snapshot get_statistics() const noexcept override;
+
+    size_t get_regions_count() const;
+
+    // regions are numbered from the first one, then from the most recently added one
+    std::vector<allocator_test_utils::block_info> get_region_blocks_info(size_t region_index) const;
 
 private:
 
     std::vector<allocator_test_utils::block_info> get_blocks_info_inner() const override;
 
+    void get_region_blocks_info_inner(void* region, std::vector<allocator_test_utils::block_info> &result) const;
+
+    size_t get_free_size_inner() const;
+
 /** TODO: Highly recommended for helper functions to return references */
 
     inline logger *get_logger() const override;
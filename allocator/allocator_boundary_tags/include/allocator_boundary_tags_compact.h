@@ -0,0 +1,208 @@
+#ifndef MATH_PRACTICE_AND_OPERATING_SYSTEMS_ALLOCATOR_ALLOCATOR_BOUNDARY_TAGS_COMPACT_H
+#define MATH_PRACTICE_AND_OPERATING_SYSTEMS_ALLOCATOR_ALLOCATOR_BOUNDARY_TAGS_COMPACT_H
+
+#include <allocator_test_utils.h>
+#include <allocator_statistics.h>
+#include <allocator_with_fit_mode.h>
+#include <pp_allocator.h>
+#include <allocator_logger_guardant.h>
+#include <remote_free_queue.h>
+#include <typename_holder.h>
+#include <cstdint>
+#include <limits>
+#include <mutex>
+
+/**
+ * Boundary tags with an 8-byte header on every block: the block size with two flags in its low bits,
+ * whether the block is occupied and whether the block before it is. Only a free block has a footer
+ * with its size, so a freed block finds a free left neighbour through it and an occupied one is never
+ * looked at. Free blocks are kept in the same two-level segregated lists as in allocator_boundary_tags,
+ * with the largest block of a list at its head, linked by 32-bit offsets from the trusted memory in units of block_granularity.
+ * Block sizes are multiples of block_granularity and the data is aligned as std::max_align_t.
+ * A block costs its header and the rounding, against 32 bytes of metadata in allocator_boundary_tags.
+ * The allocator does not grow, and a block can not be checked to belong to it beyond its address and flags.
+ * A free that finds the lock taken puts the block into the remote free queue and the next thread to take
+ * the lock frees it. Such a free marks the block as queued in its header with a compare-and-swap, so a block
+ * that is not occupied or is queued already is rejected at once, like a double free under the lock. The lock
+ * holder changes the flag of the left neighbour in the header of an occupied block atomically too. The link
+ * is put where a free block has nothing; the rest of the checks are made when the queue is drained.
+ */
+class allocator_boundary_tags_compact final :
+        public smart_mem_resource,
+        public allocator_test_utils,
+        public allocator_statistics,
+        public allocator_with_fit_mode,
+        private allocator_logger_guardant,
+        private typename_holder
+{
+
+private:
+
+    using block_header = size_t;
+
+    using free_block_link = uint32_t;
+
+    static constexpr const free_block_link no_free_block = std::numeric_limits<free_block_link>::max();
+
+    static constexpr const size_t block_granularity = 16;
+
+    static constexpr const block_header occupied_flag = 1;
+
+    static constexpr const block_header prev_occupied_flag = 2;
+
+    // занятый блок уже лежит в очереди освобождений
+    static constexpr const block_header pending_flag = 4;
+
+    static constexpr const block_header flags_mask = occupied_flag | prev_occupied_flag | pending_flag;
+
+    static_assert(flags_mask < block_granularity, "flags must fit below the block size");
+
+    static constexpr const size_t block_header_size = sizeof(block_header);
+
+    // свободный блок: заголовок, предыдущий и следующий в списке своего класса, в конце - размер
+    static constexpr const size_t min_block_size =
+            (block_header_size + 2 * sizeof(free_block_link) + sizeof(size_t) + block_granularity - 1) & ~(block_granularity - 1);
+
+    // ссылка отложенного блока лежит за ссылками списка и до футера, свободный блок там ничего не хранит
+    static constexpr const size_t remote_free_link_offset = block_header_size + 2 * sizeof(free_block_link);
+
+    static_assert(remote_free_link_offset + sizeof(void*) <= min_block_size - sizeof(size_t), "a queued block must hold its link");
+
+    static constexpr const size_t free_index_first_level_count = sizeof(size_t) * 8;
+
+    static constexpr const size_t free_index_second_level_log2 = 3;
+
+    static constexpr const size_t free_index_second_level_count = 1 << free_index_second_level_log2;
+
+    static constexpr const size_t max_free_list_probes = 8;
+
+    // мета: логгер, родительский аллокатор, фит мод, размер пространства, мьютекс, битовая карта первого уровня,
+    // битовые карты второго уровня, головы списков, очередь освобождений из других потоков (выровнена),
+    // счетчики статистики (выровнены);
+    // пространство начинается так, чтобы данные за заголовками были выровнены на block_granularity,
+    // за последним блоком лежит заголовок-ограничитель без размера
+    static constexpr const size_t space_size_offset =
+            sizeof(logger*) + sizeof(std::pmr::memory_resource*) + sizeof(fit_mode);
+
+    static constexpr const size_t mutex_offset =
+            (space_size_offset + sizeof(size_t) + alignof(std::mutex) - 1) & ~(alignof(std::mutex) - 1);
+
+    static constexpr const size_t free_index_offset = mutex_offset + sizeof(std::mutex);
+
+    static constexpr const size_t free_heads_offset =
+            free_index_offset + sizeof(size_t) + free_index_first_level_count * sizeof(unsigned char);
+
+    static constexpr const size_t remote_frees_offset =
+            (free_heads_offset + free_index_first_level_count * free_index_second_level_count * sizeof(free_block_link) +
+             alignof(remote_free_queue) - 1) & ~(alignof(remote_free_queue) - 1);
+
+    static constexpr const size_t counters_offset =
+            (remote_frees_offset + sizeof(remote_free_queue) +
+             alignof(allocator_statistics::counters) - 1) & ~(alignof(allocator_statistics::counters) - 1);
+
+    static constexpr const size_t space_offset =
+            ((counters_offset + sizeof(allocator_statistics::counters) + block_granularity - 1) & ~(block_granularity - 1)) +
+            block_granularity - block_header_size;
+
+    void *_trusted_memory;
+
+public:
+
+    explicit allocator_boundary_tags_compact(
+            size_t space_size,
+            std::pmr::memory_resource *parent_allocator = nullptr,
+            logger *log = nullptr,
+            allocator_with_fit_mode::fit_mode allocate_fit_mode = allocator_with_fit_mode::fit_mode::first_fit);
+
+    allocator_boundary_tags_compact(allocator_boundary_tags_compact const &other) = delete;
+
+    allocator_boundary_tags_compact &operator=(allocator_boundary_tags_compact const &other) = delete;
+
+    allocator_boundary_tags_compact(
+            allocator_boundary_tags_compact &&other) noexcept;
+
+    allocator_boundary_tags_compact &operator=(
+            allocator_boundary_tags_compact &&other) noexcept;
+
+    ~allocator_boundary_tags_compact() override;
+
+public:
+
+    [[nodiscard]] void *do_allocate_sm(
+            size_t bytes) override;
+
+    [[nodiscard]] void *do_allocate_aligned_sm(
+            size_t bytes,
+            size_t alignment) override;
+
+    void do_deallocate_sm(
+            void *at) override;
+
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override;
+
+    void set_fit_mode(
+            allocator_with_fit_mode::fit_mode mode) override;
+
+    std::vector<allocator_test_utils::block_info> get_blocks_info() const override;
+
+    statistics_snapshot get_statistics() const noexcept override;
+
+private:
+
+    std::vector<allocator_test_utils::block_info> get_blocks_info_inner() const override;
+
+    inline logger *get_logger() const override;
+
+    inline std::string get_typename() const noexcept override;
+
+    void release_memory() noexcept;
+
+    inline std::pmr::memory_resource *get_parent_allocator() const noexcept;
+    inline allocator_with_fit_mode::fit_mode get_fit_mode() const noexcept;
+    inline size_t get_space_size() const noexcept;
+    inline std::mutex &get_mutex() const noexcept;
+    inline allocator_statistics::counters &get_counters() const noexcept;
+    inline remote_free_queue &get_remote_frees() const noexcept;
+    inline unsigned char *get_space_start() const noexcept;
+    inline unsigned char *get_space_end() const noexcept;
+
+    static inline block_header &get_header(void *block) noexcept;
+
+    // the header of an occupied block may be marked as queued by another thread at the same time
+    static inline block_header load_header(void *block) noexcept;
+    static inline size_t get_block_size(void *block) noexcept;
+    static inline size_t &get_footer(void *block, size_t size) noexcept;
+    static inline free_block_link &get_free_block_prev(void *block) noexcept;
+    static inline free_block_link &get_free_block_next(void *block) noexcept;
+
+    inline free_block_link get_link(void *block) const noexcept;
+    inline unsigned char *get_linked_block(free_block_link link) const noexcept;
+
+    inline size_t *get_free_first_level_bitmap() const noexcept;
+    inline unsigned char *get_free_second_level_bitmaps() const noexcept;
+    inline free_block_link *get_free_list_head(size_t first_level, size_t second_level) const noexcept;
+    static inline void free_index_mapping(size_t size, size_t &first_level, size_t &second_level) noexcept;
+
+    // a free block with its header and footer written, the flag of the previous block is kept
+    void insert_free_block(void *block, size_t size);
+    void remove_free_block(void *block);
+    void *find_free_block(size_t size, allocator_with_fit_mode::fit_mode mode) const;
+    unsigned char *probe_free_list(size_t first_level, size_t second_level, size_t size, allocator_with_fit_mode::fit_mode mode) const;
+    unsigned char *get_largest_free_block() const noexcept;
+    size_t get_largest_free_block_size() const noexcept;
+
+    void *allocate_from_free_block(void *block, size_t size, size_t alignment);
+
+    // frees a block under the lock taken by the caller
+    void deallocate_block(void *at);
+
+    // frees the blocks other threads queued, under the lock taken by the caller
+    void drain_remote_frees();
+
+    std::unique_lock<std::mutex> lock_and_drain();
+
+    // queues a block inside the space without the lock, false if the address is not inside the space
+    bool defer_deallocation(void *at);
+};
+
+#endif //MATH_PRACTICE_AND_OPERATING_SYSTEMS_ALLOCATOR_ALLOCATOR_BOUNDARY_TAGS_COMPACT_H
@@ -1,5 +1,10 @@
 #include <not_implemented.h>
 #include "../include/allocator_boundary_tags.h"
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <thread>
 
 
 using byte = unsigned char;
@@ -7,9 +12,67 @@ using byte = unsigned char;
 
 allocator_boundary_tags::~allocator_boundary_tags()
 {
-    debug_with_guard("Called allocator destructor");
-    (*get_mutex()).~mutex();
-    ::operator delete(_trusted_memory);
+    if (_trusted_memory != nullptr)
+    {
+        debug_with_guard("Called allocator destructor");
+    }
+    release_memory();
+}
+
+/** Gives every region back to the parent allocator, occupied blocks included
+ */
+void allocator_boundary_tags::release_memory()
+{
+    if (_trusted_memory == nullptr)
+    {
+        return;
+    }
+
+    std::pmr::memory_resource* parent_allocator = get_parent_allocator();
+
+    void* region = *get_next_region_ptr();
+    while (region != nullptr)
+    {
+        void* next_region = *get_region_next_ptr(region);
+        size_t region_memory_size = region_header_size + get_region_size(region);
+
+        if (parent_allocator == nullptr)
+        {
+            ::operator delete(region);
+        }
+        else
+        {
+            parent_allocator->deallocate(region, region_memory_size);
+        }
+
+        region = next_region;
+    }
+
+    if (get_handle_table() != nullptr)
+    {
+        if (parent_allocator == nullptr)
+        {
+            ::operator delete(get_handle_table());
+        }
+        else
+        {
+            parent_allocator->deallocate(get_handle_table(), get_handle_table_capacity() * sizeof(void*));
+        }
+    }
+
+    size_t memory_size = allocator_metadata_size + get_size();
+    get_mutex()->~mutex();
+
+    if (parent_allocator == nullptr)
+    {
+        ::operator delete(_trusted_memory);
+    }
+    else
+    {
+        parent_allocator->deallocate(_trusted_memory, memory_size);
+    }
+
+    _trusted_memory = nullptr;
 }
 
 allocator_boundary_tags::allocator_boundary_tags(
@@ -21,16 +84,14 @@ allocator_boundary_tags::allocator_boundary_tags(
     debug_with_guard("move copy finish");
 }
 
-inline std::mutex* allocator_boundary_tags::get_mutex()
+inline std::mutex* allocator_boundary_tags::get_mutex() const
 {
-    trace_with_guard("started getting mutex");
     unsigned char* ptr = reinterpret_cast<unsigned char*>(_trusted_memory);
 
     ptr += sizeof(class logger*);
     ptr += sizeof(allocator_dbg_helper*);
     ptr += sizeof(allocator_boundary_tags::fit_mode);
 
-    trace_with_guard("ended getting mutex");
     return reinterpret_cast<std::mutex*>(ptr);
 }
 
@@ -43,7 +104,7 @@ allocator_boundary_tags &allocator_boundary_tags::operator=(
         if (_trusted_memory)
         {
             debug_with_guard("deleting old memory");
-            ::operator delete(_trusted_memory);
+            release_memory();
         }
         _trusted_memory = other._trusted_memory;
         other._trusted_memory = nullptr;
@@ -59,7 +120,8 @@ allocator_boundary_tags::allocator_boundary_tags(
         size_t space_size,
         std::pmr::memory_resource *parent_allocator,
         logger *log,
-        allocator_with_fit_mode::fit_mode allocate_fit_mode)
+        allocator_with_fit_mode::fit_mode allocate_fit_mode,
+        bool growable)
 {
     size_t memory_size = space_size + allocator_metadata_size;
     void * memory;
@@ -99,13 +161,226 @@ allocator_boundary_tags::allocator_boundary_tags(
 
     *reinterpret_cast<void**>(ptr) = nullptr;
     ptr += sizeof(void*);
+
+    *reinterpret_cast<void**>(ptr) = nullptr;
+    ptr += sizeof(void*);
+
+    *reinterpret_cast<size_t*>(ptr) = growable ? space_size : 0;
+    ptr += sizeof(size_t);
+
+    *reinterpret_cast<size_t*>(ptr) = 0;
+    ptr += sizeof(size_t);
+
+    std::memset(ptr, 0, free_index_first_level_count * sizeof(unsigned char));
+    ptr += free_index_first_level_count * sizeof(unsigned char);
+
+    std::memset(ptr, 0, free_index_first_level_count * free_index_second_level_count * sizeof(void*));
+
+    get_handle_table() = nullptr;
+    get_handle_table_capacity() = 0;
+    get_free_handle() = no_handle;
+    get_compaction_region() = get_main_region();
+    get_compaction_block() = nullptr;
+    get_verify_region() = get_main_region();
+    get_verify_block() = nullptr;
+    get_sampling_countdown() = sampling_period;
+    get_integrity_checks() = integrity_checks::off;
+
+    new (reinterpret_cast<byte*>(_trusted_memory) + remote_frees_offset) remote_free_queue;
+
+    new (reinterpret_cast<byte*>(_trusted_memory) + counters_offset) allocator_statistics::counters(space_size);
+
+    insert_free_block(get_first_block(), space_size, nullptr);
 }
 
 inline void **allocator_boundary_tags::get_first_block_ptr() const noexcept
 {
-    byte *ptr = (reinterpret_cast<byte*>(_trusted_memory)) + allocator_metadata_size - sizeof(void *);
+    byte *ptr = reinterpret_cast<byte*>(_trusted_memory);
+
+    ptr += sizeof(class logger*);
+    ptr += sizeof(memory_resource*);
+    ptr += sizeof(allocator_with_fit_mode::fit_mode);
+    ptr += sizeof(std::mutex);
+    ptr += sizeof(size_t);
+
     return reinterpret_cast<void**>(ptr);
 }
+
+inline void **allocator_boundary_tags::get_next_region_ptr() const noexcept
+{
+    return get_first_block_ptr() + 1;
+}
+
+inline size_t *allocator_boundary_tags::get_growth_size_ptr() const noexcept
+{
+    return reinterpret_cast<size_t*>(get_first_block_ptr() + 2);
+}
+
+inline size_t *allocator_boundary_tags::get_free_first_level_bitmap() const noexcept
+{
+    return reinterpret_cast<size_t*>(get_first_block_ptr() + 3);
+}
+
+inline allocator_statistics::counters &allocator_boundary_tags::get_counters() const noexcept
+{
+    return *reinterpret_cast<allocator_statistics::counters*>(reinterpret_cast<byte*>(_trusted_memory) + counters_offset);
+}
+
+inline remote_free_queue &allocator_boundary_tags::get_remote_frees() const noexcept
+{
+    return *reinterpret_cast<remote_free_queue*>(reinterpret_cast<byte*>(_trusted_memory) + remote_frees_offset);
+}
+
+inline std::pmr::memory_resource *allocator_boundary_tags::get_parent_allocator() const noexcept
+{
+    return *reinterpret_cast<std::pmr::memory_resource**>(reinterpret_cast<byte*>(_trusted_memory) + sizeof(class logger*));
+}
+
+// заголовок первого региона лежит в мете: размер, указатель на первый занятый, следующий регион
+inline void *allocator_boundary_tags::get_main_region() const noexcept
+{
+    return reinterpret_cast<byte*>(get_first_block_ptr()) - sizeof(size_t);
+}
+
+inline size_t allocator_boundary_tags::get_region_size(void* region) const noexcept
+{
+    return *reinterpret_cast<size_t*>(region);
+}
+
+inline void **allocator_boundary_tags::get_region_first_block_ptr(void* region) const noexcept
+{
+    return reinterpret_cast<void**>(reinterpret_cast<byte*>(region) + sizeof(size_t));
+}
+
+inline void **allocator_boundary_tags::get_region_next_ptr(void* region) const noexcept
+{
+    return reinterpret_cast<void**>(reinterpret_cast<byte*>(region) + sizeof(size_t) + sizeof(void*));
+}
+
+inline void *allocator_boundary_tags::get_region_start(void* region) const noexcept
+{
+    return region == get_main_region() ? get_first_block() : slide_block_for(region, region_header_size);
+}
+
+inline void *allocator_boundary_tags::get_region_end(void* region) const noexcept
+{
+    return slide_block_for(get_region_start(region), get_region_size(region));
+}
+
+void *allocator_boundary_tags::find_region(void* address) const noexcept
+{
+    for (void* region = get_main_region(); region != nullptr; region = *get_region_next_ptr(region))
+    {
+        if (address >= get_region_start(region) && address < get_region_end(region))
+        {
+            return region;
+        }
+    }
+
+    return nullptr;
+}
+
+/** The new region is sized to hold the request even if it is bigger than the usual region
+ */
+bool allocator_boundary_tags::add_region(size_t size, size_t alignment)
+{
+    size_t growth_size = *get_growth_size_ptr();
+
+    if (growth_size == 0 ||
+        size > std::numeric_limits<size_t>::max() / 2 - alignment - occupied_block_metadata_size - region_header_size)
+    {
+        return false;
+    }
+
+    size_t region_size = std::max({ growth_size, size + alignment - 1 + occupied_block_metadata_size, min_indexed_free_block_size });
+    std::pmr::memory_resource* parent_allocator = get_parent_allocator();
+    void* region;
+
+    try
+    {
+        region = parent_allocator == nullptr
+                ? ::operator new(region_header_size + region_size)
+                : parent_allocator->allocate(region_header_size + region_size);
+    }
+    catch (std::bad_alloc const &)
+    {
+        error_with_guard("Can not get new region from parent allocator");
+        return false;
+    }
+
+    *reinterpret_cast<size_t*>(region) = region_size;
+    *get_region_first_block_ptr(region) = nullptr;
+    *get_region_next_ptr(region) = *get_next_region_ptr();
+    *get_next_region_ptr() = region;
+
+    insert_free_block(get_region_start(region), region_size, nullptr);
+    get_counters().add_total_bytes(region_size);
+
+    if (get_integrity_checks() == integrity_checks::full)
+    {
+        std::memset(slide_block_for(get_region_start(region), free_block_metadata_size), poison_byte, region_size - free_block_metadata_size);
+    }
+
+    if (is_enabled_with_guard(logger::severity::debug))
+    {
+        debug_with_guard("Added region of " + std::to_string(region_size) + " bytes");
+    }
+
+    return true;
+}
+
+/** The region must be empty, its only gap is taken out of the free index
+ */
+void allocator_boundary_tags::release_region(void* region)
+{
+    remove_free_block(get_region_start(region));
+
+    void** link = get_next_region_ptr();
+    while (*link != region)
+    {
+        link = get_region_next_ptr(*link);
+    }
+    *link = *get_region_next_ptr(region);
+
+    get_counters().remove_total_bytes(get_region_size(region));
+
+    if (get_compaction_region() == region)
+    {
+        get_compaction_region() = get_main_region();
+        get_compaction_block() = nullptr;
+    }
+
+    if (get_verify_region() == region)
+    {
+        get_verify_region() = get_main_region();
+        get_verify_block() = nullptr;
+    }
+
+    size_t region_memory_size = region_header_size + get_region_size(region);
+    std::pmr::memory_resource* parent_allocator = get_parent_allocator();
+
+    if (parent_allocator == nullptr)
+    {
+        ::operator delete(region);
+    }
+    else
+    {
+        parent_allocator->deallocate(region, region_memory_size);
+    }
+
+    debug_with_guard("Gave empty region back");
+}
+
+inline unsigned char *allocator_boundary_tags::get_free_second_level_bitmaps() const noexcept
+{
+    return reinterpret_cast<unsigned char*>(get_free_first_level_bitmap() + 1);
+}
+
+inline void **allocator_boundary_tags::get_free_list_head(size_t first_level, size_t second_level) const noexcept
+{
+    void **heads = reinterpret_cast<void**>(get_free_second_level_bitmaps() + free_index_first_level_count);
+    return heads + first_level * free_index_second_level_count + second_level;
+}
 inline void* allocator_boundary_tags::get_first_block() const noexcept
 {
     byte* ptr = (reinterpret_cast<byte*>(_trusted_memory)) + allocator_metadata_size;
@@ -114,58 +389,88 @@ inline void* allocator_boundary_tags::get_first_block() const noexcept
 
 [[nodiscard]] void* allocator_boundary_tags::do_allocate_sm(size_t size)
 {
+    return do_allocate_aligned_sm(size, 1);
+}
 
-    size_t total_size = size + occupied_block_metadata_size;
-
+[[nodiscard]] void* allocator_boundary_tags::do_allocate_aligned_sm(size_t size, size_t alignment)
+{
     debug_with_guard("do_allocate_sm start");
 
-    std::lock_guard<std::mutex> lock(*get_mutex());
+    auto lock = lock_and_drain();
+
+    void* memory = allocate_block(size, alignment);
+    verify_if_due();
+
+    return memory;
+}
+
+void* allocator_boundary_tags::allocate_block(size_t size, size_t alignment)
+{
+    allocator_with_fit_mode::fit_mode mode = get_fit_mode();
+    void* memory = allocate_with_fit_mode(mode, size, alignment);
 
-    void** first_block = get_first_block_ptr();
+    if (memory == nullptr && add_region(size, alignment))
+    {
+        memory = allocate_with_fit_mode(mode, size, alignment);
+    }
 
-    byte* ptr;
-    if (*first_block == nullptr)
+    if (memory != nullptr)
     {
-        ptr = reinterpret_cast<byte*>(_trusted_memory) + allocator_metadata_size;
-        size_t size_block = get_size();
+        get_counters().on_allocate(get_block_data_size(reinterpret_cast<byte*>(memory) - occupied_block_metadata_size) + occupied_block_metadata_size);
+        get_counters().set_largest_free_block(get_largest_free_block_size());
 
-        if (size_block < total_size)
+        // выделения считаются в выборке наравне с освобождениями
+        is_check_due();
+
+        // сообщения собираются только если их есть кому записать
+        if (is_enabled_with_guard(logger::severity::debug))
         {
-            error_with_guard("Try to allocate " +
-                             std::to_string(total_size) + " from " + std::to_string(size));
-            throw std::bad_alloc();
+            debug_with_guard("Successfully allocated " + std::to_string(size) +
+                             " bytes with metadata size " +
+                             std::to_string(occupied_block_metadata_size));
         }
+        if (is_enabled_with_guard(logger::severity::information))
+        {
+            information_with_guard("Available free memory after allocation: " + std::to_string(get_free_size_inner()));
+        }
+        return memory;
+    }
+    else
+    {
+        get_counters().on_failed_allocation();
 
-        *first_block = ptr;
-
-        debug_with_guard("Allocating first block of size " + std::to_string(size));
-
-        return create_block_meta(reinterpret_cast<void*>(ptr),
-                                 total_size - occupied_block_metadata_size,
-                                 nullptr,
-                                 nullptr);
+        if (is_enabled_with_guard(logger::severity::error))
+        {
+            error_with_guard("Allocation failed for size " + std::to_string(size));
+        }
+        throw std::bad_alloc();
     }
+}
 
-    allocator_with_fit_mode::fit_mode mode = get_fit_mode();
+
+void* allocator_boundary_tags::allocate_with_fit_mode(allocator_with_fit_mode::fit_mode mode, size_t size, size_t alignment)
+{
     void* memory = nullptr;
 
     switch (mode)
     {
+        // своего указателя для next_fit нет, поиск идет как в first_fit
+        case allocator_with_fit_mode::fit_mode::next_fit:
         case allocator_with_fit_mode::fit_mode::first_fit:
             trace_with_guard("Started allocation with first_fit");
-            memory = allocate_first_fit(*first_block, size);
+            memory = allocate_first_fit(size, alignment);
             trace_with_guard("Ended allocation with first_fit");
             break;
 
         case allocator_with_fit_mode::fit_mode::the_best_fit:
             trace_with_guard("Started allocation with the_best_fit");
-            memory = allocate_best_fit(*first_block, size);
+            memory = allocate_best_fit(size, alignment);
             trace_with_guard("Ended allocation with the_best_fit");
             break;
 
         case allocator_with_fit_mode::fit_mode::the_worst_fit:
             trace_with_guard("Started allocation with the_worst_fit");
-            memory = allocate_worst_fit(*first_block, size);
+            memory = allocate_worst_fit(size, alignment);
             trace_with_guard("Ended allocation with the_worst_fit");
             break;
 
@@ -174,388 +479,1353 @@ inline void* allocator_boundary_tags::get_first_block() const noexcept
             throw std::runtime_error("Unknown fit mode");
     }
 
-    if (memory != nullptr)
-    {
-        debug_with_guard("Successfully allocated " + std::to_string(size) +
-                         " bytes with metadata size " +
-                         std::to_string(occupied_block_metadata_size));
-        get_blocks_info();
-        information_with_guard("Available free memory after allocation");
-        return memory;
-    }
-    else
-    {
-        error_with_guard("Allocation failed for size " + std::to_string(size));
-        throw std::bad_alloc();
-    }
+    return memory;
+}
+
+void* allocator_boundary_tags::allocate_first_fit(size_t size, size_t alignment)
+{
+    if (size > std::numeric_limits<size_t>::max() - alignment)
+    {
+        return nullptr;
+    }
+
+    void* free_block = find_free_block(size + alignment - 1, allocator_with_fit_mode::fit_mode::first_fit);
+    return free_block == nullptr ? nullptr : allocate_from_free_block(free_block, size, alignment);
+}
+
+
+void* allocator_boundary_tags::allocate_best_fit(size_t size, size_t alignment)
+{
+    if (size > std::numeric_limits<size_t>::max() - alignment)
+    {
+        return nullptr;
+    }
+
+    void* free_block = find_free_block(size + alignment - 1, allocator_with_fit_mode::fit_mode::the_best_fit);
+    return free_block == nullptr ? nullptr : allocate_from_free_block(free_block, size, alignment);
+}
+
+void* allocator_boundary_tags::allocate_worst_fit(size_t size, size_t alignment)
+{
+    if (size > std::numeric_limits<size_t>::max() - alignment)
+    {
+        return nullptr;
+    }
+
+    void* free_block = find_free_block(size + alignment - 1, allocator_with_fit_mode::fit_mode::the_worst_fit);
+    return free_block == nullptr ? nullptr : allocate_from_free_block(free_block, size, alignment);
+}
+
+inline void allocator_boundary_tags::free_index_mapping(size_t size, size_t &first_level, size_t &second_level) noexcept
+{
+    first_level = std::bit_width(size) - 1;
+    second_level = (size >> (first_level - free_index_second_level_log2)) & (free_index_second_level_count - 1);
+}
+
+inline size_t allocator_boundary_tags::get_free_block_size(void* free_block) const noexcept
+{
+    return *reinterpret_cast<size_t*>(free_block);
+}
+
+inline void *&allocator_boundary_tags::get_free_block_prev(void* free_block) const noexcept
+{
+    return *reinterpret_cast<void**>(reinterpret_cast<byte*>(free_block) + sizeof(size_t));
+}
+
+inline void *&allocator_boundary_tags::get_free_block_next(void* free_block) const noexcept
+{
+    return *reinterpret_cast<void**>(reinterpret_cast<byte*>(free_block) + sizeof(size_t) + sizeof(void*));
+}
+
+inline void *&allocator_boundary_tags::get_free_block_left_occupied(void* free_block) const noexcept
+{
+    return *reinterpret_cast<void**>(reinterpret_cast<byte*>(free_block) + sizeof(size_t) + 2 * sizeof(void*));
+}
+
+/** The head of a bin is its largest gap: a gap smaller than the head is linked right after it
+ */
+void allocator_boundary_tags::insert_free_block(void* free_block, size_t size, void* left_occupied)
+{
+    if (size < min_indexed_free_block_size)
+    {
+        return;
+    }
+
+    size_t first_level, second_level;
+    free_index_mapping(size, first_level, second_level);
+
+    void **head = get_free_list_head(first_level, second_level);
+
+    *reinterpret_cast<size_t*>(free_block) = size;
+    get_free_block_left_occupied(free_block) = left_occupied;
+
+    if (*head != nullptr && get_free_block_size(*head) > size)
+    {
+        void* next = get_free_block_next(*head);
+
+        get_free_block_prev(free_block) = *head;
+        get_free_block_next(free_block) = next;
+
+        if (next != nullptr)
+        {
+            get_free_block_prev(next) = free_block;
+        }
+        get_free_block_next(*head) = free_block;
+        return;
+    }
+
+    get_free_block_prev(free_block) = nullptr;
+    get_free_block_next(free_block) = *head;
+
+    if (*head != nullptr)
+    {
+        get_free_block_prev(*head) = free_block;
+    }
+    *head = free_block;
+
+    *get_free_first_level_bitmap() |= size_t(1) << first_level;
+    get_free_second_level_bitmaps()[first_level] |= 1u << second_level;
+}
+
+/** When the head goes, the largest of the remaining gaps takes its place. The search stops at a gap
+ * of the removed head's size, so a bin of equal gaps is served in constant time.
+ */
+void allocator_boundary_tags::remove_free_block(void* free_block)
+{
+    size_t first_level, second_level;
+    free_index_mapping(get_free_block_size(free_block), first_level, second_level);
+
+    void* prev = get_free_block_prev(free_block);
+    void* next = get_free_block_next(free_block);
+
+    if (next != nullptr)
+    {
+        get_free_block_prev(next) = prev;
+    }
+
+    if (prev != nullptr)
+    {
+        get_free_block_next(prev) = next;
+        return;
+    }
+
+    void **head = get_free_list_head(first_level, second_level);
+    *head = next;
+
+    if (next == nullptr)
+    {
+        unsigned char &second_level_bitmap = get_free_second_level_bitmaps()[first_level];
+        second_level_bitmap &= ~(1u << second_level);
+        if (second_level_bitmap == 0)
+        {
+            *get_free_first_level_bitmap() &= ~(size_t(1) << first_level);
+        }
+        return;
+    }
+
+    void* largest = next;
+    for (void* current = get_free_block_next(next);
+         current != nullptr && get_free_block_size(largest) < get_free_block_size(free_block);
+         current = get_free_block_next(current))
+    {
+        if (get_free_block_size(current) > get_free_block_size(largest))
+        {
+            largest = current;
+        }
+    }
+
+    if (largest == next)
+    {
+        return;
+    }
+
+    // наибольшая дыра переносится в голову списка
+    void* largest_prev = get_free_block_prev(largest);
+    void* largest_next = get_free_block_next(largest);
+
+    get_free_block_next(largest_prev) = largest_next;
+    if (largest_next != nullptr)
+    {
+        get_free_block_prev(largest_next) = largest_prev;
+    }
+
+    get_free_block_prev(largest) = nullptr;
+    get_free_block_next(largest) = next;
+    get_free_block_prev(next) = largest;
+    *head = largest;
+}
+
+/** The bin straddling the requested size is probed first, for at most max_free_list_probes gaps after its head:
+ * first_fit takes the first fitting gap probed, the_best_fit the smallest one. If none of them fits,
+ * the head is taken when it fits, being the largest gap of the bin. Otherwise the lookup is TLSF's:
+ * the request is rounded up to the next bin boundary and the first non-empty bin from there on is found
+ * in the bitmaps, every its gap fits. The gap after the head is taken when there is one, so the head
+ * does not have to be replaced. the_worst_fit takes the head of the highest non-empty bin, the largest gap of all.
+ */
+void* allocator_boundary_tags::find_free_block(size_t size, allocator_with_fit_mode::fit_mode mode) const
+{
+    size_t first_level_bitmap = *get_free_first_level_bitmap();
+
+    if (first_level_bitmap == 0 || size > std::numeric_limits<size_t>::max() - occupied_block_metadata_size)
+    {
+        return nullptr;
+    }
+
+    if (mode == allocator_with_fit_mode::fit_mode::the_worst_fit)
+    {
+        void* largest = get_largest_free_block();
+        return get_free_block_size(largest) >= size + occupied_block_metadata_size ? largest : nullptr;
+    }
+
+    size_t needed = std::max(size + occupied_block_metadata_size, min_indexed_free_block_size);
+
+    size_t first_level, second_level;
+    free_index_mapping(needed, first_level, second_level);
+
+    // запрос на нижней границе своего класса: подходит любая дыра класса
+    bool straddling = (needed & ((size_t(1) << (first_level - free_index_second_level_log2)) - 1)) != 0;
+
+    if (straddling)
+    {
+        void* found = probe_free_list(first_level, second_level, needed, mode);
+        if (found != nullptr)
+        {
+            return found;
+        }
+        ++second_level;
+    }
+
+    size_t second_level_bitmap = second_level < free_index_second_level_count
+            ? get_free_second_level_bitmaps()[first_level] & (~0u << second_level)
+            : 0;
+
+    if (second_level_bitmap == 0)
+    {
+        first_level_bitmap = first_level + 1 < free_index_first_level_count
+                ? first_level_bitmap & (~size_t(0) << (first_level + 1))
+                : 0;
+
+        if (first_level_bitmap == 0)
+        {
+            return nullptr;
+        }
+
+        first_level = std::countr_zero(first_level_bitmap);
+        second_level_bitmap = get_free_second_level_bitmaps()[first_level];
+    }
+
+    void* head = *get_free_list_head(first_level, std::countr_zero(second_level_bitmap));
+    void* next = get_free_block_next(head);
+    return next != nullptr ? next : head;
+}
+
+void* allocator_boundary_tags::probe_free_list(size_t first_level, size_t second_level, size_t needed, allocator_with_fit_mode::fit_mode mode) const
+{
+    void* head = *get_free_list_head(first_level, second_level);
+
+    // голова - наибольшая дыра класса: если не подходит она, не подходит ни одна
+    if (head == nullptr || get_free_block_size(head) < needed)
+    {
+        return nullptr;
+    }
+
+    void* found = nullptr;
+    void* free_block = get_free_block_next(head);
+    for (size_t probes = 0; free_block != nullptr && probes < max_free_list_probes; free_block = get_free_block_next(free_block), ++probes)
+    {
+        size_t free_size = get_free_block_size(free_block);
+        if (free_size >= needed && (found == nullptr || free_size < get_free_block_size(found)))
+        {
+            found = free_block;
+            if (mode == allocator_with_fit_mode::fit_mode::first_fit || free_size == needed)
+            {
+                break;
+            }
+        }
+    }
+
+    return found != nullptr ? found : head;
+}
+
+/** The head of the highest non-empty bin
+ */
+void* allocator_boundary_tags::get_largest_free_block() const noexcept
+{
+    size_t first_level_bitmap = *get_free_first_level_bitmap();
+
+    if (first_level_bitmap == 0)
+    {
+        return nullptr;
+    }
+
+    size_t first_level = std::bit_width(first_level_bitmap) - 1;
+    size_t second_level = std::bit_width(static_cast<unsigned>(get_free_second_level_bitmaps()[first_level])) - 1;
+
+    return *get_free_list_head(first_level, second_level);
+}
+
+/** Gaps too small to be indexed are not counted
+ */
+size_t allocator_boundary_tags::get_largest_free_block_size() const noexcept
+{
+    void* largest = get_largest_free_block();
+    return largest == nullptr ? 0 : get_free_block_size(largest);
+}
+
+/** Places a block at the start of the free gap, the rest of the gap stays free.
+ * A rest too small to ever hold a block is given to the allocated block.
+ * For alignment the block is moved right, the padding before it stays a free gap
+ * (indexed only if it is large enough, like any other gap).
+ */
+void* allocator_boundary_tags::allocate_from_free_block(void* free_block, size_t size, size_t alignment)
+{
+    size_t free_size = get_free_block_size(free_block);
+    void* left = get_free_block_left_occupied(free_block);
+
+    size_t padding = -reinterpret_cast<std::uintptr_t>(slide_block_for(free_block, occupied_block_metadata_size)) & (alignment - 1);
+    void* gap = free_block;
+    free_block = slide_block_for(gap, padding);
+    free_size -= padding;
+
+    size_t rest = free_size - size - occupied_block_metadata_size;
+    if (rest < min_indexed_free_block_size)
+    {
+        size += rest;
+        rest = 0;
+    }
+
+    // в отдаваемые байты не писали после освобождения; проверка до изъятия дыры из индекса
+    bool poisoned = get_integrity_checks() == integrity_checks::full;
+    if (poisoned)
+    {
+        check_poison(std::max(free_block, slide_block_for(gap, free_block_metadata_size)),
+                     slide_block_for(free_block, occupied_block_metadata_size + size));
+    }
+
+    remove_free_block(gap);
+
+    // дыра в начале региона: первый занятый блок берется из заголовка региона
+    void** first_block_ptr = left == nullptr ? get_region_first_block_ptr(find_region(gap)) : nullptr;
+    void* right = left == nullptr ? *first_block_ptr : get_next_existing_block(left);
+
+    if (left == nullptr)
+    {
+        *first_block_ptr = free_block;
+    }
+    else
+    {
+        *reinterpret_cast<void**>(reinterpret_cast<byte*>(left) + 2 * sizeof(void*) + sizeof(size_t)) = free_block;
+    }
+
+    if (right != nullptr)
+    {
+        *reinterpret_cast<void**>(reinterpret_cast<byte*>(right) + sizeof(void*) + sizeof(size_t)) = free_block;
+    }
+
+    void* memory = create_block_meta(free_block, size, left, right);
+
+    if (padding != 0)
+    {
+        insert_free_block(gap, padding, left);
+
+        // отступ без заголовка отравлен целиком
+        if (poisoned && padding < min_indexed_free_block_size)
+        {
+            std::memset(gap, poison_byte, padding);
+        }
+    }
+
+    if (rest != 0)
+    {
+        insert_free_block(slide_block_for(memory, size), rest, free_block);
+    }
+
+    return memory;
+}
+
+
+
+inline allocator_with_fit_mode::fit_mode allocator_boundary_tags::get_fit_mode()
+{
+    trace_with_guard("started getting fit mode");
+    unsigned char* ptr = reinterpret_cast<unsigned char*>(_trusted_memory);
+
+    ptr += sizeof(class logger*);
+    ptr += sizeof(memory_resource*);
+
+    trace_with_guard("ended getting fit mode");
+    return *reinterpret_cast<allocator_with_fit_mode::fit_mode*>(ptr);
+}
+
+inline void* allocator_boundary_tags::create_block_meta(void* block, size_t size, void* left, void* right)
+{
+    trace_with_guard("started setting meta data");
+    byte* place_ptr = reinterpret_cast<byte*>(block);
+
+    *reinterpret_cast<void**>(place_ptr) = _trusted_memory;
+    place_ptr += sizeof(void*);
+
+    *reinterpret_cast<size_t*>(place_ptr) = size;
+    place_ptr += sizeof(size_t);
+
+    *reinterpret_cast<void**>(place_ptr) = left;
+    place_ptr += sizeof(void*);
+
+    *reinterpret_cast<void**>(place_ptr) = right;
+    place_ptr += sizeof(void*);
+    trace_with_guard("started setting meta data");
+    return place_ptr;
+}
+
+
+inline size_t allocator_boundary_tags::get_size() const
+{
+    unsigned char* ptr = reinterpret_cast<unsigned char*>(_trusted_memory);
+
+    ptr += sizeof(class logger*);
+    ptr += sizeof(memory_resource*);
+    ptr += sizeof(allocator_boundary_tags::fit_mode);
+    ptr += sizeof(std::mutex);
+
+    return *reinterpret_cast<size_t*>(ptr);
+}
+
+void allocator_boundary_tags::do_deallocate_sm(
+        void *at)
+{
+    trace_with_guard("Started deallocate");
+
+    auto lock = get_counters().try_lock(*get_mutex());
+    if (!lock.owns_lock())
+    {
+        if (defer_deallocation(at))
+        {
+            trace_with_guard("Deferred deallocate");
+            return;
+        }
+        lock = get_counters().lock(*get_mutex());
+    }
+
+    drain_remote_frees();
+    deallocate_block(at);
+    verify_if_due();
+    trace_with_guard("Ended deallocate");
+}
+
+void allocator_boundary_tags::do_allocate_batch_sm(
+        size_t bytes,
+        size_t count,
+        void **out,
+        size_t alignment)
+{
+    debug_with_guard("do_allocate_batch_sm start");
+
+    {
+        auto lock = lock_and_drain();
+
+        allocator_with_fit_mode::fit_mode mode = get_fit_mode();
+        size_t allocated = 0;
+
+        // блоки пакета подряд: у каждого, кроме последнего, остаток дыры не меньше блока с метой,
+        // поэтому он индексируется сразу за только что выданным блоком;
+        // размер блока с метой кратен выравниванию, так что выровнен первый - выровнены все
+        if (bytes <= std::numeric_limits<size_t>::max() / count - occupied_block_metadata_size - alignment)
+        {
+            size_t run_bytes = ((bytes + occupied_block_metadata_size + alignment - 1) & ~(alignment - 1)) - occupied_block_metadata_size;
+            size_t run_size = count * (run_bytes + occupied_block_metadata_size) - occupied_block_metadata_size + alignment - 1;
+
+            void* gap = find_free_block(run_size, mode);
+            if (gap == nullptr && add_region(run_size, 1))
+            {
+                gap = find_free_block(run_size, mode);
+            }
+
+            for (; gap != nullptr && allocated < count; ++allocated)
+            {
+                out[allocated] = allocate_from_free_block(gap, run_bytes, alignment);
+                gap = slide_block_for(out[allocated], run_bytes);
+            }
+        }
+
+        for (; allocated < count; ++allocated)
+        {
+            void* memory = allocate_with_fit_mode(mode, bytes, alignment);
+            if (memory == nullptr && add_region(bytes, alignment))
+            {
+                memory = allocate_with_fit_mode(mode, bytes, alignment);
+            }
+
+            if (memory == nullptr)
+            {
+                break;
+            }
+            out[allocated] = memory;
+        }
+
+        for (size_t i = 0; i < allocated; ++i)
+        {
+            get_counters().on_allocate(get_block_data_size(reinterpret_cast<byte*>(out[i]) - occupied_block_metadata_size) + occupied_block_metadata_size);
+        }
+
+        if (allocated == count)
+        {
+            get_counters().set_largest_free_block(get_largest_free_block_size());
+            verify_if_due();
+
+            if (is_enabled_with_guard(logger::severity::debug))
+            {
+                debug_with_guard("Successfully allocated " + std::to_string(count) + " blocks of " +
+                                 std::to_string(bytes) + " bytes");
+            }
+            return;
+        }
+
+        // все или ничего: уже выданные блоки возвращаются
+        for (size_t i = 0; i < allocated; ++i)
+        {
+            deallocate_block(out[i]);
+        }
+        get_counters().on_failed_allocation();
+    }
+
+    if (is_enabled_with_guard(logger::severity::error))
+    {
+        error_with_guard("Batch allocation failed for " + std::to_string(count) + " blocks of " + std::to_string(bytes) + " bytes");
+    }
+    throw std::bad_alloc();
+}
+
+void allocator_boundary_tags::do_deallocate_batch_sm(
+        void *const *blocks,
+        size_t count)
+{
+    trace_with_guard("Started batch deallocate");
+    auto lock = lock_and_drain();
+    for (size_t i = 0; i < count; ++i)
+    {
+        deallocate_block(blocks[i]);
+    }
+    verify_if_due();
+    trace_with_guard("Ended batch deallocate");
+}
+
+void allocator_boundary_tags::deallocate_block(
+        void *at)
+{
+    if (at == nullptr)
+    {
+        return;
+    }
+    void* trusted = *reinterpret_cast<void**>(reinterpret_cast<byte*>(at) - occupied_block_metadata_size);
+    if (trusted != _trusted_memory || trusted == nullptr)
+    {
+        error_with_guard("Tryed to deallocate not allocator's property");
+        throw std::logic_error("Not allocator's property");
+        return;
+    }
+
+
+    void* block = reinterpret_cast<void*>(reinterpret_cast<byte*>(at) - occupied_block_metadata_size);
+
+    if (is_check_due())
+    {
+        check_block_links(block);
+    }
+
+    void* next_block = get_next_existing_block(block);
+    void* prev_block = get_prev_existing_block(block);
+
+    // уплотнение и проверка продолжатся с левого соседа
+    if (block == get_compaction_block())
+    {
+        get_compaction_block() = prev_block;
+    }
+    if (block == get_verify_block())
+    {
+        get_verify_block() = prev_block;
+    }
+
+    // регион нужен только крайнему блоку
+    void* region = prev_block == nullptr || next_block == nullptr ? find_region(block) : nullptr;
+
+    // свободные соседи сливаются с освобожденным блоком в одну дыру
+    void* gap_start = prev_block == nullptr
+            ? get_region_start(region)
+            : slide_block_for(prev_block, occupied_block_metadata_size + get_block_data_size(prev_block));
+    void* gap_end = next_block == nullptr
+            ? get_region_end(region)
+            : next_block;
+
+    if (static_cast<size_t>(reinterpret_cast<byte*>(block) - reinterpret_cast<byte*>(gap_start)) >= min_indexed_free_block_size)
+    {
+        remove_free_block(gap_start);
+    }
+
+    void* right_gap = slide_block_for(block, occupied_block_metadata_size + get_block_data_size(block));
+    if (static_cast<size_t>(reinterpret_cast<byte*>(gap_end) - reinterpret_cast<byte*>(right_gap)) >= min_indexed_free_block_size)
+    {
+        remove_free_block(right_gap);
+    }
+
+    if (next_block != nullptr && prev_block != nullptr) // that was midle block
+    {
+        // setting right -> left
+        byte* place_ptr = reinterpret_cast<byte*>(next_block);
+
+        place_ptr += sizeof(void*);
+        place_ptr += sizeof(size_t);
+
+        *reinterpret_cast<void**>(place_ptr) = prev_block;
+
+        // setting left -> right
+        place_ptr = reinterpret_cast<byte*>(prev_block);
+
+        place_ptr += (2 * sizeof(void*));
+        place_ptr += sizeof(size_t);
+
+        *reinterpret_cast<void**>(place_ptr) = next_block;
+    }
+    else if (next_block != nullptr) // that was the first (max left block)
+    {
+        byte* place_ptr = reinterpret_cast<byte*>(next_block);
+
+        place_ptr += sizeof(void*);
+        place_ptr += sizeof(size_t);
+
+        *reinterpret_cast<void**>(place_ptr) = nullptr;
+        *get_region_first_block_ptr(region) = next_block;
+    }
+    else if (prev_block != nullptr) // that was last block
+    {
+        byte* place_ptr = reinterpret_cast<byte*>(prev_block);
+
+        place_ptr += (2 * sizeof(void*));
+        place_ptr += sizeof(size_t);
+
+        *reinterpret_cast<void**>(place_ptr) = nullptr;
+    }
+    else if (prev_block == nullptr && next_block == nullptr) // only one block
+    {
+        *get_region_first_block_ptr(region) = nullptr;
+    }
+
+    // мета блока затирается заголовком дыры
+    get_counters().on_deallocate(get_block_data_size(block) + occupied_block_metadata_size);
+
+    // отравляется сам блок и заголовок правой дыры, остальные байты соседних дыр уже отравлены
+    if (get_integrity_checks() == integrity_checks::full)
+    {
+        void* poisoned_end = static_cast<size_t>(reinterpret_cast<byte*>(gap_end) - reinterpret_cast<byte*>(right_gap)) >= min_indexed_free_block_size
+                ? slide_block_for(right_gap, free_block_metadata_size)
+                : gap_end;
+        std::memset(block, poison_byte, reinterpret_cast<byte*>(poisoned_end) - reinterpret_cast<byte*>(block));
+    }
+
+    size_t gap_size = reinterpret_cast<byte*>(gap_end) - reinterpret_cast<byte*>(gap_start);
+    insert_free_block(gap_start, gap_size, prev_block);
+
+    if (prev_block == nullptr && next_block == nullptr && region != get_main_region())
+    {
+        release_region(region);
+        get_counters().set_largest_free_block(get_largest_free_block_size());
+    }
+    else
+    {
+        if (gap_size > get_counters().get_largest_free_block())
+        {
+            get_counters().set_largest_free_block(gap_size);
+        }
+
+        // страницы большой дыры за ее заголовком возвращаются ОС
+        os_memory_resource::release_free_range(get_parent_allocator(), slide_block_for(gap_start, free_block_metadata_size), gap_end);
+    }
+}
+
+void allocator_boundary_tags::drain_remote_frees()
+{
+    void* block = get_remote_frees().take_all();
+
+    while (block != nullptr)
+    {
+        void* next = remote_free_queue::next(block);
+
+        *reinterpret_cast<void**>(block) = _trusted_memory;
+        get_counters().on_remote_free();
+        deallocate_block(slide_block_for(block, occupied_block_metadata_size));
+
+        block = next;
+    }
+}
+
+std::unique_lock<std::mutex> allocator_boundary_tags::lock_and_drain()
+{
+    auto lock = get_counters().lock(*get_mutex());
+    drain_remote_frees();
+    return lock;
+}
+
+bool allocator_boundary_tags::defer_deallocation(void* at)
+{
+    if (at == nullptr)
+    {
+        return false;
+    }
+
+    // мета занятого блока меняется только под блокировкой при уплотнении, а оно не трогает обычные блоки;
+    // чужой или уже отложенный блок освобождается под блокировкой и там же отвергается
+    void* block = reinterpret_cast<byte*>(at) - occupied_block_metadata_size;
+    if (*reinterpret_cast<void**>(block) != _trusted_memory)
+    {
+        return false;
+    }
+
+    get_remote_frees().push(block);
+    return true;
+}
+
+inline void **&allocator_boundary_tags::get_handle_table() const noexcept
+{
+    return *reinterpret_cast<void***>(get_free_list_head(0, 0) + free_index_first_level_count * free_index_second_level_count);
+}
+
+inline size_t &allocator_boundary_tags::get_handle_table_capacity() const noexcept
+{
+    return *reinterpret_cast<size_t*>(&get_handle_table() + 1);
+}
+
+inline size_t &allocator_boundary_tags::get_free_handle() const noexcept
+{
+    return *(&get_handle_table_capacity() + 1);
+}
+
+inline void *&allocator_boundary_tags::get_compaction_region() const noexcept
+{
+    return *reinterpret_cast<void**>(&get_free_handle() + 1);
+}
+
+inline void *&allocator_boundary_tags::get_compaction_block() const noexcept
+{
+    return *(&get_compaction_region() + 1);
+}
+
+inline void *&allocator_boundary_tags::get_verify_region() const noexcept
+{
+    return *(&get_compaction_block() + 1);
+}
+
+inline void *&allocator_boundary_tags::get_verify_block() const noexcept
+{
+    return *(&get_verify_region() + 1);
+}
+
+inline size_t &allocator_boundary_tags::get_sampling_countdown() const noexcept
+{
+    return *reinterpret_cast<size_t*>(&get_verify_block() + 1);
+}
+
+inline allocator_boundary_tags::integrity_checks &allocator_boundary_tags::get_integrity_checks() const noexcept
+{
+    return *reinterpret_cast<integrity_checks*>(&get_sampling_countdown() + 1);
+}
+
+inline void *allocator_boundary_tags::get_relocatable_tag() const noexcept
+{
+    return reinterpret_cast<void*>(reinterpret_cast<std::uintptr_t>(_trusted_memory) | 1);
+}
+
+/** Free handles are linked through their slots by index
+ */
+void allocator_boundary_tags::grow_handle_table()
+{
+    size_t capacity = get_handle_table_capacity();
+    size_t new_capacity = std::max(capacity * 2, min_handle_table_capacity);
+    std::pmr::memory_resource* parent_allocator = get_parent_allocator();
+
+    void** table = reinterpret_cast<void**>(parent_allocator == nullptr
+            ? ::operator new(new_capacity * sizeof(void*))
+            : parent_allocator->allocate(new_capacity * sizeof(void*)));
+
+    if (capacity != 0)
+    {
+        std::memcpy(table, get_handle_table(), capacity * sizeof(void*));
+
+        if (parent_allocator == nullptr)
+        {
+            ::operator delete(get_handle_table());
+        }
+        else
+        {
+            parent_allocator->deallocate(get_handle_table(), capacity * sizeof(void*));
+        }
+    }
+
+    for (size_t i = capacity; i < new_capacity; ++i)
+    {
+        table[i] = reinterpret_cast<void*>(i + 1 == new_capacity ? get_free_handle() : i + 1);
+    }
+
+    get_handle_table() = table;
+    get_handle_table_capacity() = new_capacity;
+    get_free_handle() = capacity;
+}
+
+/** A free handle holds an index instead of a block, which lies in no region
+ */
+void *allocator_boundary_tags::get_relocatable_block(handle block_handle) const
+{
+    size_t index = static_cast<size_t>(block_handle);
+    void* block = index < get_handle_table_capacity() ? get_handle_table()[index] : nullptr;
+
+    if (block == nullptr || find_region(block) == nullptr ||
+        *reinterpret_cast<void**>(block) != get_relocatable_tag() ||
+        *reinterpret_cast<size_t*>(slide_block_for(block, occupied_block_metadata_size)) != index)
+    {
+        throw std::logic_error("Not a handle of allocator's relocatable block");
+    }
+
+    return block;
+}
+
+allocator_boundary_tags::handle allocator_boundary_tags::allocate_relocatable(
+        size_t size)
+{
+    debug_with_guard("allocate_relocatable start");
+
+    auto lock = lock_and_drain();
+
+    if (size > std::numeric_limits<size_t>::max() - sizeof(size_t))
+    {
+        get_counters().on_failed_allocation();
+        throw std::bad_alloc();
+    }
+
+    if (get_free_handle() == no_handle)
+    {
+        grow_handle_table();
+    }
+
+    void* memory = allocate_block(size + sizeof(size_t), 1);
+    void* block = reinterpret_cast<byte*>(memory) - occupied_block_metadata_size;
+
+    size_t index = get_free_handle();
+    get_free_handle() = reinterpret_cast<size_t>(get_handle_table()[index]);
+    get_handle_table()[index] = block;
+
+    *reinterpret_cast<void**>(block) = get_relocatable_tag();
+    *reinterpret_cast<size_t*>(memory) = index;
+    verify_if_due();
+
+    return handle(index);
+}
+
+void allocator_boundary_tags::deallocate_relocatable(
+        handle block_handle)
+{
+    trace_with_guard("Started relocatable deallocate");
+
+    auto lock = lock_and_drain();
+
+    void* block = get_relocatable_block(block_handle);
+    size_t index = static_cast<size_t>(block_handle);
+
+    *reinterpret_cast<void**>(block) = _trusted_memory;
+    deallocate_block(slide_block_for(block, occupied_block_metadata_size));
+
+    get_handle_table()[index] = reinterpret_cast<void*>(get_free_handle());
+    get_free_handle() = index;
+    verify_if_due();
+
+    trace_with_guard("Ended relocatable deallocate");
 }
 
+void *allocator_boundary_tags::resolve(
+        handle block_handle) const
+{
+    std::lock_guard lock(*get_mutex());
+
+    return slide_block_for(get_relocatable_block(block_handle), occupied_block_metadata_size + sizeof(size_t));
+}
 
-void* allocator_boundary_tags::allocate_first_fit(void* left_elem, size_t size)
+bool allocator_boundary_tags::compact(
+        size_t max_moved_bytes)
 {
-    void* place_to_place = nullptr;
-    void* that_block = nullptr;
+    trace_with_guard("Started compaction slice");
 
-    void* next_block = get_next_existing_block(left_elem);
-    void* block = left_elem;
+    auto lock = lock_and_drain();
 
-    void* st_ptr = slide_block_for(_trusted_memory, allocator_metadata_size);
-    if (st_ptr != left_elem)
+    void*& region = get_compaction_region();
+    void*& left = get_compaction_block();
+    size_t moved = 0;
+    bool finished = false;
+
+    while (moved < max_moved_bytes)
     {
-        size_t dt = reinterpret_cast<byte*>(left_elem) - reinterpret_cast<byte*>(st_ptr);
-        size_t new_size = dt - occupied_block_metadata_size;
-        if (dt >= size + occupied_block_metadata_size)
+        void* block = left == nullptr ? *get_region_first_block_ptr(region) : get_next_existing_block(left);
+
+        if (block == nullptr)
         {
-            place_to_place = st_ptr;
-            that_block = nullptr;
-            *get_first_block_ptr() = place_to_place;
+            region = *get_region_next_ptr(region);
+            left = nullptr;
 
-            return create_block_meta(place_to_place, new_size, that_block, left_elem);
+            if (region == nullptr)
+            {
+                region = get_main_region();
+                finished = true;
+                break;
+            }
+            continue;
         }
-    }
 
-    while (next_block != nullptr && place_to_place == nullptr)
-    {
-        size_t dt = get_block_distance(block, next_block);
-        if (dt >= size + occupied_block_metadata_size)
+        void* gap_start = left == nullptr
+                ? get_region_start(region)
+                : slide_block_for(left, occupied_block_metadata_size + get_block_data_size(left));
+
+        if (gap_start != block && *reinterpret_cast<void**>(block) == get_relocatable_tag())
         {
-            place_to_place = slide_block_for(block, occupied_block_metadata_size + get_block_data_size(block));
-            that_block = block;
-            break;
+            moved += move_block(block, gap_start, left, region);
+            block = gap_start;
+        }
+        else
+        {
+            moved += occupied_block_metadata_size;
         }
-        block = next_block;
-        next_block = get_next_existing_block(block);
+
+        left = block;
     }
 
-    if (place_to_place == nullptr)
+    get_counters().set_largest_free_block(get_largest_free_block_size());
+
+    trace_with_guard("Ended compaction slice");
+    return finished;
+}
+
+/** The gaps before and after the block become one gap after it
+ */
+size_t allocator_boundary_tags::move_block(void* block, void* to, void* left, void* region)
+{
+    size_t size = occupied_block_metadata_size + get_block_data_size(block);
+    void* right = get_next_existing_block(block);
+    void* old_end = slide_block_for(block, size);
+    void* gap_end = right == nullptr ? get_region_end(region) : right;
+
+    if (static_cast<size_t>(reinterpret_cast<byte*>(block) - reinterpret_cast<byte*>(to)) >= min_indexed_free_block_size)
     {
-        size_t dt = reinterpret_cast<byte*>(block) + get_block_data_size(block) + occupied_block_metadata_size - (reinterpret_cast<byte*>(_trusted_memory) + allocator_metadata_size);
-        if (get_size() - dt >= size + occupied_block_metadata_size)
-        {
-            place_to_place = slide_block_for(block, occupied_block_metadata_size + get_block_data_size(block));
-            that_block = block;
-        }
+        remove_free_block(to);
+    }
+    if (static_cast<size_t>(reinterpret_cast<byte*>(gap_end) - reinterpret_cast<byte*>(old_end)) >= min_indexed_free_block_size)
+    {
+        remove_free_block(old_end);
     }
 
-    if (place_to_place == nullptr)
+    std::memmove(to, block, size);
+
+    if (get_verify_block() == block)
     {
-        return nullptr;
+        get_verify_block() = to;
     }
 
-    byte* next_block_ = reinterpret_cast<byte*>(get_next_existing_block(that_block));
-    if (next_block_ != nullptr)
+    if (left == nullptr)
+    {
+        *get_region_first_block_ptr(region) = to;
+    }
+    else
     {
-        *reinterpret_cast<void**>(next_block_ + sizeof(void*) + sizeof(size_t)) = place_to_place;
+        *reinterpret_cast<void**>(reinterpret_cast<byte*>(left) + 2 * sizeof(void*) + sizeof(size_t)) = to;
     }
 
-    byte* prev_block = reinterpret_cast<byte*>(that_block);
-    if (that_block == nullptr)
+    if (right != nullptr)
     {
-        next_block = reinterpret_cast<byte*>(that_block);
+        *reinterpret_cast<void**>(reinterpret_cast<byte*>(right) + sizeof(void*) + sizeof(size_t)) = to;
     }
-    else if (prev_block != nullptr)
+
+    get_handle_table()[*reinterpret_cast<size_t*>(slide_block_for(to, occupied_block_metadata_size))] = to;
+
+    void* gap_start = slide_block_for(to, size);
+
+    // старое место блока и заголовок правой дыры
+    if (get_integrity_checks() == integrity_checks::full)
     {
-        *reinterpret_cast<void**>(prev_block + 2 * sizeof(void*) + sizeof(size_t)) = place_to_place;
+        void* poisoned_end = std::min(gap_end, slide_block_for(old_end, free_block_metadata_size));
+        std::memset(gap_start, poison_byte, reinterpret_cast<byte*>(poisoned_end) - reinterpret_cast<byte*>(gap_start));
     }
 
-    return create_block_meta(place_to_place, size, that_block, reinterpret_cast<void*>(next_block));
+    insert_free_block(gap_start, reinterpret_cast<byte*>(gap_end) - reinterpret_cast<byte*>(gap_start), to);
+    os_memory_resource::release_free_range(get_parent_allocator(), slide_block_for(gap_start, free_block_metadata_size), gap_end);
+
+    return size;
 }
 
+void allocator_boundary_tags::set_integrity_checks(
+        integrity_checks mode)
+{
+    auto lock = lock_and_drain();
+
+    if (mode == integrity_checks::full && get_integrity_checks() != integrity_checks::full)
+    {
+        poison_free_gaps();
+    }
+
+    get_integrity_checks() = mode;
+    get_sampling_countdown() = sampling_period;
+}
 
-void* allocator_boundary_tags::allocate_best_fit(void* left_elem, size_t size)
+bool allocator_boundary_tags::verify(
+        size_t max_checked_blocks)
 {
-    void* place_to_place = nullptr;
-    void* that_block = nullptr;
+    trace_with_guard("Started verify slice");
+
+    auto lock = lock_and_drain();
+    bool finished = verify_blocks(max_checked_blocks);
 
-    size_t actual_block_size = get_size() + 1;
-    bool at_start = false;
+    trace_with_guard("Ended verify slice");
+    return finished;
+}
 
-    void* next_block = get_next_existing_block(left_elem);
-    void* block = left_elem;
+// счетчик стоит на нуле, пока операция не закончится и не проверит цепочку
+inline bool allocator_boundary_tags::is_check_due() noexcept
+{
+    integrity_checks mode = get_integrity_checks();
 
-    while (next_block != nullptr) // search block in midle
+    if (mode == integrity_checks::off)
     {
-        size_t dt = get_block_distance(block, next_block);
-        if (dt < actual_block_size && dt >= size + occupied_block_metadata_size)
-        {
-            actual_block_size = dt;
-            that_block = block;
-            place_to_place = slide_block_for(block, occupied_block_metadata_size + get_block_data_size(block));
-        }
-        block = next_block;
-        next_block = get_next_existing_block(block);
+        return false;
     }
-    size_t dt = (reinterpret_cast<byte*>(block) + get_block_data_size(block) + occupied_block_metadata_size) - (reinterpret_cast<byte*>(_trusted_memory) + allocator_metadata_size);
 
-    if (get_size() - dt >= size + occupied_block_metadata_size && get_size() - dt < actual_block_size + occupied_block_metadata_size) // block at end
+    size_t &countdown = get_sampling_countdown();
+    if (countdown != 0)
     {
-        actual_block_size = get_size() - dt;
-        that_block = block;
-        place_to_place = slide_block_for(block, occupied_block_metadata_size + get_block_data_size(block));
+        --countdown;
     }
 
-    if (slide_block_for(_trusted_memory, allocator_metadata_size) != left_elem) // block at start
+    return countdown == 0 || mode == integrity_checks::full;
+}
+
+/** Runs after the whole operation, when no block taken from the remote free queue is left half-freed
+ */
+void allocator_boundary_tags::verify_if_due()
+{
+    if (get_integrity_checks() == integrity_checks::off || get_sampling_countdown() != 0)
     {
-        void* st_ptr = slide_block_for(_trusted_memory, allocator_metadata_size);
-        if (get_block_distance(st_ptr, left_elem) >= occupied_block_metadata_size + size &&
-            get_block_distance(st_ptr, left_elem) < actual_block_size &&
-            place_to_place == nullptr)
-        {
-            actual_block_size = get_block_distance(st_ptr, left_elem);
-            that_block = left_elem;
-            place_to_place = st_ptr;
-            at_start = true;
-        }
+        return;
     }
 
-    if (at_start)
+    get_sampling_countdown() = sampling_period;
+    verify_blocks(sampled_verify_blocks);
+}
+
+void allocator_boundary_tags::report_corruption(std::string const &what)
+{
+    error_with_guard("Heap corruption: " + what);
+    throw std::logic_error("Heap corruption: " + what);
+}
+
+/** The links of a block about to be freed agree with its neighbours and its region
+ */
+void allocator_boundary_tags::check_block_links(void* block)
+{
+    void* region = find_region(block);
+    if (region == nullptr)
     {
-        *get_first_block_ptr() = place_to_place;
+        report_corruption("block lies in no region");
     }
-    if (place_to_place == nullptr)
+
+    void* region_end = get_region_end(region);
+    void* prev = get_prev_existing_block(block);
+    void* next = get_next_existing_block(block);
+
+    if (get_block_data_size(block) > static_cast<size_t>(reinterpret_cast<byte*>(region_end) - reinterpret_cast<byte*>(block)) - occupied_block_metadata_size)
     {
-        return nullptr;
+        report_corruption("block size runs past the region end");
     }
-    byte* next_block_ = reinterpret_cast<byte*>(get_next_existing_block(that_block));
-    if (next_block_ != nullptr)
+
+    if (prev == nullptr
+            ? *get_region_first_block_ptr(region) != block
+            : prev < get_region_start(region) || prev >= block || get_next_existing_block(prev) != block)
     {
-        *reinterpret_cast<void**>(next_block_ + sizeof(void*) + sizeof(size_t)) = place_to_place;
+        report_corruption("back link of the block is broken");
     }
 
-    byte* prev_block = reinterpret_cast<byte*>(that_block);
-    if (at_start)
+    if (next != nullptr &&
+        (next < slide_block_for(block, occupied_block_metadata_size + get_block_data_size(block)) || next >= region_end ||
+         get_prev_existing_block(next) != block))
     {
-        next_block = reinterpret_cast<byte*>(that_block);
-        that_block = nullptr;
-    } else if (prev_block != nullptr)
-    {
-        *reinterpret_cast<void**>(prev_block + 2 * sizeof(void*) + sizeof(size_t)) = place_to_place;
+        report_corruption("forward link of the block is broken");
     }
-
-
-    return create_block_meta(place_to_place, size, that_block, reinterpret_cast<void*>(next_block));
 }
 
-void* allocator_boundary_tags::allocate_worst_fit(void* left_elem, size_t size)
+/** A gap too small to be indexed has no header, it is only checked for poison
+ */
+void allocator_boundary_tags::check_free_gap(void* gap_start, void* gap_end, void* left)
 {
-    void* place_to_place = nullptr;
-    void* that_block = nullptr;
-
-    size_t actual_block_size = 0;
-    bool at_start = false;
+    if (gap_end < gap_start)
+    {
+        report_corruption("block overlaps its left neighbour");
+    }
 
-    void* next_block = get_next_existing_block(left_elem);
-    void* block = left_elem;
+    size_t gap_size = reinterpret_cast<byte*>(gap_end) - reinterpret_cast<byte*>(gap_start);
+    void* poisoned_start = gap_start;
 
-    while (next_block != nullptr) // search block in midle
+    if (gap_size >= min_indexed_free_block_size)
     {
-        size_t dt = get_block_distance(block, next_block);
-        if (dt > actual_block_size && dt >= size + occupied_block_metadata_size)
+        if (get_free_block_size(gap_start) != gap_size || get_free_block_left_occupied(gap_start) != left)
         {
-            actual_block_size = dt;
-            that_block = block;
-            place_to_place = slide_block_for(block, occupied_block_metadata_size + get_block_data_size(block));
+            report_corruption("free gap header does not match its neighbours");
         }
-        block = next_block;
-        next_block = get_next_existing_block(block);
-    }
-    size_t dt = (reinterpret_cast<byte*>(block) + get_block_data_size(block) + occupied_block_metadata_size) - (reinterpret_cast<byte*>(_trusted_memory) + allocator_metadata_size);
 
-    if (get_size() - dt >= size + occupied_block_metadata_size && get_size() - dt > actual_block_size + occupied_block_metadata_size) // block at end
-    {
-        actual_block_size = get_size() - dt;
-        that_block = block;
-        place_to_place = slide_block_for(block, occupied_block_metadata_size + get_block_data_size(block));
-    }
+        size_t first_level, second_level;
+        free_index_mapping(gap_size, first_level, second_level);
 
-    if (slide_block_for(_trusted_memory, allocator_metadata_size) != left_elem) // block at start
-    {
-        void* st_ptr = slide_block_for(_trusted_memory, allocator_metadata_size);
-        if (get_block_distance(st_ptr, left_elem) >= occupied_block_metadata_size + size &&
-            get_block_distance(st_ptr, left_elem) > actual_block_size &&
-            place_to_place == nullptr)
+        // ссылка вперед по списку проверяется, когда проход дойдет до следующей дыры
+        void* prev = get_free_block_prev(gap_start);
+
+        void* head = *get_free_list_head(first_level, second_level);
+
+        if ((prev == nullptr ? head != gap_start
+                             : find_region(prev) == nullptr || get_free_block_next(prev) != gap_start) ||
+            (get_free_second_level_bitmaps()[first_level] & (1u << second_level)) == 0)
         {
-            actual_block_size = get_block_distance(st_ptr, left_elem);
-            that_block = left_elem;
-            place_to_place = st_ptr;
-            at_start = true;
+            report_corruption("free gap is not linked into the free index");
         }
-    }
 
-    if (at_start)
-    {
-        *get_first_block_ptr() = place_to_place;
-    }
+        if (gap_size > get_free_block_size(head))
+        {
+            report_corruption("free gap is larger than the head of its list");
+        }
 
-    if (place_to_place == nullptr)
-    {
-        return nullptr;
+        poisoned_start = slide_block_for(gap_start, free_block_metadata_size);
     }
-    byte* next_block_ = reinterpret_cast<byte*>(get_next_existing_block(that_block));
 
-    if (next_block_ != nullptr)
+    if (get_integrity_checks() == integrity_checks::full)
     {
-        *reinterpret_cast<void**>(next_block_ + sizeof(void*) + sizeof(size_t)) = place_to_place;
+        check_poison(poisoned_start, gap_end);
     }
+}
 
-    byte* prev_block = reinterpret_cast<byte*>(that_block);
+/** Released pages read as zeros, so with an os_memory_resource as the parent allocator zeros pass too
+ */
+void allocator_boundary_tags::check_poison(void* from, void* to)
+{
+    byte* first = reinterpret_cast<byte*>(from);
+    byte* last = reinterpret_cast<byte*>(to);
 
-    if (at_start)
+    byte* damaged = std::find_if(first, last, [](byte value) { return value != poison_byte; });
+    if (damaged == last)
     {
-        next_block = reinterpret_cast<byte*>(that_block);
-        that_block = nullptr;
+        return;
     }
-    else if (prev_block != nullptr)
+
+    if (dynamic_cast<os_memory_resource*>(get_parent_allocator()) == nullptr ||
+        std::find_if(damaged, last, [](byte value) { return value != poison_byte && value != 0; }) != last)
     {
-        *reinterpret_cast<void**>(prev_block + 2 * sizeof(void*) + sizeof(size_t)) = place_to_place;
+        report_corruption("freed memory was written to");
     }
+}
 
+void allocator_boundary_tags::poison_free_gaps()
+{
+    for (void* region = get_main_region(); region != nullptr; region = *get_region_next_ptr(region))
+    {
+        void* left = nullptr;
+
+        do
+        {
+            void* block = left == nullptr ? *get_region_first_block_ptr(region) : get_next_existing_block(left);
+            void* gap_start = left == nullptr
+                    ? get_region_start(region)
+                    : slide_block_for(left, occupied_block_metadata_size + get_block_data_size(left));
+            void* gap_end = block == nullptr ? get_region_end(region) : block;
+            size_t gap_size = reinterpret_cast<byte*>(gap_end) - reinterpret_cast<byte*>(gap_start);
 
-    return create_block_meta(place_to_place, size, that_block, reinterpret_cast<void*>(next_block));
+            size_t header_size = gap_size >= min_indexed_free_block_size ? free_block_metadata_size : 0;
+            std::memset(slide_block_for(gap_start, header_size), poison_byte, gap_size - header_size);
 
+            left = block;
+        }
+        while (left != nullptr);
+    }
 }
 
+/** The gap before a block is checked before the block itself, so a slice that stopped on a block
+ * goes on from the gap after it
+ */
+bool allocator_boundary_tags::verify_blocks(size_t max_checked_blocks)
+{
+    void*& region = get_verify_region();
+    void*& left = get_verify_block();
+    size_t checked = 0;
+    size_t drain_attempts = 0;
 
+    while (checked < max_checked_blocks)
+    {
+        void* block = left == nullptr ? *get_region_first_block_ptr(region) : get_next_existing_block(left);
+        void* region_end = get_region_end(region);
 
-inline allocator_with_fit_mode::fit_mode allocator_boundary_tags::get_fit_mode()
-{
-    trace_with_guard("started getting fit mode");
-    unsigned char* ptr = reinterpret_cast<unsigned char*>(_trusted_memory);
+        if (block != nullptr &&
+            (block < get_region_start(region) || block >= region_end ||
+             static_cast<size_t>(reinterpret_cast<byte*>(region_end) - reinterpret_cast<byte*>(block)) < occupied_block_metadata_size))
+        {
+            report_corruption("block link leads out of its region");
+        }
 
-    ptr += sizeof(class logger*);
-    ptr += sizeof(memory_resource*);
+        void* gap_start = left == nullptr
+                ? get_region_start(region)
+                : slide_block_for(left, occupied_block_metadata_size + get_block_data_size(left));
+        check_free_gap(gap_start, block == nullptr ? region_end : block, left);
 
-    trace_with_guard("ended getting fit mode");
-    return *reinterpret_cast<allocator_with_fit_mode::fit_mode*>(ptr);
-}
+        if (block == nullptr)
+        {
+            region = *get_region_next_ptr(region);
+            left = nullptr;
 
-inline void* allocator_boundary_tags::create_block_meta(void* block, size_t size, void* left, void* right)
-{
-    trace_with_guard("started setting meta data");
-    byte* place_ptr = reinterpret_cast<byte*>(block);
+            if (region == nullptr)
+            {
+                region = get_main_region();
+                return true;
+            }
+            continue;
+        }
 
-    *reinterpret_cast<void**>(place_ptr) = _trusted_memory;
-    place_ptr += sizeof(void*);
+        // блок, который другой поток положил в очередь, несет ссылку очереди вместо указателя на аллокатор:
+        // nullptr или начало другого блока аллокатора, любой другой адрес - порча. Очередь освобождается,
+        // и шаг повторяется; ссылка, записанная без блокировки, могла еще не дойти до очереди, тогда после
+        // нескольких попыток блок проверяется без принадлежности, а его освободит следующий взявший блокировку
+        void* trusted = *reinterpret_cast<void**>(block);
+        if (trusted != _trusted_memory && trusted != get_relocatable_tag())
+        {
+            if (trusted != nullptr && find_region(trusted) == nullptr)
+            {
+                report_corruption("block does not belong to the allocator");
+            }
+            if (drain_attempts < 64)
+            {
+                if (drain_attempts++ != 0)
+                {
+                    std::this_thread::yield();
+                }
+                drain_remote_frees();
+                continue;
+            }
+        }
+        drain_attempts = 0;
 
-    *reinterpret_cast<size_t*>(place_ptr) = size;
-    place_ptr += sizeof(size_t);
+        if (get_prev_existing_block(block) != left ||
+            get_block_data_size(block) > static_cast<size_t>(reinterpret_cast<byte*>(region_end) - reinterpret_cast<byte*>(block)) - occupied_block_metadata_size)
+        {
+            report_corruption("block size or back link is broken");
+        }
 
-    *reinterpret_cast<void**>(place_ptr) = left;
-    place_ptr += sizeof(void*);
+        if (trusted == get_relocatable_tag())
+        {
+            size_t index = *reinterpret_cast<size_t*>(slide_block_for(block, occupied_block_metadata_size));
+            if (index >= get_handle_table_capacity() || get_handle_table()[index] != block)
+            {
+                report_corruption("handle of the relocatable block does not point to it");
+            }
+        }
 
-    *reinterpret_cast<void**>(place_ptr) = right;
-    place_ptr += sizeof(void*);
-    trace_with_guard("started setting meta data");
-    return place_ptr;
-}
+        left = block;
+        ++checked;
+    }
 
+    return false;
+}
 
-inline size_t allocator_boundary_tags::get_size() const
+inline void allocator_boundary_tags::set_fit_mode(
+        allocator_with_fit_mode::fit_mode mode)
 {
+    trace_with_guard("started setting fit mode");
     unsigned char* ptr = reinterpret_cast<unsigned char*>(_trusted_memory);
 
     ptr += sizeof(class logger*);
     ptr += sizeof(memory_resource*);
-    ptr += sizeof(allocator_boundary_tags::fit_mode);
-    ptr += sizeof(std::mutex);
-
-    return *reinterpret_cast<size_t*>(ptr);
+    *reinterpret_cast<allocator_with_fit_mode::fit_mode*>(ptr) = mode;
+    trace_with_guard("ended setting fit mode");
 }
 
-void allocator_boundary_tags::do_deallocate_sm(
-        void *at)
+
+std::vector<allocator_test_utils::block_info> allocator_boundary_tags::get_blocks_info() const
 {
-    trace_with_guard("Started deallocate");
     std::lock_guard lock(*get_mutex());
-    if (at == nullptr)
-    {
-        return;
-    }
-    void* trusted = *reinterpret_cast<void**>(reinterpret_cast<byte*>(at) - occupied_block_metadata_size);
-    if (trusted != _trusted_memory || trusted == nullptr)
-    {
-        error_with_guard("Tryed to deallocate not allocator's property");
-        throw std::logic_error("Not allocator's property");
-        return;
-    }
 
+    return get_blocks_info_inner();
+}
 
-    void* block = reinterpret_cast<void*>(reinterpret_cast<byte*>(at) - occupied_block_metadata_size);
+allocator_statistics::statistics_snapshot allocator_boundary_tags::get_statistics() const noexcept
+{
+    return _trusted_memory == nullptr ? statistics_snapshot {} : get_counters().snapshot();
+}
 
-    void* next_block = get_next_existing_block(block);
-    void* prev_block = get_prev_existing_block(block);
+size_t allocator_boundary_tags::get_free_size_inner() const
+{
+    size_t free_size = 0;
 
-    if (next_block != nullptr && prev_block != nullptr) // that was midle block
+    for (auto &block : get_blocks_info_inner())
     {
-        // setting right -> left
-        byte* place_ptr = reinterpret_cast<byte*>(next_block);
-
-        place_ptr += sizeof(void*);
-        place_ptr += sizeof(size_t);
-
-        *reinterpret_cast<void**>(place_ptr) = prev_block;
+        if (!block.is_block_occupied)
+        {
+            free_size += block.block_size;
+        }
+    }
 
-        // setting left -> right
-        place_ptr = reinterpret_cast<byte*>(prev_block);
+    return free_size;
+}
 
-        place_ptr += (2 * sizeof(void*));
-        place_ptr += sizeof(size_t);
+std::vector<allocator_test_utils::block_info> allocator_boundary_tags::get_blocks_info_inner() const
+{
+    std::vector <allocator_test_utils::block_info> result;
 
-        *reinterpret_cast<void**>(place_ptr) = next_block;
-    }
-    else if (next_block != nullptr) // that was the first (max left block)
+    for (void* region = get_main_region(); region != nullptr; region = *get_region_next_ptr(region))
     {
-        byte* place_ptr = reinterpret_cast<byte*>(next_block);
-
-        place_ptr += sizeof(void*);
-        place_ptr += sizeof(size_t);
-
-        *reinterpret_cast<void**>(place_ptr) = nullptr;
-        *get_first_block_ptr() = next_block;
+        get_region_blocks_info_inner(region, result);
     }
-    else if (prev_block != nullptr) // that was last block
-    {
-        byte* place_ptr = reinterpret_cast<byte*>(prev_block);
 
-        place_ptr += (2 * sizeof(void*));
-        place_ptr += sizeof(size_t);
+    return result;
+}
 
-        *reinterpret_cast<void**>(place_ptr) = nullptr;
-    }
-    else if (prev_block == nullptr && next_block == nullptr) // only one block
+size_t allocator_boundary_tags::get_regions_count() const
+{
+    std::lock_guard lock(*get_mutex());
+
+    size_t count = 0;
+    for (void* region = get_main_region(); region != nullptr; region = *get_region_next_ptr(region))
     {
-        *get_first_block_ptr() = nullptr;
+        ++count;
     }
 
-    trace_with_guard("Ended deallocate");
+    return count;
 }
 
-inline void allocator_boundary_tags::set_fit_mode(
-        allocator_with_fit_mode::fit_mode mode)
+std::vector<allocator_test_utils::block_info> allocator_boundary_tags::get_region_blocks_info(size_t region_index) const
 {
-    trace_with_guard("started setting fit mode");
-    unsigned char* ptr = reinterpret_cast<unsigned char*>(_trusted_memory);
+    std::lock_guard lock(*get_mutex());
 
-    ptr += sizeof(class logger*);
-    ptr += sizeof(memory_resource*);
-    *reinterpret_cast<allocator_with_fit_mode::fit_mode*>(ptr) = mode;
-    trace_with_guard("ended setting fit mode");
-}
+    void* region = get_main_region();
+    for (; region != nullptr && region_index != 0; --region_index)
+    {
+        region = *get_region_next_ptr(region);
+    }
 
+    if (region == nullptr)
+    {
+        throw std::out_of_range("Region index is out of range");
+    }
 
-std::vector<allocator_test_utils::block_info> allocator_boundary_tags::get_blocks_info() const
-{
-    size_t full_free_size = 0;
     std::vector <allocator_test_utils::block_info> result;
+    get_region_blocks_info_inner(region, result);
+
+    return result;
+}
+
+void allocator_boundary_tags::get_region_blocks_info_inner(void* region, std::vector<allocator_test_utils::block_info> &result) const
+{
     // block_info - размер и занят ли
 
-    void *first_block = *get_first_block_ptr();
+    void *first_block = *get_region_first_block_ptr(region);
 
     if(first_block == nullptr)
     {
-        full_free_size = get_size();
-        result.push_back({ full_free_size, false });
-        return result;
+        result.push_back({ get_region_size(region), false });
+        return;
     }
 
     void* current = first_block;
@@ -564,10 +1834,9 @@ std::vector<allocator_test_utils::block_info> allocator_boundary_tags::get_block
     // проверяем, что нет других блоков
     if (get_prev_existing_block(current) == nullptr)
     {
-        size_t first_available_block_size = get_block_distance(current, slide_block_for(_trusted_memory, allocator_metadata_size));
+        size_t first_available_block_size = reinterpret_cast<byte*>(current) - reinterpret_cast<byte*>(get_region_start(region));
         if (first_available_block_size > 0)
         {
-            full_free_size += first_available_block_size;
             result.push_back({ first_available_block_size,
                                false });
         }
@@ -579,19 +1848,17 @@ std::vector<allocator_test_utils::block_info> allocator_boundary_tags::get_block
     while (current != nullptr)
     {
         size_t size_between_current_and_next = 0;
-        bool t_ = false;
         if (next == nullptr)
         {
-            void* end = slide_block_for(_trusted_memory,  allocator_metadata_size + get_size());
+            void* end = get_region_end(region);
             void* start = slide_block_for(current, occupied_block_metadata_size + get_block_data_size(current));
 
             size_between_current_and_next = reinterpret_cast<byte*>(end) - reinterpret_cast<byte*>(start);
             if (size_between_current_and_next > 0)
             {
-                full_free_size += size_between_current_and_next;
                 result.push_back({ size_between_current_and_next, false });
             }
-            return result;
+            return;
         }
         else
         {
@@ -601,7 +1868,6 @@ std::vector<allocator_test_utils::block_info> allocator_boundary_tags::get_block
             size_between_current_and_next = reinterpret_cast<byte*>(next_load_block) - reinterpret_cast<byte*>(end_address_current_block);
             if (size_between_current_and_next > 0)
             {
-                full_free_size += size_between_current_and_next;
                 result.push_back({ size_between_current_and_next, false });
             }
             result.push_back({ get_block_data_size(next) + occupied_block_metadata_size, true });
@@ -610,8 +1876,6 @@ std::vector<allocator_test_utils::block_info> allocator_boundary_tags::get_block
         current = next;
         next = get_next_existing_block(current);
     }
-    return result;
-
 }
 
 inline size_t allocator_boundary_tags::get_block_distance(void* left, void *right) const
@@ -679,11 +1943,6 @@ allocator_boundary_tags::boundary_iterator allocator_boundary_tags::end() const
     throw not_implemented("allocator_boundary_tags::boundary_iterator allocator_boundary_tags::end() const noexcept", "your code should be here...");
 }
 
-std::vector<allocator_test_utils::block_info> allocator_boundary_tags::get_blocks_info_inner() const
-{
-    throw not_implemented("std::vector<allocator_test_utils::block_info> allocator_boundary_tags::get_blocks_info_inner() const", "your code should be here...");
-}
-
 
 allocator_boundary_tags &allocator_boundary_tags::operator=(const allocator_boundary_tags &other)
 {
@@ -0,0 +1,708 @@
+#include "../include/allocator_boundary_tags_compact.h"
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstring>
+
+
+using byte = unsigned char;
+
+
+allocator_boundary_tags_compact::allocator_boundary_tags_compact(
+        size_t space_size,
+        std::pmr::memory_resource *parent_allocator,
+        logger *log,
+        allocator_with_fit_mode::fit_mode allocate_fit_mode)
+{
+    space_size &= ~(block_granularity - 1);
+
+    if (space_size < min_block_size)
+    {
+        throw std::logic_error("allocator_boundary_tags_compact space must hold at least one block");
+    }
+
+    // ссылки на свободные блоки - номера кусков по block_granularity от начала меты
+    if (space_size / block_granularity >= no_free_block - space_offset / block_granularity - 1)
+    {
+        throw std::logic_error("allocator_boundary_tags_compact space is too big for its free block links");
+    }
+
+    size_t memory_size = space_offset + space_size + block_header_size;
+
+    _trusted_memory = parent_allocator == nullptr
+            ? ::operator new(memory_size)
+            : parent_allocator->allocate(memory_size);
+
+    byte *ptr = reinterpret_cast<byte*>(_trusted_memory);
+
+    *reinterpret_cast<class logger**>(ptr) = log;
+    ptr += sizeof(class logger*);
+
+    *reinterpret_cast<std::pmr::memory_resource**>(ptr) = parent_allocator;
+    ptr += sizeof(std::pmr::memory_resource*);
+
+    *reinterpret_cast<allocator_with_fit_mode::fit_mode*>(ptr) = allocate_fit_mode;
+
+    *reinterpret_cast<size_t*>(reinterpret_cast<byte*>(_trusted_memory) + space_size_offset) = space_size;
+
+    new (&get_mutex()) std::mutex;
+
+    *get_free_first_level_bitmap() = 0;
+    std::memset(get_free_second_level_bitmaps(), 0, free_index_first_level_count * sizeof(unsigned char));
+    std::fill_n(get_free_list_head(0, 0), free_index_first_level_count * free_index_second_level_count, no_free_block);
+
+    new (reinterpret_cast<byte*>(_trusted_memory) + remote_frees_offset) remote_free_queue;
+    new (reinterpret_cast<byte*>(_trusted_memory) + counters_offset) allocator_statistics::counters(space_size);
+
+    // слева от первого блока ничего нет, он считает соседа занятым; ограничитель всегда занят
+    get_header(get_space_start()) = prev_occupied_flag;
+    insert_free_block(get_space_start(), space_size);
+    get_header(get_space_end()) = occupied_flag;
+}
+
+allocator_boundary_tags_compact::allocator_boundary_tags_compact(
+        allocator_boundary_tags_compact &&other) noexcept :
+        _trusted_memory(std::exchange(other._trusted_memory, nullptr))
+{
+}
+
+allocator_boundary_tags_compact &allocator_boundary_tags_compact::operator=(
+        allocator_boundary_tags_compact &&other) noexcept
+{
+    if (this != &other)
+    {
+        release_memory();
+        _trusted_memory = std::exchange(other._trusted_memory, nullptr);
+    }
+
+    return *this;
+}
+
+allocator_boundary_tags_compact::~allocator_boundary_tags_compact()
+{
+    release_memory();
+}
+
+void allocator_boundary_tags_compact::release_memory() noexcept
+{
+    if (_trusted_memory == nullptr)
+    {
+        return;
+    }
+
+    std::pmr::memory_resource *parent_allocator = get_parent_allocator();
+    size_t memory_size = space_offset + get_space_size() + block_header_size;
+
+    get_mutex().~mutex();
+
+    if (parent_allocator == nullptr)
+    {
+        ::operator delete(_trusted_memory);
+    }
+    else
+    {
+        parent_allocator->deallocate(_trusted_memory, memory_size);
+    }
+
+    _trusted_memory = nullptr;
+}
+
+[[nodiscard]] void *allocator_boundary_tags_compact::do_allocate_sm(
+        size_t bytes)
+{
+    return do_allocate_aligned_sm(bytes, 1);
+}
+
+[[nodiscard]] void *allocator_boundary_tags_compact::do_allocate_aligned_sm(
+        size_t bytes,
+        size_t alignment)
+{
+    auto lock = lock_and_drain();
+
+    // данные и так выровнены на block_granularity
+    if (alignment <= block_granularity)
+    {
+        alignment = 1;
+    }
+
+    void *memory = nullptr;
+
+    if (bytes <= get_space_size() && alignment <= get_space_size())
+    {
+        size_t size = std::max((bytes + block_header_size + block_granularity - 1) & ~(block_granularity - 1), min_block_size);
+
+        // отступ для выравнивания либо нулевой, либо вмещает свободный блок
+        size_t search_size = alignment == 1 ? size : size + alignment + min_block_size - block_granularity;
+
+        void *block = find_free_block(search_size, get_fit_mode());
+        if (block != nullptr)
+        {
+            memory = allocate_from_free_block(block, size, alignment);
+        }
+    }
+
+    if (memory == nullptr)
+    {
+        get_counters().on_failed_allocation();
+
+        if (is_enabled_with_guard(logger::severity::error))
+        {
+            error_with_guard("Allocation failed for size " + std::to_string(bytes));
+        }
+        throw std::bad_alloc();
+    }
+
+    get_counters().on_allocate(get_block_size(reinterpret_cast<byte*>(memory) - block_header_size));
+    get_counters().set_largest_free_block(get_largest_free_block_size());
+
+    if (is_enabled_with_guard(logger::severity::debug))
+    {
+        debug_with_guard("Successfully allocated " + std::to_string(bytes) + " bytes");
+    }
+
+    return memory;
+}
+
+/** The block is taken from the start of the free block. For alignment the data is moved right by a padding
+ * that is either zero or big enough to stay a free block, and a rest too small to be a free block is
+ * given to the allocated one.
+ */
+void *allocator_boundary_tags_compact::allocate_from_free_block(
+        void *block,
+        size_t size,
+        size_t alignment)
+{
+    size_t free_size = get_block_size(block);
+    remove_free_block(block);
+
+    size_t padding = -reinterpret_cast<std::uintptr_t>(reinterpret_cast<byte*>(block) + block_header_size) & (alignment - 1);
+    if (padding != 0 && padding < min_block_size)
+    {
+        padding += (min_block_size - padding + alignment - 1) & ~(alignment - 1);
+    }
+
+    block_header prev_flag = load_header(block) & prev_occupied_flag;
+
+    if (padding != 0)
+    {
+        insert_free_block(block, padding);
+        block = reinterpret_cast<byte*>(block) + padding;
+        free_size -= padding;
+        prev_flag = 0;
+    }
+
+    if (free_size - size >= min_block_size)
+    {
+        void *rest = reinterpret_cast<byte*>(block) + size;
+        get_header(rest) = prev_occupied_flag;
+        insert_free_block(rest, free_size - size);
+    }
+    else
+    {
+        size = free_size;
+        std::atomic_ref(get_header(reinterpret_cast<byte*>(block) + size)).fetch_or(prev_occupied_flag, std::memory_order_relaxed);
+    }
+
+    get_header(block) = size | occupied_flag | prev_flag;
+
+    return reinterpret_cast<byte*>(block) + block_header_size;
+}
+
+void allocator_boundary_tags_compact::do_deallocate_sm(
+        void *at)
+{
+    if (at == nullptr)
+    {
+        return;
+    }
+
+    auto lock = get_counters().try_lock(get_mutex());
+    if (!lock.owns_lock())
+    {
+        if (defer_deallocation(at))
+        {
+            trace_with_guard("Deferred deallocate");
+            return;
+        }
+        lock = get_counters().lock(get_mutex());
+    }
+
+    drain_remote_frees();
+    deallocate_block(at);
+}
+
+/** Free neighbours are merged with the freed block: the right one is found by the size of the block,
+ * the left one by its footer, which only free blocks have.
+ */
+void allocator_boundary_tags_compact::deallocate_block(
+        void *at)
+{
+    byte *block = reinterpret_cast<byte*>(at) - block_header_size;
+
+    if (block < get_space_start() || block >= get_space_end() ||
+        (block - get_space_start()) % block_granularity != 0 ||
+        (load_header(block) & (occupied_flag | pending_flag)) != occupied_flag ||
+        get_block_size(block) < min_block_size ||
+        get_block_size(block) > static_cast<size_t>(get_space_end() - block) ||
+        (load_header(block + get_block_size(block)) & prev_occupied_flag) == 0)
+    {
+        error_with_guard("Tried to deallocate not allocator's property");
+        throw std::logic_error("Not allocator's property");
+    }
+
+    size_t size = get_block_size(block);
+    get_counters().on_deallocate(size);
+
+    byte *next = block + size;
+    if ((load_header(next) & occupied_flag) == 0)
+    {
+        size += get_block_size(next);
+        remove_free_block(next);
+    }
+
+    if ((load_header(block) & prev_occupied_flag) == 0)
+    {
+        size_t prev_size = *reinterpret_cast<size_t*>(block - sizeof(size_t));
+        block -= prev_size;
+        size += prev_size;
+        remove_free_block(block);
+    }
+
+    insert_free_block(block, size);
+    std::atomic_ref(get_header(block + size)).fetch_and(~prev_occupied_flag, std::memory_order_relaxed);
+
+    if (size > get_counters().get_largest_free_block())
+    {
+        get_counters().set_largest_free_block(size);
+    }
+
+    trace_with_guard("Ended deallocate");
+}
+
+void allocator_boundary_tags_compact::drain_remote_frees()
+{
+    void *node = get_remote_frees().take_all();
+
+    while (node != nullptr)
+    {
+        void *next = remote_free_queue::next(node);
+
+        byte *block = reinterpret_cast<byte*>(node) - remote_free_link_offset;
+
+        // флаг очереди снимается только здесь, второе освобождение блока до этого отвергается
+        get_counters().on_remote_free();
+        std::atomic_ref(get_header(block)).fetch_and(~pending_flag, std::memory_order_relaxed);
+        try
+        {
+            deallocate_block(block + block_header_size);
+        }
+        catch (std::logic_error const &)
+        {
+            // отвергнутый блок уже записан в лог, бросить некому: освобождавший поток давно ушел
+        }
+
+        node = next;
+    }
+}
+
+std::unique_lock<std::mutex> allocator_boundary_tags_compact::lock_and_drain()
+{
+    auto lock = get_counters().lock(get_mutex());
+    drain_remote_frees();
+    return lock;
+}
+
+bool allocator_boundary_tags_compact::defer_deallocation(
+        void *at)
+{
+    // флаг левого соседа в заголовке занятого блока меняется под блокировкой, поэтому флаг очереди ставится
+    // сравнением с обменом; соседей и размер проверит тот, кто разберет очередь
+    byte *block = reinterpret_cast<byte*>(at) - block_header_size;
+    if (block < get_space_start() || block > get_space_end() - min_block_size ||
+        (block - get_space_start()) % block_granularity != 0)
+    {
+        return false;
+    }
+
+    std::atomic_ref header(get_header(block));
+    block_header expected = header.load(std::memory_order_relaxed);
+    do
+    {
+        if ((expected & (occupied_flag | pending_flag)) != occupied_flag)
+        {
+            error_with_guard("Tried to deallocate not allocator's property");
+            throw std::logic_error("Not allocator's property");
+        }
+    }
+    while (!header.compare_exchange_weak(expected, expected | pending_flag, std::memory_order_relaxed));
+
+    get_remote_frees().push(block + remote_free_link_offset);
+    return true;
+}
+
+bool allocator_boundary_tags_compact::do_is_equal(const std::pmr::memory_resource &other) const noexcept
+{
+    return this == &other;
+}
+
+void allocator_boundary_tags_compact::set_fit_mode(
+        allocator_with_fit_mode::fit_mode mode)
+{
+    // режим читается при выделении под блокировкой
+    std::lock_guard lock(get_mutex());
+
+    *reinterpret_cast<allocator_with_fit_mode::fit_mode*>(
+            reinterpret_cast<byte*>(_trusted_memory) + sizeof(logger*) + sizeof(std::pmr::memory_resource*)) = mode;
+}
+
+std::vector<allocator_test_utils::block_info> allocator_boundary_tags_compact::get_blocks_info() const
+{
+    std::lock_guard lock(get_mutex());
+
+    return get_blocks_info_inner();
+}
+
+std::vector<allocator_test_utils::block_info> allocator_boundary_tags_compact::get_blocks_info_inner() const
+{
+    std::vector<allocator_test_utils::block_info> result;
+
+    for (byte *block = get_space_start(); block != get_space_end(); block += get_block_size(block))
+    {
+        result.push_back({ get_block_size(block), (load_header(block) & occupied_flag) != 0 });
+    }
+
+    return result;
+}
+
+allocator_statistics::statistics_snapshot allocator_boundary_tags_compact::get_statistics() const noexcept
+{
+    return _trusted_memory == nullptr ? statistics_snapshot {} : get_counters().snapshot();
+}
+
+inline logger *allocator_boundary_tags_compact::get_logger() const
+{
+    return *reinterpret_cast<logger**>(_trusted_memory);
+}
+
+inline std::string allocator_boundary_tags_compact::get_typename() const noexcept
+{
+    return "allocator_boundary_tags_compact";
+}
+
+inline std::pmr::memory_resource *allocator_boundary_tags_compact::get_parent_allocator() const noexcept
+{
+    return *reinterpret_cast<std::pmr::memory_resource**>(reinterpret_cast<byte*>(_trusted_memory) + sizeof(logger*));
+}
+
+inline allocator_with_fit_mode::fit_mode allocator_boundary_tags_compact::get_fit_mode() const noexcept
+{
+    return *reinterpret_cast<allocator_with_fit_mode::fit_mode*>(
+            reinterpret_cast<byte*>(_trusted_memory) + sizeof(logger*) + sizeof(std::pmr::memory_resource*));
+}
+
+inline size_t allocator_boundary_tags_compact::get_space_size() const noexcept
+{
+    return *reinterpret_cast<size_t*>(reinterpret_cast<byte*>(_trusted_memory) + space_size_offset);
+}
+
+inline std::mutex &allocator_boundary_tags_compact::get_mutex() const noexcept
+{
+    return *reinterpret_cast<std::mutex*>(reinterpret_cast<byte*>(_trusted_memory) + mutex_offset);
+}
+
+inline allocator_statistics::counters &allocator_boundary_tags_compact::get_counters() const noexcept
+{
+    return *reinterpret_cast<allocator_statistics::counters*>(reinterpret_cast<byte*>(_trusted_memory) + counters_offset);
+}
+
+inline remote_free_queue &allocator_boundary_tags_compact::get_remote_frees() const noexcept
+{
+    return *reinterpret_cast<remote_free_queue*>(reinterpret_cast<byte*>(_trusted_memory) + remote_frees_offset);
+}
+
+inline unsigned char *allocator_boundary_tags_compact::get_space_start() const noexcept
+{
+    return reinterpret_cast<byte*>(_trusted_memory) + space_offset;
+}
+
+inline unsigned char *allocator_boundary_tags_compact::get_space_end() const noexcept
+{
+    return get_space_start() + get_space_size();
+}
+
+inline allocator_boundary_tags_compact::block_header &allocator_boundary_tags_compact::get_header(void *block) noexcept
+{
+    return *reinterpret_cast<block_header*>(block);
+}
+
+inline allocator_boundary_tags_compact::block_header allocator_boundary_tags_compact::load_header(void *block) noexcept
+{
+    return std::atomic_ref(get_header(block)).load(std::memory_order_relaxed);
+}
+
+inline size_t allocator_boundary_tags_compact::get_block_size(void *block) noexcept
+{
+    return load_header(block) & ~flags_mask;
+}
+
+inline size_t &allocator_boundary_tags_compact::get_footer(void *block, size_t size) noexcept
+{
+    return *reinterpret_cast<size_t*>(reinterpret_cast<byte*>(block) + size - sizeof(size_t));
+}
+
+inline allocator_boundary_tags_compact::free_block_link &allocator_boundary_tags_compact::get_free_block_prev(void *block) noexcept
+{
+    return *reinterpret_cast<free_block_link*>(reinterpret_cast<byte*>(block) + block_header_size);
+}
+
+inline allocator_boundary_tags_compact::free_block_link &allocator_boundary_tags_compact::get_free_block_next(void *block) noexcept
+{
+    return *reinterpret_cast<free_block_link*>(reinterpret_cast<byte*>(block) + block_header_size + sizeof(free_block_link));
+}
+
+inline allocator_boundary_tags_compact::free_block_link allocator_boundary_tags_compact::get_link(void *block) const noexcept
+{
+    return static_cast<free_block_link>((reinterpret_cast<byte*>(block) - reinterpret_cast<byte*>(_trusted_memory)) / block_granularity);
+}
+
+// блоки начинаются на block_header_size раньше границы block_granularity
+inline unsigned char *allocator_boundary_tags_compact::get_linked_block(free_block_link link) const noexcept
+{
+    return reinterpret_cast<byte*>(_trusted_memory) + link * block_granularity + (space_offset & (block_granularity - 1));
+}
+
+inline size_t *allocator_boundary_tags_compact::get_free_first_level_bitmap() const noexcept
+{
+    return reinterpret_cast<size_t*>(reinterpret_cast<byte*>(_trusted_memory) + free_index_offset);
+}
+
+inline unsigned char *allocator_boundary_tags_compact::get_free_second_level_bitmaps() const noexcept
+{
+    return reinterpret_cast<unsigned char*>(get_free_first_level_bitmap() + 1);
+}
+
+inline allocator_boundary_tags_compact::free_block_link *allocator_boundary_tags_compact::get_free_list_head(
+        size_t first_level,
+        size_t second_level) const noexcept
+{
+    auto *heads = reinterpret_cast<free_block_link*>(reinterpret_cast<byte*>(_trusted_memory) + free_heads_offset);
+    return heads + first_level * free_index_second_level_count + second_level;
+}
+
+inline void allocator_boundary_tags_compact::free_index_mapping(size_t size, size_t &first_level, size_t &second_level) noexcept
+{
+    first_level = std::bit_width(size) - 1;
+    second_level = (size >> (first_level - free_index_second_level_log2)) & (free_index_second_level_count - 1);
+}
+
+/** As in allocator_boundary_tags the head of a bin is its largest block
+ */
+void allocator_boundary_tags_compact::insert_free_block(void *block, size_t size)
+{
+    size_t first_level, second_level;
+    free_index_mapping(size, first_level, second_level);
+
+    free_block_link *head = get_free_list_head(first_level, second_level);
+
+    get_header(block) = size | (get_header(block) & prev_occupied_flag);
+    get_footer(block, size) = size;
+
+    if (*head != no_free_block && get_block_size(get_linked_block(*head)) > size)
+    {
+        byte *head_block = get_linked_block(*head);
+        free_block_link next = get_free_block_next(head_block);
+
+        get_free_block_prev(block) = *head;
+        get_free_block_next(block) = next;
+
+        if (next != no_free_block)
+        {
+            get_free_block_prev(get_linked_block(next)) = get_link(block);
+        }
+        get_free_block_next(head_block) = get_link(block);
+        return;
+    }
+
+    get_free_block_prev(block) = no_free_block;
+    get_free_block_next(block) = *head;
+
+    if (*head != no_free_block)
+    {
+        get_free_block_prev(get_linked_block(*head)) = get_link(block);
+    }
+    *head = get_link(block);
+
+    *get_free_first_level_bitmap() |= size_t(1) << first_level;
+    get_free_second_level_bitmaps()[first_level] |= 1u << second_level;
+}
+
+void allocator_boundary_tags_compact::remove_free_block(void *block)
+{
+    size_t first_level, second_level;
+    free_index_mapping(get_block_size(block), first_level, second_level);
+
+    free_block_link prev = get_free_block_prev(block);
+    free_block_link next = get_free_block_next(block);
+
+    if (next != no_free_block)
+    {
+        get_free_block_prev(get_linked_block(next)) = prev;
+    }
+
+    if (prev != no_free_block)
+    {
+        get_free_block_next(get_linked_block(prev)) = next;
+        return;
+    }
+
+    free_block_link *head = get_free_list_head(first_level, second_level);
+    *head = next;
+
+    if (next == no_free_block)
+    {
+        unsigned char &second_level_bitmap = get_free_second_level_bitmaps()[first_level];
+        second_level_bitmap &= ~(1u << second_level);
+        if (second_level_bitmap == 0)
+        {
+            *get_free_first_level_bitmap() &= ~(size_t(1) << first_level);
+        }
+        return;
+    }
+
+    // голову заменяет наибольший из оставшихся, поиск кончается на блоке размера снятого
+    byte *largest = get_linked_block(next);
+    for (free_block_link link = get_free_block_next(largest);
+         link != no_free_block && get_block_size(largest) < get_block_size(block);
+         link = get_free_block_next(get_linked_block(link)))
+    {
+        if (get_block_size(get_linked_block(link)) > get_block_size(largest))
+        {
+            largest = get_linked_block(link);
+        }
+    }
+
+    if (get_link(largest) == next)
+    {
+        return;
+    }
+
+    free_block_link largest_prev = get_free_block_prev(largest);
+    free_block_link largest_next = get_free_block_next(largest);
+
+    get_free_block_next(get_linked_block(largest_prev)) = largest_next;
+    if (largest_next != no_free_block)
+    {
+        get_free_block_prev(get_linked_block(largest_next)) = largest_prev;
+    }
+
+    get_free_block_prev(largest) = no_free_block;
+    get_free_block_next(largest) = next;
+    get_free_block_prev(get_linked_block(next)) = get_link(largest);
+    *head = get_link(largest);
+}
+
+/** The search is the one of allocator_boundary_tags: at most max_free_list_probes blocks after the head
+ * of the bin straddling the requested size are probed, then its head, then the first non-empty bin above it
+ * is served from the bitmaps; the_worst_fit takes the head of the highest non-empty bin.
+ */
+void *allocator_boundary_tags_compact::find_free_block(size_t size, allocator_with_fit_mode::fit_mode mode) const
+{
+    size_t first_level_bitmap = *get_free_first_level_bitmap();
+
+    if (first_level_bitmap == 0)
+    {
+        return nullptr;
+    }
+
+    if (mode == allocator_with_fit_mode::fit_mode::the_worst_fit)
+    {
+        byte *largest = get_largest_free_block();
+        return get_block_size(largest) >= size ? largest : nullptr;
+    }
+
+    size_t first_level, second_level;
+    free_index_mapping(size, first_level, second_level);
+
+    if ((size & ((size_t(1) << (first_level - free_index_second_level_log2)) - 1)) != 0)
+    {
+        byte *found = probe_free_list(first_level, second_level, size, mode);
+        if (found != nullptr)
+        {
+            return found;
+        }
+        ++second_level;
+    }
+
+    size_t second_level_bitmap = second_level < free_index_second_level_count
+            ? get_free_second_level_bitmaps()[first_level] & (~0u << second_level)
+            : 0;
+
+    if (second_level_bitmap == 0)
+    {
+        first_level_bitmap = first_level + 1 < free_index_first_level_count
+                ? first_level_bitmap & (~size_t(0) << (first_level + 1))
+                : 0;
+
+        if (first_level_bitmap == 0)
+        {
+            return nullptr;
+        }
+
+        first_level = std::countr_zero(first_level_bitmap);
+        second_level_bitmap = get_free_second_level_bitmaps()[first_level];
+    }
+
+    byte *head = get_linked_block(*get_free_list_head(first_level, std::countr_zero(second_level_bitmap)));
+    free_block_link next = get_free_block_next(head);
+    return next != no_free_block ? get_linked_block(next) : head;
+}
+
+unsigned char *allocator_boundary_tags_compact::probe_free_list(size_t first_level, size_t second_level, size_t size, allocator_with_fit_mode::fit_mode mode) const
+{
+    free_block_link head_link = *get_free_list_head(first_level, second_level);
+
+    if (head_link == no_free_block || get_block_size(get_linked_block(head_link)) < size)
+    {
+        return nullptr;
+    }
+
+    byte *head = get_linked_block(head_link);
+    byte *found = nullptr;
+    free_block_link link = get_free_block_next(head);
+    for (size_t probes = 0; link != no_free_block && probes < max_free_list_probes; link = get_free_block_next(get_linked_block(link)), ++probes)
+    {
+        byte *block = get_linked_block(link);
+        size_t free_size = get_block_size(block);
+        if (free_size >= size && (found == nullptr || free_size < get_block_size(found)))
+        {
+            found = block;
+            if (mode == allocator_with_fit_mode::fit_mode::first_fit || free_size == size)
+            {
+                break;
+            }
+        }
+    }
+
+    return found != nullptr ? found : head;
+}
+
+unsigned char *allocator_boundary_tags_compact::get_largest_free_block() const noexcept
+{
+    size_t first_level_bitmap = *get_free_first_level_bitmap();
+
+    if (first_level_bitmap == 0)
+    {
+        return nullptr;
+    }
+
+    size_t first_level = std::bit_width(first_level_bitmap) - 1;
+    size_t second_level = std::bit_width(static_cast<unsigned>(get_free_second_level_bitmaps()[first_level])) - 1;
+
+    return get_linked_block(*get_free_list_head(first_level, second_level));
+}
+
+size_t allocator_boundary_tags_compact::get_largest_free_block_size() const noexcept
+{
+    byte *largest = get_largest_free_block();
+    return largest == nullptr ? 0 : get_block_size(largest);
+}
@@ -1,9 +1,16 @@
 #include <gtest/gtest.h>
 #include <allocator_dbg_helper.h>
 #include <allocator_boundary_tags.h>
+#include <allocator_boundary_tags_compact.h>
 #include <client_logger_builder.h>
+#include <algorithm>
 #include <memory>
 #include <list>
+#include <bit>
+#include <cstring>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
 
 logger *create_logger(
         std::vector<std::pair<std::string, logger::severity>> const &output_file_streams_setup,
@@ -40,9 +47,9 @@ TEST(positiveTests, test1)
                                                          }));
     std::unique_ptr<smart_mem_resource> subject(new allocator_boundary_tags(sizeof(int) * 70, nullptr, logger.get(), allocator_with_fit_mode::fit_mode::first_fit));
 
-    auto *first_block = reinterpret_cast<int *>(subject->allocate(sizeof(int) * 10));
-    auto *second_block = reinterpret_cast<int *>(subject->allocate(sizeof(int) * 10));
-    auto *third_block = reinterpret_cast<int *>(subject->allocate(sizeof(int) * 10));
+    auto *first_block = reinterpret_cast<int *>(subject->allocate(sizeof(int) * 10, 1));
+    auto *second_block = reinterpret_cast<int *>(subject->allocate(sizeof(int) * 10, 1));
+    auto *third_block = reinterpret_cast<int *>(subject->allocate(sizeof(int) * 10, 1));
 
 
 
@@ -53,9 +60,9 @@ TEST(positiveTests, test1)
 
     auto *the_same_subject = dynamic_cast<allocator_with_fit_mode *>(subject.get());
     the_same_subject->set_fit_mode(allocator_with_fit_mode::fit_mode::the_worst_fit);
-    auto  *fourth_block = reinterpret_cast<int *>(subject->allocate(sizeof(int) * 1));
+    auto  *fourth_block = reinterpret_cast<int *>(subject->allocate(sizeof(int) * 1, 1));
     the_same_subject->set_fit_mode(allocator_with_fit_mode::fit_mode::the_best_fit);
-    auto *fifth_block = reinterpret_cast<int *>(subject->allocate(sizeof(int) * 1));
+    auto *fifth_block = reinterpret_cast<int *>(subject->allocate(sizeof(int) * 1, 1));
 
     ASSERT_EQ(reinterpret_cast<int*>(reinterpret_cast<char*>(first_block + 10) + sizeof(size_t) + sizeof(void*) * 3), fourth_block);
     ASSERT_EQ(reinterpret_cast<int*>(reinterpret_cast<char*>(fourth_block + 1) + sizeof(size_t) + sizeof(void*) * 3), fifth_block);
@@ -78,16 +85,16 @@ TEST(positiveTests, test2)
                                                                   }));
     std::unique_ptr<smart_mem_resource> allocator_instance(new allocator_boundary_tags(sizeof(unsigned char) * 3000, nullptr, logger_instance.get(), allocator_with_fit_mode::fit_mode::first_fit));
 
-    char *first_block = reinterpret_cast<char *>(allocator_instance->allocate(sizeof(char) * 1000));
+    char *first_block = reinterpret_cast<char *>(allocator_instance->allocate(sizeof(char) * 1000, 1));
 //    std::cout << "Size after first allocation: " << dynamic_cast<allocator_test_utils *>(allocator_instance.get())->get_blocks_info().size() << std::endl;
 
-    char *second_block = reinterpret_cast<char *>(allocator_instance->allocate(sizeof(char) * 0));
+    char *second_block = reinterpret_cast<char *>(allocator_instance->allocate(sizeof(char) * 0, 1));
 //    std::cout << "Size after second allocation: " << dynamic_cast<allocator_test_utils *>(allocator_instance.get())->get_blocks_info().size() << std::endl;
 
     allocator_instance->deallocate(first_block, 1);
 //    std::cout << "Size after deallocation: " << dynamic_cast<allocator_test_utils *>(allocator_instance.get())->get_blocks_info().size() << std::endl;
 
-    first_block = reinterpret_cast<char *>(allocator_instance->allocate(sizeof(char) * 999));
+    first_block = reinterpret_cast<char *>(allocator_instance->allocate(sizeof(char) * 999, 1));
     //std::cout << "Size after reallocation: " << dynamic_cast<allocator_test_utils *>(allocator_instance.get())->get_blocks_info().size() << std::endl;
 
     auto actual_blocks_state = dynamic_cast<allocator_test_utils *>(allocator_instance.get())->get_blocks_info();
@@ -113,6 +120,848 @@ TEST(positiveTests, test2)
     allocator_instance->deallocate(second_block, 1);
 }
 
+TEST(positiveTests, test3)
+{
+    std::unique_ptr<smart_mem_resource> allocator_instance(new allocator_boundary_tags(10000, nullptr, nullptr, allocator_with_fit_mode::fit_mode::the_best_fit));
+
+    std::vector<size_t> sizes { 100, 10, 60, 10, 40, 10, 200 };
+    std::vector<void *> blocks;
+    for (auto size : sizes)
+    {
+        blocks.push_back(allocator_instance->allocate(sizeof(char) * size, 1));
+    }
+
+    allocator_instance->deallocate(blocks[0], 1);
+    allocator_instance->deallocate(blocks[2], 1);
+    allocator_instance->deallocate(blocks[4], 1);
+
+    auto *best = allocator_instance->allocate(sizeof(char) * 30, 1);
+    ASSERT_EQ(best, blocks[4]);
+
+    auto *the_same_subject = dynamic_cast<allocator_with_fit_mode *>(allocator_instance.get());
+    the_same_subject->set_fit_mode(allocator_with_fit_mode::fit_mode::the_worst_fit);
+    auto *worst = allocator_instance->allocate(sizeof(char) * 30, 1);
+    ASSERT_EQ(worst, reinterpret_cast<char *>(blocks[6]) + 200 + sizeof(size_t) + sizeof(void*) * 3);
+
+    allocator_instance->deallocate(best, 1);
+    allocator_instance->deallocate(worst, 1);
+    for (int i = 1; i < 7; i += 2)
+    {
+        allocator_instance->deallocate(blocks[i], 1);
+    }
+    allocator_instance->deallocate(blocks[6], 1);
+
+    auto actual_blocks_state = dynamic_cast<allocator_test_utils *>(allocator_instance.get())->get_blocks_info();
+
+    ASSERT_EQ(actual_blocks_state.size(), 1);
+    ASSERT_EQ(actual_blocks_state[0], (allocator_test_utils::block_info{ .block_size = 10000, .is_block_occupied = false }));
+}
+
+TEST(positiveTests, test4)
+{
+    struct alignas(64) counter
+    {
+        size_t value;
+    };
+
+    std::unique_ptr<smart_mem_resource> allocator_instance(new allocator_boundary_tags(10000, nullptr, nullptr, allocator_with_fit_mode::fit_mode::first_fit));
+    pp_allocator<counter> alloc(allocator_instance.get());
+
+    std::vector<void *> blocks;
+    std::vector<counter *> counters;
+    for (int i = 0; i < 10; ++i)
+    {
+        blocks.push_back(allocator_instance->allocate(sizeof(char) * (i * 13 + 1)));
+        counters.push_back(alloc.allocate_object<counter>(i % 3 + 1));
+        ASSERT_EQ(reinterpret_cast<std::uintptr_t>(counters.back()) % alignof(counter), 0);
+        counters.back()->value = i;
+    }
+
+    for (int i = 0; i < 10; ++i)
+    {
+        ASSERT_EQ(counters[i]->value, i);
+        allocator_instance->deallocate(blocks[i], 1);
+    }
+    for (int i = 0; i < 10; ++i)
+    {
+        alloc.deallocate_object(counters[i], i % 3 + 1);
+    }
+
+    auto actual_blocks_state = dynamic_cast<allocator_test_utils *>(allocator_instance.get())->get_blocks_info();
+
+    ASSERT_EQ(actual_blocks_state.size(), 1);
+    ASSERT_EQ(actual_blocks_state[0], (allocator_test_utils::block_info{ .block_size = 10000, .is_block_occupied = false }));
+}
+
+TEST(positiveTests, test5)
+{
+    std::unique_ptr<allocator_boundary_tags> parent_allocator(new allocator_boundary_tags(100'000, nullptr, nullptr, allocator_with_fit_mode::fit_mode::first_fit));
+
+    {
+        allocator_boundary_tags allocator_instance(3000, parent_allocator.get(), nullptr, allocator_with_fit_mode::fit_mode::the_best_fit, true);
+
+        std::vector<void *> blocks;
+        for (int i = 0; i < 10; ++i)
+        {
+            blocks.push_back(allocator_instance.allocate(sizeof(char) * 1000, 1));
+        }
+
+        // блок больше обычного региона получает свой регион
+        void *big_block = allocator_instance.allocate(sizeof(char) * 10000, 1);
+
+        ASSERT_EQ(allocator_instance.get_regions_count(), 6);
+
+        auto big_region_state = allocator_instance.get_region_blocks_info(1);
+
+        ASSERT_EQ(big_region_state.size(), 1);
+        ASSERT_EQ(big_region_state[0].is_block_occupied, true);
+
+        allocator_instance.deallocate(big_block, 1);
+        for (int i = 0; i < 10; i += 2)
+        {
+            allocator_instance.deallocate(blocks[i], 1);
+        }
+
+        ASSERT_EQ(allocator_instance.get_regions_count(), 5);
+
+        for (int i = 1; i < 10; i += 2)
+        {
+            allocator_instance.deallocate(blocks[i], 1);
+        }
+
+        auto actual_blocks_state = allocator_instance.get_blocks_info();
+
+        ASSERT_EQ(allocator_instance.get_regions_count(), 1);
+        ASSERT_EQ(actual_blocks_state.size(), 1);
+        ASSERT_EQ(actual_blocks_state[0], (allocator_test_utils::block_info{ .block_size = 3000, .is_block_occupied = false }));
+    }
+
+    auto parent_blocks_state = parent_allocator->get_blocks_info();
+
+    ASSERT_EQ(parent_blocks_state.size(), 1);
+    ASSERT_EQ(parent_blocks_state[0].is_block_occupied, false);
+}
+
+TEST(positiveTests, test6)
+{
+    allocator_boundary_tags allocator_instance(10000, nullptr, nullptr, allocator_with_fit_mode::fit_mode::first_fit);
+
+    auto initial = allocator_instance.get_statistics();
+
+    ASSERT_EQ(initial.total_bytes, 10000);
+    ASSERT_EQ(initial.bytes_in_use, 0);
+    ASSERT_EQ(initial.largest_free_block, 10000);
+
+    void *first_block = allocator_instance.allocate(1000, 1);
+    void *second_block = allocator_instance.allocate(1000, 1);
+    ASSERT_THROW(static_cast<void>(allocator_instance.allocate(20000, 1)), std::bad_alloc);
+
+    auto after_allocations = allocator_instance.get_statistics();
+    auto blocks_state = allocator_instance.get_blocks_info();
+
+    ASSERT_EQ(after_allocations.allocations, 2);
+    ASSERT_EQ(after_allocations.failed_allocations, 1);
+    ASSERT_EQ(after_allocations.occupied_blocks, 2);
+    ASSERT_EQ(after_allocations.bytes_in_use, blocks_state[0].block_size + blocks_state[1].block_size);
+    ASSERT_EQ(after_allocations.largest_free_block, blocks_state.back().block_size);
+    ASSERT_EQ(after_allocations.peak_bytes_in_use, after_allocations.bytes_in_use);
+    ASSERT_EQ(after_allocations.occupied_blocks_per_size_class[std::bit_width(blocks_state[0].block_size) - 1], 2);
+
+    allocator_instance.deallocate(first_block, 1);
+    allocator_instance.deallocate(second_block, 1);
+
+    auto final = allocator_instance.get_statistics();
+
+    ASSERT_EQ(final.deallocations, 2);
+    ASSERT_EQ(final.occupied_blocks, 0);
+    ASSERT_EQ(final.bytes_in_use, 0);
+    ASSERT_EQ(final.largest_free_block, 10000);
+}
+
+TEST(positiveTests, test7)
+{
+    os_memory_resource os_memory(false, 1 << 16);
+    allocator_boundary_tags allocator_instance(1 << 20, &os_memory, nullptr, allocator_with_fit_mode::fit_mode::first_fit, true);
+
+    auto *first_block = reinterpret_cast<unsigned char *>(allocator_instance.allocate(200'000, 1));
+    auto *second_block = reinterpret_cast<unsigned char *>(allocator_instance.allocate(200'000, 1));
+    auto *third_block = reinterpret_cast<unsigned char *>(allocator_instance.allocate(200'000, 1));
+    std::memset(first_block, 1, 200'000);
+    std::memset(second_block, 2, 200'000);
+    std::memset(third_block, 3, 200'000);
+
+    allocator_instance.deallocate(second_block, 1);
+
+#ifdef __linux__
+    // страницы внутри дыры отданы ОС и читаются нулями
+    ASSERT_EQ(second_block[100'000], 0);
+#endif
+    ASSERT_EQ(first_block[199'999], 1);
+    ASSERT_EQ(third_block[0], 3);
+
+    auto *again = reinterpret_cast<unsigned char *>(allocator_instance.allocate(200'000, 1));
+    ASSERT_EQ(again, second_block);
+    std::memset(again, 4, 200'000);
+
+    // второй регион тоже отображается от ОС и отдается обратно целиком
+    void *big_block = allocator_instance.allocate(2 << 20, 1);
+    ASSERT_EQ(allocator_instance.get_regions_count(), 2);
+    allocator_instance.deallocate(big_block, 1);
+    ASSERT_EQ(allocator_instance.get_regions_count(), 1);
+
+    allocator_instance.deallocate(first_block, 1);
+    allocator_instance.deallocate(again, 1);
+    allocator_instance.deallocate(third_block, 1);
+
+    auto actual_blocks_state = allocator_instance.get_blocks_info();
+    ASSERT_EQ(actual_blocks_state.size(), 1);
+    ASSERT_EQ(actual_blocks_state[0].block_size, 1 << 20);
+    ASSERT_EQ(actual_blocks_state[0].is_block_occupied, false);
+}
+
+TEST(positiveTests, test8)
+{
+    allocator_boundary_tags allocator_instance(10'000, nullptr, nullptr, allocator_with_fit_mode::fit_mode::first_fit);
+
+    void *first_block = allocator_instance.allocate(100, 1);
+
+    void *batch[20];
+    allocator_instance.allocate_batch(48, 20, batch, 1);
+
+    // пакет нарезан из одной дыры, блоки идут подряд
+    auto step = reinterpret_cast<unsigned char *>(batch[1]) - reinterpret_cast<unsigned char *>(batch[0]);
+    ASSERT_GT(step, 48);
+    for (size_t i = 1; i < 20; ++i)
+    {
+        ASSERT_EQ(reinterpret_cast<unsigned char *>(batch[i]) - reinterpret_cast<unsigned char *>(batch[i - 1]), step);
+    }
+
+    auto blocks_state = allocator_instance.get_blocks_info();
+    ASSERT_EQ(blocks_state.size(), 22);
+
+    // пакет, который не помещается, не забирает ничего
+    void *too_big_batch[100];
+    ASSERT_THROW(allocator_instance.allocate_batch(1000, 100, too_big_batch), std::bad_alloc);
+    ASSERT_EQ(allocator_instance.get_blocks_info(), blocks_state);
+
+    allocator_instance.deallocate_batch(batch, 20);
+    allocator_instance.deallocate(first_block, 1);
+
+    auto actual_blocks_state = allocator_instance.get_blocks_info();
+    ASSERT_EQ(actual_blocks_state.size(), 1);
+    ASSERT_EQ(actual_blocks_state[0].block_size, 10'000);
+    ASSERT_EQ(actual_blocks_state[0].is_block_occupied, false);
+}
+
+TEST(positiveTests, test9)
+{
+    allocator_boundary_tags_compact allocator_instance(4096, nullptr, nullptr, allocator_with_fit_mode::fit_mode::first_fit);
+
+    // 24 байта с заголовком в 8 байт занимают блок в 32 байта
+    void *first_block = allocator_instance.allocate(24);
+    void *second_block = allocator_instance.allocate(1);
+    void *third_block = allocator_instance.allocate(100);
+    ASSERT_EQ(reinterpret_cast<std::uintptr_t>(first_block) % alignof(std::max_align_t), 0);
+    ASSERT_EQ(reinterpret_cast<unsigned char *>(second_block) - reinterpret_cast<unsigned char *>(first_block), 32);
+    ASSERT_EQ(reinterpret_cast<unsigned char *>(third_block) - reinterpret_cast<unsigned char *>(second_block), 32);
+
+    std::vector<allocator_test_utils::block_info> expected_blocks_state
+        {
+            { .block_size = 32, .is_block_occupied = true },
+            { .block_size = 32, .is_block_occupied = true },
+            { .block_size = 112, .is_block_occupied = true },
+            { .block_size = 4096 - 176, .is_block_occupied = false }
+        };
+    ASSERT_EQ(allocator_instance.get_blocks_info(), expected_blocks_state);
+
+    void *aligned_block = allocator_instance.allocate(40, 256);
+    ASSERT_EQ(reinterpret_cast<std::uintptr_t>(aligned_block) % 256, 0);
+
+    ASSERT_THROW(allocator_instance.deallocate(reinterpret_cast<unsigned char *>(second_block) + 16, 1), std::logic_error);
+    ASSERT_THROW(static_cast<void>(allocator_instance.allocate(4096)), std::bad_alloc);
+
+    // свободные соседи сливаются через футер слева и заголовок справа
+    allocator_instance.deallocate(first_block, 1);
+    allocator_instance.deallocate(third_block, 1);
+    allocator_instance.deallocate(second_block, 1);
+    allocator_instance.deallocate(aligned_block, 40, 256);
+
+    expected_blocks_state = { { .block_size = 4096, .is_block_occupied = false } };
+    ASSERT_EQ(allocator_instance.get_blocks_info(), expected_blocks_state);
+    ASSERT_EQ(allocator_instance.get_statistics().bytes_in_use, 0);
+
+    void *blocks[4];
+    for (size_t i = 0; i < 4; ++i)
+    {
+        blocks[i] = allocator_instance.allocate(i % 2 == 0 ? 200 - 100 * i / 2 : 24);
+    }
+    allocator_instance.deallocate(blocks[0], 1);
+    allocator_instance.deallocate(blocks[2], 1);
+
+    allocator_instance.set_fit_mode(allocator_with_fit_mode::fit_mode::the_best_fit);
+    void *best_block = allocator_instance.allocate(90);
+    ASSERT_EQ(best_block, blocks[2]);
+
+    allocator_instance.set_fit_mode(allocator_with_fit_mode::fit_mode::the_worst_fit);
+    void *worst_block = allocator_instance.allocate(24);
+    ASSERT_EQ(reinterpret_cast<unsigned char *>(worst_block) - reinterpret_cast<unsigned char *>(blocks[3]), 32);
+
+    allocator_instance.deallocate(best_block, 1);
+    allocator_instance.deallocate(worst_block, 1);
+    allocator_instance.deallocate(blocks[1], 1);
+    allocator_instance.deallocate(blocks[3], 1);
+    ASSERT_EQ(allocator_instance.get_blocks_info(), expected_blocks_state);
+}
+
+TEST(positiveTests, test10)
+{
+    allocator_boundary_tags allocator_instance(10'000, nullptr, nullptr, allocator_with_fit_mode::fit_mode::first_fit);
+
+    constexpr size_t relocatable_size = 200;
+    constexpr size_t relocatable_block_size = relocatable_size + sizeof(size_t) + 32;
+
+    // 20 перемещаемых блоков, посередине обычный, который уплотнение не двигает
+    std::vector<allocator_boundary_tags::handle> handles;
+    void *pinned_block = nullptr;
+    for (size_t i = 0; i < 20; ++i)
+    {
+        if (i == 10)
+        {
+            pinned_block = allocator_instance.allocate(100, 1);
+        }
+        handles.push_back(allocator_instance.allocate_relocatable(relocatable_size));
+        std::memset(allocator_instance.resolve(handles.back()), static_cast<int>(i), relocatable_size);
+    }
+
+    for (size_t i = 0; i < 20; i += 2)
+    {
+        allocator_instance.deallocate_relocatable(handles[i]);
+    }
+    ASSERT_THROW(allocator_instance.deallocate_relocatable(handles[0]), std::logic_error);
+
+    size_t tail_size = 10'000 - 20 * relocatable_block_size - 132;
+    ASSERT_THROW(static_cast<void>(allocator_instance.allocate(tail_size, 1)), std::bad_alloc);
+
+    size_t slices = 1;
+    while (!allocator_instance.compact(500))
+    {
+        ++slices;
+    }
+    ASSERT_GT(slices, 2);
+
+    std::vector<allocator_test_utils::block_info> expected_blocks_state;
+    for (size_t i = 0; i < 5; ++i)
+    {
+        expected_blocks_state.push_back({ .block_size = relocatable_block_size, .is_block_occupied = true });
+    }
+    expected_blocks_state.push_back({ .block_size = 5 * relocatable_block_size, .is_block_occupied = false });
+    expected_blocks_state.push_back({ .block_size = 132, .is_block_occupied = true });
+    for (size_t i = 0; i < 5; ++i)
+    {
+        expected_blocks_state.push_back({ .block_size = relocatable_block_size, .is_block_occupied = true });
+    }
+    expected_blocks_state.push_back({ .block_size = tail_size + 5 * relocatable_block_size, .is_block_occupied = false });
+    ASSERT_EQ(allocator_instance.get_blocks_info(), expected_blocks_state);
+
+    for (size_t i = 1; i < 20; i += 2)
+    {
+        auto *data = reinterpret_cast<unsigned char *>(allocator_instance.resolve(handles[i]));
+        ASSERT_TRUE(std::all_of(data, data + relocatable_size, [i](unsigned char c) { return c == i; }));
+    }
+
+    void *big_block = allocator_instance.allocate(tail_size, 1);
+    allocator_instance.deallocate(big_block, 1);
+
+    // второй проход ничего не двигает
+    ASSERT_TRUE(allocator_instance.compact(10'000));
+    ASSERT_EQ(allocator_instance.get_blocks_info(), expected_blocks_state);
+
+    ASSERT_THROW(allocator_instance.deallocate(allocator_instance.resolve(handles[1]), 1), std::logic_error);
+
+    for (size_t i = 1; i < 20; i += 2)
+    {
+        allocator_instance.deallocate_relocatable(handles[i]);
+    }
+    allocator_instance.deallocate(pinned_block, 1);
+
+    expected_blocks_state = { { .block_size = 10'000, .is_block_occupied = false } };
+    ASSERT_EQ(allocator_instance.get_blocks_info(), expected_blocks_state);
+    ASSERT_EQ(allocator_instance.get_statistics().bytes_in_use, 0);
+}
+
+// родитель, который задерживает выделение нового региона, пока аллокатор держит блокировку
+class blocking_parent_resource final : public std::pmr::memory_resource
+{
+
+public:
+
+    std::mutex mutex;
+
+    std::condition_variable condition;
+
+    bool armed = false;
+
+    bool entered = false;
+
+    bool released = false;
+
+private:
+
+    void *do_allocate(size_t bytes, size_t alignment) override
+    {
+        std::unique_lock lock(mutex);
+        if (armed)
+        {
+            armed = false;
+            entered = true;
+            condition.notify_all();
+            condition.wait(lock, [this] { return released; });
+        }
+
+        return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void *p, size_t bytes, size_t alignment) override
+    {
+        std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override
+    {
+        return this == &other;
+    }
+
+};
+
+TEST(positiveTests, test11)
+{
+    blocking_parent_resource parent;
+    allocator_boundary_tags allocator_instance(1'000, &parent, nullptr, allocator_with_fit_mode::fit_mode::first_fit, true);
+
+    void *first_block = allocator_instance.allocate(100);
+    void *second_block = allocator_instance.allocate(100);
+
+    {
+        std::lock_guard lock(parent.mutex);
+        parent.armed = true;
+    }
+
+    // поток растит аллокатор и держит его блокировку, пока родитель не отпустит
+    void *grown_block = nullptr;
+    std::thread grower([&] { grown_block = allocator_instance.allocate(2'000); });
+
+    {
+        std::unique_lock lock(parent.mutex);
+        parent.condition.wait(lock, [&] { return parent.entered; });
+    }
+
+    // освобождения не ждут блокировку, блоки пока числятся занятыми
+    allocator_instance.deallocate(first_block, 1);
+    allocator_instance.deallocate(second_block, 1);
+
+    auto statistics = allocator_instance.get_statistics();
+    ASSERT_EQ(statistics.deallocations, 0);
+    ASSERT_EQ(statistics.remote_frees, 0);
+
+    {
+        std::lock_guard lock(parent.mutex);
+        parent.released = true;
+    }
+    parent.condition.notify_all();
+    grower.join();
+
+    ASSERT_EQ(allocator_instance.get_statistics().occupied_blocks, 3);
+
+    // следующее выделение освобождает отложенные блоки и берет место первого
+    void *reused_block = allocator_instance.allocate(100);
+    ASSERT_EQ(reused_block, first_block);
+
+    statistics = allocator_instance.get_statistics();
+    ASSERT_EQ(statistics.deallocations, 2);
+    ASSERT_EQ(statistics.remote_frees, 2);
+    ASSERT_EQ(statistics.occupied_blocks, 2);
+
+    allocator_instance.deallocate(reused_block, 1);
+    allocator_instance.deallocate(grown_block, 1);
+
+    ASSERT_EQ(allocator_instance.get_regions_count(), 1);
+    std::vector<allocator_test_utils::block_info> expected_blocks_state = { { .block_size = 1'000, .is_block_occupied = false } };
+    ASSERT_EQ(allocator_instance.get_blocks_info(), expected_blocks_state);
+    ASSERT_EQ(allocator_instance.get_statistics().bytes_in_use, 0);
+}
+
+TEST(positiveTests, test12)
+{
+    allocator_boundary_tags allocator_instance(10'000);
+    constexpr size_t block_metadata_size = sizeof(void *) + sizeof(size_t) + 2 * sizeof(void *);
+
+    std::vector<unsigned char *> blocks;
+    for (size_t i = 0; i < 8; ++i)
+    {
+        blocks.push_back(reinterpret_cast<unsigned char *>(allocator_instance.allocate(100)));
+    }
+    allocator_instance.deallocate(blocks[2], 1);
+    allocator_instance.deallocate(blocks[5], 1);
+
+    // проход по частям: шесть блоков по два за раз и дыра в конце региона
+    size_t slices_count = 1;
+    while (!allocator_instance.verify(2))
+    {
+        ++slices_count;
+    }
+    ASSERT_EQ(slices_count, 4);
+    ASSERT_TRUE(allocator_instance.verify());
+
+    // размер блока заходит на соседа
+    auto *size_field = reinterpret_cast<size_t *>(blocks[3] - block_metadata_size + sizeof(void *));
+    *size_field += 200;
+    ASSERT_THROW(static_cast<void>(allocator_instance.verify()), std::logic_error);
+    *size_field -= 200;
+    ASSERT_TRUE(allocator_instance.verify());
+
+    // заголовок дыры не совпадает с ней
+    auto *gap_size_field = reinterpret_cast<size_t *>(blocks[2] - block_metadata_size);
+    ++*gap_size_field;
+    ASSERT_THROW(static_cast<void>(allocator_instance.verify()), std::logic_error);
+    --*gap_size_field;
+    ASSERT_TRUE(allocator_instance.verify());
+
+    // блок не принадлежит аллокатору
+    auto *trusted_field = reinterpret_cast<void **>(blocks[4] - block_metadata_size);
+    void *trusted = *trusted_field;
+    *trusted_field = &allocator_instance;
+    ASSERT_THROW(static_cast<void>(allocator_instance.verify()), std::logic_error);
+    *trusted_field = trusted;
+    ASSERT_TRUE(allocator_instance.verify());
+
+    // в полном режиме связи проверяются у каждого освобождаемого блока
+    allocator_instance.set_integrity_checks(allocator_boundary_tags::integrity_checks::full);
+    auto *back_link_field = reinterpret_cast<void **>(blocks[7] - block_metadata_size + sizeof(void *) + sizeof(size_t));
+    void *back_link = *back_link_field;
+    *back_link_field = blocks[0] - block_metadata_size;
+    ASSERT_THROW(allocator_instance.deallocate(blocks[7], 1), std::logic_error);
+    *back_link_field = back_link;
+
+    for (auto *block : { blocks[0], blocks[1], blocks[3], blocks[4], blocks[6], blocks[7] })
+    {
+        allocator_instance.deallocate(block, 1);
+    }
+
+    std::vector<allocator_test_utils::block_info> expected_blocks_state = { { .block_size = 10'000, .is_block_occupied = false } };
+    ASSERT_EQ(allocator_instance.get_blocks_info(), expected_blocks_state);
+    ASSERT_TRUE(allocator_instance.verify());
+}
+
+TEST(positiveTests, test13)
+{
+    allocator_boundary_tags allocator_instance(10'000);
+    constexpr size_t block_metadata_size = sizeof(void *) + sizeof(size_t) + 2 * sizeof(void *);
+
+    auto *first_block = reinterpret_cast<unsigned char *>(allocator_instance.allocate(100, 1));
+    auto *second_block = reinterpret_cast<unsigned char *>(allocator_instance.allocate(100, 1));
+    auto *third_block = reinterpret_cast<unsigned char *>(allocator_instance.allocate(100, 1));
+
+    // включение полного режима отравляет уже свободные дыры
+    allocator_instance.set_integrity_checks(allocator_boundary_tags::integrity_checks::full);
+    ASSERT_EQ(third_block[1'000], allocator_boundary_tags::poison_byte);
+
+    allocator_instance.deallocate(second_block, 1);
+    ASSERT_EQ(second_block[0], allocator_boundary_tags::poison_byte);
+    ASSERT_EQ(second_block[99], allocator_boundary_tags::poison_byte);
+
+    // запись в освобожденную память находят и проверка, и повторная выдача
+    second_block[50] = 1;
+    ASSERT_THROW(static_cast<void>(allocator_instance.verify()), std::logic_error);
+    ASSERT_THROW(static_cast<void>(allocator_instance.allocate(100, 1)), std::logic_error);
+    second_block[50] = allocator_boundary_tags::poison_byte;
+
+    ASSERT_EQ(allocator_instance.allocate(100, 1), second_block);
+    ASSERT_TRUE(allocator_instance.verify());
+
+    // выборочный режим находит порчу за sampling_period операций
+    allocator_instance.deallocate(second_block, 1);
+    allocator_instance.set_integrity_checks(allocator_boundary_tags::integrity_checks::sampling);
+
+    auto *left_occupied_field = reinterpret_cast<void **>(second_block - block_metadata_size + sizeof(size_t) + 2 * sizeof(void *));
+    void *left_occupied = *left_occupied_field;
+    *left_occupied_field = nullptr;
+
+    auto allocate_and_deallocate = [&]
+    {
+        for (size_t i = 0; i < allocator_boundary_tags::sampling_period; ++i)
+        {
+            allocator_instance.deallocate(allocator_instance.allocate(500, 1), 1);
+        }
+    };
+    ASSERT_THROW(allocate_and_deallocate(), std::logic_error);
+    *left_occupied_field = left_occupied;
+    ASSERT_NO_THROW(allocate_and_deallocate());
+
+    allocator_instance.deallocate(first_block, 1);
+    allocator_instance.deallocate(third_block, 1);
+    ASSERT_TRUE(allocator_instance.verify());
+    ASSERT_EQ(allocator_instance.get_statistics().bytes_in_use, 0);
+
+    // отданные ОС страницы дыры читаются нулями и не считаются порчей
+    os_memory_resource os_memory;
+    allocator_boundary_tags os_allocator_instance(1 << 20, &os_memory);
+    os_allocator_instance.set_integrity_checks(allocator_boundary_tags::integrity_checks::full);
+
+    void *large_block = os_allocator_instance.allocate(1 << 19, 1);
+    std::memset(large_block, 7, 1 << 19);
+    os_allocator_instance.deallocate(large_block, 1);
+    ASSERT_TRUE(os_allocator_instance.verify());
+    os_allocator_instance.deallocate(os_allocator_instance.allocate(1 << 19, 1), 1);
+}
+
+TEST(positiveTests, test15)
+{
+    allocator_boundary_tags allocator_instance(10'000);
+    constexpr size_t block_metadata_size = sizeof(void *) + sizeof(size_t) + 2 * sizeof(void *);
+
+    auto *first_block = reinterpret_cast<unsigned char *>(allocator_instance.allocate(100));
+    auto *second_block = reinterpret_cast<unsigned char *>(allocator_instance.allocate(100));
+
+    auto **owner_field = reinterpret_cast<void **>(second_block - block_metadata_size);
+    void *owner = *owner_field;
+
+    // поток записал ссылку очереди вместо указателя на аллокатор, но еще не положил блок в очередь
+    *owner_field = first_block - block_metadata_size;
+    ASSERT_TRUE(allocator_instance.verify());
+    *owner_field = nullptr;
+    ASSERT_TRUE(allocator_instance.verify());
+
+    // ссылка за пределы аллокатора - порча
+    int outside = 0;
+    *owner_field = &outside;
+    ASSERT_THROW(static_cast<void>(allocator_instance.verify()), std::logic_error);
+
+    *owner_field = owner;
+    ASSERT_TRUE(allocator_instance.verify());
+
+    allocator_instance.deallocate(first_block, 1);
+    allocator_instance.deallocate(second_block, 1);
+    ASSERT_EQ(allocator_instance.get_statistics().bytes_in_use, 0);
+}
+
+// логгер, который задерживает сообщение об успешном выделении, пока аллокатор держит блокировку
+class blocking_logger final : public logger
+{
+
+public:
+
+    std::mutex mutex;
+
+    std::condition_variable condition;
+
+    bool armed = false;
+
+    bool entered = false;
+
+    bool released = false;
+
+    std::vector<std::string> errors;
+
+    logger &log(std::string const &message, logger::severity severity) & override
+    {
+        std::unique_lock lock(mutex);
+        if (severity == logger::severity::error)
+        {
+            errors.push_back(message);
+        }
+
+        if (armed && message.starts_with("Successfully allocated"))
+        {
+            armed = false;
+            entered = true;
+            condition.notify_all();
+            condition.wait(lock, [this] { return released; });
+        }
+
+        return *this;
+    }
+
+};
+
+TEST(positiveTests, test14)
+{
+    blocking_logger logger_instance;
+    allocator_boundary_tags_compact allocator_instance(4096, nullptr, &logger_instance, allocator_with_fit_mode::fit_mode::first_fit);
+
+    void *first_block = allocator_instance.allocate(100);
+    void *freed_block = allocator_instance.allocate(100);
+    void *second_block = allocator_instance.allocate(100);
+    allocator_instance.deallocate(freed_block, 1);
+
+    {
+        std::lock_guard lock(logger_instance.mutex);
+        logger_instance.armed = true;
+    }
+
+    // поток держит блокировку, пока логгер не отпустит; в дыру на месте freed_block блок не помещается
+    void *third_block = nullptr;
+    std::thread allocating_thread([&] { third_block = allocator_instance.allocate(200); });
+
+    {
+        std::unique_lock lock(logger_instance.mutex);
+        logger_instance.condition.wait(lock, [&] { return logger_instance.entered; });
+    }
+
+    // освобождения не ждут блокировку, блоки пока числятся занятыми; повторные отвергаются сразу,
+    // и для уже свободного блока, и для блока, который еще лежит в очереди
+    allocator_instance.deallocate(first_block, 1);
+    allocator_instance.deallocate(second_block, 1);
+    ASSERT_THROW(allocator_instance.deallocate(freed_block, 1), std::logic_error);
+    ASSERT_THROW(allocator_instance.deallocate(second_block, 1), std::logic_error);
+    ASSERT_EQ(allocator_instance.get_statistics().remote_frees, 0);
+    ASSERT_EQ(logger_instance.errors.size(), 2);
+
+    {
+        std::lock_guard lock(logger_instance.mutex);
+        logger_instance.released = true;
+    }
+    logger_instance.condition.notify_all();
+    allocating_thread.join();
+
+    ASSERT_EQ(allocator_instance.get_statistics().occupied_blocks, 3);
+
+    // следующее выделение освобождает отложенные блоки и берет место первого
+    void *reused_block = allocator_instance.allocate(100);
+    ASSERT_EQ(reused_block, first_block);
+
+    auto statistics = allocator_instance.get_statistics();
+    ASSERT_EQ(statistics.remote_frees, 2);
+    ASSERT_EQ(statistics.occupied_blocks, 2);
+    ASSERT_EQ(logger_instance.errors.size(), 2);
+
+    allocator_instance.deallocate(reused_block, 1);
+    allocator_instance.deallocate(third_block, 1);
+
+    std::vector<allocator_test_utils::block_info> expected_blocks_state { { .block_size = 4096, .is_block_occupied = false } };
+    ASSERT_EQ(allocator_instance.get_blocks_info(), expected_blocks_state);
+}
+
+TEST(positiveTests, test16)
+{
+    allocator_boundary_tags allocator_instance(10'000, nullptr, nullptr, allocator_with_fit_mode::fit_mode::first_fit);
+
+    // выравнивание не строже max_align_t тоже соблюдается, размеры блоков ему не кратны
+    std::vector<void *> blocks;
+    for (size_t i = 0; i < 8; ++i)
+    {
+        blocks.push_back(allocator_instance.allocate(13 + i, alignof(double)));
+        ASSERT_EQ(reinterpret_cast<std::uintptr_t>(blocks.back()) % alignof(double), 0);
+    }
+
+    for (size_t i = 0; i < 8; ++i)
+    {
+        blocks.push_back(allocator_instance.allocate(13 + i));
+        ASSERT_EQ(reinterpret_cast<std::uintptr_t>(blocks.back()) % alignof(std::max_align_t), 0);
+    }
+
+    // пакет выравнивает блоки так же, как allocate
+    void *batch[5];
+    allocator_instance.allocate_batch(13, 5, batch);
+    for (auto *block : batch)
+    {
+        ASSERT_EQ(reinterpret_cast<std::uintptr_t>(block) % alignof(std::max_align_t), 0);
+    }
+    allocator_instance.deallocate_batch(batch, 5);
+
+    allocator_instance.allocate_batch(13, 5, batch, 64);
+    for (auto *block : batch)
+    {
+        ASSERT_EQ(reinterpret_cast<std::uintptr_t>(block) % 64, 0);
+    }
+    allocator_instance.deallocate_batch(batch, 5);
+
+    for (auto *block : blocks)
+    {
+        allocator_instance.deallocate(block, 1);
+    }
+
+    ASSERT_EQ(allocator_instance.get_statistics().bytes_in_use, 0);
+    ASSERT_TRUE(allocator_instance.verify());
+}
+
+TEST(positiveTests, test17)
+{
+    for (auto mode : { allocator_with_fit_mode::fit_mode::first_fit, allocator_with_fit_mode::fit_mode::the_best_fit })
+    {
+        allocator_boundary_tags allocator_instance(100'000, nullptr, nullptr, mode);
+
+        // дыры одного класса размеров разделены занятыми блоками, подходит только наибольшая из них
+        void *largest = allocator_instance.allocate(1100, 1);
+        void *separator = allocator_instance.allocate(8, 1);
+
+        std::vector<void *> blocks;
+        for (size_t i = 0; i < 12; ++i)
+        {
+            blocks.push_back(allocator_instance.allocate(1000, 1));
+            blocks.push_back(allocator_instance.allocate(8, 1));
+        }
+
+        allocator_instance.deallocate(largest, 1);
+        for (size_t i = 0; i < blocks.size(); i += 2)
+        {
+            allocator_instance.deallocate(blocks[i], 1);
+        }
+
+        // просмотр класса ограничен, но наибольшая дыра стоит в его голове и находится сразу
+        void *block = allocator_instance.allocate(1090, 1);
+        ASSERT_EQ(block, largest);
+        ASSERT_TRUE(allocator_instance.verify());
+
+        allocator_instance.deallocate(block, 1);
+        allocator_instance.deallocate(separator, 1);
+        for (size_t i = 1; i < blocks.size(); i += 2)
+        {
+            allocator_instance.deallocate(blocks[i], 1);
+        }
+
+        ASSERT_EQ(allocator_instance.get_blocks_info().size(), 1);
+    }
+}
+
+TEST(positiveTests, test18)
+{
+    allocator_boundary_tags_compact allocator_instance(40'000, nullptr, nullptr, allocator_with_fit_mode::fit_mode::first_fit);
+
+    // блоки одного класса размеров: 1136 байт с заголовком и двенадцать по 1040, разделенные занятыми
+    void *largest = allocator_instance.allocate(1128);
+    void *separator = allocator_instance.allocate(24);
+
+    std::vector<void *> blocks;
+    for (size_t i = 0; i < 12; ++i)
+    {
+        blocks.push_back(allocator_instance.allocate(1032));
+        blocks.push_back(allocator_instance.allocate(24));
+    }
+
+    allocator_instance.deallocate(largest, 1);
+    for (size_t i = 0; i < blocks.size(); i += 2)
+    {
+        allocator_instance.deallocate(blocks[i], 1);
+    }
+
+    auto blocks_state = allocator_instance.get_blocks_info();
+    ASSERT_EQ(allocator_instance.get_statistics().largest_free_block, blocks_state.back().block_size);
+
+    // наибольший блок класса стоит в голове списка и находится без обхода всего класса
+    void *block = allocator_instance.allocate(1100);
+    ASSERT_EQ(block, largest);
+
+    allocator_instance.deallocate(block, 1);
+    allocator_instance.deallocate(separator, 1);
+    for (size_t i = 1; i < blocks.size(); i += 2)
+    {
+        allocator_instance.deallocate(blocks[i], 1);
+    }
+
+    ASSERT_EQ(allocator_instance.get_blocks_info().size(), 1);
+    ASSERT_EQ(allocator_instance.get_statistics().largest_free_block, allocator_instance.get_blocks_info()[0].block_size);
+}
+
 TEST(falsePositiveTests, test1)
 {
     std::unique_ptr<logger> logger_instance(create_logger(std::vector<std::pair<std::string, logger::severity>>
@@ -3,13 +3,18 @@
 
 #include <pp_allocator.h>
 #include <allocator_test_utils.h>
+#include <allocator_statistics.h>
 #include <allocator_with_fit_mode.h>
-#include <logger_guardant.h>
+#include <os_memory_resource.h>
+#include <allocator_logger_guardant.h>
+#include <remote_free_queue.h>
 #include <typename_holder.h>
 
 #include <memory_resource>
 #include <mutex>
 #include <cmath>
+#include <cstdint>
+#include <limits>
 
 namespace __detail
 {
@@ -36,32 +41,88 @@ namespace __detail
 class allocator_buddies_system final :
         public smart_mem_resource,
         public allocator_test_utils,
+        public allocator_statistics,
         public allocator_with_fit_mode,
-        private logger_guardant,
+        private allocator_logger_guardant,
         private typename_holder
 {
 private:
+    // pending - блок занят, но уже лежит в очереди освобождений
     struct block_metadata {
         bool occupied : 1;
-        unsigned char size : 7;
+        bool pending : 1;
+        unsigned char size : 6;
     };
 
     void* _trusted_memory;
 
-    static constexpr const size_t allocator_metadata_size =
-            sizeof(logger*) + sizeof(std::pmr::memory_resource*) + sizeof(fit_mode) + sizeof(unsigned char) + sizeof(std::mutex);
+    /**
+     * Free blocks of every order form an intrusive doubly linked list. Links are numbers of min_k sized
+     * units from the start of the space, so they fit into the smallest block next to its metadata.
+     */
+    using free_block_link = uint32_t;
 
+    static constexpr const free_block_link no_free_block = std::numeric_limits<free_block_link>::max();
+
+    static constexpr const size_t orders_count = sizeof(size_t) * 8;
+
+    // мета: логгер, родительский аллокатор, фит мод, степень размера, флаг освобождения с размером, мьютекс,
+    // битовая карта непустых порядков, головы списков, очередь освобождений из других потоков (выровнена),
+    // счетчики статистики (выровнены)
+    // ожидание на невыровненном мьютексе завершается ошибкой futex
+    static constexpr const size_t mutex_offset =
+            (sizeof(logger*) + sizeof(std::pmr::memory_resource*) + sizeof(fit_mode) + sizeof(unsigned char) + sizeof(bool) +
+             alignof(std::mutex) - 1) & ~(alignof(std::mutex) - 1);
+
+    static constexpr const size_t remote_frees_offset =
+            (mutex_offset + sizeof(std::mutex) + sizeof(size_t) + orders_count * sizeof(free_block_link) +
+             alignof(remote_free_queue) - 1) & ~(alignof(remote_free_queue) - 1);
+
+    static constexpr const size_t counters_offset =
+            (remote_frees_offset + sizeof(remote_free_queue) +
+             alignof(allocator_statistics::counters) - 1) & ~(alignof(allocator_statistics::counters) - 1);
+
+    // пространство начинается с выравнивания max_align_t, как и память от родителя
+    static constexpr const size_t allocator_metadata_size = (counters_offset + sizeof(allocator_statistics::counters) +
+                                                             alignof(std::max_align_t) - 1) & ~(alignof(std::max_align_t) - 1);
+
+    static_assert(allocator_metadata_size % alignof(std::max_align_t) == 0, "blocks must start aligned");
+
+    // мета занятого блока: block_metadata и указатель на начало блока, лежащий прямо перед данными
     static constexpr const size_t occupied_block_metadata_size = sizeof(block_metadata) + sizeof(void*);
-    static constexpr const size_t free_block_metadata_size = sizeof(block_metadata);
+
+    // при освобождении с размером блоку с выравниванием не строже max_align_t указатель на начало не нужен:
+    // данные лежат на первой границе выравнивания за block_metadata
+    static constexpr const size_t sized_occupied_block_metadata_size = sizeof(block_metadata);
+
+    // мета свободного блока: block_metadata, выравнивание, предыдущий и следующий свободный блок того же порядка
+    static constexpr const size_t free_block_metadata_size = sizeof(free_block_link) + 2 * sizeof(free_block_link);
 
     static constexpr const size_t min_k = __detail::nearest_greater_k_of_2(occupied_block_metadata_size);
 
+    static_assert((size_t(1) << min_k) >= free_block_metadata_size, "free block links must fit into the smallest block");
+
+    static_assert((size_t(1) << min_k) >= alignof(std::max_align_t), "every block must start aligned to max_align_t");
+
+    // блок в очереди освобождений связан словом за block_metadata, на месте указателя на начало блока
+    static constexpr const size_t remote_free_link_offset = sizeof(void*);
+
+    static_assert((size_t(1) << min_k) >= remote_free_link_offset + sizeof(void*), "a queued block must hold its link");
+
 public:
+    /**
+     * With an os_memory_resource as the parent allocator the space is mapped from the OS and committed lazily,
+     * and the pages of large merged free blocks are given back to the OS.
+     * With sized_frees the callers promise to free every block through deallocate with the size and alignment
+     * it was allocated with. Blocks aligned not stricter than max_align_t then keep only block_metadata before
+     * the data, padded up to the alignment, and a free that names another size than the block's one is rejected.
+     */
     explicit allocator_buddies_system(
             size_t space_size_power_of_two,
             std::pmr::memory_resource* parent_allocator = nullptr,
             logger* logger = nullptr,
-            fit_mode allocate_fit_mode = fit_mode::first_fit);
+            fit_mode allocate_fit_mode = fit_mode::first_fit,
+            bool sized_frees = false);
 
     allocator_buddies_system(const allocator_buddies_system& other) = delete;
     allocator_buddies_system& operator=(const allocator_buddies_system& other);
@@ -72,7 +133,23 @@ public:
     ~allocator_buddies_system() override;
 
     [[nodiscard]] void* do_allocate_sm(size_t size) override;
+    [[nodiscard]] void* do_allocate_aligned_sm(size_t size, size_t alignment) override;
+
+    /**
+     * When another thread holds the lock, the block is checked and put into the remote free queue
+     * instead of waiting; the next thread to take the lock merges it with its buddies.
+     * Until then the block is still counted and listed as occupied, and it is marked as queued in its
+     * metadata, so freeing it once more before it leaves the queue is rejected like any other double free.
+     */
     void do_deallocate_sm(void* at) override;
+    void do_deallocate_sized_sm(void* at, size_t size, size_t alignment) override;
+
+    /**
+     * The batch is cut from one block big enough for all of it: the block is split down to the order
+     * of one block, the halves past the last needed one go back to the free lists whole.
+     */
+    void do_allocate_batch_sm(size_t size, size_t count, void** out, size_t alignment) override;
+    void do_deallocate_batch_sm(void* const* blocks, size_t count) override;
 
     bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
 
@@ -81,6 +158,8 @@ public:
     std::vector<allocator_test_utils::block_info> get_blocks_info() const noexcept override;
     std::vector<allocator_test_utils::block_info> get_blocks_info_inner() const override;
 
+    statistics_snapshot get_statistics() const noexcept override;
+
 private:
     inline logger* get_logger() const override;
     inline std::string get_typename() const override;
@@ -89,16 +168,71 @@ private:
             size_t space_size,
             std::pmr::memory_resource* parent_allocator,
             logger* logger = nullptr,
-            fit_mode allocate_fit_mode = fit_mode::first_fit);
+            fit_mode allocate_fit_mode = fit_mode::first_fit,
+            bool sized_frees = false);
+
+    // returns the trusted memory to the allocator it was taken from
+    void release_trusted_memory() noexcept;
 
     inline std::mutex& get_mutex() noexcept;
+    inline bool is_sized_frees() const noexcept;
+
+    // мета перед данными блока с данным выравниванием
+    inline size_t get_occupied_metadata_size(size_t alignment) const noexcept;
+    inline std::pmr::memory_resource* get_parent_allocator() const noexcept;
+    inline allocator_statistics::counters& get_counters() const noexcept;
+    size_t get_largest_free_block_size() const noexcept;
 
     size_t get_size_full() const noexcept;
     static inline size_t get_size_block(void* block) noexcept;
 
-    void* get_first_suitable(size_t size) const noexcept;
-    void* get_best_suitable(size_t size) const noexcept;
-    void* get_worst_suitable(size_t size) const noexcept;
+    void* get_first_suitable(size_t size) noexcept;
+    void* get_best_suitable(size_t size) noexcept;
+    void* get_worst_suitable(size_t size) noexcept;
+
+    inline void* get_space_start() const noexcept;
+    inline size_t* get_free_orders_bitmap() const noexcept;
+    inline free_block_link* get_free_list_head(size_t order) const noexcept;
+    inline free_block_link get_block_link(void* block) const noexcept;
+    inline void* get_linked_block(free_block_link link) const noexcept;
+    static inline free_block_link& get_free_block_prev(void* block) noexcept;
+    static inline free_block_link& get_free_block_next(void* block) noexcept;
+
+    void push_free_block(void* block, size_t order) noexcept;
+    void remove_free_block(void* block, size_t order) noexcept;
+    void* pop_free_block(size_t order) noexcept;
+
+    // splits the block into blocks of the given order while the batch still needs them
+    void carve_batch(void* block, size_t block_order, size_t order, size_t alignment, void**& out, size_t& remaining) noexcept;
+
+    // data of an occupied block placed at the alignment after its metadata
+    void* get_block_data(void* block, size_t alignment) const noexcept;
+
+    // frees a block under the lock taken by the caller; size 0 means the caller does not know it
+    void deallocate_block(void* at, size_t size = 0, size_t alignment = 1);
+
+    // the block of the data, checked to be an occupied block of this allocator; does not need the lock
+    block_metadata* get_block_to_free(void* at, size_t size, size_t alignment);
+
+    void free_block(block_metadata* block);
+
+    /**
+     * The metadata of an occupied block is marked as queued without the lock while the lock holder may read it,
+     * so it is read and changed atomically. The mark is set only on an occupied block that is not queued yet.
+     */
+    static inline block_metadata load_metadata(block_metadata* block) noexcept;
+    static inline void store_metadata(block_metadata* block, block_metadata metadata) noexcept;
+    static bool try_mark_pending(block_metadata* block) noexcept;
+
+    // takes the lock only if it is free, otherwise queues the block
+    void deallocate_or_defer(void* at, size_t size, size_t alignment);
+
+    inline remote_free_queue& get_remote_frees() const noexcept;
+
+    // frees the blocks other threads queued, under the lock taken by the caller
+    void drain_remote_frees();
+
+    std::unique_lock<std::mutex> lock_and_drain();
 
     class buddy_iterator {
         void* _block;
@@ -0,0 +1,148 @@
+#ifndef MATH_PRACTICE_AND_OPERATING_SYSTEMS_ALLOCATOR_ALLOCATOR_BUDDIES_SYSTEM_CONCURRENT_H
+#define MATH_PRACTICE_AND_OPERATING_SYSTEMS_ALLOCATOR_ALLOCATOR_BUDDIES_SYSTEM_CONCURRENT_H
+
+#include <allocator_buddies_system.h>
+#include <allocator_statistics.h>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Buddy system without a lock. Every order has an atomic bitmap with one bit per block of that order,
+ * a set bit means the block is free and belongs to nobody. A thread owns a block after clearing its bit with
+ * a CAS, splits it by setting the bit of the right half and merges a freed block by clearing the bit of its
+ * buddy. Every thread searches from the place where it last freed or found a block, and threads start at
+ * different places, so they mostly take blocks of different subtrees and touch different words.
+ * When two buddies are freed at the same moment both may stay free unmerged. Such pairs are merged before
+ * an allocation is refused, so a request fails only if the memory is really not there.
+ * get_blocks_info() reads a consistent state only when no other thread uses the allocator.
+ * The statistics are counted with relaxed atomic operations by every thread, the counters have their own cache
+ * lines; the largest free block is found from the free block counts of the orders when the statistics are read.
+ */
+class allocator_buddies_system_concurrent final :
+        public smart_mem_resource,
+        public allocator_test_utils,
+        public allocator_with_fit_mode,
+        public allocator_statistics,
+        private allocator_logger_guardant,
+        private typename_holder
+{
+private:
+    struct block_metadata {
+        bool occupied : 1;
+        unsigned char size : 7;
+    };
+
+    using bitmap_word = std::uint64_t;
+
+    static constexpr const size_t bitmap_word_bits = sizeof(bitmap_word) * 8;
+
+    static constexpr const size_t orders_count = sizeof(size_t) * 8;
+
+    /**
+     * Besides the bitmap every order has a summary with one bit per bitmap word that may be non-zero, so
+     * a search skips empty words 64 at a time, and a count of free blocks to skip empty orders. Both are
+     * hints: they may be briefly stale, and a search that found nothing looks at the bitmaps themselves.
+     */
+    struct alignas(64) order_state {
+        std::atomic<std::ptrdiff_t> free_blocks;
+        size_t words_count;
+        size_t summary_words_count;
+        size_t bitmap_offset;
+        size_t summary_offset;
+    };
+
+    void* _trusted_memory;
+
+    // мета: логгер, родительский аллокатор, фит мод, степень размера, размер меты; счетчики статистики;
+    // состояния порядков (по кэш-линии на порядок); битовые карты и сводки порядков; пространство блоков
+    // выровнено на 64
+    static constexpr const size_t fit_mode_offset = sizeof(logger*) + sizeof(std::pmr::memory_resource*);
+
+    static constexpr const size_t space_power_offset = fit_mode_offset + sizeof(std::atomic<fit_mode>);
+
+    static constexpr const size_t metadata_size_offset =
+            (space_power_offset + sizeof(unsigned char) + alignof(size_t) - 1) & ~(alignof(size_t) - 1);
+
+    // счетчики меняют все потоки, поэтому они не делят кэш-линию с остальной метой
+    static constexpr const size_t counters_offset =
+            (metadata_size_offset + sizeof(size_t) + alignof(order_state) - 1) & ~(alignof(order_state) - 1);
+
+    static constexpr const size_t order_states_offset =
+            (counters_offset + sizeof(allocator_statistics::counters) + alignof(order_state) - 1) & ~(alignof(order_state) - 1);
+
+    static constexpr const size_t bitmaps_offset = order_states_offset + orders_count * sizeof(order_state);
+
+    // мета занятого блока: block_metadata и указатель на начало блока, лежащий прямо перед данными
+    static constexpr const size_t occupied_block_metadata_size = sizeof(block_metadata) + sizeof(void*);
+
+    static constexpr const size_t min_k = __detail::nearest_greater_k_of_2(occupied_block_metadata_size);
+
+public:
+    explicit allocator_buddies_system_concurrent(
+            size_t space_size_power_of_two,
+            std::pmr::memory_resource* parent_allocator = nullptr,
+            logger* logger = nullptr,
+            fit_mode allocate_fit_mode = fit_mode::first_fit);
+
+    allocator_buddies_system_concurrent(const allocator_buddies_system_concurrent& other) = delete;
+    allocator_buddies_system_concurrent& operator=(const allocator_buddies_system_concurrent& other) = delete;
+
+    allocator_buddies_system_concurrent(allocator_buddies_system_concurrent&& other) noexcept;
+    allocator_buddies_system_concurrent& operator=(allocator_buddies_system_concurrent&& other) noexcept;
+
+    ~allocator_buddies_system_concurrent() override;
+
+    [[nodiscard]] void* do_allocate_sm(size_t size) override;
+    [[nodiscard]] void* do_allocate_aligned_sm(size_t size, size_t alignment) override;
+    void do_deallocate_sm(void* at) override;
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+    void set_fit_mode(fit_mode mode) override;
+
+    std::vector<allocator_test_utils::block_info> get_blocks_info() const override;
+
+    statistics_snapshot get_statistics() const noexcept override;
+
+private:
+    std::vector<allocator_test_utils::block_info> get_blocks_info_inner() const override;
+
+    inline logger* get_logger() const override;
+    inline std::string get_typename() const override;
+
+    void release_memory() noexcept;
+
+    inline std::pmr::memory_resource* get_parent_allocator() const noexcept;
+    inline std::atomic<fit_mode>& get_fit_mode() const noexcept;
+    inline size_t get_space_power() const noexcept;
+    inline size_t get_metadata_size() const noexcept;
+    inline void* get_space_start() const noexcept;
+    inline allocator_statistics::counters& get_counters() const noexcept;
+
+    inline order_state& get_order_state(size_t order) const noexcept;
+    inline std::atomic<bitmap_word>* get_bitmap(size_t order) const noexcept;
+    inline std::atomic<bitmap_word>* get_summary(size_t order) const noexcept;
+
+    // takes any free block of the order, no_block if none is found
+    size_t take_free_block(size_t order, bool exhaustive) noexcept;
+    bool try_take_block(size_t order, size_t index) noexcept;
+    void put_free_block(size_t order, size_t index) noexcept;
+
+    // merges a block that is owned by the caller with its free buddies and puts the result into the bitmaps
+    void release_block(size_t order, size_t index) noexcept;
+
+    // merges the pairs of free buddies left unmerged by simultaneous frees
+    void merge_free_buddies() noexcept;
+
+    void* take_block(size_t order, bool exhaustive) noexcept;
+
+    // word of the order's bitmap where the calling thread last put or took a block
+    size_t& get_thread_hint(size_t order) const noexcept;
+
+    static size_t get_thread_slot() noexcept;
+
+    static constexpr const size_t no_block = static_cast<size_t>(-1);
+};
+
+#endif // MATH_PRACTICE_AND_OPERATING_SYSTEMS_ALLOCATOR_ALLOCATOR_BUDDIES_SYSTEM_CONCURRENT_H
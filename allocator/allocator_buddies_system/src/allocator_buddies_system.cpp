@@ -2,18 +2,27 @@
 #include <new>
 #include <cstring>
 #include <iostream>
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <atomic>
 
 allocator_buddies_system::allocator_buddies_system(
         size_t space_size_power_of_two,
         std::pmr::memory_resource* parent_allocator,
         logger* log,
-        fit_mode mode)
+        fit_mode mode,
+        bool sized_frees)
 {
     if (space_size_power_of_two < min_k) {
         throw std::invalid_argument("space_size must be at least " + std::to_string(min_k));
     }
 
-    size_t real_size = (1 << space_size_power_of_two) + allocator_metadata_size;
+    if (space_size_power_of_two - min_k >= sizeof(free_block_link) * 8) {
+        throw std::invalid_argument("space_size must be less than " + std::to_string(min_k + sizeof(free_block_link) * 8));
+    }
+
+    size_t real_size = (size_t(1) << space_size_power_of_two) + allocator_metadata_size;
 
     if (parent_allocator == nullptr)
     {
@@ -29,7 +38,7 @@ allocator_buddies_system::allocator_buddies_system(
     {
         try
         {
-            _trusted_memory = parent_allocator->allocate(real_size, 1);
+            _trusted_memory = parent_allocator->allocate(real_size, alignof(std::max_align_t));
         }
         catch (std::bad_alloc& ex)
         {
@@ -38,17 +47,14 @@ allocator_buddies_system::allocator_buddies_system(
         }
     }
 
-    fill_allocator_fields(space_size_power_of_two, parent_allocator, log, mode);
+    fill_allocator_fields(space_size_power_of_two, parent_allocator, log, mode, sized_frees);
 }
 
 
 allocator_buddies_system::~allocator_buddies_system() {
     trace_with_guard( "~allocator_buddies_system");
 
-    if (_trusted_memory) {
-        get_mutex().~mutex();
-        ::operator delete(_trusted_memory);
-    }
+    release_trusted_memory();
 }
 
 allocator_buddies_system::allocator_buddies_system(allocator_buddies_system&& other) noexcept {
@@ -58,6 +64,7 @@ allocator_buddies_system::allocator_buddies_system(allocator_buddies_system&& ot
 
 allocator_buddies_system& allocator_buddies_system::operator=(allocator_buddies_system&& other) noexcept {
     if (this != &other) {
+        release_trusted_memory();
         _trusted_memory = other._trusted_memory;
         other._trusted_memory = nullptr;
     }
@@ -66,31 +73,64 @@ allocator_buddies_system& allocator_buddies_system::operator=(allocator_buddies_
 
 allocator_buddies_system& allocator_buddies_system::operator=(const allocator_buddies_system& other) {
     if (this != &other) {
-        if (_trusted_memory) {
-            ::operator delete(_trusted_memory);
-        }
+        void* copy = nullptr;
 
         if (other._trusted_memory) {
-            size_t k = *reinterpret_cast<unsigned char*>(
-                    static_cast<char*>(other._trusted_memory) + sizeof(logger*) + sizeof(allocator_dbg_helper*) + sizeof(fit_mode));
-            size_t size = (1 << k) + allocator_metadata_size;
-
-            _trusted_memory = ::operator new(size);
-            std::memcpy(_trusted_memory, other._trusted_memory, size);
-        } else {
-            _trusted_memory = nullptr;
+            size_t size = other.get_size_full() + allocator_metadata_size;
+
+            // отложенные освобождения другого аллокатора доводятся до конца, чтобы копия их не унаследовала
+            auto lock = const_cast<allocator_buddies_system&>(other).lock_and_drain();
+
+            // копия берет память у того же родителя, что и оригинал: указатель на него копируется вместе с метой
+            std::pmr::memory_resource* parent_allocator = other.get_parent_allocator();
+            try {
+                copy = parent_allocator == nullptr ? ::operator new(size) : parent_allocator->allocate(size, alignof(std::max_align_t));
+            } catch (std::bad_alloc&) {
+                error_with_guard("Bad allocation memory for the copy");
+                throw;
+            }
+
+            std::memcpy(copy, other._trusted_memory, size);
+        }
+
+        release_trusted_memory();
+        _trusted_memory = copy;
+
+        if (_trusted_memory) {
+            new (&get_mutex()) std::mutex;
+            new (static_cast<char*>(_trusted_memory) + remote_frees_offset) remote_free_queue;
         }
     }
     return *this;
 }
 
+void allocator_buddies_system::release_trusted_memory() noexcept {
+    if (_trusted_memory == nullptr) {
+        return;
+    }
+
+    std::pmr::memory_resource* parent_allocator = get_parent_allocator();
+    size_t real_size = get_size_full() + allocator_metadata_size;
+
+    get_mutex().~mutex();
+
+    if (parent_allocator == nullptr) {
+        ::operator delete(_trusted_memory);
+    } else {
+        parent_allocator->deallocate(_trusted_memory, real_size, alignof(std::max_align_t));
+    }
+
+    _trusted_memory = nullptr;
+}
+
 
 // заполнение меты
 void allocator_buddies_system::fill_allocator_fields(
         size_t space_size,
         std::pmr::memory_resource* parent_allocator,
         logger* log,
-        fit_mode mode)
+        fit_mode mode,
+        bool sized_frees)
 {
     void* mem = _trusted_memory;
 
@@ -106,22 +146,54 @@ void allocator_buddies_system::fill_allocator_fields(
     *reinterpret_cast<unsigned char*>(mem) = static_cast<unsigned char>(space_size);
     mem = static_cast<char*>(mem) + sizeof(unsigned char);
 
+    *reinterpret_cast<bool*>(mem) = sized_frees;
+    mem = static_cast<char*>(_trusted_memory) + mutex_offset;
+
     new (mem) std::mutex;
     mem = static_cast<char*>(mem) + sizeof(std::mutex);
 
+    *reinterpret_cast<size_t*>(mem) = 0;
+    mem = static_cast<char*>(mem) + sizeof(size_t);
+
+    std::fill_n(reinterpret_cast<free_block_link*>(mem), orders_count, no_free_block);
+
+    new (static_cast<char*>(_trusted_memory) + remote_frees_offset) remote_free_queue;
+
+    new (static_cast<char*>(_trusted_memory) + counters_offset) allocator_statistics::counters(size_t(1) << space_size);
+    mem = get_space_start();
+
     auto* block = reinterpret_cast<block_metadata*>(mem);
     block->occupied = false;
+    block->pending = false;
     block->size = static_cast<unsigned char>(space_size);
+
+    push_free_block(block, space_size);
 }
 
 void* allocator_buddies_system::do_allocate_sm(size_t size) {
-    std::lock_guard lock(get_mutex());
+    return do_allocate_aligned_sm(size, 1);
+}
+
+/** For alignment the block is taken larger by alignment - 1 bytes and the data is moved right inside it,
+ * so the pointer to the block start is kept right before the data, not right after block_metadata.
+ */
+void* allocator_buddies_system::do_allocate_aligned_sm(size_t size, size_t alignment) {
+    auto lock = lock_and_drain();
+
+    size_t metadata_size = get_occupied_metadata_size(alignment);
+
+    if (size > std::numeric_limits<size_t>::max() - metadata_size - alignment) {
+        error_with_guard("Requested size is too big");
+        get_counters().on_failed_allocation();
+        throw std::bad_alloc();
+    }
 
-    size_t required = size + occupied_block_metadata_size; // с учетом меты
+    size_t required = size + metadata_size + alignment - 1; // с учетом меты и выравнивания
     void* block = nullptr;
 
     switch (*reinterpret_cast<fit_mode*>(
             static_cast<char*>(_trusted_memory) + sizeof(logger*) + sizeof(allocator_dbg_helper*))) {
+        case fit_mode::next_fit:
         case fit_mode::first_fit:
             block = get_first_suitable(required);
             break;
@@ -133,22 +205,28 @@ void* allocator_buddies_system::do_allocate_sm(size_t size) {
             break;
     }
 
-    if (!block) return nullptr;
+    if (!block) {
+        error_with_guard("No free block for requested size");
+        get_counters().on_failed_allocation();
+        throw std::bad_alloc();
+    }
 
     auto* meta = reinterpret_cast<block_metadata*>(block);
     size_t block_size = get_size_block(block);
 
-    // делим пока возможно
+    // делим пока возможно, правые половины уходят в списки своих порядков
     while (block_size >= 2 * required &&
            meta->size > min_k ) {
 
         size_t new_size = meta->size - 1;
-        size_t half = 1 << new_size;
+        size_t half = size_t(1) << new_size;
 
 
         auto* buddy = reinterpret_cast<block_metadata*>(static_cast<char*>(block) + half);
         buddy->occupied = false;
+        buddy->pending = false;
         buddy->size = new_size;
+        push_free_block(buddy, new_size);
 
 
         meta->size = new_size;
@@ -156,37 +234,367 @@ void* allocator_buddies_system::do_allocate_sm(size_t size) {
     }
 
     meta->occupied = true;
-    return static_cast<char*>(block) + occupied_block_metadata_size;
+
+    get_counters().on_allocate(block_size);
+    get_counters().set_largest_free_block(get_largest_free_block_size());
+
     // указатель после меты
+    return get_block_data(block, alignment);
+}
+
+void allocator_buddies_system::do_allocate_batch_sm(size_t size, size_t count, void** out, size_t alignment) {
+    auto lock = lock_and_drain();
+
+    size_t metadata_size = get_occupied_metadata_size(alignment);
+
+    if (size > std::numeric_limits<size_t>::max() - metadata_size - alignment) {
+        error_with_guard("Requested size is too big");
+        get_counters().on_failed_allocation();
+        throw std::bad_alloc();
+    }
+
+    size_t order = std::max(__detail::nearest_greater_k_of_2(size + metadata_size + alignment - 1), min_k);
+    // порядок блока, в котором помещается весь пакет
+    size_t run_order = order + std::bit_width(count - 1);
+
+    auto fit = *reinterpret_cast<fit_mode*>(
+            static_cast<char*>(_trusted_memory) + sizeof(logger*) + sizeof(allocator_dbg_helper*));
+
+    void** next_out = out;
+    size_t remaining = count;
+
+    while (remaining != 0) {
+        size_t free_orders = order < orders_count ? *get_free_orders_bitmap() & (~size_t(0) << order) : 0;
+        if (free_orders == 0) {
+            break;
+        }
+
+        // если целого блока на пакет нет, берется наибольший из имеющихся, остаток - следующим
+        size_t suitable_orders = run_order < orders_count ? free_orders & (~size_t(0) << run_order) : 0;
+        size_t block_order = fit != fit_mode::the_worst_fit && suitable_orders != 0
+                ? std::countr_zero(suitable_orders)
+                : std::bit_width(free_orders) - 1;
+
+        carve_batch(pop_free_block(block_order), block_order, order, alignment, next_out, remaining);
+    }
+
+    size_t allocated = count - remaining;
+    for (size_t i = 0; i < allocated; ++i) {
+        get_counters().on_allocate(size_t(1) << order);
+    }
+
+    if (remaining != 0) {
+        // все или ничего: уже выданные блоки возвращаются
+        for (size_t i = 0; i < allocated; ++i) {
+            deallocate_block(out[i]);
+        }
+        error_with_guard("No free blocks for requested batch");
+        get_counters().on_failed_allocation();
+        throw std::bad_alloc();
+    }
+
+    get_counters().set_largest_free_block(get_largest_free_block_size());
+}
+
+void allocator_buddies_system::do_deallocate_batch_sm(void* const* blocks, size_t count) {
+    auto lock = lock_and_drain();
+
+    for (size_t i = 0; i < count; ++i) {
+        deallocate_block(blocks[i]);
+    }
+}
+
+void allocator_buddies_system::carve_batch(void* block, size_t block_order, size_t order, size_t alignment, void**& out, size_t& remaining) noexcept {
+    auto* meta = reinterpret_cast<block_metadata*>(block);
+
+    if (remaining == 0) {
+        meta->occupied = false;
+        meta->pending = false;
+        meta->size = block_order;
+        push_free_block(block, block_order);
+        return;
+    }
+
+    if (block_order == order) {
+        meta->occupied = true;
+        meta->pending = false;
+        meta->size = order;
+
+        *out++ = get_block_data(block, alignment);
+        --remaining;
+        return;
+    }
+
+    size_t half = size_t(1) << (block_order - 1);
+    carve_batch(block, block_order - 1, order, alignment, out, remaining);
+    carve_batch(static_cast<char*>(block) + half, block_order - 1, order, alignment, out, remaining);
+}
+
+void* allocator_buddies_system::get_block_data(void* block, size_t alignment) const noexcept {
+    size_t metadata_size = get_occupied_metadata_size(alignment);
+
+    auto data = reinterpret_cast<std::uintptr_t>(block) + metadata_size;
+    data += -data & (alignment - 1);
+
+    if (metadata_size == occupied_block_metadata_size) {
+        *reinterpret_cast<void**>(data - sizeof(void*)) = block;
+    }
+    return reinterpret_cast<void*>(data);
 }
 
 void allocator_buddies_system::do_deallocate_sm(void* at) {
-    std::lock_guard lock(get_mutex());
+    deallocate_or_defer(at, 0, 1);
+}
 
+/** With sized frees a block aligned not stricter than max_align_t is found right before the data without reading
+ * the pointer to its start, and its order is checked against the one the size gives.
+ */
+void allocator_buddies_system::do_deallocate_sized_sm(void* at, size_t size, size_t alignment) {
+    deallocate_or_defer(at, size, alignment);
+}
+
+void allocator_buddies_system::deallocate_or_defer(void* at, size_t size, size_t alignment) {
     if (!at) return;
-    auto* block = reinterpret_cast<block_metadata*>(static_cast<char*>(at) - occupied_block_metadata_size);
-    block->occupied = false;
 
-    while (true) {
-        size_t offset = reinterpret_cast<char*>(block) - static_cast<char*>(_trusted_memory) - allocator_metadata_size;
+    auto lock = get_counters().try_lock(get_mutex());
+    if (!lock.owns_lock()) {
+        // занятый блок никто, кроме освобождающего, не меняет, поэтому проверяется без блокировки
+        block_metadata* block = get_block_to_free(at, size, alignment);
+
+        // из двух одновременных освобождений блока в очередь попадает только одно
+        if (!try_mark_pending(block)) {
+            error_with_guard("Tried to deallocate not allocator's property");
+            throw std::logic_error("Not allocator's property");
+        }
+
+        get_remote_frees().push(reinterpret_cast<char*>(block) + remote_free_link_offset);
+        return;
+    }
+
+    drain_remote_frees();
+    free_block(get_block_to_free(at, size, alignment));
+}
+
+void allocator_buddies_system::deallocate_block(void* at, size_t bytes, size_t alignment) {
+    if (!at) return;
+
+    free_block(get_block_to_free(at, bytes, alignment));
+}
+
+allocator_buddies_system::block_metadata* allocator_buddies_system::get_block_to_free(void* at, size_t bytes, size_t alignment) {
+    bool sized = is_sized_frees() && bytes != 0;
+    size_t metadata_size = get_occupied_metadata_size(alignment);
+
+    // блок начинается с выравнивания max_align_t, а данные лежат не дальше него от начала,
+    // поэтому начало находится и без выравнивания, с которым блок выделен (освобождение пакетом его не знает)
+    auto* block = metadata_size == occupied_block_metadata_size
+            ? *reinterpret_cast<block_metadata**>(static_cast<char*>(at) - sizeof(void*))
+            : reinterpret_cast<block_metadata*>(
+                    (reinterpret_cast<std::uintptr_t>(at) - 1) & ~(alignof(std::max_align_t) - 1));
+
+    size_t offset = reinterpret_cast<char*>(block) - static_cast<char*>(get_space_start());
+    block_metadata metadata = reinterpret_cast<char*>(block) >= static_cast<char*>(get_space_start()) && offset < get_size_full()
+            ? load_metadata(block)
+            : block_metadata{};
+
+    // блок из очереди освобождается второй раз; указатель на начало такого блока может быть уже затерт
+    // ссылкой очереди, тогда он не ведет на начало блока
+    if (!metadata.occupied || metadata.pending || offset % (size_t(1) << metadata.size) != 0) {
+        error_with_guard("Tried to deallocate not allocator's property");
+        throw std::logic_error("Not allocator's property");
+    }
+
+    if (sized && bytes <= std::numeric_limits<size_t>::max() / 2 - alignment &&
+        metadata.size != std::max(__detail::nearest_greater_k_of_2(bytes + metadata_size + alignment - 1), min_k)) {
+        error_with_guard("Tried to deallocate a block with another size");
+        throw std::logic_error("Block was allocated with another size");
+    }
+
+    return block;
+}
+
+void allocator_buddies_system::free_block(block_metadata* block) {
+    store_metadata(block, { .occupied = false, .pending = false, .size = block->size });
+    get_counters().on_deallocate(get_size_block(block));
+
+    size_t k = *reinterpret_cast<unsigned char*>(
+            static_cast<char*>(_trusted_memory) + sizeof(logger*) + sizeof(allocator_dbg_helper*) + sizeof(fit_mode));
+
+    // сливаемся с близнецом, пока он целиком свободен
+    while (block->size < k) {
+        size_t offset = reinterpret_cast<char*>(block) - static_cast<char*>(get_space_start());
         size_t size = get_size_block(block);
         size_t buddy_offset = offset ^ size;
 
         auto* buddy = reinterpret_cast<block_metadata*>(
-                static_cast<char*>(_trusted_memory) + allocator_metadata_size + buddy_offset);
+                static_cast<char*>(get_space_start()) + buddy_offset);
 
-        if (buddy->occupied || buddy->size != block->size) break;
+        if (block_metadata buddy_metadata = load_metadata(buddy);
+            buddy_metadata.occupied || buddy_metadata.size != block->size) break;
+
+        remove_free_block(buddy, buddy->size);
 
         if (buddy < block) std::swap(buddy, block);
 
         block->size += 1;
         block->occupied = false;
     }
+
+    push_free_block(block, block->size);
+    get_counters().set_largest_free_block(get_largest_free_block_size());
+
+    // страницы большого слитого блока за его метой возвращаются ОС
+    os_memory_resource::release_free_range(get_parent_allocator(),
+            reinterpret_cast<char*>(block) + free_block_metadata_size,
+            reinterpret_cast<char*>(block) + get_size_block(block));
+}
+
+inline allocator_buddies_system::block_metadata allocator_buddies_system::load_metadata(block_metadata* block) noexcept {
+    return std::atomic_ref<block_metadata>(*block).load(std::memory_order_relaxed);
+}
+
+inline void allocator_buddies_system::store_metadata(block_metadata* block, block_metadata metadata) noexcept {
+    std::atomic_ref<block_metadata>(*block).store(metadata, std::memory_order_relaxed);
+}
+
+bool allocator_buddies_system::try_mark_pending(block_metadata* block) noexcept {
+    std::atomic_ref<block_metadata> metadata(*block);
+    block_metadata expected = metadata.load(std::memory_order_relaxed);
+    block_metadata desired;
+
+    do {
+        if (!expected.occupied || expected.pending) {
+            return false;
+        }
+
+        desired = expected;
+        desired.pending = true;
+    } while (!metadata.compare_exchange_weak(expected, desired, std::memory_order_relaxed));
+
+    return true;
+}
+
+void allocator_buddies_system::drain_remote_frees() {
+    void* node = get_remote_frees().take_all();
+
+    while (node != nullptr) {
+        void* next = remote_free_queue::next(node);
+
+        get_counters().on_remote_free();
+        free_block(reinterpret_cast<block_metadata*>(static_cast<char*>(node) - remote_free_link_offset));
+
+        node = next;
+    }
+}
+
+std::unique_lock<std::mutex> allocator_buddies_system::lock_and_drain() {
+    auto lock = get_counters().lock(get_mutex());
+    drain_remote_frees();
+    return lock;
+}
+
+inline remote_free_queue& allocator_buddies_system::get_remote_frees() const noexcept {
+    return *reinterpret_cast<remote_free_queue*>(static_cast<char*>(_trusted_memory) + remote_frees_offset);
+}
+
+inline bool allocator_buddies_system::is_sized_frees() const noexcept {
+    return *reinterpret_cast<bool*>(
+            static_cast<char*>(_trusted_memory) + sizeof(logger*) + sizeof(allocator_dbg_helper*) + sizeof(fit_mode) + sizeof(unsigned char));
+}
+
+inline size_t allocator_buddies_system::get_occupied_metadata_size(size_t alignment) const noexcept {
+    return is_sized_frees() && alignment <= alignof(std::max_align_t) ? sized_occupied_block_metadata_size : occupied_block_metadata_size;
+}
+
+inline std::pmr::memory_resource* allocator_buddies_system::get_parent_allocator() const noexcept {
+    return *reinterpret_cast<std::pmr::memory_resource**>(static_cast<char*>(_trusted_memory) + sizeof(logger*));
 }
 
 inline std::mutex& allocator_buddies_system::get_mutex() noexcept {
-    return *reinterpret_cast<std::mutex*>(
-            static_cast<char*>(_trusted_memory) + allocator_metadata_size - sizeof(std::mutex));
+    return *reinterpret_cast<std::mutex*>(static_cast<char*>(_trusted_memory) + mutex_offset);
+}
+
+inline allocator_statistics::counters& allocator_buddies_system::get_counters() const noexcept {
+    return *reinterpret_cast<allocator_statistics::counters*>(static_cast<char*>(_trusted_memory) + counters_offset);
+}
+
+// наибольший свободный блок - любой блок старшего непустого порядка
+size_t allocator_buddies_system::get_largest_free_block_size() const noexcept {
+    size_t free_orders = *get_free_orders_bitmap();
+    return free_orders == 0 ? 0 : size_t(1) << (std::bit_width(free_orders) - 1);
+}
+
+allocator_statistics::statistics_snapshot allocator_buddies_system::get_statistics() const noexcept {
+    return _trusted_memory == nullptr ? statistics_snapshot{} : get_counters().snapshot();
+}
+
+inline void* allocator_buddies_system::get_space_start() const noexcept {
+    return static_cast<char*>(_trusted_memory) + allocator_metadata_size;
+}
+
+inline size_t* allocator_buddies_system::get_free_orders_bitmap() const noexcept {
+    return reinterpret_cast<size_t*>(static_cast<char*>(_trusted_memory) + mutex_offset + sizeof(std::mutex));
+}
+
+inline allocator_buddies_system::free_block_link* allocator_buddies_system::get_free_list_head(size_t order) const noexcept {
+    return reinterpret_cast<free_block_link*>(get_free_orders_bitmap() + 1) + order;
+}
+
+inline allocator_buddies_system::free_block_link allocator_buddies_system::get_block_link(void* block) const noexcept {
+    return static_cast<free_block_link>((static_cast<char*>(block) - static_cast<char*>(get_space_start())) >> min_k);
+}
+
+inline void* allocator_buddies_system::get_linked_block(free_block_link link) const noexcept {
+    return static_cast<char*>(get_space_start()) + (static_cast<size_t>(link) << min_k);
+}
+
+inline allocator_buddies_system::free_block_link& allocator_buddies_system::get_free_block_prev(void* block) noexcept {
+    return *reinterpret_cast<free_block_link*>(static_cast<char*>(block) + sizeof(free_block_link));
+}
+
+inline allocator_buddies_system::free_block_link& allocator_buddies_system::get_free_block_next(void* block) noexcept {
+    return *reinterpret_cast<free_block_link*>(static_cast<char*>(block) + 2 * sizeof(free_block_link));
+}
+
+void allocator_buddies_system::push_free_block(void* block, size_t order) noexcept {
+    free_block_link* head = get_free_list_head(order);
+    free_block_link link = get_block_link(block);
+
+    get_free_block_prev(block) = no_free_block;
+    get_free_block_next(block) = *head;
+
+    if (*head != no_free_block) {
+        get_free_block_prev(get_linked_block(*head)) = link;
+    }
+
+    *head = link;
+    *get_free_orders_bitmap() |= size_t(1) << order;
+}
+
+void allocator_buddies_system::remove_free_block(void* block, size_t order) noexcept {
+    free_block_link prev = get_free_block_prev(block);
+    free_block_link next = get_free_block_next(block);
+
+    if (next != no_free_block) {
+        get_free_block_prev(get_linked_block(next)) = prev;
+    }
+
+    if (prev != no_free_block) {
+        get_free_block_next(get_linked_block(prev)) = next;
+        return;
+    }
+
+    *get_free_list_head(order) = next;
+
+    if (next == no_free_block) {
+        *get_free_orders_bitmap() &= ~(size_t(1) << order);
+    }
+}
+
+void* allocator_buddies_system::pop_free_block(size_t order) noexcept {
+    void* block = get_linked_block(*get_free_list_head(order));
+    remove_free_block(block, order);
+    return block;
 }
 
 bool allocator_buddies_system::do_is_equal(const std::pmr::memory_resource& other) const noexcept {
@@ -201,44 +609,43 @@ inline void allocator_buddies_system::set_fit_mode(fit_mode mode) {
 
 inline size_t allocator_buddies_system::get_size_full() const noexcept {
     void* ptr = static_cast<char*>(_trusted_memory) + sizeof(logger*) + sizeof(allocator_dbg_helper*) + sizeof(fit_mode);
-    return 1 << (*reinterpret_cast<unsigned char*>(ptr));
+    return size_t(1) << (*reinterpret_cast<unsigned char*>(ptr));
 }
 
-void* allocator_buddies_system::get_first_suitable(size_t size) const noexcept {
-    for (auto it = begin(); it != end(); ++it) {
-        if (!it.occupied() && it.size() >= size) {
-            return it.get_ptr_iterator();
-        }
-    }
-    return nullptr;
+/** Every block of an order not less than the required one fits, so the smallest such order is
+ * both the first and the best fit. The worst fit splits a block of the largest free order.
+ */
+void* allocator_buddies_system::get_first_suitable(size_t size) noexcept {
+    return get_best_suitable(size);
 }
 
-void* allocator_buddies_system::get_best_suitable(size_t size) const noexcept {
-    size_t best_size = SIZE_MAX;
-    void* result = nullptr;
+void* allocator_buddies_system::get_best_suitable(size_t size) noexcept {
+    size_t order = std::max(__detail::nearest_greater_k_of_2(size), min_k);
+    if (order >= orders_count) {
+        return nullptr;
+    }
 
-    for (auto it = begin(); it != end(); ++it) {
-        size_t bsize = it.size();
-        if (!it.occupied() && bsize >= size && bsize < best_size) {
-            best_size = bsize;
-            result = it.get_ptr_iterator();
-        }
+    size_t suitable_orders = *get_free_orders_bitmap() & (~size_t(0) << order);
+    if (suitable_orders == 0) {
+        return nullptr;
     }
-    return result;
+
+    return pop_free_block(std::countr_zero(suitable_orders));
 }
 
-void* allocator_buddies_system::get_worst_suitable(size_t size) const noexcept {
-    size_t worst_size = 0;
-    void* result = nullptr;
+void* allocator_buddies_system::get_worst_suitable(size_t size) noexcept {
+    size_t order = std::max(__detail::nearest_greater_k_of_2(size), min_k);
+    size_t free_orders = *get_free_orders_bitmap();
+    if (free_orders == 0 || order >= orders_count) {
+        return nullptr;
+    }
 
-    for (auto it = begin(); it != end(); ++it) {
-        size_t bsize = it.size();
-        if (!it.occupied() && bsize >= size && bsize > worst_size) {
-            worst_size = bsize;
-            result = it.get_ptr_iterator();
-        }
+    size_t largest_order = std::bit_width(free_orders) - 1;
+    if (largest_order < order) {
+        return nullptr;
     }
-    return result;
+
+    return pop_free_block(largest_order);
 }
 
 std::vector<allocator_test_utils::block_info> allocator_buddies_system::get_blocks_info() const noexcept {
@@ -299,7 +706,7 @@ allocator_buddies_system::buddy_iterator::buddy_iterator(void* start) : _block(s
 allocator_buddies_system::buddy_iterator::buddy_iterator() : _block(nullptr) {}
 
 inline logger* allocator_buddies_system::get_logger() const {
-    return *reinterpret_cast<logger**>(_trusted_memory);
+    return _trusted_memory == nullptr ? nullptr : *reinterpret_cast<logger**>(_trusted_memory);
 }
 
 inline std::string allocator_buddies_system::get_typename() const {
@@ -311,5 +718,5 @@ std::vector<allocator_test_utils::block_info> allocator_buddies_system::get_bloc
 }
 
 inline size_t allocator_buddies_system::get_size_block(void* block) noexcept {
-    return (1 << reinterpret_cast<block_metadata*>(block)->size);
+    return (size_t(1) << reinterpret_cast<block_metadata*>(block)->size);
 }
@@ -0,0 +1,506 @@
+#include "../include/allocator_buddies_system_concurrent.h"
+#include <algorithm>
+#include <bit>
+#include <new>
+
+namespace
+{
+    std::atomic<std::uint32_t> next_thread_number(0);
+}
+
+allocator_buddies_system_concurrent::allocator_buddies_system_concurrent(
+        size_t space_size_power_of_two,
+        std::pmr::memory_resource* parent_allocator,
+        logger* log,
+        fit_mode mode)
+{
+    if (space_size_power_of_two < min_k) {
+        throw std::invalid_argument("space_size must be at least " + std::to_string(min_k));
+    }
+
+    // битовая карта младшего порядка должна поместиться в память
+    if (space_size_power_of_two - min_k > 40) {
+        throw std::invalid_argument("space_size must be at most " + std::to_string(min_k + 40));
+    }
+
+    // раскладка битовых карт зависит от размера пространства
+    size_t layout[orders_count][4] {};
+    size_t offset = bitmaps_offset;
+    for (size_t order = min_k; order <= space_size_power_of_two; ++order) {
+        size_t blocks_count = size_t(1) << (space_size_power_of_two - order);
+        size_t words_count = (blocks_count + bitmap_word_bits - 1) / bitmap_word_bits;
+        size_t summary_words_count = (words_count + bitmap_word_bits - 1) / bitmap_word_bits;
+
+        layout[order][0] = words_count;
+        layout[order][1] = summary_words_count;
+        layout[order][2] = offset;
+        offset += words_count * sizeof(bitmap_word);
+        layout[order][3] = offset;
+        offset += summary_words_count * sizeof(bitmap_word);
+    }
+
+    size_t metadata_size = (offset + alignof(order_state) - 1) & ~(alignof(order_state) - 1);
+    size_t real_size = metadata_size + (size_t(1) << space_size_power_of_two);
+
+    try {
+        _trusted_memory = parent_allocator == nullptr
+                ? ::operator new(real_size, std::align_val_t(alignof(order_state)))
+                : parent_allocator->allocate(real_size, alignof(order_state));
+    } catch (std::bad_alloc&) {
+        error_with_guard("Bad allocation memory");
+        throw;
+    }
+
+    auto* mem = static_cast<char*>(_trusted_memory);
+
+    *reinterpret_cast<class logger**>(mem) = log;
+    *reinterpret_cast<std::pmr::memory_resource**>(mem + sizeof(class logger*)) = parent_allocator;
+    new (mem + fit_mode_offset) std::atomic<fit_mode>(mode);
+    *reinterpret_cast<unsigned char*>(mem + space_power_offset) = static_cast<unsigned char>(space_size_power_of_two);
+    *reinterpret_cast<size_t*>(mem + metadata_size_offset) = metadata_size;
+    new (mem + counters_offset) allocator_statistics::counters(size_t(1) << space_size_power_of_two);
+
+    for (size_t order = 0; order < orders_count; ++order) {
+        auto* state = new (mem + order_states_offset + order * sizeof(order_state)) order_state;
+        state->free_blocks.store(0, std::memory_order_relaxed);
+        state->words_count = layout[order][0];
+        state->summary_words_count = layout[order][1];
+        state->bitmap_offset = layout[order][2];
+        state->summary_offset = layout[order][3];
+    }
+
+    for (auto* word = reinterpret_cast<std::atomic<bitmap_word>*>(mem + bitmaps_offset);
+         word < reinterpret_cast<std::atomic<bitmap_word>*>(mem + offset); ++word) {
+        new (word) std::atomic<bitmap_word>(0);
+    }
+
+    put_free_block(space_size_power_of_two, 0);
+}
+
+allocator_buddies_system_concurrent::~allocator_buddies_system_concurrent() {
+    trace_with_guard("~allocator_buddies_system_concurrent");
+    release_memory();
+}
+
+void allocator_buddies_system_concurrent::release_memory() noexcept {
+    if (_trusted_memory == nullptr) {
+        return;
+    }
+
+    std::pmr::memory_resource* parent_allocator = get_parent_allocator();
+    size_t real_size = get_metadata_size() + (size_t(1) << get_space_power());
+
+    if (parent_allocator == nullptr) {
+        ::operator delete(_trusted_memory, std::align_val_t(alignof(order_state)));
+    } else {
+        parent_allocator->deallocate(_trusted_memory, real_size, alignof(order_state));
+    }
+
+    _trusted_memory = nullptr;
+}
+
+allocator_buddies_system_concurrent::allocator_buddies_system_concurrent(allocator_buddies_system_concurrent&& other) noexcept {
+    _trusted_memory = other._trusted_memory;
+    other._trusted_memory = nullptr;
+}
+
+allocator_buddies_system_concurrent& allocator_buddies_system_concurrent::operator=(allocator_buddies_system_concurrent&& other) noexcept {
+    if (this != &other) {
+        release_memory();
+        _trusted_memory = other._trusted_memory;
+        other._trusted_memory = nullptr;
+    }
+    return *this;
+}
+
+void* allocator_buddies_system_concurrent::do_allocate_sm(size_t size) {
+    return do_allocate_aligned_sm(size, 1);
+}
+
+/** The block is taken larger by alignment - 1 bytes like in allocator_buddies_system. A search that found nothing
+ * is repeated over the bitmaps themselves, and then once more after merging the buddies left unmerged.
+ */
+void* allocator_buddies_system_concurrent::do_allocate_aligned_sm(size_t size, size_t alignment) {
+    if (size > std::numeric_limits<size_t>::max() / 2 - occupied_block_metadata_size - alignment) {
+        error_with_guard("Requested size is too big");
+        get_counters().on_failed_allocation_unlocked();
+        throw std::bad_alloc();
+    }
+
+    size_t required = size + occupied_block_metadata_size + alignment - 1;
+    size_t order = std::max(__detail::nearest_greater_k_of_2(required), min_k);
+
+    void* block = order > get_space_power() ? nullptr : take_block(order, false);
+
+    if (block == nullptr && order <= get_space_power()) {
+        block = take_block(order, true);
+
+        if (block == nullptr) {
+            merge_free_buddies();
+            block = take_block(order, true);
+        }
+    }
+
+    if (block == nullptr) {
+        error_with_guard("No free block for requested size");
+        get_counters().on_failed_allocation_unlocked();
+        throw std::bad_alloc();
+    }
+
+    get_counters().on_allocate_unlocked(size_t(1) << order);
+
+    auto* meta = static_cast<block_metadata*>(block);
+    meta->occupied = true;
+    meta->size = static_cast<unsigned char>(order);
+
+    auto data = reinterpret_cast<std::uintptr_t>(block) + occupied_block_metadata_size;
+    data += -data & (alignment - 1);
+
+    *reinterpret_cast<void**>(data - sizeof(void*)) = block;
+    return reinterpret_cast<void*>(data);
+}
+
+void allocator_buddies_system_concurrent::do_deallocate_sm(void* at) {
+    if (at == nullptr) {
+        return;
+    }
+
+    auto* block = *reinterpret_cast<block_metadata**>(static_cast<char*>(at) - sizeof(void*));
+    auto offset = static_cast<size_t>(reinterpret_cast<char*>(block) - static_cast<char*>(get_space_start()));
+
+    if (reinterpret_cast<char*>(block) < static_cast<char*>(get_space_start()) ||
+        offset >= (size_t(1) << get_space_power()) ||
+        !block->occupied ||
+        block->size < min_k || block->size > get_space_power() ||
+        offset % (size_t(1) << block->size) != 0) {
+        error_with_guard("Tried to deallocate not allocator's property");
+        throw std::logic_error("Not allocator's property");
+    }
+
+    size_t order = block->size;
+    block->occupied = false;
+    get_counters().on_deallocate_unlocked(size_t(1) << order);
+
+    release_block(order, offset >> order);
+}
+
+void* allocator_buddies_system_concurrent::take_block(size_t order, bool exhaustive) noexcept {
+    size_t space_power = get_space_power();
+    bool worst_fit = get_fit_mode().load(std::memory_order_relaxed) == fit_mode::the_worst_fit;
+
+    for (size_t step = 0; step <= space_power - order; ++step) {
+        size_t found_order = worst_fit ? space_power - step : order + step;
+        size_t index = take_free_block(found_order, exhaustive);
+
+        if (index == no_block) {
+            continue;
+        }
+
+        // правые половины отдаются в карты младших порядков, левая остается себе
+        while (found_order > order) {
+            --found_order;
+            index <<= 1;
+            put_free_block(found_order, index | 1);
+        }
+
+        return static_cast<char*>(get_space_start()) + (index << order);
+    }
+
+    return nullptr;
+}
+
+/** A thread first looks at the word where it last put or took a block of the order, then at the summary from
+ * that place; inside a word it starts from its own bit. So a thread mostly reuses the blocks it freed and
+ * threads that search at the same time rarely try to take the same block.
+ */
+size_t allocator_buddies_system_concurrent::take_free_block(size_t order, bool exhaustive) noexcept {
+    order_state& state = get_order_state(order);
+
+    if (!exhaustive && state.free_blocks.load(std::memory_order_relaxed) <= 0) {
+        return no_block;
+    }
+
+    std::atomic<bitmap_word>* bitmap = get_bitmap(order);
+    std::atomic<bitmap_word>* summary = get_summary(order);
+    size_t slot = get_thread_slot();
+    size_t rotation = slot % bitmap_word_bits;
+
+    auto take_from_word = [&](size_t word_index) -> size_t {
+        bitmap_word word = bitmap[word_index].load(std::memory_order_relaxed);
+
+        while (word != 0) {
+            size_t bit = (std::countr_zero(std::rotr(word, static_cast<int>(rotation))) + rotation) % bitmap_word_bits;
+
+            if (bitmap[word_index].compare_exchange_weak(word, word & ~(bitmap_word(1) << bit),
+                                                         std::memory_order_acq_rel, std::memory_order_relaxed)) {
+                state.free_blocks.fetch_sub(1, std::memory_order_relaxed);
+                return word_index * bitmap_word_bits + bit;
+            }
+        }
+
+        return no_block;
+    };
+
+    if (exhaustive) {
+        for (size_t word_index = 0; word_index < state.words_count; ++word_index) {
+            if (size_t index = take_from_word(word_index); index != no_block) {
+                return index;
+            }
+        }
+
+        return no_block;
+    }
+
+    size_t& hint = get_thread_hint(order);
+    if (hint >= state.words_count) {
+        hint = (slot * state.words_count) >> 32;
+    }
+
+    if (size_t index = take_from_word(hint); index != no_block) {
+        return index;
+    }
+
+    size_t start = hint / bitmap_word_bits;
+
+    for (size_t step = 0; step < state.summary_words_count; ++step) {
+        size_t summary_index = (start + step) % state.summary_words_count;
+        bitmap_word candidates = summary[summary_index].load(std::memory_order_acquire);
+
+        while (candidates != 0) {
+            size_t bit = std::countr_zero(candidates);
+            candidates &= candidates - 1;
+
+            size_t word_index = summary_index * bitmap_word_bits + bit;
+            if (size_t index = take_from_word(word_index); index != no_block) {
+                hint = word_index;
+                return index;
+            }
+
+            // слово опустело: бит сводки снимается, а если слово успели заполнить, ставится обратно
+            summary[summary_index].fetch_and(~(bitmap_word(1) << bit), std::memory_order_acq_rel);
+            if (bitmap[word_index].load(std::memory_order_acquire) != 0) {
+                summary[summary_index].fetch_or(bitmap_word(1) << bit, std::memory_order_acq_rel);
+            }
+        }
+    }
+
+    return no_block;
+}
+
+bool allocator_buddies_system_concurrent::try_take_block(size_t order, size_t index) noexcept {
+    std::atomic<bitmap_word>& word = get_bitmap(order)[index / bitmap_word_bits];
+    bitmap_word bit = bitmap_word(1) << (index % bitmap_word_bits);
+    bitmap_word value = word.load(std::memory_order_relaxed);
+
+    while ((value & bit) != 0) {
+        if (word.compare_exchange_weak(value, value & ~bit, std::memory_order_acq_rel, std::memory_order_relaxed)) {
+            get_order_state(order).free_blocks.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void allocator_buddies_system_concurrent::put_free_block(size_t order, size_t index) noexcept {
+    size_t word_index = index / bitmap_word_bits;
+    bitmap_word old = get_bitmap(order)[word_index].fetch_or(bitmap_word(1) << (index % bitmap_word_bits), std::memory_order_acq_rel);
+    get_order_state(order).free_blocks.fetch_add(1, std::memory_order_relaxed);
+    get_thread_hint(order) = word_index;
+
+    // непустое слово уже отмечено в сводке
+    if (old == 0) {
+        get_summary(order)[word_index / bitmap_word_bits].fetch_or(bitmap_word(1) << (word_index % bitmap_word_bits), std::memory_order_acq_rel);
+    }
+}
+
+/** After the block is put into the bitmap its buddy is checked once more: if the buddy was freed at the same
+ * moment, its thread could have missed this block. Whoever takes both halves merges them.
+ */
+void allocator_buddies_system_concurrent::release_block(size_t order, size_t index) noexcept {
+    size_t space_power = get_space_power();
+
+    while (order < space_power) {
+        size_t buddy = index ^ 1;
+
+        if (!try_take_block(order, buddy)) {
+            // страницы большого блока возвращаются ОС, пока он еще принадлежит этому потоку
+            auto* block = static_cast<char*>(get_space_start()) + (index << order);
+            os_memory_resource::release_free_range(get_parent_allocator(), block, block + (size_t(1) << order));
+
+            put_free_block(order, index);
+
+            if (!try_take_block(order, buddy)) {
+                return;
+            }
+
+            if (!try_take_block(order, index)) {
+                put_free_block(order, buddy);
+                return;
+            }
+        }
+
+        index >>= 1;
+        ++order;
+    }
+
+    put_free_block(space_power, 0);
+}
+
+void allocator_buddies_system_concurrent::merge_free_buddies() noexcept {
+    constexpr bitmap_word left_halves = 0x5555'5555'5555'5555;
+    size_t space_power = get_space_power();
+
+    for (size_t order = min_k; order < space_power; ++order) {
+        std::atomic<bitmap_word>* bitmap = get_bitmap(order);
+
+        for (size_t word_index = 0; word_index < get_order_state(order).words_count; ++word_index) {
+            bitmap_word word = bitmap[word_index].load(std::memory_order_relaxed);
+            bitmap_word pairs = word & (word >> 1) & left_halves;
+
+            while (pairs != 0) {
+                size_t index = word_index * bitmap_word_bits + std::countr_zero(pairs);
+                pairs &= pairs - 1;
+
+                if (!try_take_block(order, index)) {
+                    continue;
+                }
+
+                if (try_take_block(order, index + 1)) {
+                    release_block(order + 1, index >> 1);
+                } else {
+                    put_free_block(order, index);
+                }
+            }
+        }
+    }
+}
+
+bool allocator_buddies_system_concurrent::do_is_equal(const std::pmr::memory_resource& other) const noexcept {
+    return this == &other;
+}
+
+void allocator_buddies_system_concurrent::set_fit_mode(fit_mode mode) {
+    get_fit_mode().store(mode, std::memory_order_relaxed);
+}
+
+std::vector<allocator_test_utils::block_info> allocator_buddies_system_concurrent::get_blocks_info() const {
+    return get_blocks_info_inner();
+}
+
+// наибольший свободный блок - блок старшего порядка, в котором по счетчику есть свободные блоки
+allocator_statistics::statistics_snapshot allocator_buddies_system_concurrent::get_statistics() const noexcept {
+    if (_trusted_memory == nullptr) {
+        return statistics_snapshot{};
+    }
+
+    statistics_snapshot result = get_counters().snapshot();
+    result.largest_free_block = 0;
+
+    for (size_t order = get_space_power() + 1; order-- > min_k;) {
+        if (get_order_state(order).free_blocks.load(std::memory_order_relaxed) > 0) {
+            result.largest_free_block = size_t(1) << order;
+            break;
+        }
+    }
+
+    return result;
+}
+
+/** A position is the start of a free block if a bit of some order is set for it, otherwise it is the start
+ * of an occupied block with valid metadata.
+ */
+std::vector<allocator_test_utils::block_info> allocator_buddies_system_concurrent::get_blocks_info_inner() const {
+    std::vector<allocator_test_utils::block_info> blocks;
+    size_t space_power = get_space_power();
+    size_t space_size = size_t(1) << space_power;
+
+    for (size_t position = 0; position < space_size;) {
+        size_t max_order = position == 0 ? space_power : std::min<size_t>(std::countr_zero(position), space_power);
+        size_t block_size = 0;
+
+        for (size_t order = max_order + 1; order-- > min_k;) {
+            size_t index = position >> order;
+            bitmap_word word = get_bitmap(order)[index / bitmap_word_bits].load(std::memory_order_relaxed);
+
+            if ((word >> (index % bitmap_word_bits)) & 1) {
+                block_size = size_t(1) << order;
+                break;
+            }
+        }
+
+        if (block_size != 0) {
+            blocks.push_back({ .block_size = block_size, .is_block_occupied = false });
+        } else {
+            block_size = size_t(1) << reinterpret_cast<block_metadata*>(static_cast<char*>(get_space_start()) + position)->size;
+            blocks.push_back({ .block_size = block_size, .is_block_occupied = true });
+        }
+
+        position += block_size;
+    }
+
+    return blocks;
+}
+
+inline logger* allocator_buddies_system_concurrent::get_logger() const {
+    return *reinterpret_cast<logger**>(_trusted_memory);
+}
+
+inline std::string allocator_buddies_system_concurrent::get_typename() const {
+    return "allocator_buddies_system_concurrent";
+}
+
+inline std::pmr::memory_resource* allocator_buddies_system_concurrent::get_parent_allocator() const noexcept {
+    return *reinterpret_cast<std::pmr::memory_resource**>(static_cast<char*>(_trusted_memory) + sizeof(logger*));
+}
+
+inline std::atomic<allocator_with_fit_mode::fit_mode>& allocator_buddies_system_concurrent::get_fit_mode() const noexcept {
+    return *reinterpret_cast<std::atomic<fit_mode>*>(static_cast<char*>(_trusted_memory) + fit_mode_offset);
+}
+
+inline size_t allocator_buddies_system_concurrent::get_space_power() const noexcept {
+    return *reinterpret_cast<unsigned char*>(static_cast<char*>(_trusted_memory) + space_power_offset);
+}
+
+inline size_t allocator_buddies_system_concurrent::get_metadata_size() const noexcept {
+    return *reinterpret_cast<size_t*>(static_cast<char*>(_trusted_memory) + metadata_size_offset);
+}
+
+inline void* allocator_buddies_system_concurrent::get_space_start() const noexcept {
+    return static_cast<char*>(_trusted_memory) + get_metadata_size();
+}
+
+inline allocator_statistics::counters& allocator_buddies_system_concurrent::get_counters() const noexcept {
+    return *reinterpret_cast<allocator_statistics::counters*>(static_cast<char*>(_trusted_memory) + counters_offset);
+}
+
+inline allocator_buddies_system_concurrent::order_state& allocator_buddies_system_concurrent::get_order_state(size_t order) const noexcept {
+    return *reinterpret_cast<order_state*>(static_cast<char*>(_trusted_memory) + order_states_offset + order * sizeof(order_state));
+}
+
+inline std::atomic<allocator_buddies_system_concurrent::bitmap_word>* allocator_buddies_system_concurrent::get_bitmap(size_t order) const noexcept {
+    return reinterpret_cast<std::atomic<bitmap_word>*>(static_cast<char*>(_trusted_memory) + get_order_state(order).bitmap_offset);
+}
+
+inline std::atomic<allocator_buddies_system_concurrent::bitmap_word>* allocator_buddies_system_concurrent::get_summary(size_t order) const noexcept {
+    return reinterpret_cast<std::atomic<bitmap_word>*>(static_cast<char*>(_trusted_memory) + get_order_state(order).summary_offset);
+}
+
+// подсказки хранятся для последнего аллокатора, с которым работал поток
+size_t& allocator_buddies_system_concurrent::get_thread_hint(size_t order) const noexcept {
+    thread_local void const* owner = nullptr;
+    thread_local size_t hints[orders_count];
+
+    if (owner != _trusted_memory) {
+        owner = _trusted_memory;
+        std::fill_n(hints, orders_count, no_block);
+    }
+
+    return hints[order];
+}
+
+// номера потоков разносятся по всему диапазону умножением на золотое сечение
+size_t allocator_buddies_system_concurrent::get_thread_slot() noexcept {
+    thread_local std::uint32_t slot = next_thread_number.fetch_add(1, std::memory_order_relaxed) * 0x9E37'79B9u;
+    return slot;
+}
@@ -2,8 +2,16 @@
 #include <cmath>
 #include <allocator_dbg_helper.h>
 #include <allocator_buddies_system.h>
+#include <allocator_buddies_system_concurrent.h>
 #include <client_logger_builder.h>
+#include <barrier>
+#include <condition_variable>
 #include <list>
+#include <mutex>
+#include <cstring>
+#include <random>
+#include <thread>
+#include <vector>
 
 
 logger *create_logger(
@@ -87,8 +95,8 @@ TEST(positiveTests, test3)
 {
     std::unique_ptr<smart_mem_resource> allocator_instance(new allocator_buddies_system(8, nullptr, nullptr, allocator_with_fit_mode::fit_mode::first_fit));
     
-    void *first_block = allocator_instance->allocate(sizeof(unsigned char) * 0);
-    void *second_block = allocator_instance->allocate(sizeof(unsigned char) * 0);
+    void *first_block = allocator_instance->allocate(sizeof(unsigned char) * 0, 1);
+    void *second_block = allocator_instance->allocate(sizeof(unsigned char) * 0, 1);
     allocator_instance->deallocate(first_block, 1);
     
     auto actual_blocks_state = dynamic_cast<allocator_test_utils *>(allocator_instance.get())->get_blocks_info();
@@ -101,6 +109,73 @@ TEST(positiveTests, test3)
     allocator_instance->deallocate(second_block, 1);
 }
 
+TEST(positiveTests, test4)
+{
+    std::unique_ptr<smart_mem_resource> allocator_instance(new allocator_buddies_system(10, nullptr, nullptr, allocator_with_fit_mode::fit_mode::the_best_fit));
+
+    std::vector<void *> blocks;
+    try
+    {
+        while (true)
+        {
+            blocks.push_back(allocator_instance->allocate(sizeof(unsigned char) * 0, 1));
+        }
+    }
+    catch (std::bad_alloc const &)
+    {
+    }
+
+    ASSERT_EQ(blocks.size(), 1024 / 16);
+
+    // освобождаем через один, затем остальные: каждая пара близнецов должна слиться до целого пространства
+    for (size_t i = 0; i < blocks.size(); i += 2)
+    {
+        allocator_instance->deallocate(blocks[i], 1);
+    }
+    for (size_t i = blocks.size() - 1; i < blocks.size(); i -= 2)
+    {
+        allocator_instance->deallocate(blocks[i], 1);
+    }
+
+    auto actual_blocks_state = dynamic_cast<allocator_test_utils *>(allocator_instance.get())->get_blocks_info();
+    ASSERT_EQ(actual_blocks_state.size(), 1);
+    ASSERT_EQ(actual_blocks_state[0].block_size, 1024);
+    ASSERT_EQ(actual_blocks_state[0].is_block_occupied, false);
+
+    dynamic_cast<allocator_with_fit_mode *>(allocator_instance.get())->set_fit_mode(allocator_with_fit_mode::fit_mode::the_worst_fit);
+
+    void *small_block = allocator_instance->allocate(sizeof(unsigned char) * 100, 1);
+    void *big_block = allocator_instance->allocate(sizeof(unsigned char) * 400, 1);
+
+    ASSERT_THROW(static_cast<void>(allocator_instance->allocate(sizeof(unsigned char) * 400, 1)), std::bad_alloc);
+
+    allocator_instance->deallocate(small_block, 1);
+    allocator_instance->deallocate(big_block, 1);
+}
+
+TEST(positiveTests, test5)
+{
+    std::unique_ptr<smart_mem_resource> allocator_instance(new allocator_buddies_system(12, nullptr, nullptr, allocator_with_fit_mode::fit_mode::first_fit));
+
+    std::vector<std::pair<void *, size_t>> blocks;
+    for (size_t alignment : { 64, 128, 256, 64, 512 })
+    {
+        void *block = allocator_instance->allocate(sizeof(unsigned char) * 40, alignment);
+        ASSERT_EQ(reinterpret_cast<std::uintptr_t>(block) % alignment, 0);
+        blocks.emplace_back(block, alignment);
+    }
+
+    for (auto [block, alignment] : blocks)
+    {
+        allocator_instance->deallocate(block, 40, alignment);
+    }
+
+    auto actual_blocks_state = dynamic_cast<allocator_test_utils *>(allocator_instance.get())->get_blocks_info();
+    ASSERT_EQ(actual_blocks_state.size(), 1);
+    ASSERT_EQ(actual_blocks_state[0].block_size, 4096);
+    ASSERT_EQ(actual_blocks_state[0].is_block_occupied, false);
+}
+
 TEST(positiveTests, test53)
 {
     std::unique_ptr<logger> logger_instance(create_logger(std::vector<std::pair<std::string, logger::severity>>
@@ -201,11 +276,461 @@ TEST(positiveTests, test53)
     }
 }
 
+TEST(positiveTests, test6)
+{
+    os_memory_resource os_memory(true, 1 << 16);
+    allocator_buddies_system allocator_instance(22, &os_memory, nullptr, allocator_with_fit_mode::fit_mode::first_fit);
+
+    std::vector<unsigned char *> blocks;
+    for (size_t i = 0; i < 4; ++i)
+    {
+        blocks.push_back(reinterpret_cast<unsigned char *>(allocator_instance.allocate(500'000)));
+        std::memset(blocks.back(), static_cast<int>(i + 1), 500'000);
+    }
+
+    allocator_instance.deallocate(blocks[1], 1);
+
+#ifdef __linux__
+    // слитый свободный блок отдан ОС и читается нулями
+    ASSERT_EQ(blocks[1][250'000], 0);
+#endif
+    ASSERT_EQ(blocks[0][499'999], 1);
+    ASSERT_EQ(blocks[2][0], 3);
+
+    auto *again = reinterpret_cast<unsigned char *>(allocator_instance.allocate(500'000));
+    ASSERT_EQ(again, blocks[1]);
+    std::memset(again, 5, 500'000);
+    blocks[1] = again;
+
+    for (auto *block : blocks)
+    {
+        allocator_instance.deallocate(block, 1);
+    }
+
+    auto actual_blocks_state = allocator_instance.get_blocks_info();
+    ASSERT_EQ(actual_blocks_state.size(), 1);
+    ASSERT_EQ(actual_blocks_state[0].block_size, 1 << 22);
+    ASSERT_EQ(actual_blocks_state[0].is_block_occupied, false);
+}
+
+TEST(positiveTests, test7)
+{
+    std::unique_ptr<smart_mem_resource> allocator_instance(new allocator_buddies_system_concurrent(12, nullptr, nullptr, allocator_with_fit_mode::fit_mode::first_fit));
+
+    void *first_block = allocator_instance->allocate(sizeof(unsigned char) * 40);
+    void *second_block = allocator_instance->allocate(sizeof(unsigned char) * 40, 64);
+    ASSERT_EQ(reinterpret_cast<std::uintptr_t>(second_block) % 64, 0);
+
+    auto actual_blocks_state = dynamic_cast<allocator_test_utils *>(allocator_instance.get())->get_blocks_info();
+    std::vector<allocator_test_utils::block_info> expected_blocks_state
+        {
+            { .block_size = 64, .is_block_occupied = true },
+            { .block_size = 64, .is_block_occupied = false },
+            { .block_size = 128, .is_block_occupied = true },
+            { .block_size = 256, .is_block_occupied = false },
+            { .block_size = 512, .is_block_occupied = false },
+            { .block_size = 1024, .is_block_occupied = false },
+            { .block_size = 2048, .is_block_occupied = false }
+        };
+    ASSERT_EQ(actual_blocks_state, expected_blocks_state);
+
+    auto statistics = dynamic_cast<allocator_statistics *>(allocator_instance.get())->get_statistics();
+    ASSERT_EQ(statistics.bytes_in_use, 64 + 128);
+    ASSERT_EQ(statistics.occupied_blocks, 2);
+    ASSERT_EQ(statistics.largest_free_block, 2048);
+
+    allocator_instance->deallocate(first_block, 1);
+    ASSERT_THROW(allocator_instance->deallocate(first_block, 1), std::logic_error);
+    allocator_instance->deallocate(second_block, 1);
+    ASSERT_THROW(static_cast<void>(allocator_instance->allocate(4096)), std::bad_alloc);
+
+    statistics = dynamic_cast<allocator_statistics *>(allocator_instance.get())->get_statistics();
+    ASSERT_EQ(statistics.allocations, 2);
+    ASSERT_EQ(statistics.deallocations, 2);
+    ASSERT_EQ(statistics.failed_allocations, 1);
+    ASSERT_EQ(statistics.bytes_in_use, 0);
+    ASSERT_EQ(statistics.peak_bytes_in_use, 64 + 128);
+    ASSERT_EQ(statistics.largest_free_block, 4096);
+
+    actual_blocks_state = dynamic_cast<allocator_test_utils *>(allocator_instance.get())->get_blocks_info();
+    ASSERT_EQ(actual_blocks_state.size(), 1);
+    ASSERT_EQ(actual_blocks_state[0].block_size, 4096);
+}
+
+TEST(positiveTests, test8)
+{
+    allocator_buddies_system_concurrent allocator_instance(20);
+
+    // каждый поток пишет свой номер в свои блоки и проверяет, что их никто не перезаписал
+    std::vector<std::thread> threads;
+    for (unsigned char t = 1; t <= 8; ++t)
+    {
+        threads.emplace_back([&allocator_instance, t]()
+        {
+            std::mt19937 rng(t);
+            std::vector<std::pair<unsigned char *, size_t>> window(32, { nullptr, 0 });
+
+            for (size_t i = 0; i < 20'000; ++i)
+            {
+                auto &[block, size] = window[rng() % window.size()];
+                if (block != nullptr)
+                {
+                    ASSERT_EQ(std::count(block, block + size, t), size);
+                    allocator_instance.deallocate(block, 1);
+                }
+
+                size = rng() % 2000 + 1;
+                block = reinterpret_cast<unsigned char *>(allocator_instance.allocate(size));
+                std::memset(block, t, size);
+            }
+
+            for (auto [block, size] : window)
+            {
+                allocator_instance.deallocate(block, 1);
+            }
+        });
+    }
+
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+
+    // пары близнецов, не слитые при одновременном освобождении, сливаются перед отказом
+    void *whole_space = allocator_instance.allocate((1 << 19) + 1);
+    allocator_instance.deallocate(whole_space, 1);
+
+    auto actual_blocks_state = allocator_instance.get_blocks_info();
+    ASSERT_EQ(actual_blocks_state.size(), 1);
+    ASSERT_EQ(actual_blocks_state[0].block_size, 1 << 20);
+    ASSERT_EQ(actual_blocks_state[0].is_block_occupied, false);
+
+    // счетчики всех потоков сходятся
+    auto statistics = allocator_instance.get_statistics();
+    ASSERT_EQ(statistics.allocations, 8 * 20'000 + 1);
+    ASSERT_EQ(statistics.deallocations, statistics.allocations);
+    ASSERT_EQ(statistics.bytes_in_use, 0);
+    ASSERT_EQ(statistics.occupied_blocks, 0);
+    ASSERT_EQ(statistics.largest_free_block, 1 << 20);
+}
+
+TEST(positiveTests, test9)
+{
+    allocator_buddies_system allocator_instance(12, nullptr, nullptr, allocator_with_fit_mode::fit_mode::first_fit);
+
+    void *first_block = allocator_instance.allocate(40);
+
+    // пять блоков по 64 байта вырезаются из одного блока в 512 байт, хвост остается свободным целиком
+    void *batch[5];
+    allocator_instance.allocate_batch(40, 5, batch);
+    for (size_t i = 1; i < 5; ++i)
+    {
+        ASSERT_EQ(reinterpret_cast<unsigned char *>(batch[i]) - reinterpret_cast<unsigned char *>(batch[i - 1]), 64);
+    }
+
+    std::vector<allocator_test_utils::block_info> expected_blocks_state
+        {
+            { .block_size = 64, .is_block_occupied = true },
+            { .block_size = 64, .is_block_occupied = false },
+            { .block_size = 128, .is_block_occupied = false },
+            { .block_size = 256, .is_block_occupied = false },
+            { .block_size = 64, .is_block_occupied = true },
+            { .block_size = 64, .is_block_occupied = true },
+            { .block_size = 64, .is_block_occupied = true },
+            { .block_size = 64, .is_block_occupied = true },
+            { .block_size = 64, .is_block_occupied = true },
+            { .block_size = 64, .is_block_occupied = false },
+            { .block_size = 128, .is_block_occupied = false },
+            { .block_size = 1024, .is_block_occupied = false },
+            { .block_size = 2048, .is_block_occupied = false }
+        };
+    ASSERT_EQ(allocator_instance.get_blocks_info(), expected_blocks_state);
+
+    void *too_big_batch[64];
+    ASSERT_THROW(allocator_instance.allocate_batch(100, 64, too_big_batch), std::bad_alloc);
+    ASSERT_EQ(allocator_instance.get_blocks_info(), expected_blocks_state);
+
+    allocator_instance.deallocate_batch(batch, 5);
+    allocator_instance.deallocate(first_block, 1);
+
+    auto actual_blocks_state = allocator_instance.get_blocks_info();
+    ASSERT_EQ(actual_blocks_state.size(), 1);
+    ASSERT_EQ(actual_blocks_state[0].block_size, 4096);
+}
+
+TEST(positiveTests, test10)
+{
+    allocator_buddies_system allocator_instance(14, nullptr, nullptr, allocator_with_fit_mode::fit_mode::first_fit, true);
+
+    // без указателя на начало блока 63 байта помещаются в блок из 64
+    void *first_block = allocator_instance.allocate(63, 1);
+    ASSERT_EQ(allocator_instance.get_blocks_info()[0], (allocator_test_utils::block_info { .block_size = 64, .is_block_occupied = true }));
+
+    // мета дополняется до выравнивания, и данные остаются выровненными
+    void *default_aligned_block = allocator_instance.allocate(48);
+    ASSERT_EQ(reinterpret_cast<std::uintptr_t>(default_aligned_block) % alignof(std::max_align_t), 0);
+    ASSERT_EQ(allocator_instance.get_blocks_info()[1], (allocator_test_utils::block_info { .block_size = 64, .is_block_occupied = true }));
+
+    void *double_block = allocator_instance.allocate(8, alignof(double));
+    ASSERT_EQ(reinterpret_cast<std::uintptr_t>(double_block) % alignof(double), 0);
+
+    void *aligned_block = allocator_instance.allocate(100, 256);
+    ASSERT_EQ(reinterpret_cast<std::uintptr_t>(aligned_block) % 256, 0);
+
+    {
+        std::pmr::vector<int> numbers(&allocator_instance);
+        for (int i = 0; i < 300; ++i)
+        {
+            numbers.push_back(i);
+        }
+        ASSERT_EQ(numbers[299], 299);
+    }
+
+    ASSERT_THROW(allocator_instance.deallocate(first_block, 200, 1), std::logic_error);
+
+    allocator_instance.deallocate(first_block, 63, 1);
+    allocator_instance.deallocate(default_aligned_block, 48);
+    allocator_instance.deallocate(double_block, 8, alignof(double));
+    allocator_instance.deallocate(aligned_block, 100, 256);
+
+    auto actual_blocks_state = allocator_instance.get_blocks_info();
+    ASSERT_EQ(actual_blocks_state.size(), 1);
+    ASSERT_EQ(actual_blocks_state[0].block_size, 1 << 14);
+}
+
+TEST(positiveTests, test11)
+{
+    for (bool sized_frees : { false, true })
+    {
+        allocator_buddies_system allocator_instance(20, nullptr, nullptr, allocator_with_fit_mode::fit_mode::first_fit, sized_frees);
+
+        constexpr size_t threads_count = 4;
+        constexpr size_t blocks_per_thread = 500;
+
+        std::vector<std::vector<void *>> blocks(threads_count, std::vector<void *>(blocks_per_thread));
+        std::barrier allocated(threads_count);
+
+        // каждый поток освобождает блоки соседа, пока остальные еще выделяют и освобождают
+        std::vector<std::thread> threads;
+        for (size_t i = 0; i < threads_count; ++i)
+        {
+            threads.emplace_back([&, i]
+            {
+                for (size_t j = 0; j < blocks_per_thread; ++j)
+                {
+                    blocks[i][j] = allocator_instance.allocate(8 + j % 64);
+                    std::memset(blocks[i][j], static_cast<int>(i), 8 + j % 64);
+                }
+
+                allocated.arrive_and_wait();
+
+                auto &neighbour_blocks = blocks[(i + 1) % threads_count];
+                for (size_t j = 0; j < blocks_per_thread; ++j)
+                {
+                    allocator_instance.deallocate(neighbour_blocks[j], 8 + j % 64);
+                    allocator_instance.deallocate(allocator_instance.allocate(16), 16);
+                }
+            });
+        }
+
+        for (auto &thread : threads)
+        {
+            thread.join();
+        }
+
+        // отложенные освобождения доводятся до конца следующим выделением
+        allocator_instance.deallocate(allocator_instance.allocate(16), 16);
+
+        auto actual_blocks_state = allocator_instance.get_blocks_info();
+        ASSERT_EQ(actual_blocks_state.size(), 1);
+        ASSERT_EQ(actual_blocks_state[0].block_size, 1 << 20);
+
+        auto statistics = allocator_instance.get_statistics();
+        ASSERT_EQ(statistics.bytes_in_use, 0);
+        ASSERT_EQ(statistics.allocations, statistics.deallocations);
+    }
+}
+
+TEST(positiveTests, test13)
+{
+    allocator_buddies_system parent(16, nullptr, nullptr, allocator_with_fit_mode::fit_mode::first_fit);
+
+    {
+        allocator_buddies_system original(10, &parent, nullptr, allocator_with_fit_mode::fit_mode::first_fit);
+        void *block = original.allocate(100);
+
+        // копия берет память у родителя оригинала и отдает ее ему же
+        allocator_buddies_system copy(8);
+        copy = original;
+
+        allocator_buddies_system moved_to(10, &parent, nullptr, allocator_with_fit_mode::fit_mode::first_fit);
+        moved_to = std::move(copy);
+
+        ASSERT_EQ(moved_to.get_blocks_info(), original.get_blocks_info());
+
+        original.deallocate(block, 100);
+    }
+
+    // память оригинала, копии и замененного при перемещении аллокатора вернулась родителю
+    auto actual_blocks_state = parent.get_blocks_info();
+    ASSERT_EQ(actual_blocks_state.size(), 1);
+    ASSERT_EQ(actual_blocks_state[0].block_size, 1 << 16);
+}
+
 TEST(falsePositiveTests, test1)
 {
     ASSERT_THROW(new allocator_buddies_system(static_cast<int>(std::floor(std::log2(sizeof(allocator_dbg_helper::block_pointer_t) * 2 + 1))) - 1), std::logic_error);
 }
 
+TEST(positiveTests, test12)
+{
+    allocator_buddies_system allocator_instance(14, nullptr, nullptr, allocator_with_fit_mode::fit_mode::first_fit);
+
+    auto initial = allocator_instance.get_statistics();
+
+    ASSERT_EQ(initial.total_bytes, 1 << 14);
+    ASSERT_EQ(initial.bytes_in_use, 0);
+    ASSERT_EQ(initial.peak_bytes_in_use, 0);
+    ASSERT_EQ(initial.largest_free_block, 1 << 14);
+
+    void *first_block = allocator_instance.allocate(1000);
+    void *second_block = allocator_instance.allocate(500);
+    ASSERT_THROW(static_cast<void>(allocator_instance.allocate(20'000)), std::bad_alloc);
+
+    auto after_allocations = allocator_instance.get_statistics();
+    auto blocks_state = allocator_instance.get_blocks_info();
+
+    size_t occupied_bytes = 0;
+    size_t largest_free_block = 0;
+    for (auto const &block : blocks_state)
+    {
+        if (block.is_block_occupied)
+        {
+            occupied_bytes += block.block_size;
+        }
+        else
+        {
+            largest_free_block = std::max(largest_free_block, block.block_size);
+        }
+    }
+
+    ASSERT_EQ(after_allocations.allocations, 2);
+    ASSERT_EQ(after_allocations.failed_allocations, 1);
+    ASSERT_EQ(after_allocations.occupied_blocks, 2);
+    ASSERT_EQ(after_allocations.bytes_in_use, occupied_bytes);
+    ASSERT_EQ(after_allocations.peak_bytes_in_use, occupied_bytes);
+    ASSERT_EQ(after_allocations.free_bytes, (1 << 14) - occupied_bytes);
+    ASSERT_EQ(after_allocations.largest_free_block, largest_free_block);
+
+    allocator_instance.deallocate(first_block, 1);
+
+    // пик не уменьшается после освобождения
+    auto after_first_deallocation = allocator_instance.get_statistics();
+
+    ASSERT_EQ(after_first_deallocation.deallocations, 1);
+    ASSERT_LT(after_first_deallocation.bytes_in_use, occupied_bytes);
+    ASSERT_EQ(after_first_deallocation.peak_bytes_in_use, occupied_bytes);
+
+    allocator_instance.deallocate(second_block, 1);
+
+    auto final = allocator_instance.get_statistics();
+
+    ASSERT_EQ(final.deallocations, 2);
+    ASSERT_EQ(final.occupied_blocks, 0);
+    ASSERT_EQ(final.bytes_in_use, 0);
+    ASSERT_EQ(final.peak_bytes_in_use, occupied_bytes);
+    ASSERT_EQ(final.largest_free_block, 1 << 14);
+}
+
+// логгер, который задерживает сообщение об отказе в выделении, пока аллокатор держит блокировку
+class blocking_logger final : public logger
+{
+
+public:
+
+    std::mutex mutex;
+
+    std::condition_variable condition;
+
+    bool armed = false;
+
+    bool entered = false;
+
+    bool released = false;
+
+    std::vector<std::string> errors;
+
+    logger &log(std::string const &message, logger::severity severity) & override
+    {
+        std::unique_lock lock(mutex);
+        if (severity == logger::severity::error)
+        {
+            errors.push_back(message);
+        }
+
+        if (armed && message.starts_with("No free block"))
+        {
+            armed = false;
+            entered = true;
+            condition.notify_all();
+            condition.wait(lock, [this] { return released; });
+        }
+
+        return *this;
+    }
+
+};
+
+TEST(positiveTests, test14)
+{
+    blocking_logger logger_instance;
+    allocator_buddies_system allocator_instance(12, nullptr, &logger_instance, allocator_with_fit_mode::fit_mode::first_fit);
+
+    void *first_block = allocator_instance.allocate(40);
+    void *second_block = allocator_instance.allocate(40, 16);
+
+    {
+        std::lock_guard lock(logger_instance.mutex);
+        logger_instance.armed = true;
+    }
+
+    // поток держит блокировку, пока логгер не отпустит
+    std::thread allocating_thread([&] { ASSERT_THROW(static_cast<void>(allocator_instance.allocate(1 << 12)), std::bad_alloc); });
+
+    {
+        std::unique_lock lock(logger_instance.mutex);
+        logger_instance.condition.wait(lock, [&] { return logger_instance.entered; });
+    }
+
+    // освобождения встают в очередь; повторное освобождение блока из очереди отвергается сразу,
+    // в том числе когда указатель на начало блока уже затерт ссылкой очереди
+    allocator_instance.deallocate(first_block, 1);
+    allocator_instance.deallocate(second_block, 1);
+    ASSERT_THROW(allocator_instance.deallocate(first_block, 1), std::logic_error);
+    ASSERT_THROW(allocator_instance.deallocate(second_block, 1), std::logic_error);
+    ASSERT_EQ(allocator_instance.get_statistics().remote_frees, 0);
+
+    {
+        std::lock_guard lock(logger_instance.mutex);
+        logger_instance.released = true;
+    }
+    logger_instance.condition.notify_all();
+    allocating_thread.join();
+
+    ASSERT_EQ(allocator_instance.get_statistics().occupied_blocks, 2);
+
+    // следующее освобождение под блокировкой разбирает очередь, и повторное снова отвергается
+    ASSERT_THROW(allocator_instance.deallocate(first_block, 1), std::logic_error);
+
+    auto statistics = allocator_instance.get_statistics();
+    ASSERT_EQ(statistics.remote_frees, 2);
+    ASSERT_EQ(statistics.occupied_blocks, 0);
+    ASSERT_EQ(logger_instance.errors.size(), 4);
+
+    std::vector<allocator_test_utils::block_info> expected_blocks_state { { .block_size = 1 << 12, .is_block_occupied = false } };
+    ASSERT_EQ(allocator_instance.get_blocks_info(), expected_blocks_state);
+}
+
 int main(
     int argc,
     char *argv[])
@@ -2,15 +2,24 @@
 #define MATH_PRACTICE_AND_OPERATING_SYSTEMS_ALLOCATOR_ALLOCATOR_GLOBAL_HEAP_H
 
 #include <allocator_dbg_helper.h>
+#include <allocator_statistics.h>
 #include <logger.h>
-#include <logger_guardant.h>
+#include <allocator_logger_guardant.h>
 #include <pp_allocator.h>
 #include <typename_holder.h>
 
+/**
+ * Every block is preceded by a header with its size, so the statistics count the bytes of a block
+ * whatever size the caller frees it with. Blocks aligned stricter than max_align_t are taken with
+ * the aligned operator new, their header is as long as the alignment and remembers it. There is no lock: the counters are updated atomically.
+ * A copy or a moved-to heap starts with zeroed counters, so the statistics are exact only when
+ * blocks are freed by the heap that allocated them.
+ */
 class allocator_global_heap final:
     private allocator_dbg_helper,
     public smart_mem_resource,
-    private logger_guardant,
+    public allocator_statistics,
+    private allocator_logger_guardant,
     private typename_holder
 {
 
@@ -20,6 +29,14 @@ private:
 
     static constexpr const size_t size_t_size = sizeof(size_t);
 
+    // заголовок блока хранит его размер и выравнивание (0 для блоков без строгого выравнивания)
+    // прямо перед данными и сохраняет выравнивание max_align_t
+    static constexpr const size_t block_metadata_size = alignof(std::max_align_t);
+
+    static_assert(block_metadata_size >= 2 * sizeof(size_t), "the header must hold the size and the alignment");
+
+    allocator_statistics::counters _counters;
+
 public:
     
     explicit allocator_global_heap(
@@ -43,12 +60,19 @@ public:
     
     [[nodiscard]] void *do_allocate_sm(
         size_t size) override;
+
+    [[nodiscard]] void *do_allocate_aligned_sm(
+        size_t size,
+        size_t alignment) override;
     
     void do_deallocate_sm(
         void *at) override;
 
     bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
 
+    // total_bytes is the memory taken from the heap, so free_bytes and largest_free_block are zero
+    statistics_snapshot get_statistics() const noexcept override;
+
 private:
     
     inline logger *get_logger() const override;
@@ -57,6 +81,11 @@ private:
     
     inline std::string get_typename() const override;
 
+    // заголовок перед данными: размер блока и его строгое выравнивание
+    static inline size_t &get_block_size(void *at) noexcept;
+
+    static inline size_t &get_block_alignment(void *at) noexcept;
+
 public:
 
 };
@@ -1,74 +1,141 @@
 #include "../include/allocator_global_heap.h"
+#include <limits>
 #include <new>
 #include <utility>
 
 allocator_global_heap::allocator_global_heap(logger *logger)
-        : _logger(logger)
+        : _logger(logger),
+          _counters(0)
 {
-    if (_logger) _logger->trace("allocator_global_heap::allocator_global_heap(logger *) started");
-    if (_logger) _logger->trace("allocator_global_heap::allocator_global_heap(logger *) finished");
+    trace_with_guard("allocator_global_heap::allocator_global_heap(logger *) started");
+    trace_with_guard("allocator_global_heap::allocator_global_heap(logger *) finished");
 }
 
 allocator_global_heap::~allocator_global_heap()
 {
-    if (_logger) _logger->trace("allocator_global_heap::~allocator_global_heap() started");
-    if (_logger) _logger->trace("allocator_global_heap::~allocator_global_heap() finished");
+    trace_with_guard("allocator_global_heap::~allocator_global_heap() started");
+    trace_with_guard("allocator_global_heap::~allocator_global_heap() finished");
 }
 
 allocator_global_heap::allocator_global_heap(const allocator_global_heap &other)
-        : _logger(other._logger)
+        : _logger(other._logger),
+          _counters(0)
 {
-    if (_logger) _logger->trace("allocator_global_heap::allocator_global_heap(const &) started");
-    if (_logger) _logger->trace("allocator_global_heap::allocator_global_heap(const &) finished");
+    trace_with_guard("allocator_global_heap::allocator_global_heap(const &) started");
+    trace_with_guard("allocator_global_heap::allocator_global_heap(const &) finished");
 }
 
 allocator_global_heap &allocator_global_heap::operator=(const allocator_global_heap &other)
 {
-    if (_logger) _logger->trace("allocator_global_heap::operator=(const &) started");
+    trace_with_guard("allocator_global_heap::operator=(const &) started");
     if (this != &other) {
         _logger = other._logger;
     }
-    if (_logger) _logger->trace("allocator_global_heap::operator=(const &) finished");
+    trace_with_guard("allocator_global_heap::operator=(const &) finished");
     return *this;
 }
 
 allocator_global_heap::allocator_global_heap(allocator_global_heap &&other) noexcept
-        : _logger(other._logger)
+        : _logger(other._logger),
+          _counters(0)
 {
-    if (_logger) _logger->trace("allocator_global_heap::allocator_global_heap(&&) started");
+    trace_with_guard("allocator_global_heap::allocator_global_heap(&&) started");
     other._logger = nullptr;
-    if (_logger) _logger->trace("allocator_global_heap::allocator_global_heap(&&) finished");
+    trace_with_guard("allocator_global_heap::allocator_global_heap(&&) finished");
 }
 
 allocator_global_heap &allocator_global_heap::operator=(allocator_global_heap &&other) noexcept
 {
-    if (_logger) _logger->trace("allocator_global_heap::operator=(&&) started");
+    trace_with_guard("allocator_global_heap::operator=(&&) started");
     if (this != &other) {
         _logger = other._logger;
         other._logger = nullptr;
     }
-    if (_logger) _logger->trace("allocator_global_heap::operator=(&&) finished");
+    trace_with_guard("allocator_global_heap::operator=(&&) finished");
     return *this;
 }
 
 void *allocator_global_heap::do_allocate_sm(size_t size)
 {
-    if (_logger) _logger->debug("allocator_global_heap::do_allocate_sm started. Size: " + std::to_string(size));
+    if (is_enabled_with_guard(logger::severity::debug))
+    {
+        debug_with_guard("allocator_global_heap::do_allocate_sm started. Size: " + std::to_string(size));
+    }
     try {
-        void *ptr = ::operator new(size);
-        if (_logger) _logger->debug("allocator_global_heap::do_allocate_sm finished. Ptr: " + std::to_string(reinterpret_cast<std::uintptr_t>(ptr)));
+        if (size > std::numeric_limits<size_t>::max() - block_metadata_size)
+        {
+            throw std::bad_alloc();
+        }
+
+        void *block = ::operator new(size + block_metadata_size);
+        void *ptr = reinterpret_cast<unsigned char *>(block) + block_metadata_size;
+        get_block_size(ptr) = size;
+        get_block_alignment(ptr) = 0;
+        _counters.on_allocate_unlocked(size);
+
+        if (is_enabled_with_guard(logger::severity::debug))
+        {
+            debug_with_guard("allocator_global_heap::do_allocate_sm finished. Ptr: " + std::to_string(reinterpret_cast<std::uintptr_t>(ptr)));
+        }
+        return ptr;
+    } catch (const std::bad_alloc &) {
+        _counters.on_failed_allocation_unlocked();
+        error_with_guard("allocator_global_heap::do_allocate_sm failed with std::bad_alloc");
+        throw;
+    }
+}
+
+void *allocator_global_heap::do_allocate_aligned_sm(size_t size, size_t alignment)
+{
+    if (alignment <= block_metadata_size)
+    {
+        return do_allocate_sm(size);
+    }
+
+    try {
+        if (size > std::numeric_limits<size_t>::max() - alignment)
+        {
+            throw std::bad_alloc();
+        }
+
+        // заголовок длиной в выравнивание оставляет данные выровненными
+        void *block = ::operator new(size + alignment, std::align_val_t(alignment));
+        void *ptr = reinterpret_cast<unsigned char *>(block) + alignment;
+        get_block_size(ptr) = size;
+        get_block_alignment(ptr) = alignment;
+        _counters.on_allocate_unlocked(size);
+
         return ptr;
     } catch (const std::bad_alloc &) {
-        if (_logger) _logger->error("allocator_global_heap::do_allocate_sm failed with std::bad_alloc");
+        _counters.on_failed_allocation_unlocked();
+        error_with_guard("allocator_global_heap::do_allocate_aligned_sm failed with std::bad_alloc");
         throw;
     }
 }
 
 void allocator_global_heap::do_deallocate_sm(void *at)
 {
-    if (_logger) _logger->debug("allocator_global_heap::do_deallocate_sm started. Ptr: " + std::to_string(reinterpret_cast<std::uintptr_t>(at)));
-    ::operator delete(at);
-    if (_logger) _logger->debug("allocator_global_heap::do_deallocate_sm finished.");
+    if (is_enabled_with_guard(logger::severity::debug))
+    {
+        debug_with_guard("allocator_global_heap::do_deallocate_sm started. Ptr: " + std::to_string(reinterpret_cast<std::uintptr_t>(at)));
+    }
+    if (at == nullptr)
+    {
+        return;
+    }
+
+    _counters.on_deallocate_unlocked(get_block_size(at));
+
+    size_t alignment = get_block_alignment(at);
+    if (alignment == 0)
+    {
+        ::operator delete(reinterpret_cast<unsigned char *>(at) - block_metadata_size);
+    }
+    else
+    {
+        ::operator delete(reinterpret_cast<unsigned char *>(at) - alignment, std::align_val_t(alignment));
+    }
+    debug_with_guard("allocator_global_heap::do_deallocate_sm finished.");
 }
 
 bool allocator_global_heap::do_is_equal(const std::pmr::memory_resource &other) const noexcept
@@ -76,6 +143,15 @@ bool allocator_global_heap::do_is_equal(const std::pmr::memory_resource &other)
     return this == &other;
 }
 
+allocator_statistics::statistics_snapshot allocator_global_heap::get_statistics() const noexcept
+{
+    auto snapshot = _counters.snapshot();
+    snapshot.total_bytes = snapshot.bytes_in_use;
+    snapshot.free_bytes = 0;
+    snapshot.largest_free_block = 0;
+    return snapshot;
+}
+
 logger *allocator_global_heap::get_logger() const
 {
     return _logger;
@@ -85,3 +161,13 @@ std::string allocator_global_heap::get_typename() const
 {
     return "allocator_global_heap";
 }
+
+inline size_t &allocator_global_heap::get_block_size(void *at) noexcept
+{
+    return reinterpret_cast<size_t *>(at)[-2];
+}
+
+inline size_t &allocator_global_heap::get_block_alignment(void *at) noexcept
+{
+    return reinterpret_cast<size_t *>(at)[-1];
+}
@@ -1,5 +1,9 @@
 #include <gtest/gtest.h>
+#include <bit>
+#include <cstdint>
 #include <iostream>
+#include <thread>
+#include <vector>
 #include <allocator_global_heap.h>
 #include <client_logger_builder.h>
 
@@ -77,6 +81,107 @@ TEST(allocatorGlobalHeapTests, test4)
     allocator_instance->deallocate(second_block, 1);
 }
 
+TEST(allocatorGlobalHeapTests, test5)
+{
+    allocator_global_heap allocator_instance;
+
+    void *first_block = allocator_instance.allocate(1000);
+    void *second_block = allocator_instance.allocate(500);
+
+    auto after_allocations = allocator_instance.get_statistics();
+
+    ASSERT_EQ(after_allocations.allocations, 2);
+    ASSERT_EQ(after_allocations.occupied_blocks, 2);
+    ASSERT_EQ(after_allocations.bytes_in_use, 1500);
+    ASSERT_EQ(after_allocations.peak_bytes_in_use, 1500);
+    ASSERT_EQ(after_allocations.total_bytes, 1500);
+    ASSERT_EQ(after_allocations.free_bytes, 0);
+    ASSERT_EQ(after_allocations.largest_free_block, 0);
+    ASSERT_EQ(after_allocations.occupied_blocks_per_size_class[std::bit_width(1000u) - 1], 1);
+
+    // размер блока берется из его заголовка, а не из аргумента deallocate
+    allocator_instance.deallocate(first_block, 1);
+
+    auto after_first_deallocation = allocator_instance.get_statistics();
+
+    ASSERT_EQ(after_first_deallocation.deallocations, 1);
+    ASSERT_EQ(after_first_deallocation.bytes_in_use, 500);
+    ASSERT_EQ(after_first_deallocation.peak_bytes_in_use, 1500);
+
+    allocator_instance.deallocate(second_block, 1);
+
+    auto final = allocator_instance.get_statistics();
+
+    ASSERT_EQ(final.deallocations, 2);
+    ASSERT_EQ(final.occupied_blocks, 0);
+    ASSERT_EQ(final.bytes_in_use, 0);
+    ASSERT_EQ(final.peak_bytes_in_use, 1500);
+}
+
+TEST(allocatorGlobalHeapTests, test6)
+{
+    allocator_global_heap allocator_instance;
+
+    constexpr size_t threads_count = 4;
+    constexpr size_t blocks_per_thread = 1000;
+
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < threads_count; ++i)
+    {
+        threads.emplace_back([&allocator_instance]
+        {
+            std::vector<void *> blocks;
+            for (size_t j = 0; j < blocks_per_thread; ++j)
+            {
+                blocks.push_back(allocator_instance.allocate(16 + j % 64));
+            }
+            for (auto *block : blocks)
+            {
+                allocator_instance.deallocate(block, 1);
+            }
+        });
+    }
+
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+
+    // счетчики меняются без блокировки, но ни одно изменение не теряется
+    auto statistics = allocator_instance.get_statistics();
+
+    ASSERT_EQ(statistics.allocations, threads_count * blocks_per_thread);
+    ASSERT_EQ(statistics.deallocations, threads_count * blocks_per_thread);
+    ASSERT_EQ(statistics.occupied_blocks, 0);
+    ASSERT_EQ(statistics.bytes_in_use, 0);
+    ASSERT_GT(statistics.peak_bytes_in_use, 0);
+}
+
+TEST(allocatorGlobalHeapTests, test7)
+{
+    allocator_global_heap allocator_instance;
+
+    // выравнивание строже max_align_t дает aligned operator new, а не случайная удача
+    std::vector<void *> blocks;
+    for (size_t i = 0; i < 32; ++i)
+    {
+        size_t alignment = size_t(32) << (i % 4);
+        blocks.push_back(allocator_instance.allocate(13 + i, alignment));
+        ASSERT_EQ(reinterpret_cast<std::uintptr_t>(blocks.back()) % alignment, 0);
+    }
+
+    ASSERT_EQ(allocator_instance.get_statistics().occupied_blocks, 32);
+
+    for (size_t i = 0; i < blocks.size(); ++i)
+    {
+        allocator_instance.deallocate(blocks[i], 13 + i, size_t(32) << (i % 4));
+    }
+
+    auto statistics = allocator_instance.get_statistics();
+    ASSERT_EQ(statistics.occupied_blocks, 0);
+    ASSERT_EQ(statistics.bytes_in_use, 0);
+}
+
 int main(
     int argc,
     char *argv[])
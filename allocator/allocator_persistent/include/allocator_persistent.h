@@ -0,0 +1,285 @@
+#ifndef MATH_PRACTICE_AND_OPERATING_SYSTEMS_ALLOCATOR_ALLOCATOR_PERSISTENT_H
+#define MATH_PRACTICE_AND_OPERATING_SYSTEMS_ALLOCATOR_ALLOCATOR_PERSISTENT_H
+
+#include <allocator_test_utils.h>
+#include <allocator_with_fit_mode.h>
+#include <pp_allocator.h>
+#include <allocator_logger_guardant.h>
+#include <typename_holder.h>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <set>
+#include <string>
+#include <utility>
+
+/**
+ * Pointer stored as the distance from its own address to the target, so a structure made of such pointers
+ * stays valid wherever the file of allocator_persistent is mapped. The distance 1 means nullptr:
+ * a pointer can not point into its own middle.
+ */
+template<typename T>
+class offset_ptr final
+{
+
+private:
+
+    std::ptrdiff_t _distance;
+
+public:
+
+    offset_ptr(
+        T *pointer = nullptr) noexcept
+    {
+        set(pointer);
+    }
+
+    offset_ptr(
+        offset_ptr const &other) noexcept
+    {
+        set(other.get());
+    }
+
+    offset_ptr &operator=(
+        offset_ptr const &other) noexcept
+    {
+        set(other.get());
+        return *this;
+    }
+
+    offset_ptr &operator=(
+        T *pointer) noexcept
+    {
+        set(pointer);
+        return *this;
+    }
+
+public:
+
+    T *get() const noexcept
+    {
+        return _distance == 1
+            ? nullptr
+            : reinterpret_cast<T *>(reinterpret_cast<std::uintptr_t>(this) + _distance);
+    }
+
+    T *operator->() const noexcept
+    {
+        return get();
+    }
+
+    T &operator*() const noexcept
+    {
+        return *get();
+    }
+
+    operator T *() const noexcept
+    {
+        return get();
+    }
+
+private:
+
+    void set(
+        T *pointer) noexcept
+    {
+        _distance = pointer == nullptr
+            ? 1
+            : static_cast<std::ptrdiff_t>(reinterpret_cast<std::uintptr_t>(pointer) - reinterpret_cast<std::uintptr_t>(this));
+    }
+
+};
+
+/**
+ * Boundary tags heap living in a memory-mapped file. All block metadata is kept as offsets from the start of
+ * the file, so the heap, and the structures allocated from it with offset_ptr links, are used as they are
+ * after the file is opened again, by the same or another process, at any address.
+ * One block can be marked as the root to find the stored structure after reopening.
+ * Free gaps between blocks are indexed by size in process memory; the index is built when the file is opened.
+ * The file may be used by one allocator at a time. Changes reach the disk when the OS writes the pages back,
+ * flush() and the destructor force it. A process killed in the middle of an allocation or a free leaves
+ * the file marked unclean; such a file is checked when opened and rejected if the block list is broken.
+ */
+class allocator_persistent final:
+    public smart_mem_resource,
+    public allocator_test_utils,
+    public allocator_with_fit_mode,
+    private allocator_logger_guardant,
+    private typename_holder
+{
+
+private:
+
+    // заголовок файла: сигнатура, версия, фит мод, размер файла, смещение первого занятого блока,
+    // смещение корня, признак незавершенной операции; выровнен до 64 байт
+
+    // мета занятого блока: размер данных, смещения предыдущего и следующего занятого блока, контрольное слово
+    // (смещение блока, сложенное по xor с block_check_mask); смещение 0 означает отсутствие блока
+
+    struct file_header
+    {
+        char signature[8];
+        std::uint32_t version;
+        std::uint32_t fit_mode;
+        std::uint64_t file_size;
+        std::uint64_t first_occupied;
+        std::uint64_t root;
+        std::uint64_t dirty;
+        std::uint64_t reserved[2];
+    };
+
+    struct block_metadata
+    {
+        std::uint64_t size;
+        std::uint64_t prev;
+        std::uint64_t next;
+        std::uint64_t check;
+    };
+
+    static constexpr const char file_signature[8] = { 'M', 'P', 'O', 'S', 'P', 'R', 'S', '\0' };
+
+    static constexpr const std::uint32_t file_version = 1;
+
+    static constexpr const std::uint64_t block_check_mask = 0x5045'5253'4953'5400;
+
+    static constexpr const size_t allocator_metadata_size = sizeof(file_header);
+
+    static constexpr const size_t occupied_block_metadata_size = sizeof(block_metadata);
+
+    // данные блоков выровнены хотя бы на 8, чтобы мета перед ними тоже была выровнена
+    static constexpr const size_t min_alignment = alignof(block_metadata);
+
+    void *_trusted_memory;
+
+    size_t _mapping_size;
+
+    logger *_logger;
+
+    mutable std::mutex _mutex;
+
+    // непустые дыры по возрастанию размера: размер и смещение занятого блока перед дырой (0 - заголовок файла)
+    std::set<std::pair<std::uint64_t, std::uint64_t>> _free_gaps;
+
+#ifdef _WIN32
+    void *_file;
+
+    void *_file_mapping;
+#else
+    int _file;
+#endif
+
+public:
+
+    /**
+     * Opens the heap stored in the file or creates a new one of space_size bytes if the file does not
+     * exist or is empty. space_size is ignored for an existing heap.
+     * Throws std::runtime_error if the file can not be mapped or does not hold a valid heap.
+     */
+    explicit allocator_persistent(
+        std::string const &file_path,
+        size_t space_size,
+        logger *logger = nullptr,
+        allocator_with_fit_mode::fit_mode allocate_fit_mode = allocator_with_fit_mode::fit_mode::first_fit);
+
+    allocator_persistent(
+        allocator_persistent const &other) = delete;
+
+    allocator_persistent &operator=(
+        allocator_persistent const &other) = delete;
+
+    allocator_persistent(
+        allocator_persistent &&other) noexcept = delete;
+
+    allocator_persistent &operator=(
+        allocator_persistent &&other) noexcept = delete;
+
+    // occupied blocks stay in the file
+    ~allocator_persistent() override;
+
+public:
+
+    [[nodiscard]] void *do_allocate_sm(
+        size_t size) override;
+
+    [[nodiscard]] void *do_allocate_aligned_sm(
+        size_t size,
+        size_t alignment) override;
+
+    void do_deallocate_sm(
+        void *at) override;
+
+    bool do_is_equal(
+        std::pmr::memory_resource const &other) const noexcept override;
+
+public:
+
+    inline void set_fit_mode(
+        allocator_with_fit_mode::fit_mode mode) override;
+
+    std::vector<allocator_test_utils::block_info> get_blocks_info() const override;
+
+public:
+
+    // the block must be allocated by this allocator, nullptr clears the root
+    void set_root(
+        void *block);
+
+    // nullptr if no root was set
+    void *get_root() const;
+
+    size_t get_size() const noexcept;
+
+    // writes the changed pages to the file and waits for it
+    void flush();
+
+private:
+
+    std::vector<allocator_test_utils::block_info> get_blocks_info_inner() const override;
+
+    // true if the file was empty and the heap has to be created
+    bool map_file(
+        std::string const &file_path,
+        size_t space_size);
+
+    void unmap_file() noexcept;
+
+    void create_heap(
+        size_t file_size,
+        allocator_with_fit_mode::fit_mode allocate_fit_mode);
+
+    void check_heap(
+        std::string const &file_path);
+
+    void index_free_gaps();
+
+    // the gap after the occupied block at prev, 0 is the file header
+    inline std::uint64_t get_gap_start(
+        std::uint64_t prev) const noexcept;
+
+    inline std::uint64_t get_gap_end(
+        std::uint64_t prev) const noexcept;
+
+    void insert_free_gap(
+        std::uint64_t prev);
+
+    void erase_free_gap(
+        std::uint64_t prev) noexcept;
+
+    inline file_header &get_header() const noexcept;
+
+    inline block_metadata &get_block(
+        std::uint64_t offset) const noexcept;
+
+    inline std::uint64_t get_block_end(
+        std::uint64_t offset) const noexcept;
+
+    std::uint64_t get_occupied_block_offset(
+        void *at);
+
+    inline logger *get_logger() const override;
+
+    inline std::string get_typename() const override;
+
+};
+
+#endif //MATH_PRACTICE_AND_OPERATING_SYSTEMS_ALLOCATOR_ALLOCATOR_PERSISTENT_H
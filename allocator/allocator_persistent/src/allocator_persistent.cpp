@@ -0,0 +1,538 @@
+#include "../include/allocator_persistent.h"
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    constexpr std::uint64_t round_up(
+        std::uint64_t value,
+        std::uint64_t alignment) noexcept
+    {
+        return (value + alignment - 1) & ~(alignment - 1);
+    }
+
+    // файл растягивается до целого числа страниц, 64 КБ подходят и для гранулярности Windows
+    constexpr std::uint64_t file_size_granularity = 1 << 16;
+}
+
+allocator_persistent::allocator_persistent(
+    std::string const &file_path,
+    size_t space_size,
+    logger *logger,
+    allocator_with_fit_mode::fit_mode allocate_fit_mode):
+        _trusted_memory(nullptr),
+        _mapping_size(0),
+        _logger(logger)
+{
+    if (space_size > std::numeric_limits<size_t>::max() / 2)
+    {
+        throw std::bad_alloc();
+    }
+
+    bool created = map_file(file_path, space_size);
+
+    try
+    {
+        if (created)
+        {
+            create_heap(_mapping_size, allocate_fit_mode);
+            debug_with_guard("Created persistent heap in " + file_path);
+        }
+        else
+        {
+            check_heap(file_path);
+            debug_with_guard("Opened persistent heap in " + file_path);
+        }
+
+        index_free_gaps();
+    }
+    catch (...)
+    {
+        unmap_file();
+        throw;
+    }
+}
+
+allocator_persistent::~allocator_persistent()
+{
+    debug_with_guard("Called allocator destructor");
+    unmap_file();
+}
+
+/** A new file is created empty and resized here, an existing one is mapped with its own size.
+ */
+bool allocator_persistent::map_file(
+    std::string const &file_path,
+    size_t space_size)
+{
+#ifdef _WIN32
+    _file = CreateFileA(file_path.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (_file == INVALID_HANDLE_VALUE)
+    {
+        error_with_guard("Can not open heap file " + file_path);
+        throw std::runtime_error("Cannot open heap file: " + file_path);
+    }
+
+    LARGE_INTEGER file_size;
+    GetFileSizeEx(_file, &file_size);
+    bool created = file_size.QuadPart == 0;
+    _mapping_size = created
+        ? round_up(space_size + allocator_metadata_size, file_size_granularity)
+        : static_cast<size_t>(file_size.QuadPart);
+
+    _file_mapping = CreateFileMappingA(_file, nullptr, PAGE_READWRITE,
+                                       static_cast<DWORD>(static_cast<std::uint64_t>(_mapping_size) >> 32),
+                                       static_cast<DWORD>(_mapping_size), nullptr);
+    _trusted_memory = _file_mapping == nullptr ? nullptr : MapViewOfFile(_file_mapping, FILE_MAP_ALL_ACCESS, 0, 0, 0);
+
+    if (_trusted_memory == nullptr)
+    {
+        if (_file_mapping != nullptr)
+        {
+            CloseHandle(_file_mapping);
+        }
+        CloseHandle(_file);
+        error_with_guard("Can not map heap file " + file_path);
+        throw std::runtime_error("Cannot map heap file: " + file_path);
+    }
+#else
+    _file = open(file_path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (_file == -1)
+    {
+        error_with_guard("Can not open heap file " + file_path);
+        throw std::runtime_error("Cannot open heap file: " + file_path);
+    }
+
+    struct stat file_status {};
+    fstat(_file, &file_status);
+    bool created = file_status.st_size == 0;
+    _mapping_size = created
+        ? round_up(space_size + allocator_metadata_size, file_size_granularity)
+        : static_cast<size_t>(file_status.st_size);
+
+    if (created && ftruncate(_file, static_cast<off_t>(_mapping_size)) != 0)
+    {
+        close(_file);
+        error_with_guard("Can not resize heap file " + file_path);
+        throw std::runtime_error("Cannot resize heap file: " + file_path);
+    }
+
+    void *mapping = mmap(nullptr, _mapping_size, PROT_READ | PROT_WRITE, MAP_SHARED, _file, 0);
+    if (mapping == MAP_FAILED)
+    {
+        close(_file);
+        error_with_guard("Can not map heap file " + file_path);
+        throw std::runtime_error("Cannot map heap file: " + file_path);
+    }
+    _trusted_memory = mapping;
+#endif
+
+    return created;
+}
+
+void allocator_persistent::unmap_file() noexcept
+{
+    if (_trusted_memory == nullptr)
+    {
+        return;
+    }
+
+#ifdef _WIN32
+    FlushViewOfFile(_trusted_memory, 0);
+    UnmapViewOfFile(_trusted_memory);
+    CloseHandle(_file_mapping);
+    CloseHandle(_file);
+#else
+    msync(_trusted_memory, _mapping_size, MS_SYNC);
+    munmap(_trusted_memory, _mapping_size);
+    close(_file);
+#endif
+
+    _trusted_memory = nullptr;
+}
+
+// сигнатура пишется последней: файл, оборванный при создании, не примется за кучу
+void allocator_persistent::create_heap(
+    size_t file_size,
+    allocator_with_fit_mode::fit_mode allocate_fit_mode)
+{
+    file_header &header = get_header();
+
+    header.version = file_version;
+    header.fit_mode = static_cast<std::uint32_t>(allocate_fit_mode);
+    header.file_size = file_size;
+    header.first_occupied = 0;
+    header.root = 0;
+    header.dirty = 0;
+    std::memcpy(header.signature, file_signature, sizeof(file_signature));
+}
+
+/** After an unclean close the list of occupied blocks is walked: every block must lie inside the file after
+ * the previous one and carry its check word. Forward links are changed first by allocation and free, so they
+ * are trusted and the back links are restored from them.
+ */
+void allocator_persistent::check_heap(
+    std::string const &file_path)
+{
+    file_header &header = get_header();
+
+    if (_mapping_size < allocator_metadata_size ||
+        std::memcmp(header.signature, file_signature, sizeof(file_signature)) != 0 ||
+        header.version != file_version ||
+        header.file_size != _mapping_size)
+    {
+        error_with_guard("File " + file_path + " does not hold a persistent heap");
+        throw std::runtime_error("Not a persistent heap file of a supported version: " + file_path);
+    }
+
+    if (header.dirty == 0)
+    {
+        return;
+    }
+
+    warning_with_guard("Persistent heap " + file_path + " was not closed cleanly, checking blocks");
+
+    std::uint64_t prev = 0;
+    std::uint64_t prev_end = allocator_metadata_size;
+
+    for (std::uint64_t current = header.first_occupied; current != 0; current = get_block(current).next)
+    {
+        if (current < prev_end ||
+            current > header.file_size - occupied_block_metadata_size ||
+            current % alignof(block_metadata) != 0 ||
+            get_block(current).check != (current ^ block_check_mask) ||
+            get_block(current).size > header.file_size - current - occupied_block_metadata_size)
+        {
+            error_with_guard("Persistent heap " + file_path + " is broken");
+            throw std::runtime_error("Broken persistent heap file: " + file_path);
+        }
+
+        get_block(current).prev = prev;
+        prev = current;
+        prev_end = get_block_end(current);
+    }
+
+    if (header.root >= header.file_size)
+    {
+        header.root = 0;
+    }
+
+    header.dirty = 0;
+}
+
+void allocator_persistent::index_free_gaps()
+{
+    _free_gaps.clear();
+
+    insert_free_gap(0);
+    for (std::uint64_t current = get_header().first_occupied; current != 0; current = get_block(current).next)
+    {
+        insert_free_gap(current);
+    }
+}
+
+/** Only erasing is done before the file is changed, so an exception while inserting loses a gap
+ * until the file is opened again but never leaves a stale one in the index.
+ */
+void allocator_persistent::insert_free_gap(
+    std::uint64_t prev)
+{
+    if (std::uint64_t gap_size = get_gap_end(prev) - get_gap_start(prev); gap_size != 0)
+    {
+        _free_gaps.emplace(gap_size, prev);
+    }
+}
+
+void allocator_persistent::erase_free_gap(
+    std::uint64_t prev) noexcept
+{
+    _free_gaps.erase({ get_gap_end(prev) - get_gap_start(prev), prev });
+}
+
+[[nodiscard]] void *allocator_persistent::do_allocate_sm(
+    size_t size)
+{
+    return do_allocate_aligned_sm(size, 1);
+}
+
+/** Gaps between occupied blocks are the free blocks, like in allocator_boundary_tags. The metadata of the new
+ * block is put right before the aligned data, so the alignment padding stays a part of the gap on the left.
+ * The gap is taken from the size index: the_worst_fit takes the largest one, the other modes the smallest
+ * one that fits, so first_fit and next_fit behave as the_best_fit.
+ */
+[[nodiscard]] void *allocator_persistent::do_allocate_aligned_sm(
+    size_t size,
+    size_t alignment)
+{
+    std::lock_guard lock(_mutex);
+
+    file_header &header = get_header();
+    alignment = std::max(alignment, min_alignment);
+
+    if (size > header.file_size)
+    {
+        error_with_guard("Requested size is too big");
+        throw std::bad_alloc();
+    }
+
+    auto mode = static_cast<allocator_with_fit_mode::fit_mode>(header.fit_mode);
+    std::uint64_t needed = occupied_block_metadata_size + size;
+
+    std::uint64_t found_data = 0;
+    std::uint64_t found_prev = 0;
+
+    auto fits = [&](std::pair<std::uint64_t, std::uint64_t> const &gap)
+    {
+        std::uint64_t data = round_up(get_gap_start(gap.second) + occupied_block_metadata_size, alignment);
+        if (data + size > get_gap_end(gap.second))
+        {
+            return false;
+        }
+
+        found_data = data;
+        found_prev = gap.second;
+        return true;
+    };
+
+    // дыра, которой не хватило только из-за выравнивания, пропускается; дальше идут дыры не меньше
+    if (mode == allocator_with_fit_mode::fit_mode::the_worst_fit)
+    {
+        for (auto gap = _free_gaps.rbegin(); gap != _free_gaps.rend() && gap->first >= needed && !fits(*gap); ++gap)
+        {
+        }
+    }
+    else
+    {
+        for (auto gap = _free_gaps.lower_bound({ needed, 0 }); gap != _free_gaps.end() && !fits(*gap); ++gap)
+        {
+        }
+    }
+
+    if (found_data == 0)
+    {
+        error_with_guard("No free gap for requested size");
+        throw std::bad_alloc();
+    }
+
+    std::uint64_t found_next = found_prev == 0 ? header.first_occupied : get_block(found_prev).next;
+    erase_free_gap(found_prev);
+
+    header.dirty = 1;
+
+    std::uint64_t offset = found_data - occupied_block_metadata_size;
+    block_metadata &block = get_block(offset);
+    block.size = size;
+    block.prev = found_prev;
+    block.next = found_next;
+    block.check = offset ^ block_check_mask;
+
+    (found_prev == 0 ? header.first_occupied : get_block(found_prev).next) = offset;
+    if (found_next != 0)
+    {
+        get_block(found_next).prev = offset;
+    }
+
+    header.dirty = 0;
+
+    // дыра слева остается за предыдущим блоком, справа - за новым
+    insert_free_gap(found_prev);
+    insert_free_gap(offset);
+
+    if (is_enabled_with_guard(logger::severity::debug))
+    {
+        debug_with_guard("Allocated " + std::to_string(size) + " bytes at offset " + std::to_string(found_data));
+    }
+
+    return reinterpret_cast<unsigned char *>(_trusted_memory) + found_data;
+}
+
+void allocator_persistent::do_deallocate_sm(
+    void *at)
+{
+    if (at == nullptr)
+    {
+        return;
+    }
+
+    std::lock_guard lock(_mutex);
+
+    file_header &header = get_header();
+    std::uint64_t offset = get_occupied_block_offset(at);
+    block_metadata &block = get_block(offset);
+
+    erase_free_gap(block.prev);
+    erase_free_gap(offset);
+
+    header.dirty = 1;
+
+    (block.prev == 0 ? header.first_occupied : get_block(block.prev).next) = block.next;
+    if (block.next != 0)
+    {
+        get_block(block.next).prev = block.prev;
+    }
+
+    // повторное освобождение того же блока не пройдет проверку
+    block.check = 0;
+
+    if (header.root == offset + occupied_block_metadata_size)
+    {
+        warning_with_guard("Root block was deallocated");
+        header.root = 0;
+    }
+
+    header.dirty = 0;
+
+    insert_free_gap(block.prev);
+
+    trace_with_guard("Deallocated block");
+}
+
+std::uint64_t allocator_persistent::get_occupied_block_offset(
+    void *at)
+{
+    auto address = reinterpret_cast<std::uintptr_t>(at);
+    auto start = reinterpret_cast<std::uintptr_t>(_trusted_memory);
+
+    if (address < start + allocator_metadata_size + occupied_block_metadata_size ||
+        address >= start + _mapping_size ||
+        address % min_alignment != 0 ||
+        get_block(address - start - occupied_block_metadata_size).check != ((address - start - occupied_block_metadata_size) ^ block_check_mask))
+    {
+        error_with_guard("Tried to deallocate not allocator's property");
+        throw std::logic_error("Not allocator's property");
+    }
+
+    return address - start - occupied_block_metadata_size;
+}
+
+bool allocator_persistent::do_is_equal(
+    std::pmr::memory_resource const &other) const noexcept
+{
+    return this == &other;
+}
+
+inline void allocator_persistent::set_fit_mode(
+    allocator_with_fit_mode::fit_mode mode)
+{
+    std::lock_guard lock(_mutex);
+    get_header().fit_mode = static_cast<std::uint32_t>(mode);
+}
+
+void allocator_persistent::set_root(
+    void *block)
+{
+    std::lock_guard lock(_mutex);
+    get_header().root = block == nullptr ? 0 : get_occupied_block_offset(block) + occupied_block_metadata_size;
+}
+
+void *allocator_persistent::get_root() const
+{
+    std::lock_guard lock(_mutex);
+    std::uint64_t root = get_header().root;
+
+    return root == 0 ? nullptr : reinterpret_cast<unsigned char *>(_trusted_memory) + root;
+}
+
+size_t allocator_persistent::get_size() const noexcept
+{
+    return get_header().file_size - allocator_metadata_size;
+}
+
+void allocator_persistent::flush()
+{
+    std::lock_guard lock(_mutex);
+
+#ifdef _WIN32
+    bool flushed = FlushViewOfFile(_trusted_memory, 0) && FlushFileBuffers(_file);
+#else
+    bool flushed = msync(_trusted_memory, _mapping_size, MS_SYNC) == 0;
+#endif
+
+    if (!flushed)
+    {
+        error_with_guard("Can not write persistent heap to the file");
+        throw std::runtime_error("Cannot write persistent heap to the file");
+    }
+}
+
+std::vector<allocator_test_utils::block_info> allocator_persistent::get_blocks_info() const
+{
+    std::lock_guard lock(_mutex);
+
+    return get_blocks_info_inner();
+}
+
+std::vector<allocator_test_utils::block_info> allocator_persistent::get_blocks_info_inner() const
+{
+    std::vector<allocator_test_utils::block_info> result;
+    file_header &header = get_header();
+
+    std::uint64_t gap_start = allocator_metadata_size;
+    for (std::uint64_t current = header.first_occupied; current != 0; current = get_block(current).next)
+    {
+        if (current > gap_start)
+        {
+            result.push_back({ current - gap_start, false });
+        }
+        result.push_back({ occupied_block_metadata_size + get_block(current).size, true });
+        gap_start = get_block_end(current);
+    }
+
+    if (header.file_size > gap_start)
+    {
+        result.push_back({ header.file_size - gap_start, false });
+    }
+
+    return result;
+}
+
+inline allocator_persistent::file_header &allocator_persistent::get_header() const noexcept
+{
+    return *reinterpret_cast<file_header *>(_trusted_memory);
+}
+
+inline allocator_persistent::block_metadata &allocator_persistent::get_block(
+    std::uint64_t offset) const noexcept
+{
+    return *reinterpret_cast<block_metadata *>(reinterpret_cast<unsigned char *>(_trusted_memory) + offset);
+}
+
+inline std::uint64_t allocator_persistent::get_block_end(
+    std::uint64_t offset) const noexcept
+{
+    return offset + occupied_block_metadata_size + get_block(offset).size;
+}
+
+inline std::uint64_t allocator_persistent::get_gap_start(
+    std::uint64_t prev) const noexcept
+{
+    return prev == 0 ? allocator_metadata_size : get_block_end(prev);
+}
+
+inline std::uint64_t allocator_persistent::get_gap_end(
+    std::uint64_t prev) const noexcept
+{
+    std::uint64_t next = prev == 0 ? get_header().first_occupied : get_block(prev).next;
+    return next == 0 ? get_header().file_size : next;
+}
+
+inline logger *allocator_persistent::get_logger() const
+{
+    return _logger;
+}
+
+inline std::string allocator_persistent::get_typename() const
+{
+    return "allocator_persistent";
+}
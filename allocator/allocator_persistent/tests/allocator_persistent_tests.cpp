@@ -0,0 +1,177 @@
+#include <gtest/gtest.h>
+#include <allocator_persistent.h>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+namespace
+{
+    std::string heap_path(
+        std::string const &name)
+    {
+        auto path = (std::filesystem::temp_directory_path() / name).string();
+        std::filesystem::remove(path);
+        return path;
+    }
+
+    struct list_node
+    {
+        int value;
+        offset_ptr<list_node> next;
+    };
+}
+
+TEST(allocatorPersistentPositiveTests, test1)
+{
+    auto path = heap_path("allocator_persistent_tests_1.heap");
+    std::vector<allocator_test_utils::block_info> blocks_state;
+
+    {
+        allocator_persistent allocator(path, 100'000);
+
+        // список строится с головы, корень - голова
+        list_node *head = nullptr;
+        for (int i = 0; i < 100; ++i)
+        {
+            auto *node = new (allocator.allocate(sizeof(list_node))) list_node { i, head };
+            head = node;
+        }
+        allocator.set_root(head);
+
+        blocks_state = allocator.get_blocks_info();
+    }
+
+    allocator_persistent allocator(path, 0);
+
+    ASSERT_EQ(allocator.get_blocks_info(), blocks_state);
+
+    auto *head = reinterpret_cast<list_node *>(allocator.get_root());
+    ASSERT_NE(head, nullptr);
+
+    int expected = 99;
+    for (list_node *node = head; node != nullptr; node = node->next)
+    {
+        ASSERT_EQ(node->value, expected--);
+    }
+    ASSERT_EQ(expected, -1);
+
+    while (head != nullptr)
+    {
+        list_node *next = head->next;
+        allocator.deallocate(head, sizeof(list_node));
+        head = next;
+    }
+
+    ASSERT_EQ(allocator.get_root(), nullptr);
+
+    auto actual_blocks_state = allocator.get_blocks_info();
+    ASSERT_EQ(actual_blocks_state.size(), 1);
+    ASSERT_EQ(actual_blocks_state[0].is_block_occupied, false);
+    ASSERT_GE(actual_blocks_state[0].block_size, 100'000);
+
+    std::filesystem::remove(path);
+}
+
+TEST(allocatorPersistentPositiveTests, test2)
+{
+    auto path = heap_path("allocator_persistent_tests_2.heap");
+    allocator_persistent allocator(path, 10'000, nullptr, allocator_with_fit_mode::fit_mode::the_best_fit);
+
+    void *first_block = allocator.allocate(1000);
+    void *second_block = allocator.allocate(100);
+    void *third_block = allocator.allocate(300);
+    void *fourth_block = allocator.allocate(100);
+
+    allocator.deallocate(first_block, 1);
+    allocator.deallocate(third_block, 1);
+
+    // лучшая дыра - на месте третьего блока
+    void *best_block = allocator.allocate(200);
+    ASSERT_EQ(best_block, third_block);
+
+    void *aligned_block = allocator.allocate(50, 256);
+    ASSERT_EQ(reinterpret_cast<std::uintptr_t>(aligned_block) % 256, 0);
+
+    ASSERT_THROW(allocator.deallocate(reinterpret_cast<unsigned char *>(second_block) + 8, 1), std::logic_error);
+    ASSERT_THROW(static_cast<void>(allocator.allocate(allocator.get_size())), std::bad_alloc);
+
+    for (void *block : { second_block, best_block, fourth_block, aligned_block })
+    {
+        allocator.deallocate(block, 1);
+    }
+
+    ASSERT_THROW(allocator.deallocate(second_block, 1), std::logic_error);
+    ASSERT_EQ(allocator.get_blocks_info().size(), 1);
+
+    std::filesystem::remove(path);
+}
+
+TEST(allocatorPersistentPositiveTests, test3)
+{
+    auto path = heap_path("allocator_persistent_tests_3.heap");
+    std::vector<void *> blocks;
+
+    {
+        allocator_persistent allocator(path, 4'000'000);
+
+        for (size_t i = 0; i < 20'000; ++i)
+        {
+            size_t alignment = i % 7 == 0 ? 64 : 8;
+            blocks.push_back(allocator.allocate(16 + i % 100, alignment));
+            ASSERT_EQ(reinterpret_cast<std::uintptr_t>(blocks.back()) % alignment, 0);
+        }
+
+        // дыры через одну, затем их повторное заполнение блоками меньше освобожденных
+        for (size_t i = 0; i < blocks.size(); i += 2)
+        {
+            allocator.deallocate(blocks[i], 1);
+        }
+        for (size_t i = 0; i < blocks.size(); i += 2)
+        {
+            blocks[i] = allocator.allocate(8 + i % 50);
+        }
+
+        allocator.set_root(blocks[0]);
+        auto *root = reinterpret_cast<unsigned char *>(blocks[0]);
+        for (auto &block : blocks)
+        {
+            block = reinterpret_cast<void *>(reinterpret_cast<unsigned char *>(block) - root);
+        }
+    }
+
+    // индекс дыр строится заново при открытии; файл может отобразиться по другому адресу
+    allocator_persistent allocator(path, 0);
+
+    for (auto &block : blocks)
+    {
+        block = reinterpret_cast<unsigned char *>(allocator.get_root()) + reinterpret_cast<std::uintptr_t>(block);
+    }
+
+    for (size_t i = 1; i < blocks.size(); i += 2)
+    {
+        allocator.deallocate(blocks[i], 1);
+    }
+    void *big_block = allocator.allocate(1'000'000);
+
+    allocator.deallocate(big_block, 1);
+    for (size_t i = 0; i < blocks.size(); i += 2)
+    {
+        allocator.deallocate(blocks[i], 1);
+    }
+
+    auto actual_blocks_state = allocator.get_blocks_info();
+    ASSERT_EQ(actual_blocks_state.size(), 1);
+    ASSERT_EQ(actual_blocks_state[0].is_block_occupied, false);
+
+    std::filesystem::remove(path);
+}
+
+TEST(allocatorPersistentNegativeTests, test1)
+{
+    auto path = heap_path("allocator_persistent_tests_negative_1.heap");
+    std::ofstream(path) << "not a heap";
+
+    ASSERT_THROW(allocator_persistent allocator(path, 10'000), std::runtime_error);
+
+    std::filesystem::remove(path);
+}
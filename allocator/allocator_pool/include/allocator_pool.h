@@ -0,0 +1,141 @@
+#ifndef MATH_PRACTICE_AND_OPERATING_SYSTEMS_ALLOCATOR_ALLOCATOR_POOL_H
+#define MATH_PRACTICE_AND_OPERATING_SYSTEMS_ALLOCATOR_ALLOCATOR_POOL_H
+
+#include <pp_allocator.h>
+#include <allocator_logger_guardant.h>
+#include <typename_holder.h>
+#include <cstddef>
+
+/**
+ * Pool of blocks of one fixed size, meant for node based containers. Blocks are cut from slabs taken
+ * from the parent allocator (the global heap if there is none); freed blocks go to an intrusive free list
+ * and are reused first, so both operations are O(1) and blocks carry no metadata.
+ * The first slab holds only a few blocks and every next one twice as many, up to blocks_per_slab,
+ * so a small container does not reserve a whole slab.
+ * Requests bigger than the block or aligned stricter than it are rejected. There is no locking,
+ * a pool belongs to one container.
+ */
+class allocator_pool final:
+    public smart_mem_resource,
+    private allocator_logger_guardant,
+    private typename_holder
+{
+
+private:
+
+    // заголовок слэба: следующий слэб в списке всех слэбов и число блоков в нём
+    struct slab_header
+    {
+        slab_header *next;
+        size_t blocks;
+    };
+
+    static constexpr const size_t initial_blocks_per_slab = 4;
+
+    // свободный блок хранит ссылку на следующий свободный блок
+    struct free_block
+    {
+        free_block *next;
+    };
+
+    std::pmr::memory_resource *_parent_allocator;
+
+    logger *_logger;
+
+    size_t _block_size;
+
+    size_t _block_alignment;
+
+    size_t _blocks_per_slab;
+
+    // размер следующего слэба в блоках, растёт вдвое до _blocks_per_slab
+    size_t _next_slab_blocks;
+
+    // смещение первого блока от начала слэба
+    size_t _slab_header_size;
+
+    slab_header *_slabs;
+
+    free_block *_free_blocks;
+
+    // ещё не выданная часть последнего слэба
+    unsigned char *_untouched_begin;
+
+    unsigned char *_untouched_end;
+
+public:
+
+    explicit allocator_pool(
+        size_t block_size,
+        size_t block_alignment = alignof(std::max_align_t),
+        size_t blocks_per_slab = 64,
+        std::pmr::memory_resource *parent_allocator = nullptr,
+        logger *logger = nullptr);
+
+    allocator_pool(
+        allocator_pool const &other) = delete;
+
+    allocator_pool &operator=(
+        allocator_pool const &other) = delete;
+
+    allocator_pool(
+        allocator_pool &&other) noexcept;
+
+    allocator_pool &operator=(
+        allocator_pool &&other) noexcept;
+
+    ~allocator_pool() override;
+
+public:
+
+    [[nodiscard]] void *do_allocate_sm(
+        size_t size) override;
+
+    [[nodiscard]] void *do_allocate_aligned_sm(
+        size_t size,
+        size_t alignment) override;
+
+    void do_deallocate_sm(
+        void *at) override;
+
+    void do_allocate_batch_sm(
+        size_t size,
+        size_t count,
+        void **out,
+        size_t alignment) override;
+
+    void do_deallocate_batch_sm(
+        void *const *blocks,
+        size_t count) override;
+
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override;
+
+public:
+
+    size_t get_block_size() const noexcept;
+
+    /**
+     * Pool for objects of type T, e.g. the nodes of a container
+     */
+    template<typename T>
+    static allocator_pool for_objects_of(
+        std::pmr::memory_resource *parent_allocator = nullptr,
+        size_t blocks_per_slab = 64,
+        logger *logger = nullptr)
+    {
+        return allocator_pool(sizeof(T), alignof(T), blocks_per_slab, parent_allocator, logger);
+    }
+
+private:
+
+    void take_slab();
+
+    void release();
+
+    inline logger *get_logger() const override;
+
+    inline std::string get_typename() const override;
+
+};
+
+#endif //MATH_PRACTICE_AND_OPERATING_SYSTEMS_ALLOCATOR_ALLOCATOR_POOL_H
@@ -0,0 +1,265 @@
+#include "../include/allocator_pool.h"
+#include <algorithm>
+#include <bit>
+#include <limits>
+#include <utility>
+
+using byte = unsigned char;
+
+allocator_pool::allocator_pool(
+    size_t block_size,
+    size_t block_alignment,
+    size_t blocks_per_slab,
+    std::pmr::memory_resource *parent_allocator,
+    logger *logger):
+        _parent_allocator(parent_allocator == nullptr ? std::pmr::get_default_resource() : parent_allocator),
+        _logger(logger),
+        _block_size(0),
+        _block_alignment(std::max(block_alignment, alignof(free_block))),
+        _blocks_per_slab(blocks_per_slab == 0 ? 1 : blocks_per_slab),
+        _next_slab_blocks(std::min(_blocks_per_slab, initial_blocks_per_slab)),
+        _slab_header_size(0),
+        _slabs(nullptr),
+        _free_blocks(nullptr),
+        _untouched_begin(nullptr),
+        _untouched_end(nullptr)
+{
+    if (!std::has_single_bit(_block_alignment))
+    {
+        error_with_guard("Block alignment is not a power of two");
+        throw std::logic_error("allocator_pool block alignment must be a power of two");
+    }
+
+    if (block_size > std::numeric_limits<size_t>::max() / 2 / _blocks_per_slab)
+    {
+        error_with_guard("Block size is too big");
+        throw std::logic_error("allocator_pool block size is too big");
+    }
+
+    // блоки идут подряд, поэтому размер блока кратен его выравниванию
+    _block_size = (std::max(block_size, sizeof(free_block)) + _block_alignment - 1) & ~(_block_alignment - 1);
+    _slab_header_size = (sizeof(slab_header) + _block_alignment - 1) & ~(_block_alignment - 1);
+
+    debug_with_guard("allocator_pool created");
+}
+
+allocator_pool::allocator_pool(
+    allocator_pool &&other) noexcept:
+        _parent_allocator(other._parent_allocator),
+        _logger(other._logger),
+        _block_size(other._block_size),
+        _block_alignment(other._block_alignment),
+        _blocks_per_slab(other._blocks_per_slab),
+        _next_slab_blocks(std::exchange(other._next_slab_blocks, std::min(other._blocks_per_slab, initial_blocks_per_slab))),
+        _slab_header_size(other._slab_header_size),
+        _slabs(std::exchange(other._slabs, nullptr)),
+        _free_blocks(std::exchange(other._free_blocks, nullptr)),
+        _untouched_begin(std::exchange(other._untouched_begin, nullptr)),
+        _untouched_end(std::exchange(other._untouched_end, nullptr))
+{
+}
+
+allocator_pool &allocator_pool::operator=(
+    allocator_pool &&other) noexcept
+{
+    if (this != &other)
+    {
+        release();
+
+        _parent_allocator = other._parent_allocator;
+        _logger = other._logger;
+        _block_size = other._block_size;
+        _block_alignment = other._block_alignment;
+        _blocks_per_slab = other._blocks_per_slab;
+        _next_slab_blocks = std::exchange(other._next_slab_blocks, std::min(other._blocks_per_slab, initial_blocks_per_slab));
+        _slab_header_size = other._slab_header_size;
+        _slabs = std::exchange(other._slabs, nullptr);
+        _free_blocks = std::exchange(other._free_blocks, nullptr);
+        _untouched_begin = std::exchange(other._untouched_begin, nullptr);
+        _untouched_end = std::exchange(other._untouched_end, nullptr);
+    }
+
+    return *this;
+}
+
+allocator_pool::~allocator_pool()
+{
+    release();
+}
+
+[[nodiscard]] void *allocator_pool::do_allocate_sm(
+    size_t size)
+{
+    return do_allocate_aligned_sm(size, 1);
+}
+
+[[nodiscard]] void *allocator_pool::do_allocate_aligned_sm(
+    size_t size,
+    size_t alignment)
+{
+    if (size > _block_size || alignment > _block_alignment)
+    {
+        error_with_guard("Requested block does not fit allocator_pool block");
+        throw std::bad_alloc();
+    }
+
+    if (_free_blocks != nullptr)
+    {
+        return std::exchange(_free_blocks, _free_blocks->next);
+    }
+
+    if (_untouched_begin == _untouched_end)
+    {
+        take_slab();
+    }
+
+    return std::exchange(_untouched_begin, _untouched_begin + _block_size);
+}
+
+void allocator_pool::do_deallocate_sm(
+    void *at)
+{
+    if (at == nullptr)
+    {
+        return;
+    }
+
+    _free_blocks = new (at) free_block { _free_blocks };
+}
+
+void allocator_pool::do_allocate_batch_sm(
+    size_t size,
+    size_t count,
+    void **out,
+    size_t alignment)
+{
+    if (size > _block_size || alignment > _block_alignment)
+    {
+        error_with_guard("Requested block does not fit allocator_pool block");
+        throw std::bad_alloc();
+    }
+
+    size_t allocated = 0;
+    for (; allocated < count && _free_blocks != nullptr; ++allocated)
+    {
+        out[allocated] = std::exchange(_free_blocks, _free_blocks->next);
+    }
+
+    try
+    {
+        while (allocated < count)
+        {
+            if (_untouched_begin == _untouched_end)
+            {
+                take_slab();
+            }
+
+            // из нетронутой части слэба блоки нарезаются подряд
+            size_t taken = std::min(count - allocated, static_cast<size_t>(_untouched_end - _untouched_begin) / _block_size);
+            for (size_t i = 0; i < taken; ++i, ++allocated)
+            {
+                out[allocated] = std::exchange(_untouched_begin, _untouched_begin + _block_size);
+            }
+        }
+    }
+    catch (...)
+    {
+        do_deallocate_batch_sm(out, allocated);
+        throw;
+    }
+}
+
+void allocator_pool::do_deallocate_batch_sm(
+    void *const *blocks,
+    size_t count)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        do_deallocate_sm(blocks[i]);
+    }
+}
+
+bool allocator_pool::do_is_equal(const std::pmr::memory_resource &other) const noexcept
+{
+    return this == &other;
+}
+
+size_t allocator_pool::get_block_size() const noexcept
+{
+    return _block_size;
+}
+
+void allocator_pool::take_slab()
+{
+    void *memory;
+
+    try
+    {
+        memory = _parent_allocator->allocate(_slab_header_size + _block_size * _next_slab_blocks, _block_alignment);
+    }
+    catch (std::bad_alloc const &)
+    {
+        error_with_guard("allocator_pool can not get new slab");
+        throw;
+    }
+
+    _slabs = new (memory) slab_header { _slabs, _next_slab_blocks };
+
+    _untouched_begin = reinterpret_cast<byte *>(memory) + _slab_header_size;
+    _untouched_end = _untouched_begin + _block_size * _next_slab_blocks;
+
+    _next_slab_blocks = std::min(_next_slab_blocks * 2, _blocks_per_slab);
+
+    trace_with_guard("allocator_pool took new slab");
+}
+
+void allocator_pool::release()
+{
+    // родитель, умеющий освобождать пакетами, получает слэбы пачками под одной своей блокировкой;
+    // пакет не передает размер и выравнивание, поэтому слэбы со строгим выравниванием освобождаются по одному,
+    // как в pp_allocator::deallocate_bytes_batch
+    auto *smart_parent = _block_alignment <= alignof(std::max_align_t)
+        ? dynamic_cast<smart_mem_resource *>(_parent_allocator)
+        : nullptr;
+    constexpr size_t batch_capacity = 64;
+    void *batch[batch_capacity];
+    size_t batch_size = 0;
+
+    while (_slabs != nullptr)
+    {
+        auto *next = _slabs->next;
+        if (smart_parent == nullptr)
+        {
+            _parent_allocator->deallocate(_slabs, _slab_header_size + _block_size * _slabs->blocks, _block_alignment);
+        }
+        else
+        {
+            batch[batch_size++] = _slabs;
+            if (batch_size == batch_capacity)
+            {
+                smart_parent->deallocate_batch(batch, batch_size);
+                batch_size = 0;
+            }
+        }
+        _slabs = next;
+    }
+
+    if (batch_size != 0)
+    {
+        smart_parent->deallocate_batch(batch, batch_size);
+    }
+
+    _free_blocks = nullptr;
+    _untouched_begin = _untouched_end = nullptr;
+    _next_slab_blocks = std::min(_blocks_per_slab, initial_blocks_per_slab);
+}
+
+inline logger *allocator_pool::get_logger() const
+{
+    return _logger;
+}
+
+inline std::string allocator_pool::get_typename() const
+{
+    return "allocator_pool";
+}
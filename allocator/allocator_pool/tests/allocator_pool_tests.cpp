@@ -0,0 +1,141 @@
+#include <gtest/gtest.h>
+#include <allocator_pool.h>
+#include <allocator_boundary_tags.h>
+#include <allocator_buddies_system.h>
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace
+{
+    struct tree_node
+    {
+        int key;
+        tree_node *left;
+        tree_node *right;
+
+        explicit tree_node(int key) : key(key), left(nullptr), right(nullptr)
+        {
+        }
+    };
+}
+
+TEST(allocatorPoolPositiveTests, test1)
+{
+    allocator_pool pool(20, 8, 4);
+
+    ASSERT_EQ(pool.get_block_size(), 24);
+
+    auto *first_block = pool.allocate(20, 8);
+    auto *second_block = pool.allocate(10, 4);
+
+    ASSERT_EQ(reinterpret_cast<unsigned char *>(second_block) - reinterpret_cast<unsigned char *>(first_block), 24);
+
+    pool.deallocate(first_block, 20, 8);
+
+    // освобождённый блок выдаётся первым
+    ASSERT_EQ(pool.allocate(20, 8), first_block);
+
+    ASSERT_THROW(static_cast<void>(pool.allocate(25, 8)), std::bad_alloc);
+    ASSERT_THROW(static_cast<void>(pool.allocate(8, 64)), std::bad_alloc);
+}
+
+TEST(allocatorPoolPositiveTests, test2)
+{
+    allocator_boundary_tags parent(100'000, nullptr, nullptr, allocator_with_fit_mode::fit_mode::first_fit);
+
+    {
+        allocator_pool pool(48, 64, 16, &parent);
+
+        std::vector<void *> blocks;
+        for (int i = 0; i < 100; ++i)
+        {
+            blocks.push_back(pool.allocate(48, 64));
+            ASSERT_EQ(reinterpret_cast<std::uintptr_t>(blocks.back()) % 64, 0);
+        }
+
+        for (size_t i = 0; i < blocks.size(); i += 2)
+        {
+            pool.deallocate(blocks[i], 48, 64);
+        }
+
+        for (size_t i = 0; i < blocks.size(); i += 2)
+        {
+            blocks[i] = pool.allocate(48, 64);
+        }
+
+        std::sort(blocks.begin(), blocks.end());
+        ASSERT_EQ(std::adjacent_find(blocks.begin(), blocks.end()), blocks.end());
+    }
+
+    // все слэбы вернулись родителю
+    auto actual_blocks_state = parent.get_blocks_info();
+
+    ASSERT_EQ(actual_blocks_state.size(), 1);
+    ASSERT_EQ(actual_blocks_state[0].is_block_occupied, false);
+}
+
+TEST(allocatorPoolPositiveTests, test3)
+{
+    auto pool = allocator_pool::for_objects_of<tree_node>();
+    pp_allocator<tree_node> alloc(&pool);
+
+    auto *root = alloc.new_object<tree_node>(10);
+    root->left = alloc.new_object<tree_node>(5);
+    root->right = alloc.new_object<tree_node>(15);
+
+    ASSERT_EQ(root->left->key, 5);
+    ASSERT_EQ(root->right->key, 15);
+
+    alloc.delete_object(root->left);
+    alloc.delete_object(root->right);
+    alloc.delete_object(root);
+
+    allocator_pool moved(std::move(pool));
+    pp_allocator<tree_node> moved_alloc(&moved);
+
+    auto *node = moved_alloc.new_object<tree_node>(1);
+    ASSERT_EQ(node->key, 1);
+    moved_alloc.delete_object(node);
+}
+
+TEST(allocatorPoolPositiveTests, test4)
+{
+    allocator_boundary_tags parent(100'000, nullptr, nullptr, allocator_with_fit_mode::fit_mode::first_fit);
+    allocator_pool pool(64, 64, 64, &parent);
+
+    void *block = pool.allocate(64, 64);
+
+    // первый слэб берёт только несколько блоков, а не все 64
+    auto actual_blocks_state = parent.get_blocks_info();
+    auto slab = std::find_if(actual_blocks_state.begin(), actual_blocks_state.end(),
+                             [](auto const &info) { return info.is_block_occupied; });
+
+    ASSERT_NE(slab, actual_blocks_state.end());
+    ASSERT_LT(slab->block_size, 16 * 64);
+
+    pool.deallocate(block, 64, 64);
+}
+
+TEST(allocatorPoolPositiveTests, test5)
+{
+    // родитель проверяет размер и выравнивание при освобождении, поэтому слэбы со строгим выравниванием
+    // нельзя отдавать ему пакетом
+    allocator_buddies_system parent(16, nullptr, nullptr, allocator_with_fit_mode::fit_mode::first_fit, true);
+
+    {
+        allocator_pool pool(24, 64, 8, &parent);
+
+        std::vector<void *> blocks;
+        for (int i = 0; i < 50; ++i)
+        {
+            blocks.push_back(pool.allocate(24, 64));
+            ASSERT_EQ(reinterpret_cast<std::uintptr_t>(blocks.back()) % 64, 0);
+        }
+    }
+
+    auto actual_blocks_state = parent.get_blocks_info();
+
+    ASSERT_EQ(actual_blocks_state.size(), 1);
+    ASSERT_EQ(actual_blocks_state[0].is_block_occupied, false);
+}
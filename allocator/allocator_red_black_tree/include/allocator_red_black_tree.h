@@ -3,16 +3,19 @@
 
 #include <pp_allocator.h>
 #include <allocator_test_utils.h>
+#include <allocator_statistics.h>
 #include <allocator_with_fit_mode.h>
-#include <logger_guardant.h>
+#include <allocator_logger_guardant.h>
+#include <remote_free_queue.h>
 #include <typename_holder.h>
 #include <mutex>
 
 class allocator_red_black_tree final:
     public smart_mem_resource,
     public allocator_test_utils,
+    public allocator_statistics,
     public allocator_with_fit_mode,
-    private logger_guardant,
+    private allocator_logger_guardant,
     private typename_holder
 {
 
@@ -29,10 +32,27 @@ private:
 
     void *_trusted_memory;
 
-    static constexpr const size_t allocator_metadata_size = sizeof(logger*) + sizeof(allocator_dbg_helper*) + sizeof(fit_mode) + sizeof(size_t) + sizeof(std::mutex) + sizeof(void*);
-    static constexpr const size_t occupied_block_metadata_size = sizeof(block_data) + 3 * sizeof(void*);
+    // структура меты: логгер, родительский аллокатор, фит мод, размер пространства, мьютекс, корень дерева свободных блоков,
+    // очередь освобождений из других потоков (выровнена), счетчики статистики (выровнены)
+
+    // структура меты занятого блока: block_data, указатель на предыдущий и следующий блок, указатель на аллокатор;
+    // мета дополнена до кратной max_align_t, чтобы данные блока с выровненным началом были выровнены
+
+    // структура меты свободного блока: block_data, указатель на предыдущий и следующий блок, родитель, левый и правый
+    // потомок в дереве; дерево упорядочено по размеру блока, при равных размерах по адресу
+
+    static constexpr const size_t remote_frees_offset = (sizeof(logger*) + sizeof(allocator_dbg_helper*) + sizeof(fit_mode) + sizeof(size_t) + sizeof(std::mutex) + sizeof(void*) +
+                                                         alignof(remote_free_queue) - 1) & ~(alignof(remote_free_queue) - 1);
+
+    static constexpr const size_t counters_offset = (remote_frees_offset + sizeof(remote_free_queue) +
+                                                     alignof(allocator_statistics::counters) - 1) & ~(alignof(allocator_statistics::counters) - 1);
+    static constexpr const size_t allocator_metadata_size = counters_offset + sizeof(allocator_statistics::counters);
+    static constexpr const size_t occupied_block_metadata_size = (sizeof(block_data) + 3 * sizeof(void*) +
+                                                                  alignof(std::max_align_t) - 1) & ~(alignof(std::max_align_t) - 1);
     static constexpr const size_t free_block_metadata_size = sizeof(block_data) + 5 * sizeof(void*);
 
+    static_assert(allocator_metadata_size % alignof(std::max_align_t) == 0, "the first block must start aligned");
+
 public:
     
     ~allocator_red_black_tree() override;
@@ -61,7 +81,16 @@ public:
     
     [[nodiscard]] void *do_allocate_sm(
         size_t size) override;
+
+    [[nodiscard]] void *do_allocate_aligned_sm(
+        size_t size,
+        size_t alignment) override;
     
+    /**
+     * When another thread holds the lock, the block is checked to be this allocator's one and put
+     * into the remote free queue instead of waiting; the next thread to take the lock frees it.
+     * Until then the block is still counted and listed as occupied.
+     */
     void do_deallocate_sm(
         void *at) override;
 
@@ -73,12 +102,80 @@ public:
 
     inline logger *get_logger() const override;
 
+    statistics_snapshot get_statistics() const noexcept override;
+
 private:
 
     std::vector<allocator_test_utils::block_info> get_blocks_info_inner() const override;
 
     inline std::string get_typename() const noexcept override;
 
+    inline std::mutex *get_mutex() const noexcept;
+
+    inline allocator_statistics::counters &get_counters() const noexcept;
+
+    inline remote_free_queue &get_remote_frees() const noexcept;
+
+    // frees a block under the lock taken by the caller
+    void deallocate_block(void *at);
+
+    // frees the blocks other threads queued, under the lock taken by the caller
+    void drain_remote_frees();
+
+    std::unique_lock<std::mutex> lock_and_drain();
+
+    // queues a block of this allocator without the lock, the link replaces the allocator pointer in its meta
+    bool defer_deallocation(void *at);
+
+    size_t get_largest_free_block_size() const noexcept;
+
+    inline allocator_with_fit_mode::fit_mode get_fit_mode() const noexcept;
+
+    inline size_t get_space_size() const noexcept;
+
+    inline void *get_first_block() const noexcept;
+
+    inline void *&get_root() const noexcept;
+
+    static inline block_data &get_block_data(void *block) noexcept;
+
+    static inline void *&get_prev_block(void *block) noexcept;
+
+    static inline void *&get_next_block(void *block) noexcept;
+
+    // для занятого блока здесь лежит указатель на аллокатор, для свободного - родитель в дереве
+    static inline void *&get_block_trusted(void *block) noexcept;
+
+    static inline void *&get_parent(void *block) noexcept;
+
+    static inline void *&get_left(void *block) noexcept;
+
+    static inline void *&get_right(void *block) noexcept;
+
+    static inline bool is_red(void *block) noexcept;
+
+    inline size_t get_block_size(void *block) const noexcept;
+
+    inline bool is_less(void *left, size_t left_size, void *right) const noexcept;
+
+    void rotate_left(void *block) noexcept;
+
+    void rotate_right(void *block) noexcept;
+
+    void transplant(void *replaced, void *replacement) noexcept;
+
+    void insert_free_block(void *block) noexcept;
+
+    void remove_free_block(void *block) noexcept;
+
+    void remove_fixup(void *block, void *parent) noexcept;
+
+    void *find_free_block(size_t size, allocator_with_fit_mode::fit_mode mode) const noexcept;
+
+    void *allocate_from_free_block(void *block, size_t size, size_t alignment) noexcept;
+
+    size_t get_free_size_inner() const noexcept;
+
     class rb_iterator
     {
         void* _block_ptr;
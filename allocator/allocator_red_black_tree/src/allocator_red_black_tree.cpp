@@ -1,140 +1,971 @@
-#include <not_implemented.h>
-
 #include "../include/allocator_red_black_tree.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+using byte = unsigned char;
 
 allocator_red_black_tree::~allocator_red_black_tree()
 {
-    throw not_implemented("allocator_red_black_tree::~allocator_red_black_tree()", "your code should be here...");
+    if (_trusted_memory == nullptr)
+    {
+        return;
+    }
+
+    debug_with_guard("Called allocator destructor");
+
+    auto *parent_allocator = *reinterpret_cast<std::pmr::memory_resource **>(reinterpret_cast<byte *>(_trusted_memory) + sizeof(logger *));
+    size_t memory_size = get_space_size() + allocator_metadata_size;
+
+    get_mutex()->~mutex();
+
+    if (parent_allocator == nullptr)
+    {
+        ::operator delete(_trusted_memory);
+    }
+    else
+    {
+        parent_allocator->deallocate(_trusted_memory, memory_size);
+    }
 }
 
 allocator_red_black_tree::allocator_red_black_tree(
     allocator_red_black_tree &&other) noexcept
 {
-    throw not_implemented("allocator_red_black_tree::allocator_red_black_tree(allocator_red_black_tree &&) noexcept", "your code should be here...");
+    _trusted_memory = other._trusted_memory;
+    other._trusted_memory = nullptr;
 }
 
 allocator_red_black_tree &allocator_red_black_tree::operator=(
     allocator_red_black_tree &&other) noexcept
 {
-    throw not_implemented("allocator_red_black_tree &allocator_red_black_tree::operator=(allocator_red_black_tree &&) noexcept", "your code should be here...");
+    if (this != &other)
+    {
+        std::swap(_trusted_memory, other._trusted_memory);
+    }
+
+    return *this;
 }
 
+/** If parent_allocator* == nullptr the global heap is used
+ */
 allocator_red_black_tree::allocator_red_black_tree(
         size_t space_size,
         std::pmr::memory_resource *parent_allocator,
         logger *logger,
         allocator_with_fit_mode::fit_mode allocate_fit_mode)
 {
-    throw not_implemented("allocator_red_black_tree::allocator_red_black_tree(size_t ,std::pmr::memory_resource *,logger *,allocator_with_fit_mode::fit_mode)", "your code should be here...");
+    if (space_size < free_block_metadata_size)
+    {
+        throw std::logic_error("space_size must be at least " + std::to_string(free_block_metadata_size));
+    }
+
+    size_t memory_size = space_size + allocator_metadata_size;
+
+    _trusted_memory = parent_allocator == nullptr
+            ? ::operator new(memory_size)
+            : parent_allocator->allocate(memory_size, alignof(std::max_align_t));
+
+    byte *ptr = reinterpret_cast<byte *>(_trusted_memory);
+
+    *reinterpret_cast<class logger **>(ptr) = logger;
+    ptr += sizeof(class logger *);
+
+    *reinterpret_cast<std::pmr::memory_resource **>(ptr) = parent_allocator;
+    ptr += sizeof(std::pmr::memory_resource *);
+
+    *reinterpret_cast<allocator_with_fit_mode::fit_mode *>(ptr) = allocate_fit_mode;
+    ptr += sizeof(allocator_with_fit_mode::fit_mode);
+
+    *reinterpret_cast<size_t *>(ptr) = space_size;
+    ptr += sizeof(size_t);
+
+    new (ptr) std::mutex;
+    ptr += sizeof(std::mutex);
+
+    *reinterpret_cast<void **>(ptr) = nullptr;
+
+    new (reinterpret_cast<byte *>(_trusted_memory) + remote_frees_offset) remote_free_queue;
+
+    new (reinterpret_cast<byte *>(_trusted_memory) + counters_offset) allocator_statistics::counters(space_size);
+
+    void *block = get_first_block();
+    get_prev_block(block) = nullptr;
+    get_next_block(block) = nullptr;
+    insert_free_block(block);
+
+    debug_with_guard("allocator_red_black_tree created");
 }
 
+/** Pointers inside the copied memory still point to the other allocator, so all of them are moved by the same distance
+ */
 allocator_red_black_tree::allocator_red_black_tree(const allocator_red_black_tree &other)
 {
-    throw not_implemented("allocator_red_black_tree::allocator_red_black_tree(const allocator_red_black_tree &other)", "your code should be here...");
+    if (other._trusted_memory == nullptr)
+    {
+        _trusted_memory = nullptr;
+        return;
+    }
+
+    // отложенные освобождения другого аллокатора доводятся до конца, чтобы копия их не унаследовала
+    auto lock = const_cast<allocator_red_black_tree &>(other).lock_and_drain();
+
+    auto *parent_allocator = *reinterpret_cast<std::pmr::memory_resource **>(reinterpret_cast<byte *>(other._trusted_memory) + sizeof(logger *));
+    size_t memory_size = other.get_space_size() + allocator_metadata_size;
+
+    _trusted_memory = parent_allocator == nullptr
+            ? ::operator new(memory_size)
+            : parent_allocator->allocate(memory_size, alignof(std::max_align_t));
+
+    std::memcpy(_trusted_memory, other._trusted_memory, memory_size);
+    new (get_mutex()) std::mutex;
+    new (&get_remote_frees()) remote_free_queue;
+
+    auto rebase = [this, &other](void *&ptr)
+    {
+        if (ptr != nullptr)
+        {
+            ptr = reinterpret_cast<byte *>(_trusted_memory) + (reinterpret_cast<byte *>(ptr) - reinterpret_cast<byte *>(other._trusted_memory));
+        }
+    };
+
+    rebase(get_root());
+
+    for (void *block = get_first_block(); block != nullptr; block = get_next_block(block))
+    {
+        rebase(get_prev_block(block));
+        rebase(get_next_block(block));
+
+        if (get_block_data(block).occupied)
+        {
+            get_block_trusted(block) = _trusted_memory;
+        }
+        else
+        {
+            rebase(get_parent(block));
+            rebase(get_left(block));
+            rebase(get_right(block));
+        }
+    }
 }
 
 allocator_red_black_tree &allocator_red_black_tree::operator=(const allocator_red_black_tree &other)
 {
-    throw not_implemented("allocator_red_black_tree &allocator_red_black_tree::operator=(const allocator_red_black_tree &other)", "your code should be here...");
+    if (this != &other)
+    {
+        allocator_red_black_tree copy(other);
+        *this = std::move(copy);
+    }
+
+    return *this;
 }
 
 bool allocator_red_black_tree::do_is_equal(const std::pmr::memory_resource &other) const noexcept
 {
-    throw not_implemented("bool allocator_red_black_tree::do_is_equal(const std::pmr::memory_resource &other) const noexcept", "your code should be here...");
+    return this == &other;
 }
 
 [[nodiscard]] void *allocator_red_black_tree::do_allocate_sm(
     size_t size)
 {
-    throw not_implemented("[[nodiscard]] void *allocator_red_black_tree::do_allocate_sm(size_t)", "your code should be here...");
+    return do_allocate_aligned_sm(size, 1);
 }
 
+/** For alignment the search asks for alignment - 1 more bytes plus room for a free block in front,
+ * so the padding before the aligned block can always stay a free block of its own.
+ */
+[[nodiscard]] void *allocator_red_black_tree::do_allocate_aligned_sm(
+    size_t size,
+    size_t alignment)
+{
+    debug_with_guard("do_allocate_sm start");
+
+    auto lock = lock_and_drain();
+
+    void *memory = nullptr;
+
+    if (size <= std::numeric_limits<size_t>::max() - occupied_block_metadata_size - free_block_metadata_size - alignment)
+    {
+        size_t needed = std::max(size + occupied_block_metadata_size, free_block_metadata_size);
+        if (alignment > 1)
+        {
+            needed += alignment - 1 + free_block_metadata_size;
+        }
+
+        void *block = find_free_block(needed, get_fit_mode());
+        if (block != nullptr)
+        {
+            memory = allocate_from_free_block(block, size, alignment);
+        }
+    }
+
+    if (memory == nullptr)
+    {
+        if (is_enabled_with_guard(logger::severity::error))
+        {
+            error_with_guard("Allocation failed for size " + std::to_string(size));
+        }
+        get_counters().on_failed_allocation();
+        throw std::bad_alloc();
+    }
 
+    get_counters().on_allocate(get_block_size(reinterpret_cast<byte *>(memory) - occupied_block_metadata_size));
+    get_counters().set_largest_free_block(get_largest_free_block_size());
+
+    if (is_enabled_with_guard(logger::severity::information))
+    {
+        information_with_guard("Available free memory after allocation: " + std::to_string(get_free_size_inner()));
+    }
+
+    debug_with_guard("do_allocate_sm finish");
+
+    return memory;
+}
+
+/** Free neighbours are taken out of the tree and merged with the freed block, so two free blocks are never adjacent
+ */
 void allocator_red_black_tree::do_deallocate_sm(
     void *at)
 {
-    throw not_implemented("void allocator_red_black_tree::do_deallocate_sm(void *)", "your code should be here...");
+    debug_with_guard("do_deallocate_sm start");
+
+    auto lock = get_counters().try_lock(*get_mutex());
+    if (!lock.owns_lock())
+    {
+        if (defer_deallocation(at))
+        {
+            debug_with_guard("do_deallocate_sm deferred");
+            return;
+        }
+        lock = get_counters().lock(*get_mutex());
+    }
+
+    drain_remote_frees();
+    deallocate_block(at);
+
+    debug_with_guard("do_deallocate_sm finish");
+}
+
+void allocator_red_black_tree::deallocate_block(
+    void *at)
+{
+    if (at == nullptr)
+    {
+        return;
+    }
+
+    void *block = reinterpret_cast<byte *>(at) - occupied_block_metadata_size;
+
+    if (get_block_trusted(block) != _trusted_memory || !get_block_data(block).occupied)
+    {
+        error_with_guard("Tried to deallocate not allocator's property");
+        throw std::logic_error("Not allocator's property");
+    }
+
+    get_block_data(block).occupied = false;
+    get_counters().on_deallocate(get_block_size(block));
+
+    void *next = get_next_block(block);
+    if (next != nullptr && !get_block_data(next).occupied)
+    {
+        remove_free_block(next);
+
+        get_next_block(block) = get_next_block(next);
+        if (get_next_block(block) != nullptr)
+        {
+            get_prev_block(get_next_block(block)) = block;
+        }
+    }
+
+    void *prev = get_prev_block(block);
+    if (prev != nullptr && !get_block_data(prev).occupied)
+    {
+        remove_free_block(prev);
+
+        get_next_block(prev) = get_next_block(block);
+        if (get_next_block(block) != nullptr)
+        {
+            get_prev_block(get_next_block(block)) = prev;
+        }
+
+        block = prev;
+    }
+
+    insert_free_block(block);
+    get_counters().set_largest_free_block(get_largest_free_block_size());
+
+    if (is_enabled_with_guard(logger::severity::information))
+    {
+        information_with_guard("Available free memory after deallocation: " + std::to_string(get_free_size_inner()));
+    }
+}
+
+void allocator_red_black_tree::drain_remote_frees()
+{
+    void *node = get_remote_frees().take_all();
+
+    // связь лежит на месте указателя на аллокатор
+    while (node != nullptr)
+    {
+        void *next = remote_free_queue::next(node);
+        void *block = reinterpret_cast<byte *>(node) - sizeof(block_data) - 2 * sizeof(void *);
+
+        get_block_trusted(block) = _trusted_memory;
+        get_counters().on_remote_free();
+        deallocate_block(reinterpret_cast<byte *>(block) + occupied_block_metadata_size);
+
+        node = next;
+    }
+}
+
+std::unique_lock<std::mutex> allocator_red_black_tree::lock_and_drain()
+{
+    auto lock = get_counters().lock(*get_mutex());
+    drain_remote_frees();
+    return lock;
+}
+
+bool allocator_red_black_tree::defer_deallocation(
+    void *at)
+{
+    if (at == nullptr)
+    {
+        return false;
+    }
+
+    // занятый блок никто, кроме освобождающего, не меняет; чужой или уже отложенный блок
+    // освобождается под блокировкой и там же отвергается
+    void *block = reinterpret_cast<byte *>(at) - occupied_block_metadata_size;
+    if (get_block_trusted(block) != _trusted_memory || !get_block_data(block).occupied)
+    {
+        return false;
+    }
+
+    get_remote_frees().push(&get_block_trusted(block));
+    return true;
 }
 
-void allocator_red_black_tree::set_fit_mode(allocator_with_fit_mode::fit_mode mode)
+inline void allocator_red_black_tree::set_fit_mode(allocator_with_fit_mode::fit_mode mode)
 {
-    throw not_implemented("void allocator_red_black_tree::set_fit_mode(allocator_with_fit_mode::fit_mode)", "your code should be here...");
+    std::lock_guard lock(*get_mutex());
+
+    *reinterpret_cast<allocator_with_fit_mode::fit_mode *>(reinterpret_cast<byte *>(_trusted_memory) + sizeof(logger *) + sizeof(allocator_dbg_helper *)) = mode;
 }
 
 
 std::vector<allocator_test_utils::block_info> allocator_red_black_tree::get_blocks_info() const
 {
-    throw not_implemented("std::vector<allocator_test_utils::block_info> allocator_red_black_tree::get_blocks_info() const", "your code should be here...");
+    std::lock_guard lock(*get_mutex());
+
+    return get_blocks_info_inner();
 }
 
 inline logger *allocator_red_black_tree::get_logger() const
 {
-    throw not_implemented("inline logger *allocator_red_black_tree::get_logger() const", "your code should be here...");
+    return *reinterpret_cast<logger **>(_trusted_memory);
 }
 
 std::vector<allocator_test_utils::block_info> allocator_red_black_tree::get_blocks_info_inner() const
 {
-    throw not_implemented("std::vector<allocator_test_utils::block_info> allocator_red_black_tree::get_blocks_info_inner() const", "your code should be here...");
+    std::vector<allocator_test_utils::block_info> result;
+
+    for (auto it = begin(), last = end(); it != last; ++it)
+    {
+        result.push_back({ it.size(), it.occupied() });
+    }
+
+    return result;
+}
+
+size_t allocator_red_black_tree::get_free_size_inner() const noexcept
+{
+    size_t free_size = 0;
+
+    for (auto it = begin(), last = end(); it != last; ++it)
+    {
+        if (!it.occupied())
+        {
+            free_size += it.size();
+        }
+    }
+
+    return free_size;
 }
 
 inline std::string allocator_red_black_tree::get_typename() const noexcept
 {
-    throw not_implemented("inline std::string allocator_red_black_tree::get_typename() const noexcept", "your code should be here...");
+    return "allocator_red_black_tree";
 }
 
+inline std::mutex *allocator_red_black_tree::get_mutex() const noexcept
+{
+    byte *ptr = reinterpret_cast<byte *>(_trusted_memory);
+
+    ptr += sizeof(logger *);
+    ptr += sizeof(allocator_dbg_helper *);
+    ptr += sizeof(allocator_with_fit_mode::fit_mode);
+    ptr += sizeof(size_t);
+
+    return reinterpret_cast<std::mutex *>(ptr);
+}
+
+inline remote_free_queue &allocator_red_black_tree::get_remote_frees() const noexcept
+{
+    return *reinterpret_cast<remote_free_queue *>(reinterpret_cast<byte *>(_trusted_memory) + remote_frees_offset);
+}
+
+inline allocator_statistics::counters &allocator_red_black_tree::get_counters() const noexcept
+{
+    return *reinterpret_cast<allocator_statistics::counters *>(reinterpret_cast<byte *>(_trusted_memory) + counters_offset);
+}
+
+// наибольший свободный блок - самый правый узел дерева
+size_t allocator_red_black_tree::get_largest_free_block_size() const noexcept
+{
+    void *block = get_root();
+    if (block == nullptr)
+    {
+        return 0;
+    }
+
+    while (get_right(block) != nullptr)
+    {
+        block = get_right(block);
+    }
+
+    return get_block_size(block);
+}
+
+allocator_statistics::statistics_snapshot allocator_red_black_tree::get_statistics() const noexcept
+{
+    return _trusted_memory == nullptr ? statistics_snapshot {} : get_counters().snapshot();
+}
+
+inline allocator_with_fit_mode::fit_mode allocator_red_black_tree::get_fit_mode() const noexcept
+{
+    return *reinterpret_cast<allocator_with_fit_mode::fit_mode *>(reinterpret_cast<byte *>(_trusted_memory) + sizeof(logger *) + sizeof(allocator_dbg_helper *));
+}
+
+inline size_t allocator_red_black_tree::get_space_size() const noexcept
+{
+    byte *ptr = reinterpret_cast<byte *>(_trusted_memory);
+
+    ptr += sizeof(logger *);
+    ptr += sizeof(allocator_dbg_helper *);
+    ptr += sizeof(allocator_with_fit_mode::fit_mode);
+
+    return *reinterpret_cast<size_t *>(ptr);
+}
+
+inline void *allocator_red_black_tree::get_first_block() const noexcept
+{
+    return reinterpret_cast<byte *>(_trusted_memory) + allocator_metadata_size;
+}
+
+inline void *&allocator_red_black_tree::get_root() const noexcept
+{
+    return *reinterpret_cast<void **>(reinterpret_cast<byte *>(get_mutex()) + sizeof(std::mutex));
+}
+
+inline allocator_red_black_tree::block_data &allocator_red_black_tree::get_block_data(void *block) noexcept
+{
+    return *reinterpret_cast<block_data *>(block);
+}
+
+inline void *&allocator_red_black_tree::get_prev_block(void *block) noexcept
+{
+    return *reinterpret_cast<void **>(reinterpret_cast<byte *>(block) + sizeof(block_data));
+}
+
+inline void *&allocator_red_black_tree::get_next_block(void *block) noexcept
+{
+    return *reinterpret_cast<void **>(reinterpret_cast<byte *>(block) + sizeof(block_data) + sizeof(void *));
+}
+
+inline void *&allocator_red_black_tree::get_block_trusted(void *block) noexcept
+{
+    return *reinterpret_cast<void **>(reinterpret_cast<byte *>(block) + sizeof(block_data) + 2 * sizeof(void *));
+}
+
+inline void *&allocator_red_black_tree::get_parent(void *block) noexcept
+{
+    return get_block_trusted(block);
+}
+
+inline void *&allocator_red_black_tree::get_left(void *block) noexcept
+{
+    return *reinterpret_cast<void **>(reinterpret_cast<byte *>(block) + sizeof(block_data) + 3 * sizeof(void *));
+}
+
+inline void *&allocator_red_black_tree::get_right(void *block) noexcept
+{
+    return *reinterpret_cast<void **>(reinterpret_cast<byte *>(block) + sizeof(block_data) + 4 * sizeof(void *));
+}
+
+inline bool allocator_red_black_tree::is_red(void *block) noexcept
+{
+    return block != nullptr && get_block_data(block).color == block_color::RED;
+}
+
+// размер блока вместе с метой: до следующего блока или до конца пространства
+inline size_t allocator_red_black_tree::get_block_size(void *block) const noexcept
+{
+    void *next = get_next_block(block);
+    byte *end = next == nullptr
+            ? reinterpret_cast<byte *>(get_first_block()) + get_space_size()
+            : reinterpret_cast<byte *>(next);
+
+    return end - reinterpret_cast<byte *>(block);
+}
+
+inline bool allocator_red_black_tree::is_less(void *left, size_t left_size, void *right) const noexcept
+{
+    size_t right_size = get_block_size(right);
+    return left_size < right_size || (left_size == right_size && left < right);
+}
+
+void allocator_red_black_tree::rotate_left(void *block) noexcept
+{
+    void *child = get_right(block);
+
+    get_right(block) = get_left(child);
+    if (get_left(child) != nullptr)
+    {
+        get_parent(get_left(child)) = block;
+    }
+
+    transplant(block, child);
+
+    get_left(child) = block;
+    get_parent(block) = child;
+}
+
+void allocator_red_black_tree::rotate_right(void *block) noexcept
+{
+    void *child = get_left(block);
+
+    get_left(block) = get_right(child);
+    if (get_right(child) != nullptr)
+    {
+        get_parent(get_right(child)) = block;
+    }
+
+    transplant(block, child);
+
+    get_right(child) = block;
+    get_parent(block) = child;
+}
+
+// ставит replacement (может быть nullptr) на место replaced в родителе
+void allocator_red_black_tree::transplant(void *replaced, void *replacement) noexcept
+{
+    void *parent = get_parent(replaced);
+
+    if (parent == nullptr)
+    {
+        get_root() = replacement;
+    }
+    else if (get_left(parent) == replaced)
+    {
+        get_left(parent) = replacement;
+    }
+    else
+    {
+        get_right(parent) = replacement;
+    }
+
+    if (replacement != nullptr)
+    {
+        get_parent(replacement) = parent;
+    }
+}
+
+void allocator_red_black_tree::insert_free_block(void *block) noexcept
+{
+    size_t size = get_block_size(block);
+
+    get_block_data(block).occupied = false;
+    get_block_data(block).color = block_color::RED;
+    get_left(block) = nullptr;
+    get_right(block) = nullptr;
+
+    void *parent = nullptr;
+    for (void *current = get_root(); current != nullptr; )
+    {
+        parent = current;
+        current = is_less(block, size, current) ? get_left(current) : get_right(current);
+    }
+
+    get_parent(block) = parent;
+
+    if (parent == nullptr)
+    {
+        get_root() = block;
+    }
+    else if (is_less(block, size, parent))
+    {
+        get_left(parent) = block;
+    }
+    else
+    {
+        get_right(parent) = block;
+    }
+
+    while (is_red(get_parent(block)))
+    {
+        parent = get_parent(block);
+        void *grandparent = get_parent(parent);
+
+        if (parent == get_left(grandparent))
+        {
+            void *uncle = get_right(grandparent);
+
+            if (is_red(uncle))
+            {
+                get_block_data(parent).color = block_color::BLACK;
+                get_block_data(uncle).color = block_color::BLACK;
+                get_block_data(grandparent).color = block_color::RED;
+                block = grandparent;
+                continue;
+            }
+
+            if (block == get_right(parent))
+            {
+                block = parent;
+                rotate_left(block);
+                parent = get_parent(block);
+            }
+
+            get_block_data(parent).color = block_color::BLACK;
+            get_block_data(grandparent).color = block_color::RED;
+            rotate_right(grandparent);
+        }
+        else
+        {
+            void *uncle = get_left(grandparent);
+
+            if (is_red(uncle))
+            {
+                get_block_data(parent).color = block_color::BLACK;
+                get_block_data(uncle).color = block_color::BLACK;
+                get_block_data(grandparent).color = block_color::RED;
+                block = grandparent;
+                continue;
+            }
+
+            if (block == get_left(parent))
+            {
+                block = parent;
+                rotate_right(block);
+                parent = get_parent(block);
+            }
+
+            get_block_data(parent).color = block_color::BLACK;
+            get_block_data(grandparent).color = block_color::RED;
+            rotate_left(grandparent);
+        }
+    }
+
+    get_block_data(get_root()).color = block_color::BLACK;
+}
+
+void allocator_red_black_tree::remove_free_block(void *block) noexcept
+{
+    void *removed = block;
+    block_color removed_color = get_block_data(removed).color;
+    void *child;
+    void *child_parent;
+
+    if (get_left(block) == nullptr)
+    {
+        child = get_right(block);
+        child_parent = get_parent(block);
+        transplant(block, child);
+    }
+    else if (get_right(block) == nullptr)
+    {
+        child = get_left(block);
+        child_parent = get_parent(block);
+        transplant(block, child);
+    }
+    else
+    {
+        // на место блока встает следующий за ним по порядку
+        removed = get_right(block);
+        while (get_left(removed) != nullptr)
+        {
+            removed = get_left(removed);
+        }
+
+        removed_color = get_block_data(removed).color;
+        child = get_right(removed);
+
+        if (get_parent(removed) == block)
+        {
+            child_parent = removed;
+        }
+        else
+        {
+            child_parent = get_parent(removed);
+            transplant(removed, child);
+            get_right(removed) = get_right(block);
+            get_parent(get_right(removed)) = removed;
+        }
+
+        transplant(block, removed);
+        get_left(removed) = get_left(block);
+        get_parent(get_left(removed)) = removed;
+        get_block_data(removed).color = get_block_data(block).color;
+    }
+
+    if (removed_color == block_color::BLACK)
+    {
+        remove_fixup(child, child_parent);
+    }
+}
+
+void allocator_red_black_tree::remove_fixup(void *block, void *parent) noexcept
+{
+    while (block != get_root() && !is_red(block))
+    {
+        if (block == get_left(parent))
+        {
+            void *sibling = get_right(parent);
+
+            if (is_red(sibling))
+            {
+                get_block_data(sibling).color = block_color::BLACK;
+                get_block_data(parent).color = block_color::RED;
+                rotate_left(parent);
+                sibling = get_right(parent);
+            }
+
+            if (!is_red(get_left(sibling)) && !is_red(get_right(sibling)))
+            {
+                get_block_data(sibling).color = block_color::RED;
+                block = parent;
+                parent = get_parent(block);
+                continue;
+            }
+
+            if (!is_red(get_right(sibling)))
+            {
+                get_block_data(get_left(sibling)).color = block_color::BLACK;
+                get_block_data(sibling).color = block_color::RED;
+                rotate_right(sibling);
+                sibling = get_right(parent);
+            }
+
+            get_block_data(sibling).color = get_block_data(parent).color;
+            get_block_data(parent).color = block_color::BLACK;
+            get_block_data(get_right(sibling)).color = block_color::BLACK;
+            rotate_left(parent);
+            block = get_root();
+        }
+        else
+        {
+            void *sibling = get_left(parent);
+
+            if (is_red(sibling))
+            {
+                get_block_data(sibling).color = block_color::BLACK;
+                get_block_data(parent).color = block_color::RED;
+                rotate_right(parent);
+                sibling = get_left(parent);
+            }
+
+            if (!is_red(get_left(sibling)) && !is_red(get_right(sibling)))
+            {
+                get_block_data(sibling).color = block_color::RED;
+                block = parent;
+                parent = get_parent(block);
+                continue;
+            }
+
+            if (!is_red(get_left(sibling)))
+            {
+                get_block_data(get_right(sibling)).color = block_color::BLACK;
+                get_block_data(sibling).color = block_color::RED;
+                rotate_left(sibling);
+                sibling = get_left(parent);
+            }
+
+            get_block_data(sibling).color = get_block_data(parent).color;
+            get_block_data(parent).color = block_color::BLACK;
+            get_block_data(get_left(sibling)).color = block_color::BLACK;
+            rotate_right(parent);
+            block = get_root();
+        }
+    }
+
+    if (block != nullptr)
+    {
+        get_block_data(block).color = block_color::BLACK;
+    }
+}
+
+/** the_best_fit takes the smallest fitting block (the lowest address among equal ones), the_worst_fit the largest one.
+ * first_fit takes the first fitting block met on the way down from the root, it does not look for the smallest one.
+ * The tree has no place to resume a search from, so next_fit works as first_fit.
+ */
+void *allocator_red_black_tree::find_free_block(size_t size, allocator_with_fit_mode::fit_mode mode) const noexcept
+{
+    void *current = get_root();
+    void *found = nullptr;
+
+    switch (mode)
+    {
+        case allocator_with_fit_mode::fit_mode::next_fit:
+        case allocator_with_fit_mode::fit_mode::first_fit:
+            while (current != nullptr && get_block_size(current) < size)
+            {
+                current = get_right(current);
+            }
+            return current;
+
+        case allocator_with_fit_mode::fit_mode::the_best_fit:
+            while (current != nullptr)
+            {
+                if (get_block_size(current) >= size)
+                {
+                    found = current;
+                    current = get_left(current);
+                }
+                else
+                {
+                    current = get_right(current);
+                }
+            }
+            return found;
+
+        case allocator_with_fit_mode::fit_mode::the_worst_fit:
+            while (current != nullptr)
+            {
+                found = current;
+                current = get_right(current);
+            }
+            return found != nullptr && get_block_size(found) >= size ? found : nullptr;
+    }
+
+    return nullptr;
+}
+
+/** The block is placed at the start of the free one (or after the alignment padding, which stays free),
+ * the rest stays free if it can hold a free block and is given to the allocated block otherwise.
+ */
+void *allocator_red_black_tree::allocate_from_free_block(void *block, size_t size, size_t alignment) noexcept
+{
+    remove_free_block(block);
+
+    size_t padding = -reinterpret_cast<std::uintptr_t>(reinterpret_cast<byte *>(block) + occupied_block_metadata_size) & (alignment - 1);
+    while (padding != 0 && padding < free_block_metadata_size)
+    {
+        padding += alignment;
+    }
+
+    if (padding != 0)
+    {
+        void *aligned_block = reinterpret_cast<byte *>(block) + padding;
+
+        get_prev_block(aligned_block) = block;
+        get_next_block(aligned_block) = get_next_block(block);
+        if (get_next_block(block) != nullptr)
+        {
+            get_prev_block(get_next_block(block)) = aligned_block;
+        }
+        get_next_block(block) = aligned_block;
+
+        insert_free_block(block);
+        block = aligned_block;
+    }
+
+    size_t block_size = std::max(size + occupied_block_metadata_size, free_block_metadata_size);
+
+    if (get_block_size(block) - block_size >= free_block_metadata_size)
+    {
+        void *rest = reinterpret_cast<byte *>(block) + block_size;
+
+        get_prev_block(rest) = block;
+        get_next_block(rest) = get_next_block(block);
+        if (get_next_block(block) != nullptr)
+        {
+            get_prev_block(get_next_block(block)) = rest;
+        }
+        get_next_block(block) = rest;
+
+        insert_free_block(rest);
+    }
+
+    get_block_data(block).occupied = true;
+    get_block_trusted(block) = _trusted_memory;
+
+    return reinterpret_cast<byte *>(block) + occupied_block_metadata_size;
+}
 
 allocator_red_black_tree::rb_iterator allocator_red_black_tree::begin() const noexcept
 {
-    throw not_implemented("allocator_red_black_tree::rb_iterator allocator_red_black_tree::begin() const noexcept", "your code should be here...");
+    return rb_iterator(_trusted_memory);
 }
 
 allocator_red_black_tree::rb_iterator allocator_red_black_tree::end() const noexcept
 {
-    throw not_implemented("allocator_red_black_tree::rb_iterator allocator_red_black_tree::end() const noexcept", "your code should be here...");
+    return rb_iterator();
 }
 
-
 bool allocator_red_black_tree::rb_iterator::operator==(const allocator_red_black_tree::rb_iterator &other) const noexcept
 {
-    throw not_implemented("bool allocator_red_black_tree::rb_iterator::operator==(const allocator_red_black_tree::rb_iterator &) const noexcept", "your code should be here...");
+    return _block_ptr == other._block_ptr;
 }
 
 bool allocator_red_black_tree::rb_iterator::operator!=(const allocator_red_black_tree::rb_iterator &other) const noexcept
 {
-    throw not_implemented("bool allocator_red_black_tree::rb_iterator::operator!=(const allocator_red_black_tree::rb_iterator &) const noexcept", "your code should be here...");
+    return !(*this == other);
 }
 
 allocator_red_black_tree::rb_iterator &allocator_red_black_tree::rb_iterator::operator++() & noexcept
 {
-    throw not_implemented("allocator_red_black_tree::rb_iterator &allocator_red_black_tree::rb_iterator::operator++() & noexcept", "your code should be here...");
+    _block_ptr = get_next_block(_block_ptr);
+    return *this;
 }
 
 allocator_red_black_tree::rb_iterator allocator_red_black_tree::rb_iterator::operator++(int n)
 {
-    throw not_implemented("allocator_red_black_tree::rb_iterator allocator_red_black_tree::rb_iterator::operator++(int)", "your code should be here...");
+    auto copy = *this;
+    ++*this;
+    return copy;
 }
 
 size_t allocator_red_black_tree::rb_iterator::size() const noexcept
 {
-    throw not_implemented("size_t allocator_red_black_tree::rb_iterator::size() const noexcept", "your code should be here...");
+    void *next = get_next_block(_block_ptr);
+    if (next != nullptr)
+    {
+        return reinterpret_cast<byte *>(next) - reinterpret_cast<byte *>(_block_ptr);
+    }
+
+    size_t space_size = *reinterpret_cast<size_t *>(reinterpret_cast<byte *>(_trusted) + sizeof(logger *) + sizeof(allocator_dbg_helper *) + sizeof(allocator_with_fit_mode::fit_mode));
+    return reinterpret_cast<byte *>(_trusted) + allocator_metadata_size + space_size - reinterpret_cast<byte *>(_block_ptr);
 }
 
 void *allocator_red_black_tree::rb_iterator::operator*() const noexcept
 {
-    throw not_implemented("void *allocator_red_black_tree::rb_iterator::operator*() const noexcept", "your code should be here...");
+    return _block_ptr;
 }
 
-allocator_red_black_tree::rb_iterator::rb_iterator()
+allocator_red_black_tree::rb_iterator::rb_iterator():
+    _block_ptr(nullptr),
+    _trusted(nullptr)
 {
-    throw not_implemented("allocator_red_black_tree::rb_iterator::rb_iterator()", "your code should be here...");
 }
 
-allocator_red_black_tree::rb_iterator::rb_iterator(void *trusted)
+allocator_red_black_tree::rb_iterator::rb_iterator(void *trusted):
+    _block_ptr(reinterpret_cast<byte *>(trusted) + allocator_metadata_size),
+    _trusted(trusted)
 {
-    throw not_implemented("allocator_red_black_tree::rb_iterator::rb_iterator(void *)", "your code should be here...");
 }
 
 bool allocator_red_black_tree::rb_iterator::occupied() const noexcept
 {
-    throw not_implemented("bool allocator_red_black_tree::rb_iterator::occupied() const noexcept", "your code should be here...");
+    return get_block_data(_block_ptr).occupied;
 }
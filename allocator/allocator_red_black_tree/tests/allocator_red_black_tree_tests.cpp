@@ -2,9 +2,37 @@
 #include <logger.h>
 #include <logger_builder.h>
 #include <client_logger_builder.h>
+#include <cstdint>
 #include <list>
+#include <new>
 #include <allocator_red_black_tree.h>
 
+namespace
+{
+	// родитель дает ровно то выравнивание, которое просят, и не больше
+	class exact_alignment_resource final:
+		public std::pmr::memory_resource
+	{
+		static constexpr size_t base_alignment = 64;
+
+		void *do_allocate(size_t bytes, size_t alignment) override
+		{
+			auto *base = reinterpret_cast<unsigned char *>(::operator new(bytes + base_alignment, std::align_val_t(base_alignment)));
+			return base + (alignment < base_alignment ? alignment : 0);
+		}
+
+		void do_deallocate(void *p, size_t, size_t alignment) override
+		{
+			::operator delete(reinterpret_cast<unsigned char *>(p) - (alignment < base_alignment ? alignment : 0), std::align_val_t(base_alignment));
+		}
+
+		bool do_is_equal(std::pmr::memory_resource const &other) const noexcept override
+		{
+			return this == &other;
+		}
+	};
+}
+
 logger *create_logger(
 	std::vector<std::pair<std::string, logger::severity>> const &output_file_streams_setup,
 	bool use_console_stream = true,
@@ -57,14 +85,14 @@ TEST(allocatorRBTPositiveTests, test1)
 
 	std::unique_ptr<smart_mem_resource> alloc(new allocator_red_black_tree(3000, nullptr, logger_instance.get(), allocator_with_fit_mode::fit_mode::first_fit));
 
-	auto first_block = reinterpret_cast<int *>(alloc->allocate(sizeof(int) * 250));
+	auto first_block = reinterpret_cast<int *>(alloc->allocate(sizeof(int) * 250, 1));
 
-	auto second_block = reinterpret_cast<char *>(alloc->allocate(sizeof(int) * 250));
+	auto second_block = reinterpret_cast<char *>(alloc->allocate(sizeof(int) * 250, 1));
 	alloc->deallocate(first_block, 1);
 
-	first_block = reinterpret_cast<int *>(alloc->allocate(sizeof(int) * 229));
+	first_block = reinterpret_cast<int *>(alloc->allocate(sizeof(int) * 226, 1));
 
-	auto third_block = reinterpret_cast<int *>(alloc->allocate(sizeof(int) * 250));
+	auto third_block = reinterpret_cast<int *>(alloc->allocate(sizeof(int) * 250, 1));
 
 	alloc->deallocate(second_block, 1);
 	alloc->deallocate(first_block, 1);
@@ -219,6 +247,124 @@ TEST(allocatorRBTPositiveTests, test7)
 	void* eleven = allocator->allocate(1 * 234);
 }
 
+TEST(allocatorRBTPositiveTests, test8)
+{
+	std::unique_ptr<smart_mem_resource> allocator(new allocator_red_black_tree(10'000, nullptr, nullptr, allocator_with_fit_mode::fit_mode::the_best_fit));
+
+	std::vector<size_t> sizes { 300, 10, 100, 10, 200, 10, 400 };
+	std::vector<void *> blocks;
+	for (auto size : sizes)
+	{
+		blocks.push_back(allocator->allocate(sizeof(char) * size));
+	}
+
+	allocator->deallocate(blocks[0], 1);
+	allocator->deallocate(blocks[2], 1);
+	allocator->deallocate(blocks[4], 1);
+
+	void *best = allocator->allocate(sizeof(char) * 90);
+	ASSERT_EQ(best, blocks[2]);
+
+	dynamic_cast<allocator_with_fit_mode *>(allocator.get())->set_fit_mode(allocator_with_fit_mode::fit_mode::the_worst_fit);
+	void *worst = allocator->allocate(sizeof(char) * 90);
+	ASSERT_GT(worst, blocks[6]);
+
+	auto *counter = allocator->allocate(sizeof(size_t), 64);
+	ASSERT_EQ(reinterpret_cast<std::uintptr_t>(counter) % 64, 0);
+
+	allocator->deallocate(counter, sizeof(size_t), 64);
+	allocator->deallocate(best, 1);
+	allocator->deallocate(worst, 1);
+	for (int i = 1; i < 7; i += 2)
+	{
+		allocator->deallocate(blocks[i], 1);
+	}
+	allocator->deallocate(blocks[6], 1);
+
+	auto actual_blocks_state = dynamic_cast<allocator_test_utils *>(allocator.get())->get_blocks_info();
+
+	ASSERT_EQ(actual_blocks_state.size(), 1);
+	ASSERT_EQ(actual_blocks_state[0], (allocator_test_utils::block_info{ .block_size = 10'000, .is_block_occupied = false }));
+}
+
+
+TEST(allocatorRBTPositiveTests, test9)
+{
+	allocator_red_black_tree allocator_instance(10'000, nullptr, nullptr, allocator_with_fit_mode::fit_mode::first_fit);
+
+	auto initial = allocator_instance.get_statistics();
+
+	ASSERT_EQ(initial.total_bytes, 10'000);
+	ASSERT_EQ(initial.bytes_in_use, 0);
+	ASSERT_EQ(initial.peak_bytes_in_use, 0);
+	ASSERT_EQ(initial.largest_free_block, 10'000);
+
+	void *first_block = allocator_instance.allocate(1000);
+	void *second_block = allocator_instance.allocate(500);
+	ASSERT_THROW(static_cast<void>(allocator_instance.allocate(20'000)), std::bad_alloc);
+
+	auto after_allocations = allocator_instance.get_statistics();
+	auto blocks_state = allocator_instance.get_blocks_info();
+
+	size_t occupied_bytes = 0;
+	size_t largest_free_block = 0;
+	for (auto const &block : blocks_state)
+	{
+		if (block.is_block_occupied)
+		{
+			occupied_bytes += block.block_size;
+		}
+		else
+		{
+			largest_free_block = std::max(largest_free_block, block.block_size);
+		}
+	}
+
+	ASSERT_EQ(after_allocations.allocations, 2);
+	ASSERT_EQ(after_allocations.failed_allocations, 1);
+	ASSERT_EQ(after_allocations.occupied_blocks, 2);
+	ASSERT_EQ(after_allocations.bytes_in_use, occupied_bytes);
+	ASSERT_EQ(after_allocations.peak_bytes_in_use, occupied_bytes);
+	ASSERT_EQ(after_allocations.free_bytes, 10'000 - occupied_bytes);
+	ASSERT_EQ(after_allocations.largest_free_block, largest_free_block);
+
+	allocator_instance.deallocate(first_block, 1);
+
+	// пик не уменьшается после освобождения
+	auto after_first_deallocation = allocator_instance.get_statistics();
+
+	ASSERT_EQ(after_first_deallocation.deallocations, 1);
+	ASSERT_LT(after_first_deallocation.bytes_in_use, occupied_bytes);
+	ASSERT_EQ(after_first_deallocation.peak_bytes_in_use, occupied_bytes);
+
+	allocator_instance.deallocate(second_block, 1);
+
+	auto final = allocator_instance.get_statistics();
+
+	ASSERT_EQ(final.deallocations, 2);
+	ASSERT_EQ(final.occupied_blocks, 0);
+	ASSERT_EQ(final.bytes_in_use, 0);
+	ASSERT_EQ(final.peak_bytes_in_use, occupied_bytes);
+	ASSERT_EQ(final.largest_free_block, 10'000);
+}
+
+TEST(allocatorRBTPositiveTests, test10)
+{
+	exact_alignment_resource parent;
+
+	// начало памяти родителя и мета занятого блока выровнены на max_align_t, поэтому выровнен и первый блок
+	allocator_red_black_tree allocator_instance(1000, &parent, nullptr, allocator_with_fit_mode::fit_mode::first_fit);
+	void *first_block = allocator_instance.allocate(100, 1);
+	ASSERT_EQ(reinterpret_cast<std::uintptr_t>(first_block) % alignof(std::max_align_t), 0);
+
+	void *second_block = allocator_instance.allocate(13, 8);
+	ASSERT_EQ(reinterpret_cast<std::uintptr_t>(second_block) % 8, 0);
+
+	allocator_instance.deallocate(first_block, 1);
+	allocator_instance.deallocate(second_block, 1);
+
+	ASSERT_EQ(allocator_instance.get_statistics().bytes_in_use, 0);
+}
 
 int main(
     int argc,
@@ -0,0 +1,172 @@
+#ifndef MATH_PRACTICE_AND_OPERATING_SYSTEMS_ALLOCATOR_ALLOCATOR_SHARDED_H
+#define MATH_PRACTICE_AND_OPERATING_SYSTEMS_ALLOCATOR_ALLOCATOR_SHARDED_H
+
+#include <pp_allocator.h>
+#include <allocator_logger_guardant.h>
+#include <typename_holder.h>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/**
+ * Front end over several arenas (any of the arena allocators), each with its own lock and memory.
+ * A thread allocates from its home arena, threads get home arenas round-robin on their first allocation;
+ * when the home arena is exhausted the next arenas are tried in turn. A block is freed to the arena
+ * that owns it, found by its address: every arena is created over a parent resource that remembers
+ * the memory ranges the arena took, so an arena must take all of its memory from that parent.
+ * Frees look the owner up in an immutable sorted snapshot of the ranges without taking any lock;
+ * an arena taking or returning memory publishes a new snapshot, and the old ones are deleted once
+ * no free is reading them.
+ */
+class allocator_sharded final:
+    public smart_mem_resource,
+    private allocator_logger_guardant,
+    private typename_holder
+{
+
+public:
+
+    // creates an arena over the given parent resource
+    using arena_factory = std::function<std::unique_ptr<smart_mem_resource>(std::pmr::memory_resource *)>;
+
+private:
+
+    class arena_parent;
+
+    struct owned_range
+    {
+        std::uintptr_t begin;
+
+        std::uintptr_t end;
+
+        size_t arena_index;
+    };
+
+    // диапазоны памяти арен, отсортированные по адресу начала; опубликованный снимок не меняется
+    using ranges_snapshot = std::vector<owned_range>;
+
+    static constexpr const size_t reader_slots_count = 64;
+
+    // число освобождений, читающих снимок; потоки раскиданы по слотам, чтобы не делить одну линию кэша
+    struct alignas(64) reader_slot
+    {
+        std::atomic<size_t> readers;
+    };
+
+    struct arena
+    {
+        std::unique_ptr<arena_parent> parent;
+
+        std::unique_ptr<smart_mem_resource> resource;
+    };
+
+    std::pmr::memory_resource *_parent_allocator;
+
+    logger *_logger;
+
+    std::atomic<ranges_snapshot const *> _ranges;
+
+    // только для публикующих новый снимок
+    std::mutex _ranges_mutex;
+
+    // замененные снимки, которые еще может читать освобождение
+    std::vector<ranges_snapshot const *> _retired_ranges;
+
+    reader_slot _reader_slots[reader_slots_count];
+
+    std::vector<arena> _arenas;
+
+public:
+
+    /**
+     * arenas_count == 0 means one arena per hardware thread.
+     * Arenas take their memory from parent_allocator (the global heap if there is none).
+     */
+    explicit allocator_sharded(
+        arena_factory const &create_arena,
+        size_t arenas_count = 0,
+        std::pmr::memory_resource *parent_allocator = nullptr,
+        logger *logger = nullptr);
+
+    allocator_sharded(
+        allocator_sharded const &other) = delete;
+
+    allocator_sharded &operator=(
+        allocator_sharded const &other) = delete;
+
+    allocator_sharded(
+        allocator_sharded &&other) noexcept = delete;
+
+    allocator_sharded &operator=(
+        allocator_sharded &&other) noexcept = delete;
+
+    ~allocator_sharded() override;
+
+public:
+
+    [[nodiscard]] void *do_allocate_sm(
+        size_t size) override;
+
+    [[nodiscard]] void *do_allocate_aligned_sm(
+        size_t size,
+        size_t alignment) override;
+
+    void do_deallocate_sm(
+        void *at) override;
+
+    void do_deallocate_sized_sm(
+        void *at,
+        size_t size,
+        size_t alignment) override;
+
+    // the whole batch comes from one arena
+    void do_allocate_batch_sm(
+        size_t size,
+        size_t count,
+        void **out,
+        size_t alignment) override;
+
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override;
+
+public:
+
+    size_t get_arenas_count() const noexcept;
+
+    smart_mem_resource &get_arena(
+        size_t index) const;
+
+    // the arena the calling thread allocates from first
+    size_t get_home_arena_index() const noexcept;
+
+private:
+
+    // tries the home arena and then the next ones, the last std::bad_alloc is rethrown
+    template<typename allocate_type>
+    auto allocate_from_arenas(
+        allocate_type const &allocate);
+
+    smart_mem_resource &get_owning_arena(
+        void *at);
+
+    void add_range(
+        void *begin,
+        size_t size,
+        size_t arena_index);
+
+    void remove_range(
+        void *begin);
+
+    // under _ranges_mutex
+    void publish_ranges(
+        std::unique_ptr<ranges_snapshot> ranges);
+
+    inline logger *get_logger() const override;
+
+    inline std::string get_typename() const override;
+
+};
+
+#endif //MATH_PRACTICE_AND_OPERATING_SYSTEMS_ALLOCATOR_ALLOCATOR_SHARDED_H
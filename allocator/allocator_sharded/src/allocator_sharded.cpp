@@ -0,0 +1,338 @@
+#include "../include/allocator_sharded.h"
+#include <algorithm>
+#include <atomic>
+#include <iterator>
+#include <thread>
+
+namespace
+{
+    std::atomic<size_t> next_thread_number(0);
+
+    size_t get_thread_number() noexcept
+    {
+        thread_local size_t thread_number = next_thread_number.fetch_add(1, std::memory_order_relaxed);
+
+        return thread_number;
+    }
+}
+
+/** Remembers which memory its arena took, so that blocks can be freed to the arena by address
+ */
+class allocator_sharded::arena_parent final:
+    public std::pmr::memory_resource
+{
+
+private:
+
+    allocator_sharded &_owner;
+
+    size_t _arena_index;
+
+public:
+
+    arena_parent(
+        allocator_sharded &owner,
+        size_t arena_index):
+            _owner(owner),
+            _arena_index(arena_index)
+    {
+    }
+
+private:
+
+    void *do_allocate(
+        size_t bytes,
+        size_t alignment) override
+    {
+        void *memory = _owner._parent_allocator->allocate(bytes, alignment);
+
+        try
+        {
+            _owner.add_range(memory, bytes, _arena_index);
+        }
+        catch (...)
+        {
+            _owner._parent_allocator->deallocate(memory, bytes, alignment);
+            throw;
+        }
+
+        return memory;
+    }
+
+    void do_deallocate(
+        void *p,
+        size_t bytes,
+        size_t alignment) override
+    {
+        _owner.remove_range(p);
+        _owner._parent_allocator->deallocate(p, bytes, alignment);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override
+    {
+        return this == &other;
+    }
+
+};
+
+allocator_sharded::allocator_sharded(
+    arena_factory const &create_arena,
+    size_t arenas_count,
+    std::pmr::memory_resource *parent_allocator,
+    logger *logger):
+        _parent_allocator(parent_allocator == nullptr ? std::pmr::get_default_resource() : parent_allocator),
+        _logger(logger),
+        _ranges(new ranges_snapshot()),
+        _reader_slots()
+{
+    if (arenas_count == 0)
+    {
+        arenas_count = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+
+    _arenas.reserve(arenas_count);
+
+    for (size_t i = 0; i < arenas_count; ++i)
+    {
+        auto parent = std::make_unique<arena_parent>(*this, i);
+        auto resource = create_arena(parent.get());
+
+        if (resource == nullptr)
+        {
+            error_with_guard("Arena factory returned no arena");
+            throw std::logic_error("Arena factory returned no arena");
+        }
+
+        _arenas.push_back({ std::move(parent), std::move(resource) });
+    }
+
+    debug_with_guard("allocator_sharded created");
+}
+
+allocator_sharded::~allocator_sharded()
+{
+    // арены отдают память через своих родителей, пока диапазоны еще живы
+    _arenas.clear();
+
+    delete _ranges.load();
+    for (auto const *ranges : _retired_ranges)
+    {
+        delete ranges;
+    }
+
+    debug_with_guard("allocator_sharded destroyed");
+}
+
+template<typename allocate_type>
+auto allocator_sharded::allocate_from_arenas(
+    allocate_type const &allocate)
+{
+    size_t home_arena_index = get_home_arena_index();
+
+    for (size_t i = 0; ; ++i)
+    {
+        try
+        {
+            return allocate(*_arenas[(home_arena_index + i) % _arenas.size()].resource);
+        }
+        catch (std::bad_alloc const &)
+        {
+            if (i + 1 == _arenas.size())
+            {
+                error_with_guard("Every arena is exhausted");
+                throw;
+            }
+
+            trace_with_guard("Arena is exhausted, trying the next one");
+        }
+    }
+}
+
+[[nodiscard]] void *allocator_sharded::do_allocate_sm(
+    size_t size)
+{
+    return allocate_from_arenas([size](smart_mem_resource &resource)
+    {
+        return resource.allocate(size, 1);
+    });
+}
+
+[[nodiscard]] void *allocator_sharded::do_allocate_aligned_sm(
+    size_t size,
+    size_t alignment)
+{
+    return allocate_from_arenas([size, alignment](smart_mem_resource &resource)
+    {
+        return resource.allocate(size, alignment);
+    });
+}
+
+void allocator_sharded::do_deallocate_sm(
+    void *at)
+{
+    if (at == nullptr)
+    {
+        return;
+    }
+
+    // размер неизвестен (освобождение пакетом), арена получает блок тоже без размера
+    get_owning_arena(at).deallocate_batch(&at, 1);
+}
+
+void allocator_sharded::do_deallocate_sized_sm(
+    void *at,
+    size_t size,
+    size_t alignment)
+{
+    if (at == nullptr)
+    {
+        return;
+    }
+
+    get_owning_arena(at).deallocate(at, size, alignment);
+}
+
+void allocator_sharded::do_allocate_batch_sm(
+    size_t size,
+    size_t count,
+    void **out,
+    size_t alignment)
+{
+    allocate_from_arenas([size, count, out, alignment](smart_mem_resource &resource)
+    {
+        resource.allocate_batch(size, count, out, alignment);
+    });
+}
+
+bool allocator_sharded::do_is_equal(const std::pmr::memory_resource &other) const noexcept
+{
+    return this == &other;
+}
+
+size_t allocator_sharded::get_arenas_count() const noexcept
+{
+    return _arenas.size();
+}
+
+smart_mem_resource &allocator_sharded::get_arena(
+    size_t index) const
+{
+    if (index >= _arenas.size())
+    {
+        throw std::out_of_range("Arena index is out of range");
+    }
+
+    return *_arenas[index].resource;
+}
+
+size_t allocator_sharded::get_home_arena_index() const noexcept
+{
+    return get_thread_number() % _arenas.size();
+}
+
+smart_mem_resource &allocator_sharded::get_owning_arena(
+    void *at)
+{
+    auto address = reinterpret_cast<std::uintptr_t>(at);
+    auto &readers = _reader_slots[get_thread_number() % reader_slots_count].readers;
+
+    // снимок читается, пока счетчик слота не нулевой; публикующий не удалит его раньше
+    readers.fetch_add(1);
+    auto const &ranges = *_ranges.load();
+
+    auto it = std::upper_bound(ranges.begin(), ranges.end(), address, [](std::uintptr_t value, owned_range const &range)
+    {
+        return value < range.begin;
+    });
+    size_t arena_index = it != ranges.begin() && address < std::prev(it)->end
+        ? std::prev(it)->arena_index
+        : _arenas.size();
+
+    readers.fetch_sub(1, std::memory_order_release);
+
+    if (arena_index < _arenas.size())
+    {
+        return *_arenas[arena_index].resource;
+    }
+
+    error_with_guard("Tried to deallocate block not allocated by allocator_sharded");
+    throw std::logic_error("Not allocator's property");
+}
+
+void allocator_sharded::add_range(
+    void *begin,
+    size_t size,
+    size_t arena_index)
+{
+    auto address = reinterpret_cast<std::uintptr_t>(begin);
+
+    std::lock_guard lock(_ranges_mutex);
+
+    auto const &current = *_ranges.load(std::memory_order_relaxed);
+    auto ranges = std::make_unique<ranges_snapshot>();
+    ranges->reserve(current.size() + 1);
+
+    auto it = std::upper_bound(current.begin(), current.end(), address, [](std::uintptr_t value, owned_range const &range)
+    {
+        return value < range.begin;
+    });
+    ranges->insert(ranges->end(), current.begin(), it);
+    ranges->push_back({ address, address + size, arena_index });
+    ranges->insert(ranges->end(), it, current.end());
+
+    publish_ranges(std::move(ranges));
+}
+
+void allocator_sharded::remove_range(
+    void *begin)
+{
+    auto address = reinterpret_cast<std::uintptr_t>(begin);
+
+    std::lock_guard lock(_ranges_mutex);
+
+    auto const &current = *_ranges.load(std::memory_order_relaxed);
+    auto ranges = std::make_unique<ranges_snapshot>();
+    ranges->reserve(current.size());
+
+    std::copy_if(current.begin(), current.end(), std::back_inserter(*ranges), [address](owned_range const &range)
+    {
+        return range.begin != address;
+    });
+
+    publish_ranges(std::move(ranges));
+}
+
+/** Frees only read the snapshot after counting themselves in their slot, so once every slot is seen
+ * empty after the swap no free can still hold a replaced snapshot.
+ */
+void allocator_sharded::publish_ranges(
+    std::unique_ptr<ranges_snapshot> ranges)
+{
+    _retired_ranges.reserve(_retired_ranges.size() + 1);
+    _retired_ranges.push_back(_ranges.exchange(ranges.release()));
+
+    for (auto &slot : _reader_slots)
+    {
+        if (slot.readers.load() != 0)
+        {
+            trace_with_guard("Replaced ranges are still read, deleting them later");
+            return;
+        }
+    }
+
+    for (auto const *retired : _retired_ranges)
+    {
+        delete retired;
+    }
+    _retired_ranges.clear();
+}
+
+inline logger *allocator_sharded::get_logger() const
+{
+    return _logger;
+}
+
+inline std::string allocator_sharded::get_typename() const
+{
+    return "allocator_sharded";
+}
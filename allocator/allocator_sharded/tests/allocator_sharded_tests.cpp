@@ -0,0 +1,267 @@
+#include <gtest/gtest.h>
+#include <allocator_sharded.h>
+#include <allocator_boundary_tags.h>
+#include <allocator_buddies_system.h>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    size_t count_occupied_blocks(
+        smart_mem_resource &arena)
+    {
+        size_t count = 0;
+        for (auto &block : dynamic_cast<allocator_test_utils &>(arena).get_blocks_info())
+        {
+            count += block.is_block_occupied;
+        }
+        return count;
+    }
+
+    bool is_empty(
+        smart_mem_resource &arena)
+    {
+        auto blocks_state = dynamic_cast<allocator_test_utils &>(arena).get_blocks_info();
+        return blocks_state.size() == 1 && !blocks_state[0].is_block_occupied;
+    }
+
+    // берет каждый блок у родителя отдельно, так что каждое выделение добавляет диапазон, а освобождение убирает
+    class direct_arena final:
+        public smart_mem_resource
+    {
+
+    private:
+
+        std::pmr::memory_resource *_parent;
+
+    public:
+
+        explicit direct_arena(
+            std::pmr::memory_resource *parent):
+                _parent(parent)
+        {
+        }
+
+    private:
+
+        void *do_allocate_sm(
+            size_t size) override
+        {
+            return _parent->allocate(size);
+        }
+
+        void do_deallocate_sm(
+            void *) override
+        {
+            throw std::logic_error("direct_arena needs the size to free a block");
+        }
+
+        void do_deallocate_sized_sm(
+            void *at,
+            size_t size,
+            size_t alignment) override
+        {
+            _parent->deallocate(at, size, alignment);
+        }
+
+        bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override
+        {
+            return this == &other;
+        }
+
+    };
+}
+
+TEST(allocatorShardedPositiveTests, test1)
+{
+    allocator_sharded allocator_instance([](std::pmr::memory_resource *parent)
+    {
+        return std::make_unique<allocator_boundary_tags>(10'000, parent);
+    }, 2);
+
+    ASSERT_EQ(allocator_instance.get_arenas_count(), 2);
+
+    size_t home = allocator_instance.get_home_arena_index();
+    auto &home_arena = allocator_instance.get_arena(home);
+    auto &neighbour_arena = allocator_instance.get_arena(1 - home);
+
+    // в арену помещается 9 блоков по 1000 байт, остальные берутся у соседней
+    std::vector<void *> blocks;
+    for (size_t i = 0; i < 15; ++i)
+    {
+        blocks.push_back(allocator_instance.allocate(1000));
+        std::memset(blocks.back(), static_cast<int>(i), 1000);
+    }
+
+    ASSERT_EQ(count_occupied_blocks(home_arena), 9);
+    ASSERT_EQ(count_occupied_blocks(neighbour_arena), 6);
+
+    for (size_t i = 0; i < 3; ++i)
+    {
+        blocks.push_back(allocator_instance.allocate(1000));
+    }
+    ASSERT_THROW(static_cast<void>(allocator_instance.allocate(1000)), std::bad_alloc);
+
+    int foreign = 0;
+    ASSERT_THROW(allocator_instance.deallocate(&foreign, sizeof(int)), std::logic_error);
+
+    // блоки возвращаются в свои арены
+    allocator_instance.deallocate(blocks.back(), 1000);
+    blocks.pop_back();
+    ASSERT_EQ(count_occupied_blocks(neighbour_arena), 8);
+
+    void *batch[4];
+    allocator_instance.allocate_batch(100, 4, batch);
+    ASSERT_EQ(count_occupied_blocks(home_arena), 13);
+    allocator_instance.deallocate_batch(batch, 4);
+
+    for (auto *block : blocks)
+    {
+        allocator_instance.deallocate(block, 1000);
+    }
+
+    ASSERT_TRUE(is_empty(home_arena));
+    ASSERT_TRUE(is_empty(neighbour_arena));
+}
+
+TEST(allocatorShardedPositiveTests, test2)
+{
+    allocator_sharded allocator_instance([](std::pmr::memory_resource *parent)
+    {
+        return std::make_unique<allocator_buddies_system>(22, parent);
+    }, 4);
+
+    std::vector<std::thread> threads;
+    std::vector<std::vector<void *>> handed_over(4);
+
+    for (int t = 0; t < 4; ++t)
+    {
+        threads.emplace_back([&allocator_instance, &handed_over, t]()
+        {
+            std::vector<std::pair<unsigned char *, size_t>> blocks;
+
+            for (int i = 0; i < 20'000; ++i)
+            {
+                size_t size = 1 + (i * 7 + t) % 700;
+                auto *block = reinterpret_cast<unsigned char *>(allocator_instance.allocate(size));
+                std::memset(block, t + 1, size);
+                blocks.emplace_back(block, size);
+
+                if (blocks.size() > 50)
+                {
+                    auto [ptr, ptr_size] = blocks[i % blocks.size()];
+                    for (size_t j = 0; j < ptr_size; ++j)
+                    {
+                        ASSERT_EQ(ptr[j], t + 1);
+                    }
+                    allocator_instance.deallocate(ptr, ptr_size);
+                    blocks.erase(blocks.begin() + i % blocks.size());
+                }
+            }
+
+            for (auto [ptr, ptr_size] : blocks)
+            {
+                handed_over[t].push_back(ptr);
+            }
+        });
+    }
+
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+
+    // блоки завершившихся потоков освобождаются на этом
+    for (auto &blocks : handed_over)
+    {
+        for (auto *ptr : blocks)
+        {
+            allocator_instance.deallocate(ptr, 1);
+        }
+    }
+
+    for (size_t i = 0; i < allocator_instance.get_arenas_count(); ++i)
+    {
+        ASSERT_TRUE(is_empty(allocator_instance.get_arena(i)));
+    }
+}
+
+TEST(allocatorShardedPositiveTests, test3)
+{
+    // арены проверяют, что блок освобождается с тем размером, с которым выделен
+    allocator_sharded allocator_instance([](std::pmr::memory_resource *parent)
+    {
+        return std::make_unique<allocator_buddies_system>(16, parent, nullptr,
+            allocator_with_fit_mode::fit_mode::first_fit, true);
+    }, 2);
+
+    auto *block = allocator_instance.allocate(1000);
+    auto *aligned_block = allocator_instance.allocate(300, 64);
+    allocator_instance.deallocate(block, 1000);
+    allocator_instance.deallocate(aligned_block, 300, 64);
+
+    // пакет освобождается без размера
+    void *batch[4];
+    allocator_instance.allocate_batch(100, 4, batch);
+    allocator_instance.deallocate_batch(batch, 4);
+
+    for (size_t i = 0; i < allocator_instance.get_arenas_count(); ++i)
+    {
+        ASSERT_TRUE(is_empty(allocator_instance.get_arena(i)));
+    }
+}
+
+TEST(allocatorShardedPositiveTests, test4)
+{
+    // диапазоны меняются при каждом выделении и освобождении, пока другие потоки ищут в них владельцев
+    allocator_sharded allocator_instance([](std::pmr::memory_resource *parent)
+    {
+        return std::make_unique<direct_arena>(parent);
+    }, 4);
+
+    std::vector<std::thread> threads;
+    std::vector<std::vector<std::pair<unsigned char *, size_t>>> handed_over(4);
+
+    for (int t = 0; t < 4; ++t)
+    {
+        threads.emplace_back([&allocator_instance, &handed_over, t]()
+        {
+            std::vector<std::pair<unsigned char *, size_t>> blocks;
+
+            for (int i = 0; i < 5'000; ++i)
+            {
+                size_t size = 1 + (i * 13 + t) % 300;
+                auto *block = reinterpret_cast<unsigned char *>(allocator_instance.allocate(size));
+                std::memset(block, t + 1, size);
+                blocks.emplace_back(block, size);
+
+                if (blocks.size() > 20)
+                {
+                    auto [ptr, ptr_size] = blocks[i % blocks.size()];
+                    ASSERT_EQ(ptr[ptr_size - 1], t + 1);
+                    allocator_instance.deallocate(ptr, ptr_size);
+                    blocks.erase(blocks.begin() + i % blocks.size());
+                }
+            }
+
+            handed_over[t] = std::move(blocks);
+        });
+    }
+
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+
+    for (auto &blocks : handed_over)
+    {
+        for (auto [ptr, ptr_size] : blocks)
+        {
+            allocator_instance.deallocate(ptr, ptr_size);
+        }
+    }
+
+    int foreign = 0;
+    ASSERT_THROW(allocator_instance.deallocate(&foreign, sizeof(int)), std::logic_error);
+}
@@ -0,0 +1,250 @@
+#ifndef MATH_PRACTICE_AND_OPERATING_SYSTEMS_ALLOCATOR_ALLOCATOR_SLAB_H
+#define MATH_PRACTICE_AND_OPERATING_SYSTEMS_ALLOCATOR_ALLOCATOR_SLAB_H
+
+#include <pp_allocator.h>
+#include <allocator_test_utils.h>
+#include <allocator_statistics.h>
+#include <os_memory_resource.h>
+#include <allocator_logger_guardant.h>
+#include <typename_holder.h>
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <mutex>
+
+/**
+ * Allocator for many small objects. The space is cut into slabs of slab_size bytes, a slab serves blocks
+ * of one size class and keeps their occupancy in a bitmap in its header, so a block costs no metadata and
+ * both allocation and free are O(1). Slabs with free blocks of a class form a list. The first slab of a class
+ * that becomes empty is kept by the class, so a block going back and forth over a slab boundary does not move
+ * a slab to the free ones and back each time; further empty slabs go back to the free slabs at once. Slab runs
+ * may take the kept slabs, other classes take them when no free slab is left.
+ * With an os_memory_resource as the parent allocator the pages of free slabs are given back to the OS once
+ * the free slabs around them form a run no shorter than its release threshold.
+ * Requests bigger than max_small_size or aligned stricter than max_small_alignment take a run of whole slabs.
+ */
+class allocator_slab final:
+    public smart_mem_resource,
+    public allocator_test_utils,
+    public allocator_statistics,
+    private allocator_logger_guardant,
+    private typename_holder
+{
+
+public:
+
+    static constexpr const size_t slab_size = size_t(1) << 15;
+
+    static constexpr const size_t max_small_size = 4096;
+
+    static constexpr const size_t max_small_alignment = 64;
+
+private:
+
+    // классы: до 64 байт с шагом 8, дальше по четыре на каждую степень двойки
+    static constexpr const size_t size_classes_count = 8 + 4 * 6;
+
+    static constexpr const std::array<size_t, size_classes_count> class_sizes = []
+    {
+        std::array<size_t, size_classes_count> sizes {};
+
+        for (size_t i = 0; i < 8; ++i)
+        {
+            sizes[i] = 8 * (i + 1);
+        }
+        for (size_t i = 8; i < size_classes_count; ++i)
+        {
+            size_t power = size_t(64) << ((i - 8) / 4);
+            sizes[i] = power + power / 4 * ((i - 8) % 4 + 1);
+        }
+
+        return sizes;
+    }();
+
+    static_assert(class_sizes[size_classes_count - 1] == max_small_size);
+
+    static constexpr const size_t bitmap_words_count = 64;
+
+    using slab_link = uint32_t;
+
+    static constexpr const slab_link no_slab = std::numeric_limits<slab_link>::max();
+
+    // заголовок слэба класса: свободных блоков, соседи в списке слэбов класса со свободными блоками,
+    // сводка непустых слов битовой карты, битовая карта свободных блоков
+    struct slab_header
+    {
+        uint32_t free_count;
+
+        slab_link prev;
+
+        slab_link next;
+
+        uint64_t summary;
+
+        uint64_t free_bitmap[bitmap_words_count];
+    };
+
+    static constexpr const size_t slab_data_offset = (sizeof(slab_header) + max_small_alignment - 1) & ~(max_small_alignment - 1);
+
+    static_assert((slab_size - slab_data_offset) / class_sizes[0] <= bitmap_words_count * 64, "the bitmap must cover the smallest class");
+
+    // состояние слэба в мете: номер класса, свободен, или начало серии слэбов под один большой блок с ее длиной
+    // (у остальных слэбов серии длина 0)
+    using slab_state = uint32_t;
+
+    static constexpr const slab_state free_slab_state = std::numeric_limits<slab_state>::max();
+
+    static constexpr const slab_state large_run_flag = slab_state(1) << 31;
+
+    // узел дерева серий слэбов, которые можно взять (свободных и пустых, оставленных классам): длины серий
+    // в начале и в конце отрезка узла и самой длинной серии в нем
+    struct free_run_node
+    {
+        uint32_t prefix;
+
+        uint32_t suffix;
+
+        uint32_t longest;
+    };
+
+    // мета: логгер, родительский аллокатор, число слэбов, начало слэбов, мьютекс (выровнен), головы списков
+    // слэбов со свободными блоками, пустые слэбы, оставленные классам, счетчики статистики (выровнены),
+    // состояния слэбов, битовая карта свободных слэбов, битовая карта свободных слэбов, отданных ОС,
+    // дерево серий на степень двойки листьев
+    static constexpr const size_t mutex_offset =
+            (sizeof(logger*) + sizeof(std::pmr::memory_resource*) + sizeof(size_t) + sizeof(void*) +
+             alignof(std::mutex) - 1) & ~(alignof(std::mutex) - 1);
+
+    static constexpr const size_t partial_heads_offset = mutex_offset + sizeof(std::mutex);
+
+    static constexpr const size_t empty_slabs_offset = partial_heads_offset + size_classes_count * sizeof(slab_link);
+
+    static constexpr const size_t counters_offset =
+            (empty_slabs_offset + size_classes_count * sizeof(slab_link) +
+             alignof(allocator_statistics::counters) - 1) & ~(alignof(allocator_statistics::counters) - 1);
+
+    static constexpr const size_t slab_states_offset = counters_offset + sizeof(allocator_statistics::counters);
+
+    void *_trusted_memory;
+
+public:
+
+    /**
+     * space_size is rounded up to whole slabs. The slabs are taken from the parent allocator
+     * in one piece aligned to slab_size, the metadata separately.
+     */
+    explicit allocator_slab(
+            size_t space_size,
+            std::pmr::memory_resource *parent_allocator = nullptr,
+            logger *log = nullptr);
+
+    allocator_slab(allocator_slab const &other) = delete;
+
+    allocator_slab &operator=(allocator_slab const &other) = delete;
+
+    allocator_slab(
+            allocator_slab &&other) noexcept;
+
+    allocator_slab &operator=(
+            allocator_slab &&other) noexcept;
+
+    ~allocator_slab() override;
+
+public:
+
+    [[nodiscard]] void *do_allocate_sm(
+            size_t bytes) override;
+
+    [[nodiscard]] void *do_allocate_aligned_sm(
+            size_t bytes,
+            size_t alignment) override;
+
+    void do_deallocate_sm(
+            void *at) override;
+
+    // the whole batch under one lock, all or nothing
+    void do_allocate_batch_sm(
+            size_t bytes,
+            size_t count,
+            void **out,
+            size_t alignment) override;
+
+    void do_deallocate_batch_sm(
+            void *const *blocks,
+            size_t count) override;
+
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override;
+
+public:
+
+    // the size of the block a request of bytes gets, 0 for the requests served by slab runs
+    static size_t get_block_size(
+            size_t bytes) noexcept;
+
+    /**
+     * Blocks of class slabs in address order, free slabs in a row as one free block,
+     * a slab run as one block. An empty slab kept by its class is listed as a free slab.
+     * Slab headers are not listed.
+     */
+    std::vector<allocator_test_utils::block_info> get_blocks_info() const override;
+
+    statistics_snapshot get_statistics() const noexcept override;
+
+private:
+
+    std::vector<allocator_test_utils::block_info> get_blocks_info_inner() const override;
+
+    inline logger *get_logger() const override;
+
+    inline std::string get_typename() const noexcept override;
+
+    void release_memory() noexcept;
+
+    inline std::pmr::memory_resource *get_parent_allocator() const noexcept;
+    inline size_t get_slabs_count() const noexcept;
+    inline unsigned char *get_slabs_start() const noexcept;
+    inline std::mutex &get_mutex() const noexcept;
+    inline slab_link *get_partial_heads() const noexcept;
+    inline slab_link *get_empty_slabs() const noexcept;
+    inline allocator_statistics::counters &get_counters() const noexcept;
+    inline slab_state *get_slab_states() const noexcept;
+    inline uint64_t *get_free_slabs_bitmap() const noexcept;
+    inline uint64_t *get_released_slabs_bitmap() const noexcept;
+    inline free_run_node *get_free_runs() const noexcept;
+    static inline size_t get_free_slabs_bitmap_offset(size_t slabs_count) noexcept;
+    static inline size_t get_bitmap_words_count(size_t slabs_count) noexcept;
+    static inline size_t get_metadata_size(size_t slabs_count) noexcept;
+
+    inline unsigned char *get_slab(size_t index) const noexcept;
+    static inline slab_header &get_slab_header(unsigned char *slab) noexcept;
+    static inline size_t get_class_index(size_t bytes) noexcept;
+    static inline size_t get_class_blocks_count(size_t class_index) noexcept;
+
+    // a free slab taken out of the bitmap, or an empty slab taken from its class; no_slab when there is none
+    slab_link take_free_slab() noexcept;
+    // the first run of slabs that may be taken, O(log slabs) in the tree of runs
+    slab_link take_free_run(size_t length) noexcept;
+    void release_slabs(size_t index, size_t length) noexcept;
+
+    // an empty slab kept by its class stops being one, the caller takes it
+    void reclaim_empty_slab(size_t index, size_t class_index) noexcept;
+
+    // marks slabs as ones that may or may not be taken in the tree of runs
+    void mark_available(size_t index, size_t length, bool available) noexcept;
+
+    // gives back the pages of the run of free slabs around the given ones that are not given back yet
+    void give_back_pages(size_t index, size_t length) noexcept;
+
+    void link_partial_slab(size_t index, size_t class_index) noexcept;
+    void unlink_partial_slab(size_t index, size_t class_index) noexcept;
+
+    // allocates under the lock taken by the caller, nullptr when nothing fits
+    void *allocate_block(size_t bytes, size_t alignment) noexcept;
+
+    // frees under the lock taken by the caller
+    void deallocate_block(void *at);
+
+    size_t get_largest_free_block_size() const noexcept;
+};
+
+#endif //MATH_PRACTICE_AND_OPERATING_SYSTEMS_ALLOCATOR_ALLOCATOR_SLAB_H
@@ -0,0 +1,853 @@
+#include "../include/allocator_slab.h"
+#include <algorithm>
+#include <bit>
+#include <utility>
+
+using byte = unsigned char;
+
+allocator_slab::allocator_slab(
+        size_t space_size,
+        std::pmr::memory_resource *parent_allocator,
+        logger *log)
+{
+    if (parent_allocator == nullptr)
+    {
+        parent_allocator = std::pmr::get_default_resource();
+    }
+
+    size_t slabs_count = std::max<size_t>((space_size + slab_size - 1) / slab_size, 1);
+    if (slabs_count >= large_run_flag || space_size > std::numeric_limits<size_t>::max() - slab_size)
+    {
+        throw std::logic_error("allocator_slab space is too big");
+    }
+
+    _trusted_memory = parent_allocator->allocate(get_metadata_size(slabs_count));
+
+    void *slabs;
+    try
+    {
+        slabs = parent_allocator->allocate(slabs_count * slab_size, slab_size);
+    }
+    catch (...)
+    {
+        parent_allocator->deallocate(_trusted_memory, get_metadata_size(slabs_count));
+        throw;
+    }
+
+    byte *ptr = reinterpret_cast<byte *>(_trusted_memory);
+
+    *reinterpret_cast<logger **>(ptr) = log;
+    ptr += sizeof(logger *);
+
+    *reinterpret_cast<std::pmr::memory_resource **>(ptr) = parent_allocator;
+    ptr += sizeof(std::pmr::memory_resource *);
+
+    *reinterpret_cast<size_t *>(ptr) = slabs_count;
+    ptr += sizeof(size_t);
+
+    *reinterpret_cast<void **>(ptr) = slabs;
+
+    new (&get_mutex()) std::mutex;
+
+    std::fill_n(get_partial_heads(), size_classes_count, no_slab);
+    std::fill_n(get_empty_slabs(), size_classes_count, no_slab);
+
+    new (&get_counters()) allocator_statistics::counters(slabs_count * slab_size);
+
+    std::fill_n(get_slab_states(), slabs_count, free_slab_state);
+
+    // лишние биты последнего слова не отмечают слэбы свободными; нетронутые слэбы ОС еще не выдавала
+    size_t bitmap_words = get_bitmap_words_count(slabs_count);
+    std::fill_n(get_free_slabs_bitmap(), bitmap_words, ~uint64_t(0));
+    if (slabs_count % 64 != 0)
+    {
+        get_free_slabs_bitmap()[bitmap_words - 1] = (uint64_t(1) << (slabs_count % 64)) - 1;
+    }
+    std::copy_n(get_free_slabs_bitmap(), bitmap_words, get_released_slabs_bitmap());
+
+    std::fill_n(get_free_runs(), 2 * std::bit_ceil(slabs_count), free_run_node {});
+    mark_available(0, slabs_count, true);
+
+    debug_with_guard("allocator_slab created");
+}
+
+allocator_slab::allocator_slab(
+        allocator_slab &&other) noexcept:
+            _trusted_memory(std::exchange(other._trusted_memory, nullptr))
+{
+}
+
+allocator_slab &allocator_slab::operator=(
+        allocator_slab &&other) noexcept
+{
+    if (this != &other)
+    {
+        release_memory();
+        _trusted_memory = std::exchange(other._trusted_memory, nullptr);
+    }
+
+    return *this;
+}
+
+allocator_slab::~allocator_slab()
+{
+    release_memory();
+}
+
+void allocator_slab::release_memory() noexcept
+{
+    if (_trusted_memory == nullptr)
+    {
+        return;
+    }
+
+    std::pmr::memory_resource *parent_allocator = get_parent_allocator();
+    size_t slabs_count = get_slabs_count();
+
+    get_mutex().~mutex();
+    parent_allocator->deallocate(get_slabs_start(), slabs_count * slab_size, slab_size);
+    parent_allocator->deallocate(_trusted_memory, get_metadata_size(slabs_count));
+
+    _trusted_memory = nullptr;
+}
+
+[[nodiscard]] void *allocator_slab::do_allocate_sm(
+        size_t bytes)
+{
+    return do_allocate_aligned_sm(bytes, 1);
+}
+
+[[nodiscard]] void *allocator_slab::do_allocate_aligned_sm(
+        size_t bytes,
+        size_t alignment)
+{
+    trace_with_guard("do_allocate_sm start");
+
+    void *memory;
+    {
+        auto lock = get_counters().lock(get_mutex());
+
+        memory = allocate_block(bytes, alignment);
+        if (memory == nullptr)
+        {
+            get_counters().on_failed_allocation();
+        }
+    }
+
+    if (memory == nullptr)
+    {
+        if (is_enabled_with_guard(logger::severity::error))
+        {
+            error_with_guard("Allocation failed for size " + std::to_string(bytes));
+        }
+        throw std::bad_alloc();
+    }
+
+    trace_with_guard("do_allocate_sm finish");
+
+    return memory;
+}
+
+void allocator_slab::do_deallocate_sm(
+        void *at)
+{
+    trace_with_guard("do_deallocate_sm start");
+
+    auto lock = get_counters().lock(get_mutex());
+    deallocate_block(at);
+
+    trace_with_guard("do_deallocate_sm finish");
+}
+
+void allocator_slab::do_allocate_batch_sm(
+        size_t bytes,
+        size_t count,
+        void **out,
+        size_t alignment)
+{
+    {
+        auto lock = get_counters().lock(get_mutex());
+
+        size_t allocated = 0;
+        for (; allocated < count; ++allocated)
+        {
+            out[allocated] = allocate_block(bytes, alignment);
+            if (out[allocated] == nullptr)
+            {
+                break;
+            }
+        }
+
+        if (allocated == count)
+        {
+            return;
+        }
+
+        // все или ничего: уже выданные блоки возвращаются
+        for (size_t i = 0; i < allocated; ++i)
+        {
+            deallocate_block(out[i]);
+        }
+        get_counters().on_failed_allocation();
+    }
+
+    if (is_enabled_with_guard(logger::severity::error))
+    {
+        error_with_guard("Batch allocation failed for " + std::to_string(count) + " blocks of " + std::to_string(bytes) + " bytes");
+    }
+    throw std::bad_alloc();
+}
+
+void allocator_slab::do_deallocate_batch_sm(
+        void *const *blocks,
+        size_t count)
+{
+    auto lock = get_counters().lock(get_mutex());
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        deallocate_block(blocks[i]);
+    }
+}
+
+bool allocator_slab::do_is_equal(const std::pmr::memory_resource &other) const noexcept
+{
+    return this == &other;
+}
+
+size_t allocator_slab::get_block_size(
+        size_t bytes) noexcept
+{
+    return bytes > max_small_size ? 0 : class_sizes[get_class_index(bytes)];
+}
+
+void *allocator_slab::allocate_block(
+        size_t bytes,
+        size_t alignment) noexcept
+{
+    if (bytes <= max_small_size && alignment <= max_small_alignment)
+    {
+        // данные слэба выровнены на max_small_alignment, поэтому блок выровнен, если размер класса кратен выравниванию
+        size_t class_index = get_class_index(bytes);
+        while (class_index < size_classes_count && class_sizes[class_index] % alignment != 0)
+        {
+            ++class_index;
+        }
+
+        if (class_index < size_classes_count)
+        {
+            slab_link index = get_partial_heads()[class_index];
+            if (index == no_slab)
+            {
+                index = take_free_slab();
+                if (index == no_slab)
+                {
+                    return nullptr;
+                }
+
+                size_t blocks_count = get_class_blocks_count(class_index);
+                slab_header &header = get_slab_header(get_slab(index));
+
+                header.free_count = static_cast<uint32_t>(blocks_count);
+                header.summary = blocks_count / 64 == bitmap_words_count ? ~uint64_t(0) : (uint64_t(1) << (blocks_count + 63) / 64) - 1;
+                std::fill_n(header.free_bitmap, blocks_count / 64, ~uint64_t(0));
+                std::fill(header.free_bitmap + blocks_count / 64, header.free_bitmap + bitmap_words_count, 0);
+                if (blocks_count % 64 != 0)
+                {
+                    header.free_bitmap[blocks_count / 64] = (uint64_t(1) << (blocks_count % 64)) - 1;
+                }
+
+                get_slab_states()[index] = static_cast<slab_state>(class_index);
+                link_partial_slab(index, class_index);
+                get_counters().set_largest_free_block(get_largest_free_block_size());
+            }
+
+            byte *slab = get_slab(index);
+            slab_header &header = get_slab_header(slab);
+
+            if (get_empty_slabs()[class_index] == index)
+            {
+                get_empty_slabs()[class_index] = no_slab;
+                mark_available(index, 1, false);
+                get_counters().set_largest_free_block(get_largest_free_block_size());
+            }
+
+            size_t word = std::countr_zero(header.summary);
+            size_t bit = std::countr_zero(header.free_bitmap[word]);
+
+            header.free_bitmap[word] &= header.free_bitmap[word] - 1;
+            if (header.free_bitmap[word] == 0)
+            {
+                header.summary &= ~(uint64_t(1) << word);
+            }
+
+            if (--header.free_count == 0)
+            {
+                unlink_partial_slab(index, class_index);
+                get_counters().set_largest_free_block(get_largest_free_block_size());
+            }
+
+            get_counters().on_allocate(class_sizes[class_index]);
+
+            return slab + slab_data_offset + (word * 64 + bit) * class_sizes[class_index];
+        }
+    }
+
+    // большой блок - серия целых слэбов, выровненных на slab_size
+    if (alignment > slab_size || bytes > get_slabs_count() * slab_size)
+    {
+        return nullptr;
+    }
+
+    size_t length = std::max<size_t>((bytes + slab_size - 1) / slab_size, 1);
+    slab_link index = take_free_run(length);
+    if (index == no_slab)
+    {
+        return nullptr;
+    }
+
+    get_slab_states()[index] = large_run_flag | static_cast<slab_state>(length);
+    std::fill_n(get_slab_states() + index + 1, length - 1, large_run_flag);
+
+    get_counters().on_allocate(length * slab_size);
+    get_counters().set_largest_free_block(get_largest_free_block_size());
+
+    return get_slab(index);
+}
+
+void allocator_slab::deallocate_block(
+        void *at)
+{
+    if (at == nullptr)
+    {
+        return;
+    }
+
+    byte *slabs_start = get_slabs_start();
+    if (reinterpret_cast<byte *>(at) < slabs_start || reinterpret_cast<byte *>(at) >= slabs_start + get_slabs_count() * slab_size)
+    {
+        error_with_guard("Tried to deallocate not allocator's property");
+        throw std::logic_error("Not allocator's property");
+    }
+
+    size_t index = static_cast<size_t>(reinterpret_cast<byte *>(at) - slabs_start) / slab_size;
+    byte *slab = get_slab(index);
+    slab_state state = get_slab_states()[index];
+
+    if (state & large_run_flag)
+    {
+        size_t length = state & ~large_run_flag;
+        if (length == 0 || at != slab)
+        {
+            error_with_guard("Tried to deallocate not a block start");
+            throw std::logic_error("Not allocator's property");
+        }
+
+        get_counters().on_deallocate(length * slab_size);
+        release_slabs(index, length);
+        get_counters().set_largest_free_block(get_largest_free_block_size());
+        return;
+    }
+
+    size_t offset = static_cast<size_t>(reinterpret_cast<byte *>(at) - slab);
+    if (state == free_slab_state || offset < slab_data_offset || (offset - slab_data_offset) % class_sizes[state] != 0)
+    {
+        error_with_guard("Tried to deallocate not allocator's property");
+        throw std::logic_error("Not allocator's property");
+    }
+
+    size_t class_index = state;
+    size_t block = (offset - slab_data_offset) / class_sizes[class_index];
+    size_t word = block / 64;
+    uint64_t mask = uint64_t(1) << (block % 64);
+    slab_header &header = get_slab_header(slab);
+
+    if (block >= get_class_blocks_count(class_index) || (header.free_bitmap[word] & mask) != 0)
+    {
+        error_with_guard("Tried to deallocate a free block");
+        throw std::logic_error("Block is already free");
+    }
+
+    header.free_bitmap[word] |= mask;
+    header.summary |= uint64_t(1) << word;
+    get_counters().on_deallocate(class_sizes[class_index]);
+
+    // слэб, в котором освободился первый блок, снова выдает блоки; первый опустевший слэб класса остается за ним,
+    // следующие возвращаются целиком
+    if (++header.free_count == 1)
+    {
+        link_partial_slab(index, class_index);
+    }
+
+    if (header.free_count == get_class_blocks_count(class_index))
+    {
+        if (get_empty_slabs()[class_index] == no_slab)
+        {
+            get_empty_slabs()[class_index] = static_cast<slab_link>(index);
+            mark_available(index, 1, true);
+        }
+        else
+        {
+            unlink_partial_slab(index, class_index);
+            release_slabs(index, 1);
+        }
+        get_counters().set_largest_free_block(get_largest_free_block_size());
+    }
+    else if (header.free_count == 1)
+    {
+        get_counters().set_largest_free_block(get_largest_free_block_size());
+    }
+}
+
+allocator_slab::slab_link allocator_slab::take_free_slab() noexcept
+{
+    uint64_t *bitmap = get_free_slabs_bitmap();
+    size_t words = get_bitmap_words_count(get_slabs_count());
+
+    for (size_t word = 0; word < words; ++word)
+    {
+        if (bitmap[word] != 0)
+        {
+            size_t bit = std::countr_zero(bitmap[word]);
+            bitmap[word] &= bitmap[word] - 1;
+            get_released_slabs_bitmap()[word] &= ~(uint64_t(1) << bit);
+
+            auto index = static_cast<slab_link>(word * 64 + bit);
+            mark_available(index, 1, false);
+            return index;
+        }
+    }
+
+    // свободных не осталось, берется пустой слэб, оставленный другому классу
+    for (size_t class_index = 0; class_index < size_classes_count; ++class_index)
+    {
+        slab_link index = get_empty_slabs()[class_index];
+        if (index != no_slab)
+        {
+            reclaim_empty_slab(index, class_index);
+            mark_available(index, 1, false);
+            return index;
+        }
+    }
+
+    return no_slab;
+}
+
+/** A node's longest run is the longest of its children's ones and of the run across their border,
+ * so the first run long enough is found going down from the root.
+ */
+allocator_slab::slab_link allocator_slab::take_free_run(
+        size_t length) noexcept
+{
+    if (length == 1)
+    {
+        return take_free_slab();
+    }
+
+    free_run_node *runs = get_free_runs();
+    if (runs[1].longest < length)
+    {
+        return no_slab;
+    }
+
+    size_t leaves = std::bit_ceil(get_slabs_count());
+    size_t node = 1;
+    size_t start = 0;
+
+    for (size_t half = leaves / 2; node < leaves; half /= 2)
+    {
+        free_run_node const &left = runs[2 * node];
+        free_run_node const &right = runs[2 * node + 1];
+
+        if (left.longest >= length)
+        {
+            node = 2 * node;
+        }
+        else if (left.suffix + right.prefix >= length)
+        {
+            start += half - left.suffix;
+            break;
+        }
+        else
+        {
+            node = 2 * node + 1;
+            start += half;
+        }
+    }
+
+    uint64_t *bitmap = get_free_slabs_bitmap();
+    uint64_t *released = get_released_slabs_bitmap();
+
+    for (size_t taken = start; taken < start + length; ++taken)
+    {
+        slab_state state = get_slab_states()[taken];
+        if (state != free_slab_state)
+        {
+            reclaim_empty_slab(taken, state);
+        }
+
+        bitmap[taken / 64] &= ~(uint64_t(1) << (taken % 64));
+        released[taken / 64] &= ~(uint64_t(1) << (taken % 64));
+    }
+    mark_available(start, length, false);
+
+    return static_cast<slab_link>(start);
+}
+
+void allocator_slab::release_slabs(
+        size_t index,
+        size_t length) noexcept
+{
+    uint64_t *bitmap = get_free_slabs_bitmap();
+
+    for (size_t slab = index; slab < index + length; ++slab)
+    {
+        get_slab_states()[slab] = free_slab_state;
+        bitmap[slab / 64] |= uint64_t(1) << (slab % 64);
+    }
+
+    mark_available(index, length, true);
+    give_back_pages(index, length);
+}
+
+void allocator_slab::reclaim_empty_slab(
+        size_t index,
+        size_t class_index) noexcept
+{
+    unlink_partial_slab(index, class_index);
+    get_empty_slabs()[class_index] = no_slab;
+}
+
+void allocator_slab::mark_available(
+        size_t index,
+        size_t length,
+        bool available) noexcept
+{
+    free_run_node *runs = get_free_runs();
+    size_t leaves = std::bit_ceil(get_slabs_count());
+    size_t first = leaves + index;
+    size_t last = leaves + index + length - 1;
+
+    uint32_t leaf_run = available ? 1 : 0;
+    std::fill(runs + first, runs + last + 1, free_run_node { leaf_run, leaf_run, leaf_run });
+
+    // узлы над измененными листьями пересчитываются уровень за уровнем
+    for (uint32_t half = 1; first > 1; half *= 2)
+    {
+        first /= 2;
+        last /= 2;
+
+        for (size_t node = first; node <= last; ++node)
+        {
+            free_run_node const &left = runs[2 * node];
+            free_run_node const &right = runs[2 * node + 1];
+
+            runs[node] = {
+                left.prefix == half ? half + right.prefix : left.prefix,
+                right.suffix == half ? half + left.suffix : right.suffix,
+                std::max({ left.longest, right.longest, left.suffix + right.prefix })
+            };
+        }
+    }
+}
+
+/** A single slab is shorter than the default release threshold, so the pages are given back for the whole
+ * run of free slabs around the freed ones; the slabs given back earlier are skipped.
+ */
+void allocator_slab::give_back_pages(
+        size_t index,
+        size_t length) noexcept
+{
+    auto *os_parent = dynamic_cast<os_memory_resource *>(get_parent_allocator());
+    if (os_parent == nullptr)
+    {
+        return;
+    }
+
+    uint64_t *bitmap = get_free_slabs_bitmap();
+    uint64_t *released = get_released_slabs_bitmap();
+    size_t slabs_count = get_slabs_count();
+    size_t run_start = index;
+    size_t run_end = index + length;
+
+    while (run_start > 0)
+    {
+        size_t bits_before = (run_start - 1) % 64 + 1;
+        size_t free_slabs = std::countl_one(bitmap[(run_start - 1) / 64] << (64 - bits_before));
+
+        run_start -= std::min(free_slabs, bits_before);
+        if (free_slabs < bits_before)
+        {
+            break;
+        }
+    }
+
+    while (run_end < slabs_count)
+    {
+        size_t bits_after = 64 - run_end % 64;
+        size_t free_slabs = std::countr_one(bitmap[run_end / 64] >> (run_end % 64));
+
+        run_end += std::min(free_slabs, bits_after);
+        if (free_slabs < bits_after)
+        {
+            break;
+        }
+    }
+
+    if ((run_end - run_start) * slab_size < os_parent->get_release_threshold())
+    {
+        return;
+    }
+
+    for (size_t slab = run_start; slab < run_end;)
+    {
+        if ((released[slab / 64] >> (slab % 64) & 1) != 0)
+        {
+            ++slab;
+            continue;
+        }
+
+        size_t span_end = slab;
+        for (; span_end < run_end && (released[span_end / 64] >> (span_end % 64) & 1) == 0; ++span_end)
+        {
+            released[span_end / 64] |= uint64_t(1) << (span_end % 64);
+        }
+
+        os_parent->release_pages(get_slab(slab), get_slab(span_end));
+        slab = span_end;
+    }
+}
+
+void allocator_slab::link_partial_slab(
+        size_t index,
+        size_t class_index) noexcept
+{
+    slab_link &head = get_partial_heads()[class_index];
+    slab_header &header = get_slab_header(get_slab(index));
+
+    header.prev = no_slab;
+    header.next = head;
+    if (head != no_slab)
+    {
+        get_slab_header(get_slab(head)).prev = static_cast<slab_link>(index);
+    }
+    head = static_cast<slab_link>(index);
+}
+
+void allocator_slab::unlink_partial_slab(
+        size_t index,
+        size_t class_index) noexcept
+{
+    slab_header &header = get_slab_header(get_slab(index));
+
+    if (header.prev == no_slab)
+    {
+        get_partial_heads()[class_index] = header.next;
+    }
+    else
+    {
+        get_slab_header(get_slab(header.prev)).next = header.next;
+    }
+
+    if (header.next != no_slab)
+    {
+        get_slab_header(get_slab(header.next)).prev = header.prev;
+    }
+}
+
+// наибольший свободный блок - самая длинная серия слэбов, которые можно взять, или, если их нет,
+// блок старшего класса со свободным местом
+size_t allocator_slab::get_largest_free_block_size() const noexcept
+{
+    size_t longest_run = get_free_runs()[1].longest;
+    if (longest_run != 0)
+    {
+        return longest_run * slab_size;
+    }
+
+    for (size_t class_index = size_classes_count; class_index-- > 0;)
+    {
+        if (get_partial_heads()[class_index] != no_slab)
+        {
+            return class_sizes[class_index];
+        }
+    }
+
+    return 0;
+}
+
+std::vector<allocator_test_utils::block_info> allocator_slab::get_blocks_info() const
+{
+    std::lock_guard lock(get_mutex());
+
+    return get_blocks_info_inner();
+}
+
+std::vector<allocator_test_utils::block_info> allocator_slab::get_blocks_info_inner() const
+{
+    std::vector<allocator_test_utils::block_info> result;
+    size_t slabs_count = get_slabs_count();
+
+    auto is_listed_free = [this](size_t index)
+    {
+        slab_state state = get_slab_states()[index];
+        return state == free_slab_state || (state < size_classes_count && get_empty_slabs()[state] == index);
+    };
+
+    for (size_t index = 0; index < slabs_count; ++index)
+    {
+        slab_state state = get_slab_states()[index];
+
+        if (is_listed_free(index))
+        {
+            if (!result.empty() && !result.back().is_block_occupied && index != 0 && is_listed_free(index - 1))
+            {
+                result.back().block_size += slab_size;
+            }
+            else
+            {
+                result.push_back({ .block_size = slab_size, .is_block_occupied = false });
+            }
+        }
+        else if (state & large_run_flag)
+        {
+            if ((state & ~large_run_flag) != 0)
+            {
+                result.push_back({ .block_size = (state & ~large_run_flag) * slab_size, .is_block_occupied = true });
+            }
+        }
+        else
+        {
+            slab_header &header = get_slab_header(get_slab(index));
+            size_t blocks_count = get_class_blocks_count(state);
+
+            for (size_t block = 0; block < blocks_count; ++block)
+            {
+                bool occupied = (header.free_bitmap[block / 64] & (uint64_t(1) << (block % 64))) == 0;
+                result.push_back({ .block_size = class_sizes[state], .is_block_occupied = occupied });
+            }
+        }
+    }
+
+    return result;
+}
+
+allocator_statistics::statistics_snapshot allocator_slab::get_statistics() const noexcept
+{
+    return _trusted_memory == nullptr ? statistics_snapshot {} : get_counters().snapshot();
+}
+
+inline logger *allocator_slab::get_logger() const
+{
+    return _trusted_memory == nullptr ? nullptr : *reinterpret_cast<logger **>(_trusted_memory);
+}
+
+inline std::string allocator_slab::get_typename() const noexcept
+{
+    return "allocator_slab";
+}
+
+inline std::pmr::memory_resource *allocator_slab::get_parent_allocator() const noexcept
+{
+    return *reinterpret_cast<std::pmr::memory_resource **>(reinterpret_cast<byte *>(_trusted_memory) + sizeof(logger *));
+}
+
+inline size_t allocator_slab::get_slabs_count() const noexcept
+{
+    return *reinterpret_cast<size_t *>(reinterpret_cast<byte *>(_trusted_memory) + sizeof(logger *) + sizeof(std::pmr::memory_resource *));
+}
+
+inline unsigned char *allocator_slab::get_slabs_start() const noexcept
+{
+    return *reinterpret_cast<byte **>(reinterpret_cast<byte *>(_trusted_memory) + sizeof(logger *) + sizeof(std::pmr::memory_resource *) + sizeof(size_t));
+}
+
+inline std::mutex &allocator_slab::get_mutex() const noexcept
+{
+    return *reinterpret_cast<std::mutex *>(reinterpret_cast<byte *>(_trusted_memory) + mutex_offset);
+}
+
+inline allocator_slab::slab_link *allocator_slab::get_partial_heads() const noexcept
+{
+    return reinterpret_cast<slab_link *>(reinterpret_cast<byte *>(_trusted_memory) + partial_heads_offset);
+}
+
+inline allocator_slab::slab_link *allocator_slab::get_empty_slabs() const noexcept
+{
+    return reinterpret_cast<slab_link *>(reinterpret_cast<byte *>(_trusted_memory) + empty_slabs_offset);
+}
+
+inline allocator_statistics::counters &allocator_slab::get_counters() const noexcept
+{
+    return *reinterpret_cast<allocator_statistics::counters *>(reinterpret_cast<byte *>(_trusted_memory) + counters_offset);
+}
+
+inline allocator_slab::slab_state *allocator_slab::get_slab_states() const noexcept
+{
+    return reinterpret_cast<slab_state *>(reinterpret_cast<byte *>(_trusted_memory) + slab_states_offset);
+}
+
+inline uint64_t *allocator_slab::get_free_slabs_bitmap() const noexcept
+{
+    return reinterpret_cast<uint64_t *>(reinterpret_cast<byte *>(_trusted_memory) + get_free_slabs_bitmap_offset(get_slabs_count()));
+}
+
+inline uint64_t *allocator_slab::get_released_slabs_bitmap() const noexcept
+{
+    return get_free_slabs_bitmap() + get_bitmap_words_count(get_slabs_count());
+}
+
+inline allocator_slab::free_run_node *allocator_slab::get_free_runs() const noexcept
+{
+    return reinterpret_cast<free_run_node *>(get_released_slabs_bitmap() + get_bitmap_words_count(get_slabs_count()));
+}
+
+inline size_t allocator_slab::get_free_slabs_bitmap_offset(
+        size_t slabs_count) noexcept
+{
+    return (slab_states_offset + slabs_count * sizeof(slab_state) + alignof(uint64_t) - 1) & ~(alignof(uint64_t) - 1);
+}
+
+inline size_t allocator_slab::get_bitmap_words_count(
+        size_t slabs_count) noexcept
+{
+    return (slabs_count + 63) / 64;
+}
+
+inline size_t allocator_slab::get_metadata_size(
+        size_t slabs_count) noexcept
+{
+    return get_free_slabs_bitmap_offset(slabs_count) + 2 * get_bitmap_words_count(slabs_count) * sizeof(uint64_t) +
+           2 * std::bit_ceil(slabs_count) * sizeof(free_run_node);
+}
+
+inline unsigned char *allocator_slab::get_slab(
+        size_t index) const noexcept
+{
+    return get_slabs_start() + index * slab_size;
+}
+
+inline allocator_slab::slab_header &allocator_slab::get_slab_header(
+        unsigned char *slab) noexcept
+{
+    return *reinterpret_cast<slab_header *>(slab);
+}
+
+// до 64 байт шаг 8, дальше номер степени двойки и четверть внутри нее
+inline size_t allocator_slab::get_class_index(
+        size_t bytes) noexcept
+{
+    if (bytes <= 64)
+    {
+        return (std::max<size_t>(bytes, 1) + 7) / 8 - 1;
+    }
+
+    size_t power = std::bit_width(bytes - 1) - 1;
+    return 8 + (power - 6) * 4 + (((bytes - 1) >> (power - 2)) & 3);
+}
+
+inline size_t allocator_slab::get_class_blocks_count(
+        size_t class_index) noexcept
+{
+    return (slab_size - slab_data_offset) / class_sizes[class_index];
+}
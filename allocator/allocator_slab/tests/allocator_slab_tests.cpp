@@ -0,0 +1,235 @@
+#include <gtest/gtest.h>
+#include <allocator_slab.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <list>
+#include <vector>
+
+namespace
+{
+    size_t count_occupied_blocks(
+        std::vector<allocator_test_utils::block_info> const &blocks_state)
+    {
+        return std::count_if(blocks_state.begin(), blocks_state.end(), [](auto const &block) { return block.is_block_occupied; });
+    }
+}
+
+TEST(allocatorSlabPositiveTests, test1)
+{
+    allocator_slab allocator_instance(4 * allocator_slab::slab_size);
+
+    ASSERT_EQ(allocator_slab::get_block_size(24), 24);
+    ASSERT_EQ(allocator_slab::get_block_size(65), 80);
+    ASSERT_EQ(allocator_slab::get_block_size(2049), 2560);
+    ASSERT_EQ(allocator_slab::get_block_size(allocator_slab::max_small_size + 1), 0);
+
+    // блоки одного класса лежат подряд, без меты между ними
+    std::vector<unsigned char *> blocks;
+    for (size_t i = 0; i < 3; ++i)
+    {
+        blocks.push_back(reinterpret_cast<unsigned char *>(allocator_instance.allocate(24, 8)));
+        std::memset(blocks.back(), static_cast<int>(i + 1), 24);
+    }
+    ASSERT_EQ(blocks[1] - blocks[0], 24);
+    ASSERT_EQ(blocks[2] - blocks[1], 24);
+
+    // другой класс берет свой слэб
+    auto *other_class_block = allocator_instance.allocate(100);
+    ASSERT_NE(reinterpret_cast<uintptr_t>(other_class_block) / allocator_slab::slab_size,
+              reinterpret_cast<uintptr_t>(blocks[0]) / allocator_slab::slab_size);
+
+    auto blocks_state = allocator_instance.get_blocks_info();
+    ASSERT_EQ(count_occupied_blocks(blocks_state), 4);
+    ASSERT_EQ(blocks_state.back(), (allocator_test_utils::block_info { .block_size = 2 * allocator_slab::slab_size, .is_block_occupied = false }));
+
+    // освобожденный блок выдается снова первым
+    allocator_instance.deallocate(blocks[1], 1);
+    ASSERT_EQ(allocator_instance.allocate(20, 8), blocks[1]);
+    ASSERT_EQ(blocks[0][23], 1);
+    ASSERT_EQ(blocks[2][0], 3);
+
+    for (auto *block : blocks)
+    {
+        allocator_instance.deallocate(block, 1);
+    }
+    allocator_instance.deallocate(other_class_block, 1);
+
+    // опустевшие слэбы возвращаются в свободные
+    std::vector<allocator_test_utils::block_info> expected_blocks_state = { { .block_size = 4 * allocator_slab::slab_size, .is_block_occupied = false } };
+    ASSERT_EQ(allocator_instance.get_blocks_info(), expected_blocks_state);
+
+    auto statistics = allocator_instance.get_statistics();
+    ASSERT_EQ(statistics.bytes_in_use, 0);
+    ASSERT_EQ(statistics.allocations, 5);
+    ASSERT_EQ(statistics.deallocations, 5);
+    ASSERT_EQ(statistics.largest_free_block, 4 * allocator_slab::slab_size);
+}
+
+TEST(allocatorSlabPositiveTests, test2)
+{
+    allocator_slab allocator_instance(8 * allocator_slab::slab_size);
+
+    auto *aligned_block = allocator_instance.allocate(40, 32);
+    ASSERT_EQ(reinterpret_cast<uintptr_t>(aligned_block) % 32, 0);
+
+    // большой или строго выровненный блок - серия целых слэбов
+    auto *large_block = allocator_instance.allocate(3 * allocator_slab::slab_size - 100);
+    ASSERT_EQ(reinterpret_cast<uintptr_t>(large_block) % allocator_slab::slab_size, 0);
+    auto *page_aligned_block = allocator_instance.allocate(100, 4096);
+    ASSERT_EQ(reinterpret_cast<uintptr_t>(page_aligned_block) % 4096, 0);
+
+    std::vector<allocator_test_utils::block_info> blocks_state = allocator_instance.get_blocks_info();
+    ASSERT_NE(std::find(blocks_state.begin(), blocks_state.end(),
+                        allocator_test_utils::block_info { .block_size = 3 * allocator_slab::slab_size, .is_block_occupied = true }),
+              blocks_state.end());
+
+    ASSERT_THROW(static_cast<void>(allocator_instance.allocate(4 * allocator_slab::slab_size)), std::bad_alloc);
+
+    int outside;
+    ASSERT_THROW(allocator_instance.deallocate(&outside, 1), std::logic_error);
+    ASSERT_THROW(allocator_instance.deallocate(reinterpret_cast<unsigned char *>(aligned_block) + 8, 1), std::logic_error);
+    ASSERT_THROW(allocator_instance.deallocate(reinterpret_cast<unsigned char *>(large_block) + allocator_slab::slab_size, 1), std::logic_error);
+
+    auto *neighbour_block = allocator_instance.allocate(40, 32);
+    allocator_instance.deallocate(aligned_block, 1);
+    ASSERT_THROW(allocator_instance.deallocate(aligned_block, 1), std::logic_error);
+
+    // пакет целиком или ничего
+    void *batch[8];
+    allocator_instance.allocate_batch(24, 8, batch, 8);
+    for (size_t i = 1; i < 8; ++i)
+    {
+        ASSERT_EQ(reinterpret_cast<unsigned char *>(batch[i]) - reinterpret_cast<unsigned char *>(batch[i - 1]), 24);
+    }
+
+    void *too_big_batch[4];
+    ASSERT_THROW(allocator_instance.allocate_batch(allocator_slab::slab_size, 4, too_big_batch), std::bad_alloc);
+    ASSERT_EQ(count_occupied_blocks(allocator_instance.get_blocks_info()), 11);
+
+    allocator_instance.deallocate_batch(batch, 8);
+    allocator_instance.deallocate(neighbour_block, 1);
+    allocator_instance.deallocate(large_block, 1);
+    allocator_instance.deallocate(page_aligned_block, 1);
+
+    std::vector<allocator_test_utils::block_info> expected_blocks_state = { { .block_size = 8 * allocator_slab::slab_size, .is_block_occupied = false } };
+    ASSERT_EQ(allocator_instance.get_blocks_info(), expected_blocks_state);
+    ASSERT_EQ(allocator_instance.get_statistics().bytes_in_use, 0);
+}
+
+TEST(allocatorSlabPositiveTests, test3)
+{
+    allocator_slab allocator_instance(1 << 20);
+
+    {
+        std::pmr::list<int> numbers(&allocator_instance);
+        for (int i = 0; i < 10'000; ++i)
+        {
+            numbers.push_back(i);
+        }
+        numbers.remove_if([](int number) { return number % 3 != 0; });
+
+        ASSERT_EQ(numbers.size(), 3'334);
+        ASSERT_EQ(numbers.back(), 9'999);
+    }
+
+    // слэбы заполнялись и освобождались по очереди, в конце все пусты
+    std::vector<allocator_test_utils::block_info> expected_blocks_state = { { .block_size = 1 << 20, .is_block_occupied = false } };
+    ASSERT_EQ(allocator_instance.get_blocks_info(), expected_blocks_state);
+
+    // первый блок пустого пространства выдается с начала первого слэба снова
+    auto *first_block = allocator_instance.allocate(8, 8);
+    auto *second_block = allocator_instance.allocate(8, 8);
+    ASSERT_EQ(reinterpret_cast<unsigned char *>(second_block) - reinterpret_cast<unsigned char *>(first_block), 8);
+    allocator_instance.deallocate(first_block, 1);
+    allocator_instance.deallocate(second_block, 1);
+}
+
+TEST(allocatorSlabPositiveTests, test4)
+{
+    // порог по умолчанию длиннее одного слэба
+    os_memory_resource os_memory;
+    allocator_slab allocator_instance(6 * allocator_slab::slab_size, &os_memory);
+
+    // по 31 блоку в слэбе, занято четыре слэба
+    std::vector<unsigned char *> blocks;
+    for (size_t i = 0; i < 124; ++i)
+    {
+        blocks.push_back(reinterpret_cast<unsigned char *>(allocator_instance.allocate(1000)));
+        std::memset(blocks.back(), 7, 1000);
+    }
+    ASSERT_EQ(blocks[30] - blocks[0], 30 * 1024);
+    ASSERT_NE(blocks[31] - blocks[30], 1024);
+
+    auto deallocate_slab = [&](size_t slab)
+    {
+        for (size_t i = slab * 31; i < (slab + 1) * 31; ++i)
+        {
+            allocator_instance.deallocate(blocks[i], 1);
+        }
+    };
+
+    // первый опустевший слэб остается за классом, одиночный свободный слэб короче порога
+    deallocate_slab(0);
+    deallocate_slab(1);
+    ASSERT_EQ(blocks[0][0], 7);
+    ASSERT_EQ(blocks[31][0], 7);
+
+    // два свободных слэба подряд уже не короче порога и отдают страницы вместе
+    deallocate_slab(2);
+#ifdef __linux__
+    ASSERT_EQ(blocks[31][0], 0);
+    ASSERT_EQ(blocks[92][999], 0);
+#endif
+    ASSERT_EQ(blocks[0][0], 7);
+    ASSERT_EQ(blocks[93][0], 7);
+
+    deallocate_slab(3);
+#ifdef __linux__
+    ASSERT_EQ(blocks[123][0], 0);
+#endif
+
+    auto statistics = allocator_instance.get_statistics();
+    ASSERT_EQ(statistics.bytes_in_use, 0);
+    ASSERT_EQ(statistics.largest_free_block, 6 * allocator_slab::slab_size);
+}
+
+TEST(allocatorSlabPositiveTests, test5)
+{
+    allocator_slab allocator_instance(3 * allocator_slab::slab_size);
+    auto *first_slab = reinterpret_cast<unsigned char *>(allocator_instance.allocate(3 * allocator_slab::slab_size));
+    allocator_instance.deallocate(first_slab, 1);
+
+    // пустой слэб остается за классом, блок на границе слэба не гоняет его туда и обратно
+    auto *small_block = allocator_instance.allocate(24);
+    ASSERT_LT(reinterpret_cast<unsigned char *>(small_block) - first_slab, static_cast<ptrdiff_t>(allocator_slab::slab_size));
+    allocator_instance.deallocate(small_block, 1);
+    ASSERT_EQ(allocator_instance.allocate(24), small_block);
+    allocator_instance.deallocate(small_block, 1);
+
+    // другой класс берет свободный слэб, а не оставленный
+    auto *other_class_block = reinterpret_cast<unsigned char *>(allocator_instance.allocate(100));
+    ASSERT_EQ((other_class_block - first_slab) / allocator_slab::slab_size, 1);
+    auto *third_class_block = reinterpret_cast<unsigned char *>(allocator_instance.allocate(40));
+    ASSERT_EQ((third_class_block - first_slab) / allocator_slab::slab_size, 2);
+    ASSERT_EQ(allocator_instance.get_statistics().largest_free_block, allocator_slab::slab_size);
+
+    // свободных слэбов не осталось, пустой слэб первого класса отдается четвертому
+    auto *fourth_class_block = reinterpret_cast<unsigned char *>(allocator_instance.allocate(64));
+    ASSERT_EQ(fourth_class_block, first_slab + (reinterpret_cast<unsigned char *>(small_block) - first_slab));
+    ASSERT_EQ(allocator_instance.get_statistics().largest_free_block, 112);
+
+    allocator_instance.deallocate(other_class_block, 1);
+    allocator_instance.deallocate(third_class_block, 1);
+    allocator_instance.deallocate(fourth_class_block, 1);
+
+    // оставленные классам слэбы считаются свободными и забираются серией
+    std::vector<allocator_test_utils::block_info> expected_blocks_state = { { .block_size = 3 * allocator_slab::slab_size, .is_block_occupied = false } };
+    ASSERT_EQ(allocator_instance.get_blocks_info(), expected_blocks_state);
+    ASSERT_EQ(allocator_instance.get_statistics().largest_free_block, 3 * allocator_slab::slab_size);
+
+    ASSERT_EQ(allocator_instance.allocate(3 * allocator_slab::slab_size), first_slab);
+    allocator_instance.deallocate(first_slab, 1);
+    ASSERT_EQ(allocator_instance.get_blocks_info(), expected_blocks_state);
+    ASSERT_EQ(allocator_instance.get_statistics().bytes_in_use, 0);
+}
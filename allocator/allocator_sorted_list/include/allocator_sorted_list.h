@@ -3,8 +3,10 @@
 
 #include <pp_allocator.h>
 #include <allocator_test_utils.h>
+#include <allocator_statistics.h>
 #include <allocator_with_fit_mode.h>
-#include <logger_guardant.h>
+#include <allocator_logger_guardant.h>
+#include <remote_free_queue.h>
 #include <typename_holder.h>
 #include <iterator>
 #include <mutex>
@@ -12,8 +14,9 @@
 class allocator_sorted_list final:
     public smart_mem_resource,
     public allocator_test_utils,
+    public allocator_statistics,
     public allocator_with_fit_mode,
-    private logger_guardant,
+    private allocator_logger_guardant,
     private typename_holder
 {
 
@@ -21,10 +24,43 @@ private:
     
     void *_trusted_memory;
 
-    static constexpr const size_t allocator_metadata_size = sizeof(logger*) + sizeof(std::pmr::memory_resource *) + sizeof(fit_mode) + sizeof(size_t) + sizeof(std::mutex) + sizeof(void*);
+    // структура меты: логгер, родительский аллокатор, фит мод, размер пространства, мьютекс, первый свободный блок,
+    // блуждающий указатель next_fit, очередь освобождений из других потоков (выровнена), счетчики статистики (выровнены)
+
+    // структура меты блока: размер данных с флагами в старших битах (блок свободен, свободен блок слева),
+    // следующий свободный блок (для занятого - указатель на аллокатор);
+    // у свободного блока в начале данных лежит указатель на предыдущий свободный блок, в конце - размер данных
+
+    /**
+     * Free blocks form a doubly linked list. A freed block finds its free neighbours by address: the right one
+     * by its header, the left one by the size at the end of its data, which the flag in the freed block's header
+     * tells to be there. A block merged with a neighbour takes its place in the list, a block with no free
+     * neighbours goes to the head, so the list is in the order of frees rather than of addresses.
+     */
+    static constexpr const size_t free_head_offset = sizeof(logger*) + sizeof(std::pmr::memory_resource *) + sizeof(fit_mode) + sizeof(size_t) + sizeof(std::mutex);
+
+    static constexpr const size_t remote_frees_offset = (free_head_offset + sizeof(void*) + sizeof(void*) +
+                                                         alignof(remote_free_queue) - 1) & ~(alignof(remote_free_queue) - 1);
+
+    static constexpr const size_t counters_offset = (remote_frees_offset + sizeof(remote_free_queue) +
+                                                     alignof(allocator_statistics::counters) - 1) & ~(alignof(allocator_statistics::counters) - 1);
+
+    // пространство начинается с выравнивания max_align_t, как и память от родителя
+    static constexpr const size_t allocator_metadata_size = (counters_offset + sizeof(allocator_statistics::counters) +
+                                                             alignof(std::max_align_t) - 1) & ~(alignof(std::max_align_t) - 1);
 
     static constexpr const size_t block_metadata_size = sizeof(void*) + sizeof(size_t);
 
+    static_assert(allocator_metadata_size % alignof(std::max_align_t) == 0, "the first block must start aligned");
+
+    static constexpr const size_t min_block_data_size = sizeof(void*) + sizeof(size_t);
+
+    static constexpr const size_t free_flag = size_t(1) << (sizeof(size_t) * 8 - 1);
+
+    static constexpr const size_t prev_free_flag = free_flag >> 1;
+
+    static constexpr const size_t flags_mask = free_flag | prev_free_flag;
+
 public:
 
     explicit allocator_sorted_list(
@@ -49,7 +85,16 @@ public:
     
     [[nodiscard]] void *do_allocate_sm(
         size_t size) override;
+
+    [[nodiscard]] void *do_allocate_aligned_sm(
+        size_t size,
+        size_t alignment) override;
     
+    /**
+     * When another thread holds the lock, the block is checked to be this allocator's one and put
+     * into the remote free queue instead of waiting; the next thread to take the lock frees it.
+     * Until then the block is still counted and listed as occupied.
+     */
     void do_deallocate_sm(
         void *at) override;
 
@@ -60,6 +105,8 @@ public:
 
     std::vector<allocator_test_utils::block_info> get_blocks_info() const noexcept override;
 
+    statistics_snapshot get_statistics() const noexcept override;
+
 private:
 
     std::vector<allocator_test_utils::block_info> get_blocks_info_inner() const override;
@@ -68,6 +115,58 @@ private:
     
     inline std::string get_typename() const override;
 
+    inline std::mutex *get_mutex() const noexcept;
+
+    inline allocator_statistics::counters &get_counters() const noexcept;
+
+    inline remote_free_queue &get_remote_frees() const noexcept;
+
+    // frees a block under the lock taken by the caller
+    void deallocate_block(void *at);
+
+    // frees the blocks other threads queued, under the lock taken by the caller
+    void drain_remote_frees();
+
+    std::unique_lock<std::mutex> lock_and_drain();
+
+    // queues a block of this allocator without the lock, the link replaces the allocator pointer in its meta
+    bool defer_deallocation(void *at);
+
+    size_t get_largest_free_block_size() const noexcept;
+
+    inline allocator_with_fit_mode::fit_mode get_fit_mode() const noexcept;
+
+    inline size_t get_space_size() const noexcept;
+
+    inline void *get_first_block() const noexcept;
+
+    inline void *&get_free_head() const noexcept;
+
+    inline void *&get_rover() const noexcept;
+
+    static inline size_t &get_block_header(void *block) noexcept;
+
+    static inline size_t get_block_size(void *block) noexcept;
+
+    static inline void *&get_block_ptr(void *block) noexcept;
+
+    static inline void *&get_free_prev(void *block) noexcept;
+
+    bool is_free_block(void *block) const noexcept;
+
+    // the header and the size at the end of a free block, the block after it is marked to have a free left neighbour
+    void mark_free_block(void *block, size_t size) noexcept;
+
+    void link_free_block(void *block, void *prev, void *next) noexcept;
+
+    void unlink_free_block(void *block) noexcept;
+
+    void *find_free_block(size_t size, allocator_with_fit_mode::fit_mode mode) const noexcept;
+
+    void *allocate_from_free_block(void *block, size_t size, size_t alignment) noexcept;
+
+    size_t get_free_size_inner() const noexcept;
+
     class sorted_free_iterator
     {
         void* _free_ptr;
@@ -99,7 +198,6 @@ private:
 
     class sorted_iterator
     {
-        void* _free_ptr;
         void* _current_ptr;
         void* _trusted_memory;
 
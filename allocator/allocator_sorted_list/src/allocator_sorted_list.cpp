@@ -1,190 +1,822 @@
-#include <not_implemented.h>
 #include "../include/allocator_sorted_list.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+using byte = unsigned char;
 
 allocator_sorted_list::~allocator_sorted_list()
 {
-    throw not_implemented("allocator_sorted_list::~allocator_sorted_list()", "your code should be here...");
+    if (_trusted_memory == nullptr)
+    {
+        return;
+    }
+
+    debug_with_guard("Called allocator destructor");
+
+    auto *parent_allocator = *reinterpret_cast<std::pmr::memory_resource **>(reinterpret_cast<byte *>(_trusted_memory) + sizeof(logger *));
+    size_t memory_size = get_space_size() + allocator_metadata_size;
+
+    get_mutex()->~mutex();
+
+    if (parent_allocator == nullptr)
+    {
+        ::operator delete(_trusted_memory);
+    }
+    else
+    {
+        parent_allocator->deallocate(_trusted_memory, memory_size);
+    }
 }
 
 allocator_sorted_list::allocator_sorted_list(
     allocator_sorted_list &&other) noexcept
 {
-    throw not_implemented("allocator_sorted_list::allocator_sorted_list(allocator_sorted_list &&) noexcept", "your code should be here...");
+    _trusted_memory = other._trusted_memory;
+    other._trusted_memory = nullptr;
 }
 
 allocator_sorted_list &allocator_sorted_list::operator=(
     allocator_sorted_list &&other) noexcept
 {
-    throw not_implemented("allocator_sorted_list &allocator_sorted_list::operator=(allocator_sorted_list &&) noexcept", "your code should be here...");
+    if (this != &other)
+    {
+        std::swap(_trusted_memory, other._trusted_memory);
+    }
+
+    return *this;
 }
 
+/** If parent_allocator* == nullptr the global heap is used
+ */
 allocator_sorted_list::allocator_sorted_list(
         size_t space_size,
         std::pmr::memory_resource *parent_allocator,
         logger *logger,
         allocator_with_fit_mode::fit_mode allocate_fit_mode)
 {
-    throw not_implemented("allocator_sorted_list::allocator_sorted_list(size_t, std::pmr::memory_resource *,logger *,allocator_with_fit_mode::fit_mode)", "your code should be here...");
+    if (space_size < block_metadata_size + min_block_data_size)
+    {
+        throw std::logic_error("space_size must be at least " + std::to_string(block_metadata_size + min_block_data_size));
+    }
+
+    size_t memory_size = space_size + allocator_metadata_size;
+
+    _trusted_memory = parent_allocator == nullptr
+            ? ::operator new(memory_size)
+            : parent_allocator->allocate(memory_size, alignof(std::max_align_t));
+
+    byte *ptr = reinterpret_cast<byte *>(_trusted_memory);
+
+    *reinterpret_cast<class logger **>(ptr) = logger;
+    ptr += sizeof(class logger *);
+
+    *reinterpret_cast<std::pmr::memory_resource **>(ptr) = parent_allocator;
+    ptr += sizeof(std::pmr::memory_resource *);
+
+    *reinterpret_cast<allocator_with_fit_mode::fit_mode *>(ptr) = allocate_fit_mode;
+    ptr += sizeof(allocator_with_fit_mode::fit_mode);
+
+    *reinterpret_cast<size_t *>(ptr) = space_size;
+    ptr += sizeof(size_t);
+
+    new (ptr) std::mutex;
+    ptr += sizeof(std::mutex);
+
+    new (reinterpret_cast<byte *>(_trusted_memory) + remote_frees_offset) remote_free_queue;
+
+    new (reinterpret_cast<byte *>(_trusted_memory) + counters_offset) allocator_statistics::counters(space_size);
+
+    void *block = get_first_block();
+
+    get_free_head() = nullptr;
+    get_rover() = nullptr;
+    mark_free_block(block, space_size - block_metadata_size);
+    link_free_block(block, nullptr, nullptr);
+
+    debug_with_guard("allocator_sorted_list created");
 }
 
 [[nodiscard]] void *allocator_sorted_list::do_allocate_sm(
     size_t size)
 {
-    throw not_implemented("[[nodiscard]] void *allocator_sorted_list::do_allocate_sm(size_t)", "your code should be here...");
+    return do_allocate_aligned_sm(size, 1);
 }
 
+/** For alignment the search asks for alignment - 1 more bytes plus room for a free block in front,
+ * so the padding before the aligned block can always stay a free block of its own.
+ */
+[[nodiscard]] void *allocator_sorted_list::do_allocate_aligned_sm(
+    size_t size,
+    size_t alignment)
+{
+    debug_with_guard("do_allocate_sm start");
+
+    auto lock = lock_and_drain();
+
+    void *memory = nullptr;
+    size_t taken_size = 0;
+
+    if (size <= std::numeric_limits<size_t>::max() - 2 * (block_metadata_size + min_block_data_size) - alignment)
+    {
+        size_t needed = block_metadata_size + std::max(size, min_block_data_size);
+        if (alignment > 1)
+        {
+            needed += alignment - 1 + block_metadata_size + min_block_data_size;
+        }
+
+        void *block = find_free_block(needed, get_fit_mode());
+        if (block != nullptr)
+        {
+            taken_size = block_metadata_size + get_block_size(block);
+            memory = allocate_from_free_block(block, size, alignment);
+        }
+    }
+
+    if (memory == nullptr)
+    {
+        if (is_enabled_with_guard(logger::severity::error))
+        {
+            error_with_guard("Allocation failed for size " + std::to_string(size));
+        }
+        get_counters().on_failed_allocation();
+        throw std::bad_alloc();
+    }
+
+    get_counters().on_allocate(block_metadata_size + get_block_size(reinterpret_cast<byte *>(memory) - block_metadata_size));
+
+    // список обходится заново, только если был разрезан наибольший блок
+    if (taken_size >= get_counters().get_largest_free_block())
+    {
+        get_counters().set_largest_free_block(get_largest_free_block_size());
+    }
+
+    if (is_enabled_with_guard(logger::severity::information))
+    {
+        information_with_guard("Available free memory after allocation: " + std::to_string(get_free_size_inner()));
+    }
+
+    debug_with_guard("do_allocate_sm finish");
+
+    return memory;
+}
+
+/** Pointers inside the copied memory still point to the other allocator, so all of them are moved by the same distance
+ */
 allocator_sorted_list::allocator_sorted_list(const allocator_sorted_list &other)
 {
-    throw not_implemented("allocator_sorted_list::allocator_sorted_list(const allocator_sorted_list &other)", "your code should be here...");
+    if (other._trusted_memory == nullptr)
+    {
+        _trusted_memory = nullptr;
+        return;
+    }
+
+    // отложенные освобождения другого аллокатора доводятся до конца, чтобы копия их не унаследовала
+    auto lock = const_cast<allocator_sorted_list &>(other).lock_and_drain();
+
+    auto *parent_allocator = *reinterpret_cast<std::pmr::memory_resource **>(reinterpret_cast<byte *>(other._trusted_memory) + sizeof(logger *));
+    size_t memory_size = other.get_space_size() + allocator_metadata_size;
+
+    _trusted_memory = parent_allocator == nullptr
+            ? ::operator new(memory_size)
+            : parent_allocator->allocate(memory_size, alignof(std::max_align_t));
+
+    std::memcpy(_trusted_memory, other._trusted_memory, memory_size);
+    new (get_mutex()) std::mutex;
+    new (&get_remote_frees()) remote_free_queue;
+
+    auto rebase = [this, &other](void *&ptr)
+    {
+        if (ptr != nullptr)
+        {
+            ptr = reinterpret_cast<byte *>(_trusted_memory) + (reinterpret_cast<byte *>(ptr) - reinterpret_cast<byte *>(other._trusted_memory));
+        }
+    };
+
+    rebase(get_free_head());
+    rebase(get_rover());
+
+    for (auto it = begin(), last = end(); it != last; ++it)
+    {
+        void *block = *it;
+
+        if (it.occupied())
+        {
+            get_block_ptr(block) = _trusted_memory;
+        }
+        else
+        {
+            rebase(get_block_ptr(block));
+            rebase(get_free_prev(block));
+        }
+    }
 }
 
 allocator_sorted_list &allocator_sorted_list::operator=(const allocator_sorted_list &other)
 {
-    throw not_implemented("allocator_sorted_list &allocator_sorted_list::operator=(const allocator_sorted_list &other)", "your code should be here...");
+    if (this != &other)
+    {
+        allocator_sorted_list copy(other);
+        *this = std::move(copy);
+    }
+
+    return *this;
 }
 
 bool allocator_sorted_list::do_is_equal(const std::pmr::memory_resource &other) const noexcept
 {
-    throw not_implemented("bool allocator_sorted_list::do_is_equal(const std::pmr::memory_resource &other) const noexcept", "your code should be here...");
+    return this == &other;
 }
 
+/** Both free neighbours are found by address in constant time, the list is not walked.
+ */
 void allocator_sorted_list::do_deallocate_sm(
     void *at)
 {
-    throw not_implemented("void allocator_sorted_list::do_deallocate_sm(void *)", "your code should be here...");
+    debug_with_guard("do_deallocate_sm start");
+
+    auto lock = get_counters().try_lock(*get_mutex());
+    if (!lock.owns_lock())
+    {
+        if (defer_deallocation(at))
+        {
+            debug_with_guard("do_deallocate_sm deferred");
+            return;
+        }
+        lock = get_counters().lock(*get_mutex());
+    }
+
+    drain_remote_frees();
+    deallocate_block(at);
+
+    debug_with_guard("do_deallocate_sm finish");
+}
+
+void allocator_sorted_list::deallocate_block(
+    void *at)
+{
+    if (at == nullptr)
+    {
+        return;
+    }
+
+    void *block = reinterpret_cast<byte *>(at) - block_metadata_size;
+
+    if (get_block_ptr(block) != _trusted_memory)
+    {
+        error_with_guard("Tried to deallocate not allocator's property");
+        throw std::logic_error("Not allocator's property");
+    }
+
+    size_t size = get_block_size(block);
+    get_counters().on_deallocate(block_metadata_size + size);
+
+    void *right = reinterpret_cast<byte *>(block) + block_metadata_size + size;
+    bool right_free = is_free_block(right);
+
+    // размер свободного левого соседа лежит в последнем слове перед заголовком
+    void *left = (get_block_header(block) & prev_free_flag) == 0
+            ? nullptr
+            : reinterpret_cast<byte *>(block) - block_metadata_size - *(reinterpret_cast<size_t *>(block) - 1);
+
+    void *rover = get_rover();
+
+    if (right_free)
+    {
+        size += block_metadata_size + get_block_size(right);
+
+        if (left == nullptr)
+        {
+            // блок встает в список на место правого соседа
+            link_free_block(block, get_free_prev(right), get_block_ptr(right));
+        }
+        else
+        {
+            unlink_free_block(right);
+        }
+    }
+
+    if (left != nullptr)
+    {
+        size += block_metadata_size + get_block_size(left);
+        block = left;
+    }
+    else if (!right_free)
+    {
+        link_free_block(block, nullptr, get_free_head());
+    }
+
+    mark_free_block(block, size);
+
+    if (right_free && rover == right)
+    {
+        get_rover() = block;
+    }
+
+    if (block_metadata_size + get_block_size(block) > get_counters().get_largest_free_block())
+    {
+        get_counters().set_largest_free_block(block_metadata_size + get_block_size(block));
+    }
+
+    if (is_enabled_with_guard(logger::severity::information))
+    {
+        information_with_guard("Available free memory after deallocation: " + std::to_string(get_free_size_inner()));
+    }
+}
+
+void allocator_sorted_list::drain_remote_frees()
+{
+    void *node = get_remote_frees().take_all();
+
+    // связь лежит на месте указателя на аллокатор - последнего слова меты перед данными
+    while (node != nullptr)
+    {
+        void *next = remote_free_queue::next(node);
+
+        *reinterpret_cast<void **>(node) = _trusted_memory;
+        get_counters().on_remote_free();
+        deallocate_block(reinterpret_cast<byte *>(node) + sizeof(void *));
+
+        node = next;
+    }
+}
+
+std::unique_lock<std::mutex> allocator_sorted_list::lock_and_drain()
+{
+    auto lock = get_counters().lock(*get_mutex());
+    drain_remote_frees();
+    return lock;
+}
+
+bool allocator_sorted_list::defer_deallocation(
+    void *at)
+{
+    if (at == nullptr)
+    {
+        return false;
+    }
+
+    // занятый блок никто, кроме освобождающего, не меняет; чужой или уже отложенный блок
+    // освобождается под блокировкой и там же отвергается
+    void *block = reinterpret_cast<byte *>(at) - block_metadata_size;
+    if (get_block_ptr(block) != _trusted_memory)
+    {
+        return false;
+    }
+
+    get_remote_frees().push(&get_block_ptr(block));
+    return true;
 }
 
 inline void allocator_sorted_list::set_fit_mode(
     allocator_with_fit_mode::fit_mode mode)
 {
-    throw not_implemented("inline void allocator_sorted_list::set_fit_mode(allocator_with_fit_mode::fit_mode)", "your code should be here...");
+    std::lock_guard lock(*get_mutex());
+
+    *reinterpret_cast<allocator_with_fit_mode::fit_mode *>(reinterpret_cast<byte *>(_trusted_memory) + sizeof(logger *) + sizeof(std::pmr::memory_resource *)) = mode;
 }
 
 std::vector<allocator_test_utils::block_info> allocator_sorted_list::get_blocks_info() const noexcept
 {
-    throw not_implemented("std::vector<allocator_test_utils::block_info> allocator_sorted_list::get_blocks_info() const noexcept", "your code should be here...");
+    std::lock_guard lock(*get_mutex());
+
+    return get_blocks_info_inner();
 }
 
 inline logger *allocator_sorted_list::get_logger() const
 {
-    throw not_implemented("inline logger *allocator_sorted_list::get_logger() const", "your code should be here...");
+    return *reinterpret_cast<logger **>(_trusted_memory);
 }
 
 inline std::string allocator_sorted_list::get_typename() const
 {
-    throw not_implemented("inline std::string allocator_sorted_list::get_typename() const", "your code should be here...");
+    return "allocator_sorted_list";
 }
 
-
 std::vector<allocator_test_utils::block_info> allocator_sorted_list::get_blocks_info_inner() const
 {
-    throw not_implemented("std::vector<allocator_test_utils::block_info> allocator_sorted_list::get_blocks_info_inner() const", "your code should be here...");
+    std::vector<allocator_test_utils::block_info> result;
+
+    for (auto it = begin(), last = end(); it != last; ++it)
+    {
+        result.push_back({ it.size(), it.occupied() });
+    }
+
+    return result;
+}
+
+size_t allocator_sorted_list::get_free_size_inner() const noexcept
+{
+    size_t free_size = 0;
+
+    for (auto it = free_begin(), last = free_end(); it != last; ++it)
+    {
+        free_size += it.size();
+    }
+
+    return free_size;
+}
+
+inline std::mutex *allocator_sorted_list::get_mutex() const noexcept
+{
+    byte *ptr = reinterpret_cast<byte *>(_trusted_memory);
+
+    ptr += sizeof(logger *);
+    ptr += sizeof(std::pmr::memory_resource *);
+    ptr += sizeof(allocator_with_fit_mode::fit_mode);
+    ptr += sizeof(size_t);
+
+    return reinterpret_cast<std::mutex *>(ptr);
+}
+
+inline allocator_with_fit_mode::fit_mode allocator_sorted_list::get_fit_mode() const noexcept
+{
+    return *reinterpret_cast<allocator_with_fit_mode::fit_mode *>(reinterpret_cast<byte *>(_trusted_memory) + sizeof(logger *) + sizeof(std::pmr::memory_resource *));
+}
+
+inline size_t allocator_sorted_list::get_space_size() const noexcept
+{
+    byte *ptr = reinterpret_cast<byte *>(_trusted_memory);
+
+    ptr += sizeof(logger *);
+    ptr += sizeof(std::pmr::memory_resource *);
+    ptr += sizeof(allocator_with_fit_mode::fit_mode);
+
+    return *reinterpret_cast<size_t *>(ptr);
+}
+
+inline remote_free_queue &allocator_sorted_list::get_remote_frees() const noexcept
+{
+    return *reinterpret_cast<remote_free_queue *>(reinterpret_cast<byte *>(_trusted_memory) + remote_frees_offset);
+}
+
+inline allocator_statistics::counters &allocator_sorted_list::get_counters() const noexcept
+{
+    return *reinterpret_cast<allocator_statistics::counters *>(reinterpret_cast<byte *>(_trusted_memory) + counters_offset);
+}
+
+size_t allocator_sorted_list::get_largest_free_block_size() const noexcept
+{
+    size_t largest = 0;
+
+    for (void *block = get_free_head(); block != nullptr; block = get_block_ptr(block))
+    {
+        largest = std::max(largest, block_metadata_size + get_block_size(block));
+    }
+
+    return largest;
+}
+
+allocator_statistics::statistics_snapshot allocator_sorted_list::get_statistics() const noexcept
+{
+    return _trusted_memory == nullptr ? statistics_snapshot {} : get_counters().snapshot();
+}
+
+inline void *allocator_sorted_list::get_first_block() const noexcept
+{
+    return reinterpret_cast<byte *>(_trusted_memory) + allocator_metadata_size;
+}
+
+inline void *&allocator_sorted_list::get_free_head() const noexcept
+{
+    return *reinterpret_cast<void **>(reinterpret_cast<byte *>(_trusted_memory) + free_head_offset);
+}
+
+inline void *&allocator_sorted_list::get_rover() const noexcept
+{
+    return *(&get_free_head() + 1);
+}
+
+inline size_t &allocator_sorted_list::get_block_header(void *block) noexcept
+{
+    return *reinterpret_cast<size_t *>(block);
+}
+
+inline size_t allocator_sorted_list::get_block_size(void *block) noexcept
+{
+    return get_block_header(block) & ~flags_mask;
+}
+
+inline void *&allocator_sorted_list::get_block_ptr(void *block) noexcept
+{
+    return *reinterpret_cast<void **>(reinterpret_cast<byte *>(block) + sizeof(size_t));
+}
+
+inline void *&allocator_sorted_list::get_free_prev(void *block) noexcept
+{
+    return *reinterpret_cast<void **>(reinterpret_cast<byte *>(block) + block_metadata_size);
+}
+
+/** The header of a block is changed only under the lock, the remote free queue links a block
+ * in place of the allocator pointer, so the flag is read safely while other threads queue blocks
+ */
+bool allocator_sorted_list::is_free_block(void *block) const noexcept
+{
+    return reinterpret_cast<byte *>(block) < reinterpret_cast<byte *>(get_first_block()) + get_space_size() &&
+           (get_block_header(block) & free_flag) != 0;
+}
+
+void allocator_sorted_list::mark_free_block(void *block, size_t size) noexcept
+{
+    get_block_header(block) = size | free_flag;
+    *reinterpret_cast<size_t *>(reinterpret_cast<byte *>(block) + block_metadata_size + size - sizeof(size_t)) = size;
+
+    void *right = reinterpret_cast<byte *>(block) + block_metadata_size + size;
+    if (right < reinterpret_cast<byte *>(get_first_block()) + get_space_size())
+    {
+        get_block_header(right) |= prev_free_flag;
+    }
+}
+
+void allocator_sorted_list::link_free_block(void *block, void *prev, void *next) noexcept
+{
+    get_block_ptr(block) = next;
+    get_free_prev(block) = prev;
+
+    if (prev == nullptr)
+    {
+        get_free_head() = block;
+    }
+    else
+    {
+        get_block_ptr(prev) = block;
+    }
+
+    if (next != nullptr)
+    {
+        get_free_prev(next) = block;
+    }
+}
+
+void allocator_sorted_list::unlink_free_block(void *block) noexcept
+{
+    void *prev = get_free_prev(block);
+    void *next = get_block_ptr(block);
+
+    if (prev == nullptr)
+    {
+        get_free_head() = next;
+    }
+    else
+    {
+        get_block_ptr(prev) = next;
+    }
+
+    if (next != nullptr)
+    {
+        get_free_prev(next) = prev;
+    }
+
+    if (get_rover() == block)
+    {
+        get_rover() = next;
+    }
+}
+
+/** The list is in the order of frees, see deallocate_block(): first_fit takes the fitting block freed last
+ * among the ones with no free neighbours at their free, next_fit goes on along the list from the block
+ * the previous allocation stopped at and wraps around to its head; the_best_fit and the_worst_fit look
+ * through the whole list.
+ */
+void *allocator_sorted_list::find_free_block(size_t size, allocator_with_fit_mode::fit_mode mode) const noexcept
+{
+    void *found = nullptr;
+
+    switch (mode)
+    {
+        case allocator_with_fit_mode::fit_mode::next_fit:
+            for (void *block = get_rover(); block != nullptr; block = get_block_ptr(block))
+            {
+                if (block_metadata_size + get_block_size(block) >= size)
+                {
+                    return block;
+                }
+            }
+            for (void *block = get_free_head(); block != get_rover(); block = get_block_ptr(block))
+            {
+                if (block_metadata_size + get_block_size(block) >= size)
+                {
+                    return block;
+                }
+            }
+            return nullptr;
+
+        case allocator_with_fit_mode::fit_mode::first_fit:
+            for (void *block = get_free_head(); block != nullptr; block = get_block_ptr(block))
+            {
+                if (block_metadata_size + get_block_size(block) >= size)
+                {
+                    return block;
+                }
+            }
+            return nullptr;
+
+        case allocator_with_fit_mode::fit_mode::the_best_fit:
+            for (void *block = get_free_head(); block != nullptr; block = get_block_ptr(block))
+            {
+                if (block_metadata_size + get_block_size(block) >= size && (found == nullptr || get_block_size(block) < get_block_size(found)))
+                {
+                    found = block;
+                }
+            }
+            return found;
+
+        case allocator_with_fit_mode::fit_mode::the_worst_fit:
+            for (void *block = get_free_head(); block != nullptr; block = get_block_ptr(block))
+            {
+                if (found == nullptr || get_block_size(block) > get_block_size(found))
+                {
+                    found = block;
+                }
+            }
+            return found != nullptr && block_metadata_size + get_block_size(found) >= size ? found : nullptr;
+    }
+
+    return nullptr;
+}
+
+/** The block is placed at the start of the free one (or after the alignment padding, which stays free),
+ * the rest stays free if it can hold a free block and is given to the allocated block otherwise.
+ * The roving pointer moves to the free block right after the allocated one.
+ */
+void *allocator_sorted_list::allocate_from_free_block(void *block, size_t size, size_t alignment) noexcept
+{
+    size_t block_size = block_metadata_size + get_block_size(block);
+    void *prev = get_free_prev(block);
+    void *next = get_block_ptr(block);
+
+    unlink_free_block(block);
+
+    size_t padding = -reinterpret_cast<std::uintptr_t>(reinterpret_cast<byte *>(block) + block_metadata_size) & (alignment - 1);
+    while (padding != 0 && padding < block_metadata_size + min_block_data_size)
+    {
+        padding += alignment;
+    }
+
+    // слева от свободного блока занятый, так что флаг слева свободного есть только за отступом
+    size_t prev_free = 0;
+
+    if (padding != 0)
+    {
+        mark_free_block(block, padding - block_metadata_size);
+        link_free_block(block, prev, next);
+
+        prev = block;
+        block = reinterpret_cast<byte *>(block) + padding;
+        block_size -= padding;
+        prev_free = prev_free_flag;
+    }
+
+    size_t data_size = std::max(size, min_block_data_size);
+    size_t rest = block_size - block_metadata_size - data_size;
+
+    if (rest >= block_metadata_size + min_block_data_size)
+    {
+        void *rest_block = reinterpret_cast<byte *>(block) + block_metadata_size + data_size;
+        mark_free_block(rest_block, rest - block_metadata_size);
+        link_free_block(rest_block, prev, next);
+        next = rest_block;
+    }
+    else
+    {
+        data_size += rest;
+
+        void *right = reinterpret_cast<byte *>(block) + block_size;
+        if (right < reinterpret_cast<byte *>(get_first_block()) + get_space_size())
+        {
+            get_block_header(right) &= ~prev_free_flag;
+        }
+    }
+
+    get_block_header(block) = data_size | prev_free;
+    get_block_ptr(block) = _trusted_memory;
+    get_rover() = next;
+
+    return reinterpret_cast<byte *>(block) + block_metadata_size;
 }
 
 allocator_sorted_list::sorted_free_iterator allocator_sorted_list::free_begin() const noexcept
 {
-    throw not_implemented("allocator_sorted_list::sorted_free_iterator allocator_sorted_list::free_begin() const noexcept", "your code should be here...");
+    return sorted_free_iterator(_trusted_memory);
 }
 
 allocator_sorted_list::sorted_free_iterator allocator_sorted_list::free_end() const noexcept
 {
-    throw not_implemented("allocator_sorted_list::sorted_free_iterator allocator_sorted_list::free_end() const noexcept", "your code should be here...");
+    return sorted_free_iterator();
 }
 
 allocator_sorted_list::sorted_iterator allocator_sorted_list::begin() const noexcept
 {
-    throw not_implemented("allocator_sorted_list::sorted_iterator allocator_sorted_list::begin() const noexcept", "your code should be here...");
+    return sorted_iterator(_trusted_memory);
 }
 
 allocator_sorted_list::sorted_iterator allocator_sorted_list::end() const noexcept
 {
-    throw not_implemented("allocator_sorted_list::sorted_iterator allocator_sorted_list::end() const noexcept", "your code should be here...");
+    return sorted_iterator();
 }
 
 
 bool allocator_sorted_list::sorted_free_iterator::operator==(
         const allocator_sorted_list::sorted_free_iterator & other) const noexcept
 {
-    throw not_implemented("bool allocator_sorted_list::sorted_free_iterator::operator==(const allocator_sorted_list::sorted_free_iterator &) const noexcept", "your code should be here...");
+    return _free_ptr == other._free_ptr;
 }
 
 bool allocator_sorted_list::sorted_free_iterator::operator!=(
         const allocator_sorted_list::sorted_free_iterator &other) const noexcept
 {
-    throw not_implemented("bool allocator_sorted_list::sorted_free_iterator::operator!=(const allocator_sorted_list::sorted_free_iterator &) const noexcept", "your code should be here...");
+    return !(*this == other);
 }
 
 allocator_sorted_list::sorted_free_iterator &allocator_sorted_list::sorted_free_iterator::operator++() & noexcept
 {
-    throw not_implemented("allocator_sorted_list::sorted_free_iterator &allocator_sorted_list::sorted_free_iterator::operator++() & noexcept", "your code should be here...");
+    _free_ptr = get_block_ptr(_free_ptr);
+    return *this;
 }
 
 allocator_sorted_list::sorted_free_iterator allocator_sorted_list::sorted_free_iterator::operator++(int n)
 {
-    throw not_implemented("allocator_sorted_list::sorted_free_iterator allocator_sorted_list::sorted_free_iterator::operator++(int)", "your code should be here...");
+    auto copy = *this;
+    ++*this;
+    return copy;
 }
 
 size_t allocator_sorted_list::sorted_free_iterator::size() const noexcept
 {
-    throw not_implemented("size_t allocator_sorted_list::sorted_free_iterator::size() const noexcept", "your code should be here...");
+    return block_metadata_size + get_block_size(_free_ptr);
 }
 
 void *allocator_sorted_list::sorted_free_iterator::operator*() const noexcept
 {
-    throw not_implemented("void *allocator_sorted_list::sorted_free_iterator::operator*() const noexcept", "your code should be here...");
+    return _free_ptr;
 }
 
-allocator_sorted_list::sorted_free_iterator::sorted_free_iterator()
+allocator_sorted_list::sorted_free_iterator::sorted_free_iterator():
+    _free_ptr(nullptr)
 {
-    throw not_implemented("allocator_sorted_list::sorted_free_iterator::sorted_free_iterator()", "your code should be here...");
 }
 
-allocator_sorted_list::sorted_free_iterator::sorted_free_iterator(void *trusted)
+allocator_sorted_list::sorted_free_iterator::sorted_free_iterator(void *trusted):
+    _free_ptr(*reinterpret_cast<void **>(reinterpret_cast<byte *>(trusted) + free_head_offset))
 {
-    throw not_implemented("allocator_sorted_list::sorted_free_iterator::sorted_free_iterator(void *)", "your code should be here...");
 }
 
 bool allocator_sorted_list::sorted_iterator::operator==(const allocator_sorted_list::sorted_iterator & other) const noexcept
 {
-    throw not_implemented("bool allocator_sorted_list::sorted_iterator::operator==(const allocator_sorted_list::sorted_iterator &) const noexcept", "your code should be here...");
+    return _current_ptr == other._current_ptr;
 }
 
 bool allocator_sorted_list::sorted_iterator::operator!=(const allocator_sorted_list::sorted_iterator &other) const noexcept
 {
-    throw not_implemented("bool allocator_sorted_list::sorted_iterator::operator!=(const allocator_sorted_list::sorted_iterator &) const noexcept", "your code should be here...");
+    return !(*this == other);
 }
 
 allocator_sorted_list::sorted_iterator &allocator_sorted_list::sorted_iterator::operator++() & noexcept
 {
-    throw not_implemented("allocator_sorted_list::sorted_iterator &allocator_sorted_list::sorted_iterator::operator++() & noexcept", "your code should be here...");
+    size_t space_size = *reinterpret_cast<size_t *>(reinterpret_cast<byte *>(_trusted_memory) + sizeof(logger *) + sizeof(std::pmr::memory_resource *) + sizeof(allocator_with_fit_mode::fit_mode));
+    byte *space_end = reinterpret_cast<byte *>(_trusted_memory) + allocator_metadata_size + space_size;
+
+    _current_ptr = reinterpret_cast<byte *>(_current_ptr) + block_metadata_size + get_block_size(_current_ptr);
+
+    if (_current_ptr == space_end)
+    {
+        _current_ptr = nullptr;
+    }
+
+    return *this;
 }
 
 allocator_sorted_list::sorted_iterator allocator_sorted_list::sorted_iterator::operator++(int n)
 {
-    throw not_implemented("allocator_sorted_list::sorted_iterator allocator_sorted_list::sorted_iterator::operator++(int)", "your code should be here...");
+    auto copy = *this;
+    ++*this;
+    return copy;
 }
 
 size_t allocator_sorted_list::sorted_iterator::size() const noexcept
 {
-    throw not_implemented("size_t allocator_sorted_list::sorted_iterator::size() const noexcept", "your code should be here...");
+    return block_metadata_size + get_block_size(_current_ptr);
 }
 
 void *allocator_sorted_list::sorted_iterator::operator*() const noexcept
 {
-    throw not_implemented("void *allocator_sorted_list::sorted_iterator::operator*() const noexcept", "your code should be here...");
+    return _current_ptr;
 }
 
-allocator_sorted_list::sorted_iterator::sorted_iterator()
+allocator_sorted_list::sorted_iterator::sorted_iterator():
+    _current_ptr(nullptr),
+    _trusted_memory(nullptr)
 {
-    throw not_implemented("allocator_sorted_list::sorted_iterator::sorted_iterator() ", "your code should be here...");
 }
 
-allocator_sorted_list::sorted_iterator::sorted_iterator(void *trusted)
+allocator_sorted_list::sorted_iterator::sorted_iterator(void *trusted):
+    _current_ptr(reinterpret_cast<byte *>(trusted) + allocator_metadata_size),
+    _trusted_memory(trusted)
 {
-    throw not_implemented("allocator_sorted_list::sorted_iterator::sorted_iterator(void *)", "your code should be here...");
 }
 
 bool allocator_sorted_list::sorted_iterator::occupied() const noexcept
 {
-    throw not_implemented("bool allocator_sorted_list::sorted_iterator::occupied() const noexcept", "your code should be here...");
+    return (get_block_header(_current_ptr) & free_flag) == 0;
 }
@@ -2,10 +2,38 @@
 #include <logger.h>
 #include <logger_builder.h>
 #include <client_logger_builder.h>
+#include <cstdint>
 #include <list>
+#include <new>
 
 #include "../include/allocator_sorted_list.h"
 
+namespace
+{
+    // родитель дает ровно то выравнивание, которое просят, и не больше
+    class exact_alignment_resource final:
+        public std::pmr::memory_resource
+    {
+        static constexpr size_t base_alignment = 64;
+
+        void *do_allocate(size_t bytes, size_t alignment) override
+        {
+            auto *base = reinterpret_cast<unsigned char *>(::operator new(bytes + base_alignment, std::align_val_t(base_alignment)));
+            return base + (alignment < base_alignment ? alignment : 0);
+        }
+
+        void do_deallocate(void *p, size_t, size_t alignment) override
+        {
+            ::operator delete(reinterpret_cast<unsigned char *>(p) - (alignment < base_alignment ? alignment : 0), std::align_val_t(base_alignment));
+        }
+
+        bool do_is_equal(std::pmr::memory_resource const &other) const noexcept override
+        {
+            return this == &other;
+        }
+    };
+}
+
 logger *create_logger(
     std::vector<std::pair<std::string, logger::severity>> const &output_file_streams_setup,
     bool use_console_stream = true,
@@ -147,16 +175,16 @@ TEST(allocatorSortedListPositiveTests, test4)
 
     std::unique_ptr<smart_mem_resource> alloc(new allocator_sorted_list(1000, nullptr, logger_instance.get(), allocator_with_fit_mode::fit_mode::first_fit));
     
-    auto first_block = reinterpret_cast<unsigned char *>(alloc->allocate(sizeof(unsigned char) * 250));
-    auto second_block = reinterpret_cast<unsigned char *>(alloc->allocate(sizeof(char) * 150));
-    auto third_block = reinterpret_cast<unsigned char *>(alloc->allocate(sizeof(unsigned char) * 300));
+    auto first_block = reinterpret_cast<unsigned char *>(alloc->allocate(sizeof(unsigned char) * 250, 1));
+    auto second_block = reinterpret_cast<unsigned char *>(alloc->allocate(sizeof(char) * 150, 1));
+    auto third_block = reinterpret_cast<unsigned char *>(alloc->allocate(sizeof(unsigned char) * 300, 1));
     
     auto *the_same_subject = dynamic_cast<allocator_with_fit_mode *>(alloc.get());
     the_same_subject->set_fit_mode(allocator_with_fit_mode::fit_mode::the_worst_fit);
-    auto four_block = reinterpret_cast<unsigned char *>(alloc->allocate(sizeof(unsigned char) * 50));
+    auto four_block = reinterpret_cast<unsigned char *>(alloc->allocate(sizeof(unsigned char) * 50, 1));
     
     the_same_subject->set_fit_mode(allocator_with_fit_mode::fit_mode::the_best_fit);
-    auto five_block = reinterpret_cast<unsigned char *>(alloc->allocate(sizeof(unsigned char) * 50));
+    auto five_block = reinterpret_cast<unsigned char *>(alloc->allocate(sizeof(unsigned char) * 50, 1));
     
     alloc->deallocate(first_block, 1);
     alloc->deallocate(second_block, 1);
@@ -242,6 +270,39 @@ TEST(allocatorSortedListPositiveTests, test5)
     }
 }
 
+TEST(allocatorSortedListPositiveTests, test6)
+{
+    std::unique_ptr<smart_mem_resource> alloc(new allocator_sorted_list(10'000, nullptr, nullptr, allocator_with_fit_mode::fit_mode::first_fit));
+
+    std::vector<void *> blocks;
+    for (int i = 0; i < 4; ++i)
+    {
+        blocks.push_back(alloc->allocate(sizeof(char) * 100));
+    }
+
+    alloc->deallocate(blocks[0], 1);
+    alloc->deallocate(blocks[2], 1);
+
+    // поиск продолжается с блока после последнего выделенного, а не с начала списка
+    dynamic_cast<allocator_with_fit_mode *>(alloc.get())->set_fit_mode(allocator_with_fit_mode::fit_mode::next_fit);
+    auto *next_block = alloc->allocate(sizeof(char) * 50);
+    ASSERT_GT(next_block, blocks[3]);
+
+    dynamic_cast<allocator_with_fit_mode *>(alloc.get())->set_fit_mode(allocator_with_fit_mode::fit_mode::first_fit);
+    auto *first_block = alloc->allocate(sizeof(char) * 50);
+    ASSERT_EQ(first_block, blocks[0]);
+
+    alloc->deallocate(first_block, 1);
+    alloc->deallocate(next_block, 1);
+    alloc->deallocate(blocks[3], 1);
+    alloc->deallocate(blocks[1], 1);
+
+    auto actual_blocks_state = dynamic_cast<allocator_test_utils *>(alloc.get())->get_blocks_info();
+
+    ASSERT_EQ(actual_blocks_state.size(), 1);
+    ASSERT_EQ(actual_blocks_state[0], (allocator_test_utils::block_info{ .block_size = 10'000, .is_block_occupied = false }));
+}
+
 TEST(allocatorSortedListNegativeTests, test1)
 {
     std::unique_ptr<logger> logger(create_logger(std::vector<std::pair<std::string, logger::severity>>
@@ -256,6 +317,110 @@ TEST(allocatorSortedListNegativeTests, test1)
     ASSERT_THROW(alloc->allocate(sizeof(char) * 3100), std::bad_alloc);
 }
 
+TEST(allocatorSortedListPositiveTests, test7)
+{
+    allocator_sorted_list allocator_instance(10'000, nullptr, nullptr, allocator_with_fit_mode::fit_mode::first_fit);
+
+    auto initial = allocator_instance.get_statistics();
+
+    ASSERT_EQ(initial.total_bytes, 10'000);
+    ASSERT_EQ(initial.bytes_in_use, 0);
+    ASSERT_EQ(initial.peak_bytes_in_use, 0);
+    ASSERT_EQ(initial.largest_free_block, 10'000);
+
+    void *first_block = allocator_instance.allocate(1000);
+    void *second_block = allocator_instance.allocate(500);
+    ASSERT_THROW(static_cast<void>(allocator_instance.allocate(20'000)), std::bad_alloc);
+
+    auto after_allocations = allocator_instance.get_statistics();
+    auto blocks_state = allocator_instance.get_blocks_info();
+
+    size_t occupied_bytes = 0;
+    size_t largest_free_block = 0;
+    for (auto const &block : blocks_state)
+    {
+        if (block.is_block_occupied)
+        {
+            occupied_bytes += block.block_size;
+        }
+        else
+        {
+            largest_free_block = std::max(largest_free_block, block.block_size);
+        }
+    }
+
+    ASSERT_EQ(after_allocations.allocations, 2);
+    ASSERT_EQ(after_allocations.failed_allocations, 1);
+    ASSERT_EQ(after_allocations.occupied_blocks, 2);
+    ASSERT_EQ(after_allocations.bytes_in_use, occupied_bytes);
+    ASSERT_EQ(after_allocations.peak_bytes_in_use, occupied_bytes);
+    ASSERT_EQ(after_allocations.free_bytes, 10'000 - occupied_bytes);
+    ASSERT_EQ(after_allocations.largest_free_block, largest_free_block);
+
+    allocator_instance.deallocate(first_block, 1);
+
+    // пик не уменьшается после освобождения
+    auto after_first_deallocation = allocator_instance.get_statistics();
+
+    ASSERT_EQ(after_first_deallocation.deallocations, 1);
+    ASSERT_LT(after_first_deallocation.bytes_in_use, occupied_bytes);
+    ASSERT_EQ(after_first_deallocation.peak_bytes_in_use, occupied_bytes);
+
+    allocator_instance.deallocate(second_block, 1);
+
+    auto final = allocator_instance.get_statistics();
+
+    ASSERT_EQ(final.deallocations, 2);
+    ASSERT_EQ(final.occupied_blocks, 0);
+    ASSERT_EQ(final.bytes_in_use, 0);
+    ASSERT_EQ(final.peak_bytes_in_use, occupied_bytes);
+    ASSERT_EQ(final.largest_free_block, 10'000);
+}
+
+TEST(allocatorSortedListPositiveTests, test8)
+{
+    allocator_sorted_list allocator_instance(10'000, nullptr, nullptr, allocator_with_fit_mode::fit_mode::first_fit);
+
+    // выравнивание не строже max_align_t тоже соблюдается, размеры блоков ему не кратны
+    std::vector<void *> blocks;
+    for (size_t i = 0; i < 8; ++i)
+    {
+        blocks.push_back(allocator_instance.allocate(13 + i, alignof(double)));
+        ASSERT_EQ(reinterpret_cast<std::uintptr_t>(blocks.back()) % alignof(double), 0);
+    }
+
+    for (size_t i = 0; i < 8; ++i)
+    {
+        blocks.push_back(allocator_instance.allocate(13 + i));
+        ASSERT_EQ(reinterpret_cast<std::uintptr_t>(blocks.back()) % alignof(std::max_align_t), 0);
+    }
+
+    for (auto *block : blocks)
+    {
+        allocator_instance.deallocate(block, 1);
+    }
+
+    ASSERT_EQ(allocator_instance.get_statistics().bytes_in_use, 0);
+}
+
+TEST(allocatorSortedListPositiveTests, test9)
+{
+    exact_alignment_resource parent;
+
+    // все блоки отсчитываются от начала памяти родителя, поэтому она берется выровненной на max_align_t
+    allocator_sorted_list allocator_instance(1000, &parent, nullptr, allocator_with_fit_mode::fit_mode::first_fit);
+    allocator_sorted_list copy(allocator_instance);
+
+    void *block = allocator_instance.allocate(100, 1);
+    ASSERT_EQ(reinterpret_cast<std::uintptr_t>(block) % alignof(std::max_align_t), 0);
+
+    void *copy_block = copy.allocate(100, 1);
+    ASSERT_EQ(reinterpret_cast<std::uintptr_t>(copy_block) % alignof(std::max_align_t), 0);
+
+    copy.deallocate(copy_block, 1);
+    allocator_instance.deallocate(block, 1);
+}
+
 int main(
     int argc,
     char **argv)
@@ -263,4 +428,39 @@ int main(
     testing::InitGoogleTest(&argc, argv);
     
     return RUN_ALL_TESTS();
-}
\ No newline at end of file
+}
+TEST(allocatorSortedListPositiveTests, test10)
+{
+    allocator_sorted_list allocator_instance(10'000, nullptr, nullptr, allocator_with_fit_mode::fit_mode::first_fit);
+
+    std::vector<void *> blocks;
+    for (int i = 0; i < 5; ++i)
+    {
+        blocks.push_back(allocator_instance.allocate(100, 1));
+    }
+
+    // блоки без свободных соседей встают в голову списка, первым подходит освобожденный последним
+    allocator_instance.deallocate(blocks[1], 1);
+    allocator_instance.deallocate(blocks[3], 1);
+    ASSERT_EQ(allocator_instance.allocate(100, 1), blocks[3]);
+
+    // свободные соседи с обеих сторон находятся по адресу и сливаются в один блок
+    allocator_instance.deallocate(blocks[3], 1);
+    allocator_instance.deallocate(blocks[2], 1);
+
+    std::vector<allocator_test_utils::block_info> expected_blocks_state
+        {
+            { .block_size = 116, .is_block_occupied = true },
+            { .block_size = 3 * 116, .is_block_occupied = false },
+            { .block_size = 116, .is_block_occupied = true },
+            { .block_size = 10'000 - 5 * 116, .is_block_occupied = false }
+        };
+    ASSERT_EQ(allocator_instance.get_blocks_info(), expected_blocks_state);
+
+    allocator_instance.deallocate(blocks[0], 1);
+    allocator_instance.deallocate(blocks[4], 1);
+
+    expected_blocks_state = { { .block_size = 10'000, .is_block_occupied = false } };
+    ASSERT_EQ(allocator_instance.get_blocks_info(), expected_blocks_state);
+    ASSERT_EQ(allocator_instance.get_statistics().largest_free_block, 10'000);
+}
@@ -0,0 +1,133 @@
+#ifndef MATH_PRACTICE_AND_OPERATING_SYSTEMS_ALLOCATOR_ALLOCATOR_THREAD_CACHE_H
+#define MATH_PRACTICE_AND_OPERATING_SYSTEMS_ALLOCATOR_ALLOCATOR_THREAD_CACHE_H
+
+#include <pp_allocator.h>
+#include <allocator_logger_guardant.h>
+#include <typename_holder.h>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <unordered_set>
+#include <vector>
+
+/**
+ * Wraps any memory resource (usually one of the arena allocators) with per-thread magazines of free blocks.
+ * Small requests are rounded up to a size class and served from the calling thread's magazine without locking;
+ * an empty magazine is refilled with a batch of blocks from the upstream resource, a full one gives
+ * half of its blocks back. Blocks may be freed on any thread.
+ * Requests aligned stricter than the 16 byte header are not cached, they go to the upstream with their alignment.
+ */
+class allocator_thread_cache final:
+    public smart_mem_resource,
+    private allocator_logger_guardant,
+    private typename_holder
+{
+
+private:
+
+    // мета блока: номер класса размеров (uncached_size_class для больших блоков, aligned_size_class плюс log2
+    // выравнивания для строго выровненных) и размер блока у upstream для некэшируемых; выравнивание до 16 байт
+    static constexpr const size_t block_metadata_size = 2 * sizeof(size_t);
+
+    static constexpr const size_t size_class_granularity = 16;
+
+    static constexpr const size_t size_classes_count = 32;
+
+    static constexpr const size_t max_cached_size = size_class_granularity * size_classes_count;
+
+    static constexpr const size_t uncached_size_class = size_classes_count;
+
+    static constexpr const size_t aligned_size_class = uncached_size_class + 1;
+
+    struct thread_cache;
+
+    struct shared_state
+    {
+        std::mutex mutex;
+
+        // nullptr after the owning allocator is destroyed
+        std::pmr::memory_resource *upstream;
+
+        std::atomic<bool> alive;
+
+        std::unordered_set<thread_cache *> caches;
+    };
+
+    struct thread_cache
+    {
+        std::shared_ptr<shared_state> state;
+
+        std::vector<void *> magazines[size_classes_count];
+
+        ~thread_cache();
+    };
+
+    std::shared_ptr<shared_state> _state;
+
+    size_t _magazine_capacity;
+
+    logger *_logger;
+
+    size_t _id;
+
+public:
+
+    explicit allocator_thread_cache(
+        std::pmr::memory_resource *upstream,
+        size_t magazine_capacity = 64,
+        logger *logger = nullptr);
+
+    allocator_thread_cache(
+        allocator_thread_cache const &other) = delete;
+
+    allocator_thread_cache &operator=(
+        allocator_thread_cache const &other) = delete;
+
+    allocator_thread_cache(
+        allocator_thread_cache &&other) noexcept = delete;
+
+    allocator_thread_cache &operator=(
+        allocator_thread_cache &&other) noexcept = delete;
+
+    ~allocator_thread_cache() override;
+
+public:
+
+    [[nodiscard]] void *do_allocate_sm(
+        size_t size) override;
+
+    [[nodiscard]] void *do_allocate_aligned_sm(
+        size_t size,
+        size_t alignment) override;
+
+    void do_deallocate_sm(
+        void *at) override;
+
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override;
+
+public:
+
+    // gives every block cached by the calling thread back to the upstream resource
+    void flush_thread_cache();
+
+private:
+
+    thread_cache &get_thread_cache();
+
+    static void release_blocks(
+        std::pmr::memory_resource *upstream,
+        size_t size_class,
+        std::vector<void *> &magazine,
+        size_t count);
+
+    static inline size_t get_size_class(size_t size) noexcept;
+
+    static inline size_t get_class_block_size(size_t size_class) noexcept;
+
+    inline logger *get_logger() const override;
+
+    inline std::string get_typename() const override;
+
+};
+
+#endif //MATH_PRACTICE_AND_OPERATING_SYSTEMS_ALLOCATOR_ALLOCATOR_THREAD_CACHE_H
@@ -0,0 +1,303 @@
+#include "../include/allocator_thread_cache.h"
+#include <bit>
+#include <limits>
+#include <unordered_map>
+
+using byte = unsigned char;
+
+namespace
+{
+    std::atomic<size_t> next_allocator_id(1);
+}
+
+allocator_thread_cache::allocator_thread_cache(
+    std::pmr::memory_resource *upstream,
+    size_t magazine_capacity,
+    logger *logger):
+        _state(std::make_shared<shared_state>()),
+        _magazine_capacity(magazine_capacity < 2 ? 2 : magazine_capacity),
+        _logger(logger),
+        _id(next_allocator_id.fetch_add(1, std::memory_order_relaxed))
+{
+    _state->upstream = upstream == nullptr ? std::pmr::get_default_resource() : upstream;
+    _state->alive.store(true, std::memory_order_release);
+
+    debug_with_guard("allocator_thread_cache created");
+}
+
+allocator_thread_cache::~allocator_thread_cache()
+{
+    std::lock_guard lock(_state->mutex);
+
+    // the owning threads may outlive the allocator, their caches are emptied here and dropped on thread exit
+    for (auto *cache : _state->caches)
+    {
+        for (size_t size_class = 0; size_class < size_classes_count; ++size_class)
+        {
+            release_blocks(_state->upstream, size_class, cache->magazines[size_class], cache->magazines[size_class].size());
+        }
+    }
+
+    _state->caches.clear();
+    _state->upstream = nullptr;
+    _state->alive.store(false, std::memory_order_release);
+
+    debug_with_guard("allocator_thread_cache destroyed");
+}
+
+allocator_thread_cache::thread_cache::~thread_cache()
+{
+    std::lock_guard lock(state->mutex);
+
+    if (state->upstream == nullptr)
+    {
+        return;
+    }
+
+    for (size_t size_class = 0; size_class < size_classes_count; ++size_class)
+    {
+        release_blocks(state->upstream, size_class, magazines[size_class], magazines[size_class].size());
+    }
+
+    state->caches.erase(this);
+}
+
+[[nodiscard]] void *allocator_thread_cache::do_allocate_sm(
+    size_t size)
+{
+    size_t size_class = get_size_class(size);
+    void *block;
+
+    if (size_class == uncached_size_class)
+    {
+        if (size > std::numeric_limits<size_t>::max() - block_metadata_size)
+        {
+            error_with_guard("Requested size is too big");
+            throw std::bad_alloc();
+        }
+
+        block = _state->upstream->allocate(size + block_metadata_size);
+        // upstream получает при освобождении тот же размер, что и при выделении
+        reinterpret_cast<size_t *>(block)[1] = size + block_metadata_size;
+    }
+    else
+    {
+        auto &magazine = get_thread_cache().magazines[size_class];
+
+        if (magazine.empty())
+        {
+            trace_with_guard("refilling magazine from upstream");
+
+            size_t block_size = get_class_block_size(size_class) + block_metadata_size;
+            size_t count = _magazine_capacity / 2;
+            magazine.reserve(_magazine_capacity);
+
+            // upstream, умеющий выдавать пакетами, заполняет магазин за одну блокировку
+            if (auto *smart_upstream = dynamic_cast<smart_mem_resource *>(_state->upstream); smart_upstream != nullptr)
+            {
+                magazine.resize(count);
+                try
+                {
+                    smart_upstream->allocate_batch(block_size, count, magazine.data());
+                }
+                catch (std::bad_alloc const &)
+                {
+                    magazine.clear();
+                }
+            }
+
+            // пакет выдается целиком или никак, по одному можно взять хотя бы часть
+            try
+            {
+                for (size_t i = magazine.size(); i < count; ++i)
+                {
+                    magazine.push_back(_state->upstream->allocate(block_size));
+                }
+            }
+            catch (std::bad_alloc const &)
+            {
+                if (magazine.empty())
+                {
+                    error_with_guard("upstream can not refill magazine");
+                    throw;
+                }
+            }
+        }
+
+        block = magazine.back();
+        magazine.pop_back();
+    }
+
+    *reinterpret_cast<size_t *>(block) = size_class;
+
+    return reinterpret_cast<byte *>(block) + block_metadata_size;
+}
+
+/** The data starts alignment bytes after the upstream block, so the header right before it is left
+ * at the same place as for other blocks.
+ */
+[[nodiscard]] void *allocator_thread_cache::do_allocate_aligned_sm(
+    size_t size,
+    size_t alignment)
+{
+    if (alignment <= block_metadata_size)
+    {
+        return do_allocate_sm(size);
+    }
+
+    if (size > std::numeric_limits<size_t>::max() - alignment)
+    {
+        error_with_guard("Requested size is too big");
+        throw std::bad_alloc();
+    }
+
+    void *block = _state->upstream->allocate(size + alignment, alignment);
+    auto *data = reinterpret_cast<byte *>(block) + alignment;
+
+    reinterpret_cast<size_t *>(data)[-2] = aligned_size_class + std::countr_zero(alignment);
+    reinterpret_cast<size_t *>(data)[-1] = size + alignment;
+
+    return data;
+}
+
+void allocator_thread_cache::do_deallocate_sm(
+    void *at)
+{
+    if (at == nullptr)
+    {
+        return;
+    }
+
+    void *block = reinterpret_cast<byte *>(at) - block_metadata_size;
+    size_t size_class = *reinterpret_cast<size_t *>(block);
+
+    if (size_class == uncached_size_class)
+    {
+        _state->upstream->deallocate(block, reinterpret_cast<size_t *>(block)[1]);
+        return;
+    }
+
+    if (size_class >= aligned_size_class && size_class < aligned_size_class + std::numeric_limits<size_t>::digits)
+    {
+        size_t alignment = size_t(1) << (size_class - aligned_size_class);
+        _state->upstream->deallocate(reinterpret_cast<byte *>(at) - alignment, reinterpret_cast<size_t *>(at)[-1], alignment);
+        return;
+    }
+
+    if (size_class > uncached_size_class)
+    {
+        error_with_guard("Tried to deallocate block not allocated by allocator_thread_cache");
+        throw std::logic_error("Not allocator's property");
+    }
+
+    auto &magazine = get_thread_cache().magazines[size_class];
+
+    if (magazine.size() >= _magazine_capacity)
+    {
+        trace_with_guard("flushing half of magazine to upstream");
+        release_blocks(_state->upstream, size_class, magazine, _magazine_capacity / 2);
+    }
+
+    magazine.push_back(block);
+}
+
+bool allocator_thread_cache::do_is_equal(const std::pmr::memory_resource &other) const noexcept
+{
+    return this == &other;
+}
+
+void allocator_thread_cache::flush_thread_cache()
+{
+    auto &cache = get_thread_cache();
+
+    for (size_t size_class = 0; size_class < size_classes_count; ++size_class)
+    {
+        release_blocks(_state->upstream, size_class, cache.magazines[size_class], cache.magazines[size_class].size());
+    }
+}
+
+allocator_thread_cache::thread_cache &allocator_thread_cache::get_thread_cache()
+{
+    thread_local std::unordered_map<size_t, std::unique_ptr<thread_cache>> thread_caches;
+    thread_local size_t last_id = 0;
+    thread_local thread_cache *last_cache = nullptr;
+
+    if (last_id == _id)
+    {
+        return *last_cache;
+    }
+
+    auto it = thread_caches.find(_id);
+
+    if (it == thread_caches.end())
+    {
+        std::erase_if(thread_caches, [](auto const &entry)
+        {
+            return !entry.second->state->alive.load(std::memory_order_acquire);
+        });
+
+        auto cache = std::make_unique<thread_cache>();
+        cache->state = _state;
+
+        {
+            std::lock_guard lock(_state->mutex);
+            _state->caches.insert(cache.get());
+        }
+
+        it = thread_caches.emplace(_id, std::move(cache)).first;
+    }
+
+    last_id = _id;
+    last_cache = it->second.get();
+
+    return *last_cache;
+}
+
+// oldest blocks go first, recently freed ones are more likely to be in cache
+void allocator_thread_cache::release_blocks(
+    std::pmr::memory_resource *upstream,
+    size_t size_class,
+    std::vector<void *> &magazine,
+    size_t count)
+{
+    size_t block_size = get_class_block_size(size_class) + block_metadata_size;
+
+    if (auto *smart_upstream = dynamic_cast<smart_mem_resource *>(upstream); smart_upstream != nullptr)
+    {
+        smart_upstream->deallocate_batch(magazine.data(), count);
+    }
+    else
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            upstream->deallocate(magazine[i], block_size);
+        }
+    }
+
+    magazine.erase(magazine.begin(), magazine.begin() + count);
+}
+
+inline size_t allocator_thread_cache::get_size_class(size_t size) noexcept
+{
+    if (size > max_cached_size)
+    {
+        return uncached_size_class;
+    }
+
+    return size == 0 ? 0 : (size - 1) / size_class_granularity;
+}
+
+inline size_t allocator_thread_cache::get_class_block_size(size_t size_class) noexcept
+{
+    return (size_class + 1) * size_class_granularity;
+}
+
+inline logger *allocator_thread_cache::get_logger() const
+{
+    return _logger;
+}
+
+inline std::string allocator_thread_cache::get_typename() const
+{
+    return "allocator_thread_cache";
+}
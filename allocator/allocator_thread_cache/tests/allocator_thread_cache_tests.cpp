@@ -0,0 +1,162 @@
+#include <gtest/gtest.h>
+#include <allocator_thread_cache.h>
+#include <allocator_boundary_tags.h>
+#include <allocator_buddies_system.h>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+TEST(allocatorThreadCachePositiveTests, test1)
+{
+    allocator_boundary_tags upstream(100'000, nullptr, nullptr, allocator_with_fit_mode::fit_mode::first_fit);
+
+    {
+        std::unique_ptr<smart_mem_resource> cache(new allocator_thread_cache(&upstream, 8));
+
+        auto *first_block = reinterpret_cast<char *>(cache->allocate(sizeof(char) * 20));
+        auto *second_block = reinterpret_cast<char *>(cache->allocate(sizeof(char) * 20));
+        auto *big_block = reinterpret_cast<char *>(cache->allocate(sizeof(char) * 5000));
+
+        std::memset(first_block, 'a', 20);
+        std::memset(second_block, 'b', 20);
+        std::memset(big_block, 'c', 5000);
+
+        ASSERT_NE(first_block, second_block);
+
+        cache->deallocate(first_block, 1);
+
+        // freed block is reused by the same thread without going to upstream
+        auto *third_block = reinterpret_cast<char *>(cache->allocate(sizeof(char) * 17));
+        ASSERT_EQ(first_block, third_block);
+
+        cache->deallocate(second_block, 1);
+        cache->deallocate(third_block, 1);
+        cache->deallocate(big_block, 1);
+    }
+
+    auto actual_blocks_state = upstream.get_blocks_info();
+
+    ASSERT_EQ(actual_blocks_state.size(), 1);
+    ASSERT_EQ(actual_blocks_state[0].is_block_occupied, false);
+}
+
+TEST(allocatorThreadCachePositiveTests, test2)
+{
+    allocator_boundary_tags upstream(4'000'000, nullptr, nullptr, allocator_with_fit_mode::fit_mode::first_fit);
+
+    {
+        allocator_thread_cache cache(&upstream, 32);
+
+        std::vector<std::thread> threads;
+        std::vector<std::vector<void *>> handed_over(4);
+
+        for (int t = 0; t < 4; ++t)
+        {
+            threads.emplace_back([&cache, &handed_over, t]()
+            {
+                std::vector<std::pair<unsigned char *, size_t>> blocks;
+
+                for (int i = 0; i < 20'000; ++i)
+                {
+                    size_t size = (i * 7 + t) % 700;
+                    auto *block = reinterpret_cast<unsigned char *>(cache.allocate(size));
+                    std::memset(block, t + 1, size);
+                    blocks.emplace_back(block, size);
+
+                    if (blocks.size() > 50)
+                    {
+                        auto [ptr, ptr_size] = blocks[i % blocks.size()];
+                        for (size_t j = 0; j < ptr_size; ++j)
+                        {
+                            ASSERT_EQ(ptr[j], t + 1);
+                        }
+                        cache.deallocate(ptr, ptr_size);
+                        blocks.erase(blocks.begin() + i % blocks.size());
+                    }
+                }
+
+                for (auto [ptr, ptr_size] : blocks)
+                {
+                    handed_over[t].push_back(ptr);
+                }
+            });
+        }
+
+        for (auto &thread : threads)
+        {
+            thread.join();
+        }
+
+        // blocks allocated by the finished threads are freed on this one
+        for (auto &blocks : handed_over)
+        {
+            for (auto *ptr : blocks)
+            {
+                cache.deallocate(ptr, 1);
+            }
+        }
+    }
+
+    auto actual_blocks_state = upstream.get_blocks_info();
+
+    ASSERT_EQ(actual_blocks_state.size(), 1);
+    ASSERT_EQ(actual_blocks_state[0].is_block_occupied, false);
+}
+
+TEST(allocatorThreadCachePositiveTests, test3)
+{
+    allocator_boundary_tags upstream(100'000, nullptr, nullptr, allocator_with_fit_mode::fit_mode::first_fit);
+
+    {
+        allocator_thread_cache cache(&upstream, 8);
+
+        // выравнивание строже заголовка обслуживает upstream, блок не кэшируется
+        std::vector<std::pair<void *, size_t>> blocks;
+        for (size_t alignment : { 32, 64, 256, 4096 })
+        {
+            auto *block = cache.allocate(100, alignment);
+            ASSERT_EQ(reinterpret_cast<std::uintptr_t>(block) % alignment, 0);
+            std::memset(block, 'a', 100);
+            blocks.emplace_back(block, alignment);
+        }
+
+        auto *small_block = cache.allocate(20);
+
+        for (auto [block, alignment] : blocks)
+        {
+            cache.deallocate(block, 100, alignment);
+        }
+        cache.deallocate(small_block, 20);
+    }
+
+    auto actual_blocks_state = upstream.get_blocks_info();
+
+    ASSERT_EQ(actual_blocks_state.size(), 1);
+    ASSERT_EQ(actual_blocks_state[0].is_block_occupied, false);
+}
+
+TEST(allocatorThreadCachePositiveTests, test4)
+{
+    // upstream проверяет, что блок освобождается с тем размером, с которым выделен
+    allocator_buddies_system upstream(16, nullptr, nullptr, allocator_with_fit_mode::fit_mode::first_fit, true);
+
+    {
+        allocator_thread_cache cache(&upstream, 8);
+
+        auto *big_block = cache.allocate(3000);
+        auto *small_block = cache.allocate(20);
+        std::memset(big_block, 'a', 3000);
+
+        cache.deallocate(big_block, 1);
+        cache.deallocate(small_block, 1);
+
+        big_block = cache.allocate(1000);
+        cache.deallocate(big_block, 1000);
+    }
+
+    auto actual_blocks_state = upstream.get_blocks_info();
+
+    ASSERT_EQ(actual_blocks_state.size(), 1);
+    ASSERT_EQ(actual_blocks_state[0].is_block_occupied, false);
+}
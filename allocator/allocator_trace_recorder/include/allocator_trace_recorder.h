@@ -0,0 +1,232 @@
+#ifndef MATH_PRACTICE_AND_OPERATING_SYSTEMS_ALLOCATOR_ALLOCATOR_TRACE_RECORDER_H
+#define MATH_PRACTICE_AND_OPERATING_SYSTEMS_ALLOCATOR_ALLOCATOR_TRACE_RECORDER_H
+
+#include <pp_allocator.h>
+#include <allocator_logger_guardant.h>
+#include <typename_holder.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+/**
+ * Passes every request to the upstream resource and records it into a binary trace file.
+ * Records are put into a bounded lock-free ring by the calling thread (one atomic increment and
+ * a clock read per operation) and written to the file by a background thread. When the ring is full
+ * records are dropped instead of making the caller wait; the trace then contains a lost_records marker.
+ * The order of records in the file is a valid order of the operations: a free is recorded before
+ * the block goes back upstream, an allocation after the block comes from it.
+ */
+class allocator_trace_recorder final:
+    public smart_mem_resource,
+    private allocator_logger_guardant,
+    private typename_holder
+{
+
+public:
+
+    enum class record_kind : std::uint8_t
+    {
+        allocation,
+        deallocation,
+        failed_allocation,
+        // size holds the number of records dropped because the ring was full
+        lost_records
+    };
+
+    // запись трассы в файле, 32 байта
+    struct record
+    {
+        // nanoseconds since the recorder was created
+        std::uint64_t timestamp;
+        std::uint64_t pointer;
+        std::uint64_t size;
+        std::uint32_t thread;
+        std::uint8_t alignment_log2;
+        record_kind kind;
+        std::uint16_t reserved;
+    };
+
+    // заголовок файла: сигнатура, версия формата, размер записи
+    struct file_header
+    {
+        char signature[8];
+        std::uint32_t version;
+        std::uint32_t record_size;
+    };
+
+    static constexpr const char file_signature[8] = { 'M', 'P', 'O', 'S', 'T', 'R', 'C', '\0' };
+
+    static constexpr const std::uint32_t file_version = 1;
+
+private:
+
+    struct ring_cell
+    {
+        std::atomic<size_t> sequence;
+        record value;
+    };
+
+    std::pmr::memory_resource *_upstream;
+
+    logger *_logger;
+
+    std::chrono::steady_clock::time_point _start;
+
+    std::unique_ptr<ring_cell[]> _ring;
+
+    size_t _ring_mask;
+
+    alignas(64) std::atomic<size_t> _enqueue_position;
+
+    alignas(64) std::atomic<size_t> _dropped_records;
+
+    // дальше только поток записи
+    alignas(64) size_t _dequeue_position;
+
+    std::ofstream _output;
+
+    std::chrono::milliseconds _flush_period;
+
+    std::mutex _writer_mutex;
+
+    std::condition_variable _writer_wakeup;
+
+    std::condition_variable _flushed;
+
+    bool _stopping;
+
+    size_t _flush_requests;
+
+    size_t _flushes_done;
+
+    std::thread _writer;
+
+public:
+
+    explicit allocator_trace_recorder(
+        std::string const &trace_path,
+        std::pmr::memory_resource *upstream = nullptr,
+        size_t ring_capacity = 1 << 16,
+        std::chrono::milliseconds flush_period = std::chrono::milliseconds(10),
+        logger *logger = nullptr);
+
+    allocator_trace_recorder(
+        allocator_trace_recorder const &other) = delete;
+
+    allocator_trace_recorder &operator=(
+        allocator_trace_recorder const &other) = delete;
+
+    allocator_trace_recorder(
+        allocator_trace_recorder &&other) noexcept = delete;
+
+    allocator_trace_recorder &operator=(
+        allocator_trace_recorder &&other) noexcept = delete;
+
+    // writes out everything left in the ring
+    ~allocator_trace_recorder() override;
+
+public:
+
+    [[nodiscard]] void *do_allocate_sm(
+        size_t size) override;
+
+    [[nodiscard]] void *do_allocate_aligned_sm(
+        size_t size,
+        size_t alignment) override;
+
+    // a free through deallocate_batch, recorded with size 0 and passed upstream without the size
+    void do_deallocate_sm(
+        void *at) override;
+
+    // the size and alignment the caller passed are recorded and passed upstream
+    void do_deallocate_sized_sm(
+        void *at,
+        size_t size,
+        size_t alignment) override;
+
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override;
+
+public:
+
+    // blocks until the records put into the ring before the call are in the file
+    void flush();
+
+    size_t get_dropped_records() const noexcept;
+
+private:
+
+    void push_record(
+        record_kind kind,
+        void const *pointer,
+        size_t size,
+        size_t alignment) noexcept;
+
+    bool pop_record(
+        record &result) noexcept;
+
+    void write_records();
+
+    void writer_loop();
+
+    static std::uint32_t get_thread_number() noexcept;
+
+    inline logger *get_logger() const override;
+
+    inline std::string get_typename() const override;
+
+};
+
+/**
+ * Reads a trace written by allocator_trace_recorder and replays it against any memory resource.
+ */
+class allocator_trace_reader final
+{
+
+public:
+
+    struct replay_result
+    {
+        size_t allocations;
+        size_t deallocations;
+        // allocations that failed during the replay
+        size_t failed_allocations;
+        // frees of blocks whose allocation was not in the trace (lost or recorded before the trace started)
+        size_t unknown_deallocations;
+        size_t lost_records;
+    };
+
+private:
+
+    std::ifstream _input;
+
+public:
+
+    // throws std::runtime_error if the file can not be opened or is not a trace
+    explicit allocator_trace_reader(
+        std::string const &trace_path);
+
+public:
+
+    // false at the end of the trace
+    bool read(
+        allocator_trace_recorder::record &result);
+
+    /**
+     * Operations are replayed in the order of the file on the calling thread. Recorded pointers are mapped
+     * to the blocks given by the resource; blocks still live at the end of the trace are freed.
+     */
+    replay_result replay(
+        std::pmr::memory_resource &resource);
+
+    static bool is_trace_file(
+        std::string const &path);
+
+};
+
+#endif //MATH_PRACTICE_AND_OPERATING_SYSTEMS_ALLOCATOR_ALLOCATOR_TRACE_RECORDER_H
@@ -0,0 +1,401 @@
+#include "../include/allocator_trace_recorder.h"
+#include <bit>
+#include <cstring>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+    std::atomic<std::uint32_t> next_thread_number(0);
+}
+
+allocator_trace_recorder::allocator_trace_recorder(
+    std::string const &trace_path,
+    std::pmr::memory_resource *upstream,
+    size_t ring_capacity,
+    std::chrono::milliseconds flush_period,
+    logger *logger):
+        _upstream(upstream == nullptr ? std::pmr::get_default_resource() : upstream),
+        _logger(logger),
+        _start(std::chrono::steady_clock::now()),
+        _ring_mask(std::bit_ceil(ring_capacity < 2 ? 2 : ring_capacity) - 1),
+        _enqueue_position(0),
+        _dropped_records(0),
+        _dequeue_position(0),
+        _output(trace_path, std::ios::binary | std::ios::trunc),
+        _flush_period(flush_period),
+        _stopping(false),
+        _flush_requests(0),
+        _flushes_done(0)
+{
+    if (!_output)
+    {
+        error_with_guard("Can not open trace file " + trace_path);
+        throw std::runtime_error("Cannot open trace file: " + trace_path);
+    }
+
+    file_header header {};
+    std::memcpy(header.signature, file_signature, sizeof(file_signature));
+    header.version = file_version;
+    header.record_size = sizeof(record);
+    _output.write(reinterpret_cast<char const *>(&header), sizeof(header));
+
+    // ячейка с номером последовательности, равным позиции, свободна для записи
+    _ring = std::make_unique<ring_cell[]>(_ring_mask + 1);
+    for (size_t i = 0; i <= _ring_mask; ++i)
+    {
+        _ring[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    _writer = std::thread(&allocator_trace_recorder::writer_loop, this);
+
+    debug_with_guard("allocator_trace_recorder created");
+}
+
+allocator_trace_recorder::~allocator_trace_recorder()
+{
+    {
+        std::lock_guard lock(_writer_mutex);
+        _stopping = true;
+    }
+    _writer_wakeup.notify_one();
+    _writer.join();
+
+    debug_with_guard("allocator_trace_recorder destroyed");
+}
+
+[[nodiscard]] void *allocator_trace_recorder::do_allocate_sm(
+    size_t size)
+{
+    void *block;
+
+    try
+    {
+        block = _upstream->allocate(size);
+    }
+    catch (std::bad_alloc const &)
+    {
+        push_record(record_kind::failed_allocation, nullptr, size, alignof(std::max_align_t));
+        throw;
+    }
+
+    push_record(record_kind::allocation, block, size, alignof(std::max_align_t));
+    return block;
+}
+
+[[nodiscard]] void *allocator_trace_recorder::do_allocate_aligned_sm(
+    size_t size,
+    size_t alignment)
+{
+    void *block;
+
+    try
+    {
+        block = _upstream->allocate(size, alignment);
+    }
+    catch (std::bad_alloc const &)
+    {
+        push_record(record_kind::failed_allocation, nullptr, size, alignment);
+        throw;
+    }
+
+    push_record(record_kind::allocation, block, size, alignment);
+    return block;
+}
+
+void allocator_trace_recorder::do_deallocate_sm(
+    void *at)
+{
+    if (at == nullptr)
+    {
+        return;
+    }
+
+    push_record(record_kind::deallocation, at, 0, 1);
+
+    // размер неизвестен (освобождение пакетом), smart upstream получает блок тоже без размера
+    if (auto *smart_upstream = dynamic_cast<smart_mem_resource *>(_upstream); smart_upstream != nullptr)
+    {
+        smart_upstream->deallocate_batch(&at, 1);
+        return;
+    }
+
+    _upstream->deallocate(at, 1);
+}
+
+void allocator_trace_recorder::do_deallocate_sized_sm(
+    void *at,
+    size_t size,
+    size_t alignment)
+{
+    if (at == nullptr)
+    {
+        return;
+    }
+
+    push_record(record_kind::deallocation, at, size, alignment);
+    _upstream->deallocate(at, size, alignment);
+}
+
+bool allocator_trace_recorder::do_is_equal(const std::pmr::memory_resource &other) const noexcept
+{
+    return this == &other;
+}
+
+void allocator_trace_recorder::flush()
+{
+    std::unique_lock lock(_writer_mutex);
+
+    size_t ticket = ++_flush_requests;
+    _writer_wakeup.notify_one();
+    _flushed.wait(lock, [this, ticket]() { return _flushes_done >= ticket; });
+}
+
+size_t allocator_trace_recorder::get_dropped_records() const noexcept
+{
+    return _dropped_records.load(std::memory_order_relaxed);
+}
+
+/** Bounded queue of D. Vyukov: a cell is free for the position equal to its sequence number and readable
+ * when the sequence is one more than the position. Producers only compete for the enqueue position.
+ */
+void allocator_trace_recorder::push_record(
+    record_kind kind,
+    void const *pointer,
+    size_t size,
+    size_t alignment) noexcept
+{
+    auto timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - _start).count();
+
+    size_t position = _enqueue_position.load(std::memory_order_relaxed);
+    ring_cell *cell;
+
+    while (true)
+    {
+        cell = &_ring[position & _ring_mask];
+        size_t sequence = cell->sequence.load(std::memory_order_acquire);
+
+        if (sequence == position)
+        {
+            if (_enqueue_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+            {
+                break;
+            }
+        }
+        else if (static_cast<std::ptrdiff_t>(sequence - position) < 0)
+        {
+            // кольцо заполнено: запись теряется, поток записи оставит отметку о потере
+            _dropped_records.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        else
+        {
+            position = _enqueue_position.load(std::memory_order_relaxed);
+        }
+    }
+
+    cell->value = record
+        {
+            static_cast<std::uint64_t>(timestamp),
+            reinterpret_cast<std::uintptr_t>(pointer),
+            size,
+            get_thread_number(),
+            static_cast<std::uint8_t>(std::countr_zero(alignment)),
+            kind,
+            0
+        };
+    cell->sequence.store(position + 1, std::memory_order_release);
+}
+
+bool allocator_trace_recorder::pop_record(
+    record &result) noexcept
+{
+    ring_cell &cell = _ring[_dequeue_position & _ring_mask];
+
+    if (cell.sequence.load(std::memory_order_acquire) != _dequeue_position + 1)
+    {
+        return false;
+    }
+
+    result = cell.value;
+    cell.sequence.store(_dequeue_position + _ring_mask + 1, std::memory_order_release);
+    ++_dequeue_position;
+
+    return true;
+}
+
+void allocator_trace_recorder::write_records()
+{
+    std::vector<record> batch;
+    batch.reserve(_ring_mask + 2);
+
+    record current;
+    while (batch.size() <= _ring_mask && pop_record(current))
+    {
+        batch.push_back(current);
+    }
+
+    size_t lost = _dropped_records.exchange(0, std::memory_order_relaxed);
+    if (lost != 0)
+    {
+        batch.push_back({ batch.empty() ? 0 : batch.back().timestamp, 0, lost, 0, 0, record_kind::lost_records, 0 });
+        warning_with_guard("allocator_trace_recorder ring overflow, records lost");
+    }
+
+    _output.write(reinterpret_cast<char const *>(batch.data()), static_cast<std::streamsize>(batch.size() * sizeof(record)));
+}
+
+void allocator_trace_recorder::writer_loop()
+{
+    std::unique_lock lock(_writer_mutex);
+
+    while (true)
+    {
+        _writer_wakeup.wait_for(lock, _flush_period, [this]() { return _stopping || _flush_requests != _flushes_done; });
+
+        bool stopping = _stopping;
+        size_t flush_requests = _flush_requests;
+
+        lock.unlock();
+        write_records();
+        if (flush_requests != _flushes_done || stopping)
+        {
+            _output.flush();
+        }
+        lock.lock();
+
+        _flushes_done = flush_requests;
+        _flushed.notify_all();
+
+        if (stopping)
+        {
+            return;
+        }
+    }
+}
+
+std::uint32_t allocator_trace_recorder::get_thread_number() noexcept
+{
+    thread_local std::uint32_t thread_number = next_thread_number.fetch_add(1, std::memory_order_relaxed);
+    return thread_number;
+}
+
+inline logger *allocator_trace_recorder::get_logger() const
+{
+    return _logger;
+}
+
+inline std::string allocator_trace_recorder::get_typename() const
+{
+    return "allocator_trace_recorder";
+}
+
+allocator_trace_reader::allocator_trace_reader(
+    std::string const &trace_path):
+        _input(trace_path, std::ios::binary)
+{
+    if (!_input)
+    {
+        throw std::runtime_error("Cannot open trace file: " + trace_path);
+    }
+
+    allocator_trace_recorder::file_header header {};
+    if (!_input.read(reinterpret_cast<char *>(&header), sizeof(header)) ||
+        std::memcmp(header.signature, allocator_trace_recorder::file_signature, sizeof(header.signature)) != 0 ||
+        header.version != allocator_trace_recorder::file_version ||
+        header.record_size != sizeof(allocator_trace_recorder::record))
+    {
+        throw std::runtime_error("Not a trace file of a supported version: " + trace_path);
+    }
+}
+
+bool allocator_trace_reader::read(
+    allocator_trace_recorder::record &result)
+{
+    return static_cast<bool>(_input.read(reinterpret_cast<char *>(&result), sizeof(result)));
+}
+
+allocator_trace_reader::replay_result allocator_trace_reader::replay(
+    std::pmr::memory_resource &resource)
+{
+    struct live_block
+    {
+        void *block;
+        size_t size;
+        size_t alignment;
+    };
+
+    replay_result result {};
+    std::unordered_map<std::uint64_t, live_block> live_blocks;
+
+    auto free_block = [&resource](live_block const &block)
+    {
+        resource.deallocate(block.block, block.size, block.alignment);
+    };
+
+    allocator_trace_recorder::record current;
+    while (read(current))
+    {
+        switch (current.kind)
+        {
+            case allocator_trace_recorder::record_kind::allocation:
+            {
+                // освобождение этого адреса потерялось
+                if (auto it = live_blocks.find(current.pointer); it != live_blocks.end())
+                {
+                    free_block(it->second);
+                    live_blocks.erase(it);
+                }
+
+                size_t alignment = size_t(1) << current.alignment_log2;
+                try
+                {
+                    live_blocks[current.pointer] = { resource.allocate(current.size, alignment), current.size, alignment };
+                    ++result.allocations;
+                }
+                catch (std::bad_alloc const &)
+                {
+                    ++result.failed_allocations;
+                }
+                break;
+            }
+            case allocator_trace_recorder::record_kind::deallocation:
+            {
+                auto it = live_blocks.find(current.pointer);
+                if (it == live_blocks.end())
+                {
+                    ++result.unknown_deallocations;
+                    break;
+                }
+
+                free_block(it->second);
+                live_blocks.erase(it);
+                ++result.deallocations;
+                break;
+            }
+            case allocator_trace_recorder::record_kind::failed_allocation:
+                break;
+            case allocator_trace_recorder::record_kind::lost_records:
+                result.lost_records += current.size;
+                break;
+        }
+    }
+
+    for (auto &[pointer, block] : live_blocks)
+    {
+        free_block(block);
+    }
+
+    return result;
+}
+
+bool allocator_trace_reader::is_trace_file(
+    std::string const &path)
+{
+    std::ifstream input(path, std::ios::binary);
+    char signature[sizeof(allocator_trace_recorder::file_signature)];
+
+    return input.read(signature, sizeof(signature)) &&
+           std::memcmp(signature, allocator_trace_recorder::file_signature, sizeof(signature)) == 0;
+}
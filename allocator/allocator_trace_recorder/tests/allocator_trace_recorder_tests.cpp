@@ -0,0 +1,211 @@
+#include <gtest/gtest.h>
+#include <allocator_trace_recorder.h>
+#include <allocator_boundary_tags.h>
+#include <allocator_buddies_system.h>
+#include <filesystem>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    std::string trace_path(
+        std::string const &name)
+    {
+        return (std::filesystem::temp_directory_path() / name).string();
+    }
+}
+
+TEST(allocatorTraceRecorderPositiveTests, test1)
+{
+    auto path = trace_path("allocator_trace_recorder_tests_1.trace");
+    allocator_boundary_tags upstream(10'000, nullptr, nullptr, allocator_with_fit_mode::fit_mode::first_fit);
+
+    void *first_block;
+    void *aligned_block;
+    {
+        allocator_trace_recorder recorder(path, &upstream);
+
+        first_block = recorder.allocate(100);
+        aligned_block = recorder.allocate(200, 64);
+        recorder.deallocate(first_block, 100);
+        ASSERT_THROW(static_cast<void>(recorder.allocate(20'000)), std::bad_alloc);
+        recorder.deallocate(aligned_block, 200, 64);
+    }
+
+    allocator_trace_reader reader(path);
+    std::vector<allocator_trace_recorder::record> records;
+    for (allocator_trace_recorder::record current; reader.read(current); )
+    {
+        records.push_back(current);
+    }
+
+    ASSERT_EQ(records.size(), 5);
+
+    ASSERT_EQ(records[0].kind, allocator_trace_recorder::record_kind::allocation);
+    ASSERT_EQ(records[0].pointer, reinterpret_cast<std::uintptr_t>(first_block));
+    ASSERT_EQ(records[0].size, 100);
+
+    ASSERT_EQ(records[1].kind, allocator_trace_recorder::record_kind::allocation);
+    ASSERT_EQ(records[1].alignment_log2, 6);
+
+    ASSERT_EQ(records[2].kind, allocator_trace_recorder::record_kind::deallocation);
+    ASSERT_EQ(records[2].pointer, reinterpret_cast<std::uintptr_t>(first_block));
+
+    ASSERT_EQ(records[3].kind, allocator_trace_recorder::record_kind::failed_allocation);
+    ASSERT_EQ(records[3].size, 20'000);
+
+    ASSERT_EQ(records[4].pointer, reinterpret_cast<std::uintptr_t>(aligned_block));
+
+    for (size_t i = 1; i < records.size(); ++i)
+    {
+        ASSERT_LE(records[i - 1].timestamp, records[i].timestamp);
+    }
+
+    std::filesystem::remove(path);
+}
+
+TEST(allocatorTraceRecorderPositiveTests, test2)
+{
+    auto path = trace_path("allocator_trace_recorder_tests_2.trace");
+    allocator_boundary_tags upstream(200'000, nullptr, nullptr, allocator_with_fit_mode::fit_mode::first_fit);
+
+    {
+        allocator_trace_recorder recorder(path, &upstream);
+
+        // блоки выделяются в одном потоке, а освобождаются в другом
+        std::vector<void *> blocks(1000);
+        std::thread producer([&]()
+        {
+            for (size_t i = 0; i < blocks.size(); ++i)
+            {
+                blocks[i] = recorder.allocate(i % 100 + 1);
+            }
+        });
+        producer.join();
+
+        std::thread consumer([&]()
+        {
+            for (size_t i = 0; i < blocks.size(); i += 2)
+            {
+                recorder.deallocate(blocks[i], 1);
+            }
+        });
+        consumer.join();
+
+        recorder.flush();
+
+        for (size_t i = 1; i < blocks.size(); i += 2)
+        {
+            recorder.deallocate(blocks[i], 1);
+        }
+    }
+
+    allocator_boundary_tags target(200'000, nullptr, nullptr, allocator_with_fit_mode::fit_mode::the_best_fit);
+    auto result = allocator_trace_reader(path).replay(target);
+
+    ASSERT_EQ(result.allocations, 1000);
+    ASSERT_EQ(result.deallocations, 1000);
+    ASSERT_EQ(result.failed_allocations, 0);
+    ASSERT_EQ(result.unknown_deallocations, 0);
+    ASSERT_EQ(result.lost_records, 0);
+
+    auto actual_blocks_state = target.get_blocks_info();
+
+    ASSERT_EQ(actual_blocks_state.size(), 1);
+    ASSERT_EQ(actual_blocks_state[0].is_block_occupied, false);
+
+    std::filesystem::remove(path);
+}
+
+TEST(allocatorTraceRecorderPositiveTests, test3)
+{
+    auto path = trace_path("allocator_trace_recorder_tests_3.trace");
+    allocator_boundary_tags upstream(100'000, nullptr, nullptr, allocator_with_fit_mode::fit_mode::first_fit);
+    size_t dropped;
+
+    {
+        // кольцо на 16 записей, а поток записи просыпается раз в час
+        allocator_trace_recorder recorder(path, &upstream, 16, std::chrono::hours(1));
+
+        std::vector<void *> blocks;
+        for (size_t i = 0; i < 100; ++i)
+        {
+            blocks.push_back(recorder.allocate(32));
+        }
+        for (auto *block : blocks)
+        {
+            recorder.deallocate(block, 32);
+        }
+
+        dropped = recorder.get_dropped_records();
+        ASSERT_GT(dropped, 0);
+    }
+
+    ASSERT_TRUE(allocator_trace_reader::is_trace_file(path));
+
+    allocator_boundary_tags target(100'000, nullptr, nullptr, allocator_with_fit_mode::fit_mode::first_fit);
+    auto result = allocator_trace_reader(path).replay(target);
+
+    ASSERT_EQ(result.lost_records, dropped);
+    ASSERT_EQ(result.allocations + result.deallocations + result.unknown_deallocations + result.lost_records, 200);
+    ASSERT_EQ(target.get_blocks_info().size(), 1);
+
+    std::filesystem::remove(path);
+}
+
+TEST(allocatorTraceRecorderPositiveTests, test4)
+{
+    auto path = trace_path("allocator_trace_recorder_tests_4.trace");
+    // upstream проверяет, что блок освобождается с тем размером, с которым выделен
+    allocator_buddies_system upstream(16, nullptr, nullptr, allocator_with_fit_mode::fit_mode::first_fit, true);
+
+    {
+        allocator_trace_recorder recorder(path, &upstream);
+
+        auto *block = recorder.allocate(1000);
+        auto *aligned_block = recorder.allocate(300, 64);
+        recorder.deallocate(block, 1000);
+        recorder.deallocate(aligned_block, 300, 64);
+
+        void *batch[3];
+        recorder.allocate_batch(50, 3, batch);
+        recorder.deallocate_batch(batch, 3);
+    }
+
+    allocator_trace_reader reader(path);
+    std::vector<allocator_trace_recorder::record> records;
+    for (allocator_trace_recorder::record current; reader.read(current); )
+    {
+        records.push_back(current);
+    }
+
+    ASSERT_EQ(records.size(), 10);
+
+    ASSERT_EQ(records[2].kind, allocator_trace_recorder::record_kind::deallocation);
+    ASSERT_EQ(records[2].size, 1000);
+
+    ASSERT_EQ(records[3].kind, allocator_trace_recorder::record_kind::deallocation);
+    ASSERT_EQ(records[3].size, 300);
+    ASSERT_EQ(records[3].alignment_log2, 6);
+
+    // освобождение пакетом записывается без размера
+    ASSERT_EQ(records[9].kind, allocator_trace_recorder::record_kind::deallocation);
+    ASSERT_EQ(records[9].size, 0);
+
+    auto blocks_state = upstream.get_blocks_info();
+    ASSERT_EQ(blocks_state.size(), 1);
+    ASSERT_EQ(blocks_state[0].is_block_occupied, false);
+
+    std::filesystem::remove(path);
+}
+
+TEST(allocatorTraceRecorderNegativeTests, test1)
+{
+    auto path = trace_path("allocator_trace_recorder_tests_negative_1.trace");
+    std::ofstream(path) << "0 a 1 16\n";
+
+    ASSERT_FALSE(allocator_trace_reader::is_trace_file(path));
+    ASSERT_THROW(allocator_trace_reader reader(path), std::runtime_error);
+
+    std::filesystem::remove(path);
+}
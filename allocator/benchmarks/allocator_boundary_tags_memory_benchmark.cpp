@@ -0,0 +1,123 @@
+#include <allocator_boundary_tags.h>
+#include <allocator_boundary_tags_compact.h>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
+
+// How many small objects fit into the same arena with the 32-byte occupied block metadata
+// of allocator_boundary_tags and with the 8-byte headers of allocator_boundary_tags_compact,
+// and what an allocate/deallocate pair costs in both.
+
+namespace
+{
+    constexpr size_t space_size = 1 << 20;
+    constexpr size_t operations_count = 1'000'000;
+
+    struct result
+    {
+        size_t objects;
+        size_t payload;
+        double ns;
+    };
+
+    // size 0 means random sizes from 16 to 64
+    result measure(
+        smart_mem_resource &allocator,
+        size_t size)
+    {
+        std::mt19937 rng(42);
+        std::uniform_int_distribution<size_t> sizes(16, 64);
+
+        std::vector<void *> live;
+        std::vector<size_t> live_sizes;
+        size_t payload = 0;
+
+        while (true)
+        {
+            size_t bytes = size == 0 ? sizes(rng) : size;
+            try
+            {
+                live.push_back(allocator.allocate(bytes));
+            }
+            catch (std::bad_alloc const &)
+            {
+                break;
+            }
+            live_sizes.push_back(bytes);
+            payload += bytes;
+        }
+
+        result res { live.size(), payload, 0 };
+
+        // для замера времени куча заполнена наполовину, каждый второй блок свободен,
+        // на место блока встает блок того же размера
+        for (size_t i = live.size() / 2; i < live.size(); ++i)
+        {
+            allocator.deallocate(live[i], 1);
+        }
+        live.resize(live.size() / 2);
+
+        for (size_t i = 0; i < live.size(); i += 2)
+        {
+            allocator.deallocate(live[i], 1);
+            live[i] = nullptr;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+
+        for (size_t i = 0; i < operations_count; ++i)
+        {
+            size_t index = (i * 2) % live.size();
+            if (live[index] != nullptr)
+            {
+                allocator.deallocate(live[index], 1);
+            }
+            live[index] = allocator.allocate(live_sizes[index]);
+        }
+
+        auto finish = std::chrono::steady_clock::now();
+
+        for (auto *ptr : live)
+        {
+            if (ptr != nullptr)
+            {
+                allocator.deallocate(ptr, 1);
+            }
+        }
+
+        res.ns = std::chrono::duration<double, std::nano>(finish - start).count() / operations_count;
+        return res;
+    }
+
+    void print(
+        std::string const &name,
+        size_t size,
+        result const &res)
+    {
+        double overhead = (static_cast<double>(space_size) - res.payload) / res.objects;
+
+        std::cout << std::setw(10) << name << std::setw(8) << (size == 0 ? std::string("16-64") : std::to_string(size))
+                  << std::setw(10) << res.objects << std::setw(18) << std::fixed << std::setprecision(1) << overhead
+                  << std::setw(22) << res.ns << std::endl;
+    }
+}
+
+int main()
+{
+    std::cout << std::setw(10) << "layout" << std::setw(8) << "size" << std::setw(10) << "objects"
+              << std::setw(18) << "bytes per object" << std::setw(22) << "ns per alloc+dealloc" << std::endl;
+
+    for (size_t size : { 16, 24, 48, 100, 0 })
+    {
+        allocator_boundary_tags current(space_size);
+        print("current", size, measure(current, size));
+
+        allocator_boundary_tags_compact compact(space_size);
+        print("compact", size, measure(compact, size));
+    }
+
+    return 0;
+}
@@ -0,0 +1,118 @@
+#include <allocator_boundary_tags.h>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
+
+// Allocate/deallocate throughput of allocator_boundary_tags without a logger
+// for different numbers of live blocks already sitting in the arena.
+// The gaps between them are of random small sizes or all of one large size: then they all fall into
+// the highest bin of the free index, the one the largest free block and the_worst_fit are taken from.
+
+namespace
+{
+    constexpr size_t operations_count = 1'000'000;
+    constexpr size_t max_block_size = 64;
+    constexpr size_t equal_gap_size = 1024;
+
+    double measure(
+        size_t population,
+        allocator_with_fit_mode::fit_mode mode,
+        bool equal_gaps)
+    {
+        size_t gap_size = equal_gaps ? equal_gap_size : max_block_size;
+        size_t space_size = (population * 2 + 1024) * (gap_size + 64);
+        std::unique_ptr<smart_mem_resource> allocator(new allocator_boundary_tags(space_size, nullptr, nullptr, mode));
+
+        std::mt19937 rng(population);
+        std::uniform_int_distribution<size_t> sizes(8, max_block_size);
+
+        // every second block is freed so the population is spread over as many free gaps as live blocks
+        std::vector<void *> live;
+        live.reserve(population * 2);
+        for (size_t i = 0; i < population * 2; ++i)
+        {
+            live.push_back(allocator->allocate(equal_gaps ? equal_gap_size : sizes(rng)));
+        }
+        for (size_t i = 0; i < live.size(); i += 2)
+        {
+            allocator->deallocate(live[i], 1);
+        }
+
+        std::vector<size_t> request_sizes(1024);
+        for (auto &size : request_sizes)
+        {
+            size = sizes(rng);
+        }
+
+        std::vector<void *> window(16, nullptr);
+
+        auto start = std::chrono::steady_clock::now();
+
+        for (size_t i = 0; i < operations_count; ++i)
+        {
+            void *&slot = window[i % window.size()];
+            if (slot != nullptr)
+            {
+                allocator->deallocate(slot, 1);
+            }
+            slot = allocator->allocate(request_sizes[i % request_sizes.size()]);
+        }
+
+        auto finish = std::chrono::steady_clock::now();
+
+        for (auto *ptr : window)
+        {
+            allocator->deallocate(ptr, 1);
+        }
+        for (size_t i = 1; i < live.size(); i += 2)
+        {
+            allocator->deallocate(live[i], 1);
+        }
+
+        return std::chrono::duration<double, std::nano>(finish - start).count() / operations_count;
+    }
+}
+
+int main()
+{
+    std::vector<std::pair<std::string, allocator_with_fit_mode::fit_mode>> modes
+        {
+            { "first_fit", allocator_with_fit_mode::fit_mode::first_fit },
+            { "the_best_fit", allocator_with_fit_mode::fit_mode::the_best_fit },
+            { "the_worst_fit", allocator_with_fit_mode::fit_mode::the_worst_fit }
+        };
+
+    std::cout << std::setw(14) << "fit mode" << std::setw(12) << "gaps" << std::setw(12) << "live blocks" << std::setw(22) << "ns per alloc+dealloc" << std::endl;
+
+    for (bool equal_gaps : { false, true })
+    {
+        for (auto &[name, mode] : modes)
+        {
+            double baseline = 0;
+
+            for (size_t population : { 0, 1'000, 10'000, 100'000, 300'000 })
+            {
+                // равные дыры по килобайту занимают в несколько раз больше памяти
+                if (equal_gaps && population > 100'000)
+                {
+                    continue;
+                }
+
+                double ns = measure(population, mode, equal_gaps);
+                if (population == 0)
+                {
+                    baseline = ns;
+                }
+
+                std::cout << std::setw(14) << name << std::setw(12) << (equal_gaps ? "equal 1K" : "random") << std::setw(12) << population
+                          << std::setw(16) << std::fixed << std::setprecision(1) << ns
+                          << "  (x" << std::setprecision(2) << ns / baseline << ")" << std::endl;
+            }
+        }
+    }
+
+    return 0;
+}
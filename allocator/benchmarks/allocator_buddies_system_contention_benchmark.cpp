@@ -0,0 +1,138 @@
+#include <allocator_buddies_system.h>
+#include <allocator_buddies_system_concurrent.h>
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Throughput of 1..N threads sharing one buddy system: allocator_buddies_system behind its mutex
+// against allocator_buddies_system_concurrent. The second run of every size frees the blocks
+// on another thread than the one that allocated them.
+
+namespace
+{
+    constexpr size_t operations_per_thread = 500'000;
+
+    constexpr size_t space_power = 26;
+
+    double measure(
+        std::pmr::memory_resource &resource,
+        size_t threads_count,
+        bool cross_thread_frees)
+    {
+        // при освобождении чужими потоками блоки передаются соседу через общий кольцевой буфер
+        std::vector<std::unique_ptr<std::atomic<void *>[]>> mailboxes(threads_count);
+        for (auto &mailbox : mailboxes)
+        {
+            mailbox = std::make_unique<std::atomic<void *>[]>(64);
+            for (size_t i = 0; i < 64; ++i)
+            {
+                mailbox[i].store(nullptr, std::memory_order_relaxed);
+            }
+        }
+
+        std::vector<std::thread> threads;
+
+        auto start = std::chrono::steady_clock::now();
+
+        for (size_t t = 0; t < threads_count; ++t)
+        {
+            threads.emplace_back([&resource, &mailboxes, t, threads_count, cross_thread_frees]()
+            {
+                std::mt19937 rng(t);
+                std::uniform_int_distribution<size_t> sizes(8, 512);
+                std::vector<void *> window(32, nullptr);
+                auto &outgoing = mailboxes[(t + 1) % threads_count];
+
+                for (size_t i = 0; i < operations_per_thread; ++i)
+                {
+                    void *&slot = window[rng() % window.size()];
+                    if (slot != nullptr)
+                    {
+                        if (cross_thread_frees)
+                        {
+                            slot = outgoing[i % 64].exchange(slot, std::memory_order_acq_rel);
+                        }
+                        if (slot != nullptr)
+                        {
+                            resource.deallocate(slot, 1);
+                        }
+                    }
+                    slot = resource.allocate(sizes(rng));
+                }
+
+                for (auto *ptr : window)
+                {
+                    if (ptr != nullptr)
+                    {
+                        resource.deallocate(ptr, 1);
+                    }
+                }
+            });
+        }
+
+        for (auto &thread : threads)
+        {
+            thread.join();
+        }
+
+        auto finish = std::chrono::steady_clock::now();
+
+        for (auto &mailbox : mailboxes)
+        {
+            for (size_t i = 0; i < 64; ++i)
+            {
+                if (void *ptr = mailbox[i].load(std::memory_order_relaxed); ptr != nullptr)
+                {
+                    resource.deallocate(ptr, 1);
+                }
+            }
+        }
+
+        return operations_per_thread * threads_count / std::chrono::duration<double>(finish - start).count() / 1e6;
+    }
+}
+
+int main(
+    int argc,
+    char *argv[])
+{
+    // the number of cores to scale up to can be given as the first argument
+    size_t max_threads = argc > 1
+            ? std::max(1ul, std::stoul(argv[1]))
+            : std::max(1u, std::thread::hardware_concurrency());
+
+    std::vector<size_t> threads_counts;
+    for (size_t threads_count = 1; threads_count < max_threads; threads_count *= 2)
+    {
+        threads_counts.push_back(threads_count);
+    }
+    threads_counts.push_back(max_threads);
+
+    for (bool cross_thread_frees : { false, true })
+    {
+        std::cout << (cross_thread_frees ? "frees on another thread" : "frees on the same thread") << std::endl;
+        std::cout << std::setw(8) << "threads" << std::setw(20) << "mutex Mops/s" << std::setw(24) << "concurrent Mops/s" << std::endl;
+
+        for (size_t threads_count : threads_counts)
+        {
+            allocator_buddies_system locked(space_power);
+            double locked_mops = measure(locked, threads_count, cross_thread_frees);
+
+            allocator_buddies_system_concurrent concurrent(space_power);
+            double concurrent_mops = measure(concurrent, threads_count, cross_thread_frees);
+
+            std::cout << std::setw(8) << threads_count << std::fixed << std::setprecision(2)
+                      << std::setw(20) << locked_mops << std::setw(24) << concurrent_mops << std::endl;
+        }
+
+        std::cout << std::endl;
+    }
+
+    return 0;
+}
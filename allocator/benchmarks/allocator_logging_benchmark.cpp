@@ -0,0 +1,70 @@
+#include <allocator_boundary_tags.h>
+#include <allocator_buddies_system.h>
+#include <allocator_global_heap.h>
+#include <allocator_red_black_tree.h>
+#include <allocator_sorted_list.h>
+#include <chrono>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+// Cost of an allocate/deallocate pair without a logger. Built once as is and once with
+// -DMP_OS_ALLOCATOR_LOGGING=OFF, the difference is what the logging call sites cost
+// when nobody listens to them.
+
+namespace
+{
+    constexpr size_t operations_count = 2'000'000;
+
+    double measure(
+        smart_mem_resource &allocator)
+    {
+        std::vector<void *> window(16, nullptr);
+
+        auto start = std::chrono::steady_clock::now();
+
+        for (size_t i = 0; i < operations_count; ++i)
+        {
+            void *&slot = window[i % window.size()];
+            if (slot != nullptr)
+            {
+                allocator.deallocate(slot, 1);
+            }
+            slot = allocator.allocate(16 + i % 7 * 8);
+        }
+
+        auto finish = std::chrono::steady_clock::now();
+
+        for (auto *ptr : window)
+        {
+            allocator.deallocate(ptr, 1);
+        }
+
+        return std::chrono::duration<double, std::nano>(finish - start).count() / operations_count;
+    }
+}
+
+int main()
+{
+    std::vector<std::pair<std::string, std::function<std::unique_ptr<smart_mem_resource>()>>> allocators
+        {
+            { "global_heap", [] { return std::make_unique<allocator_global_heap>(); } },
+            { "boundary_tags", [] { return std::make_unique<allocator_boundary_tags>(1 << 16); } },
+            { "buddies_system", [] { return std::make_unique<allocator_buddies_system>(16); } },
+            { "sorted_list", [] { return std::make_unique<allocator_sorted_list>(1 << 16); } },
+            { "red_black_tree", [] { return std::make_unique<allocator_red_black_tree>(1 << 16); } }
+        };
+
+    std::cout << "logging call sites: " << (allocator_logger_guardant::logging_enabled ? "compiled in" : "compiled out") << std::endl;
+    std::cout << std::setw(16) << "allocator" << std::setw(22) << "ns per alloc+dealloc" << std::endl;
+
+    for (auto &[name, create] : allocators)
+    {
+        auto allocator = create();
+        std::cout << std::setw(16) << name << std::setw(22) << std::fixed << std::setprecision(1) << measure(*allocator) << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,152 @@
+#include <allocator_boundary_tags.h>
+#include <allocator_buddies_system.h>
+#include <allocator_red_black_tree.h>
+#include <chrono>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+// allocator_red_black_tree against allocator_boundary_tags and allocator_buddies_system on workloads
+// that leave the arena fragmented: mixed small and large blocks with random lifetimes.
+
+namespace
+{
+    constexpr size_t space_size_power_of_two = 24;
+    constexpr size_t space_size = size_t(1) << space_size_power_of_two;
+    constexpr size_t operations_count = 500'000;
+
+    struct workload
+    {
+        std::string name;
+        size_t live_blocks;
+        size_t min_size;
+        size_t max_size;
+    };
+
+    struct result
+    {
+        double ns_per_operation;
+        size_t failed_allocations;
+        double fragmentation;
+    };
+
+    // 1 - largest free block / all free memory at the end of the run
+    double external_fragmentation(
+        allocator_test_utils &allocator)
+    {
+        size_t free_size = 0;
+        size_t largest_free_size = 0;
+
+        for (auto &block : allocator.get_blocks_info())
+        {
+            if (!block.is_block_occupied)
+            {
+                free_size += block.block_size;
+                largest_free_size = std::max(largest_free_size, block.block_size);
+            }
+        }
+
+        return free_size == 0 ? 0 : 1 - static_cast<double>(largest_free_size) / free_size;
+    }
+
+    template<typename allocator_type>
+    result measure(
+        std::function<allocator_type *()> const &create,
+        workload const &load)
+    {
+        std::unique_ptr<allocator_type> allocator(create());
+
+        std::mt19937 rng(17);
+        std::uniform_int_distribution<size_t> sizes(load.min_size, load.max_size);
+        // большинство блоков мелкие, каждый восьмой - из всего диапазона
+        std::uniform_int_distribution<size_t> small_sizes(load.min_size, load.min_size * 4);
+
+        std::vector<void *> live(load.live_blocks, nullptr);
+        size_t failed_allocations = 0;
+
+        auto start = std::chrono::steady_clock::now();
+
+        for (size_t i = 0; i < operations_count; ++i)
+        {
+            void *&slot = live[rng() % live.size()];
+            if (slot != nullptr)
+            {
+                allocator->deallocate(slot, 1);
+                slot = nullptr;
+            }
+
+            try
+            {
+                slot = allocator->allocate(rng() % 8 == 0 ? sizes(rng) : small_sizes(rng));
+            }
+            catch (std::bad_alloc const &)
+            {
+                ++failed_allocations;
+            }
+        }
+
+        auto finish = std::chrono::steady_clock::now();
+
+        double fragmentation = external_fragmentation(*allocator);
+
+        for (auto *ptr : live)
+        {
+            if (ptr != nullptr)
+            {
+                allocator->deallocate(ptr, 1);
+            }
+        }
+
+        return { std::chrono::duration<double, std::nano>(finish - start).count() / operations_count, failed_allocations, fragmentation };
+    }
+
+    void print(
+        std::string const &workload_name,
+        std::string const &allocator_name,
+        result const &res)
+    {
+        std::cout << std::setw(12) << workload_name << std::setw(16) << allocator_name
+                  << std::fixed << std::setprecision(1) << std::setw(12) << res.ns_per_operation
+                  << std::setw(10) << res.failed_allocations
+                  << std::setprecision(3) << std::setw(16) << res.fragmentation << std::endl;
+    }
+}
+
+int main()
+{
+    std::vector<workload> workloads
+        {
+            { "small", 20'000, 16, 256 },
+            { "mixed", 10'000, 16, 4096 },
+            { "large", 2'000, 64, 32'768 }
+        };
+
+    auto mode = allocator_with_fit_mode::fit_mode::the_best_fit;
+
+    std::cout << std::setw(12) << "workload" << std::setw(16) << "allocator" << std::setw(12) << "ns per op"
+              << std::setw(10) << "failed" << std::setw(16) << "fragmentation" << std::endl;
+
+    for (auto &load : workloads)
+    {
+        print(load.name, "boundary_tags", measure<allocator_boundary_tags>([mode]()
+        {
+            return new allocator_boundary_tags(space_size, nullptr, nullptr, mode);
+        }, load));
+
+        print(load.name, "buddies_system", measure<allocator_buddies_system>([mode]()
+        {
+            return new allocator_buddies_system(space_size_power_of_two, nullptr, nullptr, mode);
+        }, load));
+
+        print(load.name, "red_black_tree", measure<allocator_red_black_tree>([mode]()
+        {
+            return new allocator_red_black_tree(space_size, nullptr, nullptr, mode);
+        }, load));
+    }
+
+    return 0;
+}
@@ -0,0 +1,111 @@
+#include <allocator_boundary_tags.h>
+#include <allocator_sharded.h>
+#include <allocator_thread_cache.h>
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Throughput of small allocations shared by 1..N threads: allocator_boundary_tags alone
+// against the same allocator behind allocator_thread_cache and one allocator_boundary_tags per thread
+// behind allocator_sharded.
+
+namespace
+{
+    constexpr size_t operations_per_thread = 500'000;
+
+    double measure(
+        std::pmr::memory_resource &resource,
+        size_t threads_count)
+    {
+        std::vector<std::thread> threads;
+
+        auto start = std::chrono::steady_clock::now();
+
+        for (size_t t = 0; t < threads_count; ++t)
+        {
+            threads.emplace_back([&resource, t]()
+            {
+                std::mt19937 rng(t);
+                std::uniform_int_distribution<size_t> sizes(8, 256);
+                std::vector<void *> window(32, nullptr);
+
+                for (size_t i = 0; i < operations_per_thread; ++i)
+                {
+                    void *&slot = window[rng() % window.size()];
+                    if (slot != nullptr)
+                    {
+                        resource.deallocate(slot, 1);
+                    }
+                    slot = resource.allocate(sizes(rng));
+                }
+
+                for (auto *ptr : window)
+                {
+                    if (ptr != nullptr)
+                    {
+                        resource.deallocate(ptr, 1);
+                    }
+                }
+            });
+        }
+
+        for (auto &thread : threads)
+        {
+            thread.join();
+        }
+
+        auto finish = std::chrono::steady_clock::now();
+
+        return operations_per_thread * threads_count / std::chrono::duration<double>(finish - start).count() / 1e6;
+    }
+}
+
+int main(
+    int argc,
+    char *argv[])
+{
+    // the number of cores to scale up to can be given as the first argument
+    size_t max_threads = argc > 1
+            ? std::max(1ul, std::stoul(argv[1]))
+            : std::max(1u, std::thread::hardware_concurrency());
+
+    std::cout << std::setw(8) << "threads" << std::setw(24) << "boundary_tags Mops/s" << std::setw(24) << "thread_cache Mops/s"
+              << std::setw(24) << "sharded Mops/s" << std::endl;
+
+    std::vector<size_t> threads_counts;
+    for (size_t threads_count = 1; threads_count < max_threads; threads_count *= 2)
+    {
+        threads_counts.push_back(threads_count);
+    }
+    threads_counts.push_back(max_threads);
+
+    for (size_t threads_count : threads_counts)
+    {
+        allocator_boundary_tags direct(threads_count * 64 * 1024 + (1 << 20));
+        double direct_mops = measure(direct, threads_count);
+
+        allocator_boundary_tags upstream(threads_count * 256 * 1024 + (1 << 20));
+        double cached_mops;
+        {
+            allocator_thread_cache cache(&upstream);
+            cached_mops = measure(cache, threads_count);
+        }
+
+        allocator_sharded sharded([](std::pmr::memory_resource *parent)
+        {
+            return std::make_unique<allocator_boundary_tags>(64 * 1024 + (1 << 20), parent);
+        }, threads_count);
+        double sharded_mops = measure(sharded, threads_count);
+
+        std::cout << std::setw(8) << threads_count << std::fixed << std::setprecision(2)
+                  << std::setw(24) << direct_mops << std::setw(24) << cached_mops << std::setw(24) << sharded_mops << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,703 @@
+#include <allocator_boundary_tags.h>
+#include <allocator_buddies_system.h>
+#include <allocator_global_heap.h>
+#include <allocator_red_black_tree.h>
+#include <allocator_slab.h>
+#include <allocator_sorted_list.h>
+#include <allocator_trace_recorder.h>
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#if defined(_WIN32)
+#include <windows.h>
+#include <psapi.h>
+#endif
+
+// Replays allocation traces against every allocator and fit mode and reports throughput, p99 latency
+// of a single operation, peak RSS of the process and external fragmentation sampled during the run.
+//
+// Without arguments synthetic traces are replayed: power-law sizes with random lifetimes, a producer thread
+// whose blocks are freed by a consumer thread, and LIFO bursts. Otherwise every argument is a trace written
+// by allocator_trace_recorder or a text trace with one operation per line ('#' starts a comment):
+//     <thread> a <id> <size> [alignment]
+//     <thread> d <id>
+// ids only have to be unique among live blocks, so addresses can be used as ids.
+
+namespace
+{
+    // пространство аллокатора - столько пиковых объёмов трассы, чтобы фрагментация была заметна
+    constexpr size_t space_size_factor = 4;
+
+    // оценка меты и выравнивания одного блока для пикового объёма
+    constexpr size_t block_overhead_estimate = 64;
+
+    // фрагментация считается по снимку статистики каждые столько операций потока 0
+    constexpr size_t fragmentation_sample_period = 1024;
+
+    struct trace_operation
+    {
+        bool is_allocation;
+        size_t slot;
+        size_t size;
+        size_t alignment;
+    };
+
+    struct trace
+    {
+        std::string name;
+        size_t slots_count;
+        // операции каждого потока в порядке выполнения
+        std::vector<std::vector<trace_operation>> threads;
+        // пик суммы размеров живых блоков с накладными расходами
+        size_t peak_footprint;
+    };
+
+    struct result
+    {
+        double mops;
+        double p99_ns;
+        double peak_rss_mb;
+        double fragmentation;
+        size_t failed_allocations;
+    };
+
+    struct subject
+    {
+        std::string name;
+        bool has_fit_mode;
+        std::function<std::pmr::memory_resource *(size_t, allocator_with_fit_mode::fit_mode)> create;
+    };
+
+    class trace_builder
+    {
+
+    private:
+
+        trace _trace;
+
+        std::vector<std::pair<size_t, size_t>> _slot_blocks;
+
+    public:
+
+        trace_builder(
+            std::string name,
+            size_t threads_count):
+                _trace { std::move(name), 0, std::vector<std::vector<trace_operation>>(threads_count), 0 }
+        {
+        }
+
+        size_t allocate(
+            size_t thread,
+            size_t size,
+            size_t alignment = 1)
+        {
+            _slot_blocks.emplace_back(size, alignment);
+            _trace.threads[thread].push_back({ true, _trace.slots_count, size, alignment });
+            return _trace.slots_count++;
+        }
+
+        void deallocate(
+            size_t thread,
+            size_t slot)
+        {
+            auto [size, alignment] = _slot_blocks[slot];
+            _trace.threads[thread].push_back({ false, slot, size, alignment });
+        }
+
+        trace build() &&
+        {
+            return std::move(_trace);
+        }
+
+    };
+
+    // размеры по закону Парето: много мелких блоков и редкие крупные
+    trace power_law_trace()
+    {
+        constexpr size_t operations_count = 200'000;
+        constexpr size_t live_blocks = 4'000;
+
+        trace_builder builder("power_law", 1);
+        std::mt19937 rng(1);
+        std::uniform_real_distribution<double> uniform(0, 1);
+
+        auto next_size = [&]()
+        {
+            return std::min<size_t>(16 / std::pow(1 - uniform(rng), 1 / 1.2), 64 * 1024);
+        };
+
+        std::vector<size_t> live;
+        for (size_t i = 0; i < operations_count; ++i)
+        {
+            if (live.size() == live_blocks || (!live.empty() && rng() % 2 == 0))
+            {
+                size_t index = rng() % live.size();
+                builder.deallocate(0, live[index]);
+                live[index] = live.back();
+                live.pop_back();
+            }
+            else
+            {
+                size_t size = next_size();
+                live.push_back(builder.allocate(0, size, size >= 64 && rng() % 4 == 0 ? 64 : 1));
+            }
+        }
+
+        for (size_t slot : live)
+        {
+            builder.deallocate(0, slot);
+        }
+
+        return std::move(builder).build();
+    }
+
+    // поток 0 выделяет, поток 1 освобождает в том же порядке
+    trace producer_consumer_trace()
+    {
+        constexpr size_t blocks_count = 100'000;
+
+        trace_builder builder("prod_cons", 2);
+        std::mt19937 rng(2);
+        std::uniform_int_distribution<size_t> sizes(16, 128);
+
+        for (size_t i = 0; i < blocks_count; ++i)
+        {
+            builder.deallocate(1, builder.allocate(0, sizes(rng)));
+        }
+
+        return std::move(builder).build();
+    }
+
+    // пачки выделений освобождаются в обратном порядке, каждый шестнадцатый блок живёт до конца
+    trace lifo_bursts_trace()
+    {
+        constexpr size_t bursts_count = 1'000;
+
+        trace_builder builder("lifo_bursts", 1);
+        std::mt19937 rng(3);
+        std::uniform_int_distribution<size_t> burst_lengths(1, 512);
+        std::uniform_int_distribution<size_t> sizes(16, 1024);
+
+        std::vector<size_t> survivors;
+        for (size_t i = 0; i < bursts_count; ++i)
+        {
+            std::vector<size_t> burst;
+            for (size_t length = burst_lengths(rng); length > 0; --length)
+            {
+                burst.push_back(builder.allocate(0, sizes(rng)));
+            }
+
+            for (auto it = burst.rbegin(); it != burst.rend(); ++it)
+            {
+                if (*it % 16 == 0)
+                {
+                    survivors.push_back(*it);
+                }
+                else
+                {
+                    builder.deallocate(0, *it);
+                }
+            }
+        }
+
+        for (size_t slot : survivors)
+        {
+            builder.deallocate(0, slot);
+        }
+
+        return std::move(builder).build();
+    }
+
+    // переводит идентификаторы блоков в слоты, а номера потоков записанной трассы - в номера по порядку
+    class recorded_trace_builder
+    {
+
+    private:
+
+        trace _trace;
+
+        std::unordered_map<std::uint64_t, size_t> _live_slots;
+
+        std::unordered_map<std::uint64_t, size_t> _thread_indices;
+
+        std::vector<std::pair<size_t, size_t>> _slot_blocks;
+
+    public:
+
+        explicit recorded_trace_builder(
+            std::string name):
+                _trace { std::move(name), 0, {}, 0 }
+        {
+        }
+
+        // false if a block with the id is already live
+        bool allocate(
+            std::uint64_t thread,
+            std::uint64_t id,
+            size_t size,
+            size_t alignment)
+        {
+            if (_live_slots.contains(id))
+            {
+                return false;
+            }
+
+            _live_slots[id] = _trace.slots_count;
+            _slot_blocks.emplace_back(size, alignment);
+            get_thread_operations(thread).push_back({ true, _trace.slots_count++, size, alignment });
+            return true;
+        }
+
+        // false if no block with the id is live
+        bool deallocate(
+            std::uint64_t thread,
+            std::uint64_t id)
+        {
+            auto it = _live_slots.find(id);
+            if (it == _live_slots.end())
+            {
+                return false;
+            }
+
+            auto [size, alignment] = _slot_blocks[it->second];
+            get_thread_operations(thread).push_back({ false, it->second, size, alignment });
+            _live_slots.erase(it);
+            return true;
+        }
+
+        trace build() &&
+        {
+            return std::move(_trace);
+        }
+
+    private:
+
+        std::vector<trace_operation> &get_thread_operations(
+            std::uint64_t thread)
+        {
+            auto [it, inserted] = _thread_indices.try_emplace(thread, _trace.threads.size());
+            if (inserted)
+            {
+                _trace.threads.emplace_back();
+            }
+
+            return _trace.threads[it->second];
+        }
+
+    };
+
+    trace load_text_trace(
+        std::string const &path)
+    {
+        std::ifstream input(path);
+        if (!input)
+        {
+            throw std::runtime_error("can not open trace " + path);
+        }
+
+        recorded_trace_builder builder(path);
+
+        std::string line;
+        for (size_t line_number = 1; std::getline(input, line); ++line_number)
+        {
+            line = line.substr(0, line.find('#'));
+            if (line.find_first_not_of(" \t\r") == std::string::npos)
+            {
+                continue;
+            }
+
+            std::istringstream fields(line);
+
+            std::uint64_t thread;
+            char kind;
+            std::uint64_t id;
+            if (!(fields >> thread >> kind >> id))
+            {
+                throw std::runtime_error(path + ":" + std::to_string(line_number) + ": malformed operation");
+            }
+
+            if (kind == 'a')
+            {
+                size_t size, alignment = 1;
+                if (!(fields >> size))
+                {
+                    throw std::runtime_error(path + ":" + std::to_string(line_number) + ": malformed allocation");
+                }
+                fields >> alignment;
+
+                if (!builder.allocate(thread, id, size, alignment))
+                {
+                    throw std::runtime_error(path + ":" + std::to_string(line_number) + ": allocation of a live block");
+                }
+            }
+            else if (kind == 'd')
+            {
+                if (!builder.deallocate(thread, id))
+                {
+                    throw std::runtime_error(path + ":" + std::to_string(line_number) + ": free of unknown block");
+                }
+            }
+            else
+            {
+                throw std::runtime_error(path + ":" + std::to_string(line_number) + ": unknown operation");
+            }
+        }
+
+        return std::move(builder).build();
+    }
+
+    /** Records may be lost when the recorder ring overflows: frees of unknown blocks are skipped and
+     * a block allocated again at a live address is freed first by the allocating thread.
+     */
+    trace load_recorded_trace(
+        std::string const &path)
+    {
+        allocator_trace_reader reader(path);
+        recorded_trace_builder builder(path);
+
+        allocator_trace_recorder::record current;
+        while (reader.read(current))
+        {
+            switch (current.kind)
+            {
+                case allocator_trace_recorder::record_kind::allocation:
+                    if (!builder.allocate(current.thread, current.pointer, current.size, size_t(1) << current.alignment_log2))
+                    {
+                        builder.deallocate(current.thread, current.pointer);
+                        builder.allocate(current.thread, current.pointer, current.size, size_t(1) << current.alignment_log2);
+                    }
+                    break;
+                case allocator_trace_recorder::record_kind::deallocation:
+                    builder.deallocate(current.thread, current.pointer);
+                    break;
+                default:
+                    break;
+            }
+        }
+
+        return std::move(builder).build();
+    }
+
+    trace load_trace(
+        std::string const &path)
+    {
+        return allocator_trace_reader::is_trace_file(path)
+                ? load_recorded_trace(path)
+                : load_text_trace(path);
+    }
+
+    /** A single thread trace is walked in order. The order of operations of different threads is known only
+     * at run time, so for them every block is counted as live at once.
+     */
+    void estimate_peak_footprint(
+        trace &tr)
+    {
+        size_t footprint = 0;
+
+        for (auto const &thread_operations : tr.threads)
+        {
+            for (auto const &operation : thread_operations)
+            {
+                size_t block_footprint = operation.size + operation.alignment + block_overhead_estimate;
+
+                if (operation.is_allocation)
+                {
+                    footprint += block_footprint;
+                    tr.peak_footprint = std::max(tr.peak_footprint, footprint);
+                }
+                else if (tr.threads.size() == 1)
+                {
+                    footprint -= block_footprint;
+                }
+            }
+        }
+    }
+
+    // сбрасывает пик RSS, если система это умеет; иначе пик считается с начала процесса
+    void reset_peak_rss()
+    {
+#if defined(__linux__)
+        std::ofstream("/proc/self/clear_refs") << "5";
+#endif
+    }
+
+    double peak_rss_mb()
+    {
+#if defined(__linux__)
+        std::ifstream status("/proc/self/status");
+        for (std::string line; std::getline(status, line); )
+        {
+            if (line.starts_with("VmHWM:"))
+            {
+                return std::stod(line.substr(6)) / 1024;
+            }
+        }
+#elif defined(_WIN32)
+        PROCESS_MEMORY_COUNTERS counters;
+        if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        {
+            return counters.PeakWorkingSetSize / 1024.0 / 1024.0;
+        }
+#endif
+        return 0;
+    }
+
+    result replay(
+        std::pmr::memory_resource &resource,
+        trace const &tr)
+    {
+        // выделение, которое не удалось, помечает слот этим адресом
+        static char failed_marker;
+
+        std::vector<std::atomic<void *>> slots(tr.slots_count);
+        std::vector<std::vector<std::uint32_t>> latencies(tr.threads.size());
+        std::atomic<size_t> failed_allocations = 0;
+
+        auto *statistics = dynamic_cast<allocator_statistics *>(&resource);
+        double fragmentation_sum = 0;
+        size_t fragmentation_samples = 0;
+
+        auto sample_fragmentation = [&]()
+        {
+            auto snapshot = statistics->get_statistics();
+            if (snapshot.free_bytes != 0 && snapshot.bytes_in_use != 0)
+            {
+                fragmentation_sum += 1 - static_cast<double>(std::min(snapshot.largest_free_block, snapshot.free_bytes)) / snapshot.free_bytes;
+                ++fragmentation_samples;
+            }
+        };
+
+        auto run_thread = [&](size_t thread)
+        {
+            auto &thread_latencies = latencies[thread];
+            thread_latencies.reserve(tr.threads[thread].size());
+
+            size_t done = 0;
+            for (auto const &operation : tr.threads[thread])
+            {
+                auto &slot = slots[operation.slot];
+
+                if (operation.is_allocation)
+                {
+                    void *ptr;
+                    auto start = std::chrono::steady_clock::now();
+                    try
+                    {
+                        ptr = resource.allocate(operation.size, operation.alignment);
+                    }
+                    catch (std::bad_alloc const &)
+                    {
+                        ptr = &failed_marker;
+                        ++failed_allocations;
+                    }
+                    auto finish = std::chrono::steady_clock::now();
+
+                    thread_latencies.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(finish - start).count());
+                    slot.store(ptr, std::memory_order_release);
+                }
+                else
+                {
+                    // блок мог выделить другой поток, который ещё до него не дошёл
+                    void *ptr;
+                    while ((ptr = slot.load(std::memory_order_acquire)) == nullptr)
+                    {
+                        std::this_thread::yield();
+                    }
+                    slot.store(nullptr, std::memory_order_relaxed);
+
+                    if (ptr != &failed_marker)
+                    {
+                        auto start = std::chrono::steady_clock::now();
+                        resource.deallocate(ptr, operation.size, operation.alignment);
+                        auto finish = std::chrono::steady_clock::now();
+
+                        thread_latencies.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(finish - start).count());
+                    }
+                }
+
+                if (thread == 0 && statistics != nullptr && ++done % fragmentation_sample_period == 0)
+                {
+                    sample_fragmentation();
+                }
+            }
+        };
+
+        reset_peak_rss();
+        auto start = std::chrono::steady_clock::now();
+
+        std::vector<std::thread> threads;
+        for (size_t thread = 1; thread < tr.threads.size(); ++thread)
+        {
+            threads.emplace_back(run_thread, thread);
+        }
+        run_thread(0);
+        for (auto &thread : threads)
+        {
+            thread.join();
+        }
+
+        auto finish = std::chrono::steady_clock::now();
+        double peak_rss = peak_rss_mb();
+
+        // трасса могла закончиться с живыми блоками
+        for (auto const &thread_operations : tr.threads)
+        {
+            for (auto const &operation : thread_operations)
+            {
+                void *ptr = slots[operation.slot].exchange(nullptr);
+                if (operation.is_allocation && ptr != nullptr && ptr != &failed_marker)
+                {
+                    resource.deallocate(ptr, operation.size, operation.alignment);
+                }
+            }
+        }
+
+        std::vector<std::uint32_t> all_latencies;
+        for (auto &thread_latencies : latencies)
+        {
+            all_latencies.insert(all_latencies.end(), thread_latencies.begin(), thread_latencies.end());
+        }
+
+        double p99 = 0;
+        if (!all_latencies.empty())
+        {
+            auto p99_it = all_latencies.begin() + all_latencies.size() * 99 / 100;
+            std::nth_element(all_latencies.begin(), p99_it, all_latencies.end());
+            p99 = *p99_it;
+        }
+
+        return
+            {
+                all_latencies.size() / std::chrono::duration<double, std::micro>(finish - start).count(),
+                p99,
+                peak_rss,
+                fragmentation_samples == 0 ? 0 : fragmentation_sum / fragmentation_samples,
+                failed_allocations
+            };
+    }
+
+    std::string fit_mode_name(
+        allocator_with_fit_mode::fit_mode mode)
+    {
+        switch (mode)
+        {
+            case allocator_with_fit_mode::fit_mode::first_fit:
+                return "first";
+            case allocator_with_fit_mode::fit_mode::the_best_fit:
+                return "best";
+            case allocator_with_fit_mode::fit_mode::the_worst_fit:
+                return "worst";
+            case allocator_with_fit_mode::fit_mode::next_fit:
+                return "next";
+        }
+        return "";
+    }
+
+    void print(
+        std::string const &trace_name,
+        std::string const &allocator_name,
+        std::string const &mode_name,
+        result const &res)
+    {
+        std::cout << std::setw(14) << trace_name << std::setw(16) << allocator_name << std::setw(7) << mode_name
+                  << std::fixed << std::setprecision(2) << std::setw(10) << res.mops
+                  << std::setprecision(0) << std::setw(10) << res.p99_ns
+                  << std::setprecision(1) << std::setw(14) << res.peak_rss_mb
+                  << std::setprecision(3) << std::setw(15) << res.fragmentation
+                  << std::setw(9) << res.failed_allocations << std::endl;
+    }
+}
+
+int main(
+    int argc,
+    char *argv[])
+{
+    std::vector<trace> traces;
+
+    try
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            traces.push_back(load_trace(argv[i]));
+        }
+    }
+    catch (std::exception const &ex)
+    {
+        std::cerr << ex.what() << std::endl;
+        return 1;
+    }
+
+    if (traces.empty())
+    {
+        traces.push_back(power_law_trace());
+        traces.push_back(producer_consumer_trace());
+        traces.push_back(lifo_bursts_trace());
+    }
+
+    for (auto &tr : traces)
+    {
+        estimate_peak_footprint(tr);
+    }
+
+    std::vector<subject> subjects
+        {
+            { "boundary_tags", true, [](size_t space_size, auto mode) { return new allocator_boundary_tags(space_size, nullptr, nullptr, mode); } },
+            { "bt_sampling", true, [](size_t space_size, auto mode)
+                {
+                    auto *allocator = new allocator_boundary_tags(space_size, nullptr, nullptr, mode);
+                    allocator->set_integrity_checks(allocator_boundary_tags::integrity_checks::sampling);
+                    return allocator;
+                } },
+            { "buddies_system", true, [](size_t space_size, auto mode) { return new allocator_buddies_system(std::bit_width(space_size - 1), nullptr, nullptr, mode); } },
+            { "red_black_tree", true, [](size_t space_size, auto mode) { return new allocator_red_black_tree(space_size, nullptr, nullptr, mode); } },
+            { "sorted_list", true, [](size_t space_size, auto mode) { return new allocator_sorted_list(space_size, nullptr, nullptr, mode); } },
+            { "slab", false, [](size_t space_size, auto) { return new allocator_slab(space_size); } },
+            { "global_heap", false, [](size_t, auto) { return new allocator_global_heap(); } }
+        };
+
+    std::vector<allocator_with_fit_mode::fit_mode> modes
+        {
+            allocator_with_fit_mode::fit_mode::first_fit,
+            allocator_with_fit_mode::fit_mode::the_best_fit,
+            allocator_with_fit_mode::fit_mode::the_worst_fit,
+            allocator_with_fit_mode::fit_mode::next_fit
+        };
+
+    std::cout << std::setw(14) << "trace" << std::setw(16) << "allocator" << std::setw(7) << "fit"
+              << std::setw(10) << "Mops/s" << std::setw(10) << "p99 ns" << std::setw(14) << "peak RSS MB"
+              << std::setw(15) << "fragmentation" << std::setw(9) << "failed" << std::endl;
+
+    for (auto const &tr : traces)
+    {
+        for (auto const &sub : subjects)
+        {
+            for (auto mode : modes)
+            {
+                std::unique_ptr<std::pmr::memory_resource> resource(sub.create(tr.peak_footprint * space_size_factor, mode));
+                print(tr.name, sub.name, sub.has_fit_mode ? fit_mode_name(mode) : "-", replay(*resource, tr));
+
+                if (!sub.has_fit_mode)
+                {
+                    break;
+                }
+            }
+        }
+    }
+
+    return 0;
+}
@@ -598,7 +598,8 @@ namespace __detail {
     template<class ...Args>
     binary_search_tree<tkey, tvalue, compare, AVL_TAG>::node *bst_impl<tkey, tvalue, compare, AVL_TAG>::create_node(
             binary_search_tree<tkey, tvalue, compare, AVL_TAG> &cont, Args &&...args) {
-        auto *new_node = cont._allocator.template new_object<typename AVL_tree<tkey, tvalue, compare>::node>(
+        using node_type = typename AVL_tree<tkey, tvalue, compare>::node;
+        auto *new_node = cont.template get_node_allocator<node_type>().template new_object<node_type>(
                 std::forward<Args>(args)...);
         return new_node;
     }
@@ -609,7 +610,7 @@ namespace __detail {
             binary_search_tree<tkey, tvalue, compare, AVL_TAG>::node **node) {
         using node_type = typename binary_search_tree<tkey, tvalue, compare, AVL_TAG>::node;
         if (node && *node) {
-            cont._allocator.template delete_object<node_type>(*node);
+            cont.template get_node_allocator<node_type>().template delete_object<node_type>(*node);
             *node = nullptr;
         }
     }
@@ -824,6 +825,7 @@ void __detail::bst_impl<tkey, tvalue, compare, __detail::AVL_TAG>::swap(
     std::swap(lhs._root, rhs._root);
     std::swap(lhs._size, rhs._size);
     std::swap(lhs._allocator, rhs._allocator);
+    std::swap(lhs._node_pool, rhs._node_pool);
     std::swap(lhs._logger, rhs._logger);
 }
 
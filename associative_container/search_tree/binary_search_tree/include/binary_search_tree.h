@@ -12,6 +12,7 @@
 #include <stack>
 #include <ranges>
 #include <pp_allocator.h>
+#include <allocator_pool.h>
 #include <concepts>
 
 namespace __detail
@@ -705,6 +706,15 @@ protected:
      */
     pp_allocator<value_type> _allocator;
 
+    // узлы берутся из пула поверх ресурса _allocator, пул создаётся вместе с первым узлом
+    // и уничтожается в clear(), так что у пустого дерева пула нет
+    std::unique_ptr<allocator_pool> _node_pool;
+
+    /** Allocator for the nodes of this tree, derived trees pass their own node type
+     */
+    template<typename node_type = node>
+    pp_allocator<value_type> get_node_allocator();
+
 public:
     explicit binary_search_tree(
             const compare& comp = compare(),
@@ -967,6 +977,7 @@ void __detail::bst_impl<tkey, tvalue, compare, tag>::swap(binary_search_tree<tke
     swap(lhs._logger, rhs._logger);
     swap(lhs._size, rhs._size);
     swap(lhs._allocator, rhs._allocator);
+    swap(lhs._node_pool, rhs._node_pool);
 }
 
 template<typename tkey, typename tvalue, compator<tkey> compare, typename tag>
@@ -2363,6 +2374,7 @@ template<typename tkey, typename tvalue, compator<tkey> compare, typename tag>
 binary_search_tree<tkey, tvalue, compare, tag>::binary_search_tree(binary_search_tree &&other) noexcept
         : //compare(std::move(other.compare)),
           _allocator(std::move(other._allocator)),
+          _node_pool(std::move(other._node_pool)),
           _logger(std::move(other._logger)),
           _root(other._root)
 {// передали владение указателем
@@ -2406,6 +2418,7 @@ binary_search_tree<tkey, tvalue, compare, tag>::operator=(binary_search_tree &&o
     // Перенос данных из другого дерева
     //compare = std::move(other.compare);
     _allocator = std::move(other._allocator);
+    _node_pool = std::move(other._node_pool);
     _logger = std::move(other._logger);
     _root = other._root;
     _size = other._size;
@@ -2425,6 +2438,23 @@ binary_search_tree<tkey, tvalue, compare, tag>::~binary_search_tree()
 
 // endregion binary_search_tree 5_rules implementation
 
+// region binary_search_tree node_allocator implementation
+
+template<typename tkey, typename tvalue, compator<tkey> compare, typename tag>
+template<typename node_type>
+pp_allocator<typename binary_search_tree<tkey, tvalue, compare, tag>::value_type>
+binary_search_tree<tkey, tvalue, compare, tag>::get_node_allocator()
+{
+    if (_node_pool == nullptr)
+    {
+        _node_pool = std::make_unique<allocator_pool>(allocator_pool::for_objects_of<node_type>(_allocator.resource()));
+    }
+
+    return pp_allocator<value_type>(_node_pool.get());
+}
+
+// endregion binary_search_tree node_allocator implementation
+
 // region binary_search_tree methods_access implementation
 
 template<typename tkey, typename tvalue, compator<tkey> compare, typename tag>
@@ -2496,8 +2526,7 @@ tvalue& binary_search_tree<tkey, tvalue, compare, tag>::operator[](const tkey& k
     }
 
     // Ключ не найден, создаем новый узел
-    auto new_node = _allocator.allocate(1);
-    _allocator.construct(new_node, std::make_pair(key, tvalue()), parent);
+    auto new_node = __detail::bst_impl<tkey, tvalue, compare, tag>::create_node(*this, parent, key, tvalue());
 
     if (parent == nullptr)
     {
@@ -2541,8 +2570,7 @@ tvalue& binary_search_tree<tkey, tvalue, compare, tag>::operator[](tkey&& key)
     }
 
     // Ключ не найден, создаем новый узел
-    auto new_node = _allocator.allocate(1);
-    _allocator.construct(new_node, std::make_pair(std::move(key), tvalue()), parent);
+    auto new_node = __detail::bst_impl<tkey, tvalue, compare, tag>::create_node(*this, parent, std::move(key), tvalue());
 
     if (parent == nullptr)
     {
@@ -2576,7 +2604,16 @@ size_t binary_search_tree<tkey, tvalue, compare, tag>::size() const noexcept
 template<typename tkey, typename tvalue, compator<tkey> compare, typename tag>
 void binary_search_tree<tkey, tvalue, compare, tag>::clear() noexcept
 {
+    if (_node_pool == nullptr) {
+        return;
+    }
+
     clear(_root);
+    _root = nullptr;
+    _size = 0;
+
+    // слэбы пула возвращаются ресурсу, а не ждут следующих вставок
+    _node_pool.reset();
 }
 
 template<typename tkey, typename tvalue, compator<tkey> compare, typename tag>
@@ -2585,9 +2622,32 @@ void binary_search_tree<tkey, tvalue, compare, tag>::clear(node* n) noexcept
     if (n == nullptr) {
         return;
     }
-    clear(n->left_subtree);
-    clear(n->right_subtree);
-    _allocator.delete_object(n);
+
+    // узлы разрушаются по одному, а их память отдается пулу пачками
+    constexpr size_t batch_capacity = 64;
+    void* batch[batch_capacity];
+    size_t batch_size = 0;
+    // узлы есть только при созданном пуле, здесь он не создается
+    pp_allocator<value_type> node_allocator(_node_pool.get());
+
+    auto release = [&](auto& self, node* current) -> void
+    {
+        if (current == nullptr) {
+            return;
+        }
+        self(self, current->left_subtree);
+        self(self, current->right_subtree);
+
+        node_allocator.destroy(current);
+        batch[batch_size++] = current;
+        if (batch_size == batch_capacity) {
+            node_allocator.deallocate_bytes_batch(batch, batch_size, sizeof(node), alignof(node));
+            batch_size = 0;
+        }
+    };
+    release(release, n);
+
+    node_allocator.deallocate_bytes_batch(batch, batch_size, sizeof(node), alignof(node));
 }
 
 // endregion binary_search_tree methods_access implementation
@@ -2774,6 +2834,7 @@ void binary_search_tree<tkey, tvalue, compare, tag>::swap(binary_search_tree& ot
     std::swap(_root, other._root);
     std::swap(_size, other._size);
     std::swap(_allocator, other._allocator);
+    std::swap(_node_pool, other._node_pool);
     std::swap(_logger, other._logger);
 }
 
@@ -3841,7 +3902,8 @@ namespace __detail {
     typename binary_search_tree<tkey, tvalue, compare, tag>::node *
     bst_impl<tkey, tvalue, compare, tag>::create_node(binary_search_tree<tkey, tvalue, compare, tag> &cont,
                                                       Args &&...args) {
-        auto *new_node = cont._allocator.template new_object<typename binary_search_tree<tkey, tvalue, compare, tag>::node>(std::forward<Args>(args)...);
+        using node_type = typename binary_search_tree<tkey, tvalue, compare, tag>::node;
+        auto *new_node = cont.template get_node_allocator<node_type>().template new_object<node_type>(std::forward<Args>(args)...);
         return new_node;
     }
 
@@ -3852,7 +3914,7 @@ namespace __detail {
         using node_type = typename binary_search_tree<tkey, tvalue, compare, tag>::node;
         if (node && *node)
         {
-            cont._allocator.template delete_object<node_type>(*node);
+            cont.template get_node_allocator<node_type>().template delete_object<node_type>(*node);
             *node = nullptr;
         }
     }
@@ -6,6 +6,8 @@
 #include <stack>
 #include <map>
 #include <pp_allocator.h>
+#include <allocator_pool.h>
+#include <memory>
 #include <search_tree.h>
 #include <initializer_list>
 #include <logger_guardant.h>
@@ -55,12 +57,16 @@ public:
     size_t find_key_index_in_node(btree_node* node, const tkey& k) const;
 
     pp_allocator<value_type> _allocator;
+    // узлы берутся из пула поверх ресурса _allocator, пул создаётся вместе с первым узлом
+    // и уничтожается в clear(), так что у пустого дерева пула нет
+    std::unique_ptr<allocator_pool> _node_pool;
     logger* _logger;
     btree_node* _root;
     size_t _size;
 
     logger* get_logger() const noexcept override;
     pp_allocator<value_type> get_allocator() const noexcept;
+    pp_allocator<btree_node> get_node_allocator();
 
 public:
 
@@ -370,6 +376,15 @@ pp_allocator<typename B_tree<tkey, tvalue, compare, t>::value_type> B_tree<tkey,
     return this->_allocator;
 }
 
+template<typename tkey, typename tvalue, compator<tkey> compare, std::size_t t>
+pp_allocator<typename B_tree<tkey, tvalue, compare, t>::btree_node> B_tree<tkey, tvalue, compare, t>::get_node_allocator()
+{
+    if (this->_node_pool == nullptr) {
+        this->_node_pool = std::make_unique<allocator_pool>(allocator_pool::for_objects_of<btree_node>(this->_allocator.resource()));
+    }
+    return pp_allocator<btree_node>(this->_node_pool.get());
+}
+
 
 
 template<typename tkey, typename tvalue, compator<tkey> compare, std::size_t t>
@@ -494,6 +509,7 @@ template<typename tkey, typename tvalue, compator<tkey> compare, std::size_t t>
 B_tree<tkey, tvalue, compare, t>::B_tree(B_tree&& other) noexcept
         : compare(std::move(static_cast<compare&>(other))),
           _allocator(std::move(other._allocator)),
+          _node_pool(std::move(other._node_pool)),
           _logger(other._logger),
           _root(other._root),
           _size(other._size)
@@ -521,6 +537,7 @@ B_tree<tkey, tvalue, compare, t>& B_tree<tkey, tvalue, compare, t>::operator=(B_
     this->clear();
     static_cast<compare&>(*this) = std::move(static_cast<compare&>(other));
     this->_allocator = std::move(other._allocator);
+    this->_node_pool = std::move(other._node_pool);
     this->_logger = other._logger;
     this->_root = other._root;
     this->_size = other._size;
@@ -1907,7 +1924,7 @@ void B_tree<tkey, tvalue, compare, t>::merge_children(
     node->_keys.erase(node->_keys.begin() + parent_key_idx);
     node->_pointers.erase(node->_pointers.begin() + child_idx + 1);
 
-    pp_allocator<btree_node> node_alloc = this->get_allocator();
+    pp_allocator<btree_node> node_alloc = this->get_node_allocator();
     node_alloc.delete_object(right_child);
 }
 
@@ -1917,6 +1934,7 @@ void B_tree<tkey, tvalue, compare, t>::clear() noexcept {
     if (_logger) _logger->trace("B_tree clear() called.");
     if (!_root) {
         _size = 0;
+        this->_node_pool.reset();
         return;
     }
 
@@ -1943,15 +1961,17 @@ void B_tree<tkey, tvalue, compare, t>::clear() noexcept {
     }
 
 
-    pp_allocator<btree_node> node_alloc = this->get_allocator();
+    // узлы только разрушаются, их память уходит вместе со слэбами пула
+    pp_allocator<btree_node> node_alloc(this->_node_pool.get());
     while (!s2.empty()) {
         typename B_tree<tkey, tvalue, compare, t>::btree_node* node_to_free = s2.top();
         s2.pop();
         if (node_to_free) {
-            node_alloc.delete_object(node_to_free);
+            node_alloc.destroy(node_to_free);
         }
     }
 
+    this->_node_pool.reset();
     this->_root = nullptr;
     this->_size = 0;
 }
@@ -1972,7 +1992,7 @@ B_tree<tkey, tvalue, compare, t>::insert(const tree_data_type& data)
 
     // Если дерево пустое — создаём корень и вставляем ключ
     if (!this->_root) {
-        pp_allocator<Node> node_allocator(this->_allocator);
+        pp_allocator<Node> node_allocator = this->get_node_allocator();
         this->_root = node_allocator.template new_object<Node>();
         this->_root->_keys.push_back(data);
         this->_size = 1;
@@ -1990,7 +2010,7 @@ B_tree<tkey, tvalue, compare, t>::insert(const tree_data_type& data)
 
     // Если корень заполнен (достиг максимума ключей), делаем расширение корня
     if (this->_root->_keys.size() == (2 * min_degree - 1)) {
-        pp_allocator<Node> node_allocator(this->_allocator);
+        pp_allocator<Node> node_allocator = this->get_node_allocator();
         NodePtr old_root = this->_root;
         NodePtr new_root = node_allocator.template new_object<Node>();
 
@@ -2050,7 +2070,7 @@ B_tree<tkey, tvalue, compare, t>::insert(const tree_data_type& data)
 
     // Спускаемся в дерево до листа, вставляя ключ
     NodePtr* current_node_ptr = &this->_root;
-    pp_allocator<Node> node_allocator(this->_allocator);
+    pp_allocator<Node> node_allocator = this->get_node_allocator();
 
     while (true) {
         NodePtr current_node = *current_node_ptr;
@@ -2243,7 +2263,7 @@ B_tree<tkey, tvalue, compare, t>::erase(btree_iterator pos)
             }
         }
         if (old_root) {
-            pp_allocator<btree_node> node_alloc = this->get_allocator();
+            pp_allocator<btree_node> node_alloc = this->get_node_allocator();
             node_alloc.delete_object(old_root);
         }
     }
@@ -2262,7 +2282,7 @@ B_tree<tkey, tvalue, compare, t>::erase(btree_iterator pos)
 
     if (this->_size == 0 && this->_root != nullptr) {
         if(this->_logger) this->_logger->error("Tree size is 0 but root is not null after erase.");
-        pp_allocator<btree_node> node_alloc = this->get_allocator();
+        pp_allocator<btree_node> node_alloc = this->get_node_allocator();
         node_alloc.delete_object(this->_root);
         this->_root = nullptr;
     } else if (this->_size > 0 && this->_root == nullptr) {
@@ -2356,7 +2376,7 @@ B_tree<tkey, tvalue, compare, t_param>::erase(const tkey& key)
             }
         }
         if (old_root) {
-            pp_allocator<typename B_tree<tkey, tvalue, compare, t_param>::btree_node> node_alloc = this->get_allocator();
+            pp_allocator<typename B_tree<tkey, tvalue, compare, t_param>::btree_node> node_alloc = this->get_node_allocator();
             node_alloc.delete_object(old_root);
         }
     }
@@ -2369,7 +2389,7 @@ B_tree<tkey, tvalue, compare, t_param>::erase(const tkey& key)
         }
         if (this->_size == 0 && this->_root != nullptr) {
             if(this->_logger) this->_logger->error("Tree size is 0 but root is not null after erase.");
-            pp_allocator<typename B_tree<tkey, tvalue, compare, t_param>::btree_node> node_alloc = this->get_allocator();
+            pp_allocator<typename B_tree<tkey, tvalue, compare, t_param>::btree_node> node_alloc = this->get_node_allocator();
             node_alloc.delete_object(this->_root);
             this->_root = nullptr;
             throw std::runtime_error("Tree size is 0 but root is not null after erase.");
@@ -84,6 +84,9 @@ public:
         const std::string &message,
         logger::severity severity) & override;
 
+    bool is_enabled(
+        logger::severity severity) const noexcept override;
+
 };
 
 #endif //MATH_PRACTICE_AND_OPERATING_SYSTEMS_CLIENT_LOGGER_H
\ No newline at end of file
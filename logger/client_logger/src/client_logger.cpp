@@ -27,6 +27,10 @@ logger& client_logger::log(const std::string &text, logger::severity severity) &
     return *this;
 }
 
+bool client_logger::is_enabled(logger::severity severity) const noexcept
+{
+    return _output_streams.contains(severity);
+}
 
 std::string client_logger::make_format(const std::string &message, severity sev) const
 {
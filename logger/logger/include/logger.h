@@ -28,6 +28,10 @@ public:
         std::string const &message,
         logger::severity severity) & = 0;
 
+    // lets callers skip building messages nobody will write
+    virtual bool is_enabled(
+        logger::severity severity) const noexcept;
+
 public:
 
     logger& trace(
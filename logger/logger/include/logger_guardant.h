@@ -34,6 +34,35 @@ public:
     logger_guardant &critical_with_guard(
         std::string const &message) &;
 
+public:
+
+    // literal messages are turned into std::string only when there is a logger to write them
+
+    logger_guardant & log_with_guard(
+        char const *message,
+        logger::severity severity) &;
+
+    logger_guardant &trace_with_guard(
+        char const *message) &;
+
+    logger_guardant &debug_with_guard(
+        char const *message) &;
+
+    logger_guardant &information_with_guard(
+        char const *message) &;
+
+    logger_guardant &warning_with_guard(
+        char const *message) &;
+
+    logger_guardant &error_with_guard(
+        char const *message) &;
+
+    logger_guardant &critical_with_guard(
+        char const *message) &;
+
+    bool is_enabled_with_guard(
+        logger::severity severity) const;
+
 protected:
 
     inline virtual logger *get_logger() const = 0;
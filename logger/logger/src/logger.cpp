@@ -2,6 +2,13 @@
 #include <iomanip>
 #include <sstream>
 
+// базовый логгер не знает своих severity, поэтому по умолчанию пишет всё
+bool logger::is_enabled(
+    [[maybe_unused]] logger::severity severity) const noexcept
+{
+    return true;
+}
+
 logger & logger::trace(
     std::string const &message) &
 {